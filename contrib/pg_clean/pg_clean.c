@@ -1617,59 +1617,16 @@ PG_FUNCTION_INFO_V1(pgxc_get_2pc_file);
 Datum pgxc_get_2pc_file(PG_FUNCTION_ARGS)
 {
     char *tid;
-    char path[MAXPGPATH];
-    File fd;
-    int ret;
     char *result;
 	text *t_result = NULL;
-    struct stat filestate;
-    off_t fileSize;
     
     tid = text_to_cstring(PG_GETARG_TEXT_P(0));
 
-    snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
-    
-    if(access(path, F_OK) == 0)
+    result = get_2pc_record(tid);
+    if (result && result[0] != '\0')
     {
-    	if(stat(path, &filestate) == -1)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not get status of file \"%s\"", path)));
-    	}
-        
-    	fileSize = filestate.st_size;
-
-        if (0 == fileSize) 
-        {
-            PG_RETURN_NULL();
-        }
-
-        result = (char *)palloc0(fileSize + 1);
-
-        fd = PathNameOpenFile(path, O_RDONLY, S_IRUSR | S_IWUSR);
-    	if (fd < 0)
-    	{   
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not open file \"%s\" for read", path)));
-    	} 
-
-    	ret = FileRead(fd, result, fileSize, WAIT_EVENT_BUFFILE_READ);
-
-    	if(ret != fileSize)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not read file \"%s\"", path)));
-    	}
-
-        FileClose(fd);
-		if (result)
-		{
-			t_result = cstring_to_text(result);
-			return PointerGetDatum(t_result);
-		}
+		t_result = cstring_to_text(result);
+		return PointerGetDatum(t_result);
     }
     PG_RETURN_NULL();
 }
@@ -1680,60 +1637,22 @@ PG_FUNCTION_INFO_V1(pgxc_get_2pc_nodes);
 Datum pgxc_get_2pc_nodes(PG_FUNCTION_ARGS)
 {
     char *tid;
-    char path[MAXPGPATH];
-    File fd;
-    int ret;
     char *result;
 	char *nodename;
 	text *t_result = NULL;
-    struct stat filestate;
-    off_t fileSize;
     
     tid = text_to_cstring(PG_GETARG_TEXT_P(0));
 
-    snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
-    
-    if(access(path, F_OK) == 0)
+    result = get_2pc_record(tid);
+    if (result)
     {
-    	if(stat(path, &filestate) == -1)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not get status of file \"%s\"", path)));
-    	}
-        
-    	fileSize = filestate.st_size;
-
-        result = (char *)palloc0(fileSize + 1);
-
-        fd = PathNameOpenFile(path, O_RDONLY, S_IRUSR | S_IWUSR);
-    	if (fd < 0)
-    	{   
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not open file \"%s\" for read", path)));
-    	} 
-
-    	ret = FileRead(fd, result, fileSize, WAIT_EVENT_BUFFILE_READ);
-
-    	if(ret != fileSize)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not read file \"%s\"", path)));
-    	}
-
-        FileClose(fd);
-		if (result)
+		nodename = strstr(result, GET_NODE);
+		if (nodename)
 		{
-			nodename = strstr(result, GET_NODE);
-			if (nodename)
-			{
-				nodename += strlen(GET_NODE);
-				nodename = strtok(nodename, "\n");
-				t_result = cstring_to_text(nodename);
-				return PointerGetDatum(t_result);
-			}
+			nodename += strlen(GET_NODE);
+			nodename = strtok(nodename, "\n");
+			t_result = cstring_to_text(nodename);
+			return PointerGetDatum(t_result);
 		}
     }
     PG_RETURN_NULL();
@@ -1744,60 +1663,22 @@ PG_FUNCTION_INFO_V1(pgxc_get_2pc_startnode);
 Datum pgxc_get_2pc_startnode(PG_FUNCTION_ARGS)
 {
     char *tid;
-    char path[MAXPGPATH];
-    File fd;
-    int ret;
     char *result;
 	char *nodename;
 	text *t_result = NULL;
-    struct stat filestate;
-    off_t fileSize;
     
     tid = text_to_cstring(PG_GETARG_TEXT_P(0));
 
-    snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
-    
-    if(access(path, F_OK) == 0)
+    result = get_2pc_record(tid);
+    if (result)
     {
-    	if(stat(path, &filestate) == -1)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not get status of file \"%s\"", path)));
-    	}
-        
-    	fileSize = filestate.st_size;
-
-        result = (char *)palloc0(fileSize + 1);
-
-        fd = PathNameOpenFile(path, O_RDONLY, S_IRUSR | S_IWUSR);
-    	if (fd < 0)
-    	{   
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not open file \"%s\" for read", path)));
-    	} 
-
-    	ret = FileRead(fd, result, fileSize, WAIT_EVENT_BUFFILE_READ);
-
-    	if(ret != fileSize)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not read file \"%s\"", path)));
-    	}
-
-        FileClose(fd);
-		if (result)
+		nodename = strstr(result, GET_START_NODE);
+		if (nodename)
 		{
-			nodename = strstr(result, GET_START_NODE);
-			if (nodename)
-			{
-				nodename += strlen(GET_START_NODE);
-				nodename = strtok(nodename, "\n");
-				t_result = cstring_to_text(nodename);
-				return PointerGetDatum(t_result);
-			}
+			nodename += strlen(GET_START_NODE);
+			nodename = strtok(nodename, "\n");
+			t_result = cstring_to_text(nodename);
+			return PointerGetDatum(t_result);
 		}
     }
     PG_RETURN_NULL();
@@ -1808,60 +1689,22 @@ PG_FUNCTION_INFO_V1(pgxc_get_2pc_startxid);
 Datum pgxc_get_2pc_startxid(PG_FUNCTION_ARGS)
 {
     char *tid;
-    char path[MAXPGPATH];
-    File fd;
-    int ret;
     char *result;
 	char *startxid;
 	text *t_result = NULL;
-    struct stat filestate;
-    off_t fileSize;
     
     tid = text_to_cstring(PG_GETARG_TEXT_P(0));
 
-    snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
-    
-    if(access(path, F_OK) == 0)
+    result = get_2pc_record(tid);
+    if (result)
     {
-    	if(stat(path, &filestate) == -1)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not get status of file \"%s\"", path)));
-    	}
-        
-    	fileSize = filestate.st_size;
-
-        result = (char *)palloc0(fileSize + 1);
-
-        fd = PathNameOpenFile(path, O_RDONLY, S_IRUSR | S_IWUSR);
-    	if (fd < 0)
-    	{   
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not open file \"%s\" for read", path)));
-    	} 
-
-    	ret = FileRead(fd, result, fileSize, WAIT_EVENT_BUFFILE_READ);
-
-    	if(ret != fileSize)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not read file \"%s\"", path)));
-    	}
-
-        FileClose(fd);
-		if (result)
+		startxid = strstr(result, GET_START_XID);
+		if (startxid)
 		{
-			startxid = strstr(result, GET_START_XID);
-			if (startxid)
-			{
-				startxid += strlen(GET_START_XID);
-				startxid = strtok(startxid, "\n");
-				t_result = cstring_to_text(startxid);
-				return PointerGetDatum(t_result);
-			}
+			startxid += strlen(GET_START_XID);
+			startxid = strtok(startxid, "\n");
+			t_result = cstring_to_text(startxid);
+			return PointerGetDatum(t_result);
 		}
     }
     PG_RETURN_NULL();
@@ -1873,60 +1716,22 @@ PG_FUNCTION_INFO_V1(pgxc_get_2pc_commit_timestamp);
 Datum pgxc_get_2pc_commit_timestamp(PG_FUNCTION_ARGS)
 {
     char *tid;
-    char path[MAXPGPATH];
-    File fd;
-    int ret;
     char *result;
 	char *commit_timestamp;
 	text *t_result = NULL;
-    struct stat filestate;
-    off_t fileSize;
     
     tid = text_to_cstring(PG_GETARG_TEXT_P(0));
 
-    snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
-    
-    if(access(path, F_OK) == 0)
+    result = get_2pc_record(tid);
+    if (result)
     {
-    	if(stat(path, &filestate) == -1)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not get status of file \"%s\"", path)));
-    	}
-        
-    	fileSize = filestate.st_size;
-
-        result = (char *)palloc0(fileSize + 1);
-
-        fd = PathNameOpenFile(path, O_RDONLY, S_IRUSR | S_IWUSR);
-    	if (fd < 0)
-    	{   
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not open file \"%s\" for read", path)));
-    	} 
-
-    	ret = FileRead(fd, result, fileSize, WAIT_EVENT_BUFFILE_READ);
-
-    	if(ret != fileSize)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not read file \"%s\"", path)));
-    	}
-
-        FileClose(fd);
-		if (result)
+		commit_timestamp = strstr(result, GET_COMMIT_TIMESTAMP);
+		if (commit_timestamp)
 		{
-			commit_timestamp = strstr(result, GET_COMMIT_TIMESTAMP);
-			if (commit_timestamp)
-			{
-				commit_timestamp += strlen(GET_COMMIT_TIMESTAMP);
-				commit_timestamp = strtok(commit_timestamp, "\n");
-				t_result = cstring_to_text(commit_timestamp);
-				return PointerGetDatum(t_result);
-			}
+			commit_timestamp += strlen(GET_COMMIT_TIMESTAMP);
+			commit_timestamp = strtok(commit_timestamp, "\n");
+			t_result = cstring_to_text(commit_timestamp);
+			return PointerGetDatum(t_result);
 		}
     }
     PG_RETURN_NULL();
@@ -1939,51 +1744,15 @@ PG_FUNCTION_INFO_V1(pgxc_get_2pc_xid);
 Datum pgxc_get_2pc_xid(PG_FUNCTION_ARGS)
 {
     char *tid;
-    char path[MAXPGPATH];
-    File fd;
-    int ret;
     GlobalTransactionId xid;
 	char *result;
 	char *str_xid;
-    struct stat filestate;
-    off_t fileSize;
     
     tid = text_to_cstring(PG_GETARG_TEXT_P(0));
 
-    snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
-    
-    if(access(path, F_OK) == 0)
+    result = get_2pc_record(tid);
+    if (result)
     {
-    	if(stat(path, &filestate) == -1)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not get status of file \"%s\"", path)));
-    	}
-        
-    	fileSize = filestate.st_size;
-		result = (char *)palloc0(fileSize + 1);
-		
-        fd = PathNameOpenFile(path, O_RDONLY, S_IRUSR | S_IWUSR);
-    	if (fd < 0)
-    	{   
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not open file \"%s\" for read", path)));
-    	} 
-		
-
-    	ret = FileRead(fd, result, fileSize, WAIT_EVENT_BUFFILE_READ);
-
-    	if(ret != fileSize)
-    	{
-    		ereport(ERROR,
-    			(errcode_for_file_access(),
-    			errmsg("could not read file \"%s\"", path)));
-    	}
-
-        FileClose(fd);
-		
 		str_xid = strstr(result, GET_XID);
 		if (str_xid)
 		{
@@ -1992,7 +1761,6 @@ Datum pgxc_get_2pc_xid(PG_FUNCTION_ARGS)
 			xid = strtoul(str_xid, NULL, 10);
 			PG_RETURN_UINT32(xid);
 		}
-		
     }
     PG_RETURN_NULL();
 }
@@ -2173,40 +1941,34 @@ PG_FUNCTION_INFO_V1(pgxc_get_record_list);
 Datum pgxc_get_record_list(PG_FUNCTION_ARGS)
 {
     int count = 0;
-    DIR *dir = NULL;
-    struct dirent *ptr = NULL;
+    List *gids = NIL;
+    ListCell *lc = NULL;
+    char *gid = NULL;
     char *recordList = NULL;
 	text *t_recordList = NULL;
 
-	if(!(dir = opendir(TWOPHASE_RECORD_DIR)))
-	{
-		PG_RETURN_NULL();
-	}
+    /* journaled records as well as the ones kept in files of their own */
+    gids = get_2pc_record_list();
 
-    while((ptr = readdir(dir)) != NULL)
+    foreach(lc, gids)
     {
-        if(strcmp(ptr->d_name,".") == 0 || strcmp(ptr->d_name,"..") == 0)
-        {
-            continue;
-        }       
+        gid = (char *) lfirst(lc);
         if (count >= MAXIMUM_OUTPUT_FILE)
             break;
         
         if(!recordList)
         {
-            recordList = (char *)palloc0(strlen(ptr->d_name) + 1);
-            sprintf(recordList, "%s", ptr->d_name);
+            recordList = (char *)palloc0(strlen(gid) + 1);
+            sprintf(recordList, "%s", gid);
         }
         else
         {
     		recordList = (char *) repalloc(recordList,
-								   strlen(ptr->d_name) + strlen(recordList) + 2);
-            sprintf(recordList, "%s,%s", recordList, ptr->d_name);
+								   strlen(gid) + strlen(recordList) + 2);
+            sprintf(recordList, "%s,%s", recordList, gid);
         }
         count++;
     }
-
-    closedir(dir);
     
     if(!recordList)
     {
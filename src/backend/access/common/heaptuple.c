@@ -80,6 +80,8 @@
 #include "pgxc/execRemote.h"
 #include "catalog/pg_type.h"
 #include "mb/pg_wchar.h"
+#include "utils/builtins.h"
+#include <math.h>
 #endif
 
 /* Does att's datatype allow packing into the 1-byte-header varlena format? */
@@ -1354,6 +1356,151 @@ get_typioparam_mod(Oid typioparam, int32 typmod)
     }
 }
 
+#ifdef __TBASE__
+/*
+ * Parse the text form of an integer in place: an optional minus sign and up
+ * to 18 digits, so that the value can not overflow.
+ */
+static bool
+datarow_parse_int(const char *data, int len, int64 *result)
+{
+    const char *end = data + len;
+    bool        neg = false;
+    int64        val = 0;
+
+    if (data < end && *data == '-')
+    {
+        neg = true;
+        data++;
+    }
+    if (data == end || end - data > 18)
+        return false;
+
+    for (; data < end; data++)
+    {
+        if (*data < '0' || *data > '9')
+            return false;
+        val = val * 10 + (*data - '0');
+    }
+
+    *result = neg ? -val : val;
+    return true;
+}
+
+/*
+ * Decode a column of a common type directly from the DataRow message.
+ *
+ * Gathering a large result on the coordinator mostly costs the input
+ * functions of its columns, called through fmgr on a copy of every value.
+ * The text forms sent by the remote nodes for the types below are simple
+ * enough to be parsed in place.  Anything unusual, such as spaces, special
+ * float values or out of range numbers, is left to the input function, so
+ * that edge cases and errors behave exactly as before.  Returns false if the
+ * value has to go through the input function.
+ */
+static bool
+datarow_decode_fast(Form_pg_attribute attr, const char *data, int len,
+                    MemoryContext cxt, Datum *value)
+{// #lizard forgives
+    int64        ival;
+
+    switch (attr->atttypid)
+    {
+        case INT2OID:
+            if (!datarow_parse_int(data, len, &ival) ||
+                ival < PG_INT16_MIN || ival > PG_INT16_MAX)
+                return false;
+            *value = Int16GetDatum((int16) ival);
+            return true;
+
+        case INT4OID:
+            if (!datarow_parse_int(data, len, &ival) ||
+                ival < PG_INT32_MIN || ival > PG_INT32_MAX)
+                return false;
+            *value = Int32GetDatum((int32) ival);
+            return true;
+
+        case INT8OID:
+            if (!datarow_parse_int(data, len, &ival))
+                return false;
+            if (attr->attbyval)
+                *value = Int64GetDatum(ival);
+            else
+            {
+                MemoryContext oldcontext = MemoryContextSwitchTo(cxt);
+
+                *value = Int64GetDatum(ival);
+                MemoryContextSwitchTo(oldcontext);
+            }
+            return true;
+
+        case OIDOID:
+            if (len == 0 || *data == '-' ||
+                !datarow_parse_int(data, len, &ival) || ival > PG_UINT32_MAX)
+                return false;
+            *value = ObjectIdGetDatum((Oid) ival);
+            return true;
+
+        case BOOLOID:
+            if (len != 1 || (*data != 't' && *data != 'f'))
+                return false;
+            *value = BoolGetDatum(*data == 't');
+            return true;
+
+        case FLOAT4OID:
+        case FLOAT8OID:
+            {
+                char        num[64];
+                char       *endptr;
+                double        val;
+
+                /* strtod needs a terminated string, and skips spaces */
+                if (len == 0 || len >= sizeof(num) ||
+                    !(isdigit((unsigned char) *data) || *data == '-' || *data == '.'))
+                    return false;
+                memcpy(num, data, len);
+                num[len] = '\0';
+
+                errno = 0;
+                val = strtod(num, &endptr);
+                if (errno != 0 || endptr != num + len || isinf(val) || isnan(val))
+                    return false;
+
+                if (attr->atttypid == FLOAT4OID)
+                {
+                    float4        fval = (float4) val;
+
+                    if (isinf(fval) || (fval == 0.0 && val != 0.0))
+                        return false;
+                    *value = Float4GetDatum(fval);
+                }
+                else if (attr->attbyval)
+                    *value = Float8GetDatum(val);
+                else
+                {
+                    MemoryContext oldcontext = MemoryContextSwitchTo(cxt);
+
+                    *value = Float8GetDatum(val);
+                    MemoryContextSwitchTo(oldcontext);
+                }
+                return true;
+            }
+
+        case TEXTOID:
+            {
+                MemoryContext oldcontext = MemoryContextSwitchTo(cxt);
+
+                *value = PointerGetDatum(cstring_to_text_with_len(data, len));
+                MemoryContextSwitchTo(oldcontext);
+                return true;
+            }
+
+        default:
+            return false;
+    }
+}
+#endif
+
 /*
  * slot_deform_datarow
  *         Extract data from the DataRow message into Datum/isnull arrays.
@@ -1375,10 +1522,18 @@ slot_deform_datarow(TupleTableSlot *slot)
     int i;
     int         col_count;
     char       *cur = slot->tts_datarow->msg;
+#ifdef __TBASE__
+    StringInfoData bufferData;
+    StringInfo  buffer = &bufferData;
+#else
     StringInfo  buffer;
+#endif
     uint16        n16;
     uint32        n32;
     MemoryContext oldcontext;
+#ifdef __TBASE__
+    bool        convert_typmod;
+#endif
 
     Assert(slot->tts_tupleDescriptor != NULL);
     Assert(slot->tts_datarow != NULL);
@@ -1422,7 +1577,17 @@ slot_deform_datarow(TupleTableSlot *slot)
                                                   ALLOCSET_DEFAULT_MAXSIZE);
     }
 
+#ifdef __TBASE__
+    convert_typmod = GetDatabaseEncoding() != pg_get_client_encoding() &&
+                     pg_get_client_encoding() != PG_SQL_ASCII && IS_PGXC_LOCAL_COORDINATOR;
+#endif
+
+#ifdef __TBASE__
+    /* rows made of fast path columns only never need the buffer */
+    bufferData.data = NULL;
+#else
     buffer = makeStringInfo();
+#endif
     for (i = 0; i < natts; i++)
     {
         Form_pg_attribute attr = slot->tts_tupleDescriptor->attrs[i];
@@ -1449,6 +1614,8 @@ slot_deform_datarow(TupleTableSlot *slot)
             cur += 4;
             len = ntohl(n32);
 
+            if (buffer->data == NULL)
+                initStringInfo(buffer);
             appendBinaryStringInfo(buffer, cur, len);
 
             tupDesc = create_tuple_desc(buffer->data, len);
@@ -1503,15 +1670,31 @@ slot_deform_datarow(TupleTableSlot *slot)
                 slot->tts_values[i] = PointerGetDatum(data);
             }
         }
+#endif
+#ifdef __TBASE__
+        else if (datarow_decode_fast(attr, cur, len, slot->tts_drowcxt,
+                                     &slot->tts_values[i]))
+        {
+            cur += len;
+            slot->tts_isnull[i] = false;
+        }
 #endif
         else
         {
             int typmod = slot->tts_attinmeta->atttypmods[i];
+#ifdef __TBASE__
+            if (buffer->data == NULL)
+                initStringInfo(buffer);
+#endif
             appendBinaryStringInfo(buffer, cur, len);
             cur += len;
 
+#ifdef __TBASE__
+            if (convert_typmod)
+#else
             if (GetDatabaseEncoding() != pg_get_client_encoding() &&
                             pg_get_client_encoding() != PG_SQL_ASCII && IS_PGXC_LOCAL_COORDINATOR)
+#endif
                 typmod = get_typioparam_mod(slot->tts_attinmeta->attioparams[i], typmod);
 
             slot->tts_values[i] = InputFunctionCall(slot->tts_attinmeta->attinfuncs + i,
@@ -1559,8 +1742,13 @@ slot_deform_datarow(TupleTableSlot *slot)
             }
         }
     }
+#ifdef __TBASE__
+    if (buffer->data)
+        pfree(buffer->data);
+#else
     pfree(buffer->data);
     pfree(buffer);
+#endif
 
     slot->tts_nvalid = natts;
 }
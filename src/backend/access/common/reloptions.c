@@ -398,6 +398,26 @@ static relopt_int intRelOpts[] =
         },
         -1, 0, 1024
     },
+#ifdef __TBASE__
+    {
+        {
+            "partition_premake",
+            "Number of future interval partitions the partition maintenance worker keeps created, -1 to use partition_premake",
+            RELOPT_KIND_HEAP,
+            ShareUpdateExclusiveLock
+        },
+        -1, -1, MAX_NUM_INTERVAL_PARTITIONS
+    },
+    {
+        {
+            "partition_retention",
+            "Number of past interval partitions the partition maintenance worker keeps, 0 to keep all",
+            RELOPT_KIND_HEAP,
+            ShareUpdateExclusiveLock
+        },
+        0, 0, MAX_NUM_INTERVAL_PARTITIONS
+    },
+#endif
 
     /* list terminator */
     {{NULL}}
@@ -1427,6 +1447,12 @@ default_reloptions(Datum reloptions, bool validate, relopt_kind kind)
         offsetof(StdRdOptions, user_catalog_table)},
         {"parallel_workers", RELOPT_TYPE_INT,
         offsetof(StdRdOptions, parallel_workers)}
+#ifdef __TBASE__
+        ,{"partition_premake", RELOPT_TYPE_INT,
+        offsetof(StdRdOptions, partition_premake)},
+        {"partition_retention", RELOPT_TYPE_INT,
+        offsetof(StdRdOptions, partition_retention)}
+#endif
     };
 
     options = parseRelOptions(reloptions, validate, kind, &numoptions);
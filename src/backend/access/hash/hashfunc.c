@@ -1052,6 +1052,109 @@ compute_hash(Oid type, Datum value, char locator)
 }
 
 
+#ifdef __TBASE__
+/*
+ * compute_hash_batch()
+ * Compute the hash values of a vector of datums for bulk routing. The result
+ * of each element is the same as compute_hash() would return for it, null
+ * values hash to zero as the single row locators do. The common distribution
+ * key types are hashed inline without the per-row function manager call.
+ */
+void
+compute_hash_batch(Oid type, Datum *values, bool *nulls, int nvalues,
+                   char locator, long *hashvalues)
+{// #lizard forgives
+    int     i;
+    bool    hashed;
+
+#ifdef _MIGRATE_
+    hashed = (locator == LOCATOR_TYPE_HASH || locator == LOCATOR_TYPE_SHARD);
+#else
+    hashed = (locator == LOCATOR_TYPE_HASH);
+#endif
+
+    if (hashed)
+    {
+        switch (type)
+        {
+            case INT4OID:
+                for (i = 0; i < nvalues; i++)
+                {
+                    if (nulls && nulls[i])
+                    {
+                        hashvalues[i] = 0;
+                        continue;
+                    }
+                    hashvalues[i] = (long) hash_uint32((uint32) DatumGetInt32(values[i]));
+                }
+                return;
+
+            case INT8OID:
+                for (i = 0; i < nvalues; i++)
+                {
+                    int64   val;
+                    uint32  lohalf;
+                    uint32  hihalf;
+
+                    if (nulls && nulls[i])
+                    {
+                        hashvalues[i] = 0;
+                        continue;
+                    }
+
+                    /* same folding as hashint8 */
+                    val    = DatumGetInt64(values[i]);
+                    lohalf = (uint32) val;
+                    hihalf = (uint32) (val >> 32);
+                    lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+                    hashvalues[i] = (long) hash_uint32(lohalf);
+                }
+                return;
+
+            case VARCHAROID:
+            case TEXTOID:
+#ifdef _PG_ORCL_
+            case VARCHAR2OID:
+            case NVARCHAR2OID:
+#endif
+                for (i = 0; i < nvalues; i++)
+                {
+                    text   *key;
+
+                    if (nulls && nulls[i])
+                    {
+                        hashvalues[i] = 0;
+                        continue;
+                    }
+
+                    /* same as hashtext */
+                    key = DatumGetTextPP(values[i]);
+                    hashvalues[i] = (long) hash_any((unsigned char *) VARDATA_ANY(key),
+                                                    VARSIZE_ANY_EXHDR(key));
+                    if ((Pointer) key != DatumGetPointer(values[i]))
+                    {
+                        pfree(key);
+                    }
+                }
+                return;
+
+            default:
+                break;
+        }
+    }
+
+    for (i = 0; i < nvalues; i++)
+    {
+        if (nulls && nulls[i])
+        {
+            hashvalues[i] = 0;
+            continue;
+        }
+        hashvalues[i] = (long) compute_hash(type, values[i], locator);
+    }
+}
+#endif
+
 /*
  * get_compute_hash_function
  * Get hash function name depending on the hash type.
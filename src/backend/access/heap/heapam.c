@@ -86,6 +86,9 @@
 #include "access/xact.h"
 #include "pgxc/shardmap.h"
 #endif
+#ifdef _SHARDING_
+#include "storage/extentmapping.h"
+#endif
 #ifdef _MLS_
 #include "catalog/pg_authid.h"
 #include "access/relcryptaccess.h"
@@ -95,6 +98,48 @@
 
 /* GUC variable */
 bool        synchronize_seqscans = true;
+#ifdef _SHARDING_
+int            shard_scan_readahead_extents = 4;
+#endif
+
+#ifdef _SHARDING_
+/*
+ * Shard scan state.
+ *
+ * A shard scan visits only the extents of the chosen shards by following
+ * their scan chains in the extent mapping.  The chain is resolved a few
+ * extents ahead of the block being read (see shard_scan_readahead_extents),
+ * so the blocks of the coming extents can be prefetched while the current
+ * one is being scanned instead of being read one by one as the scan reaches
+ * them.
+ */
+#define SHARD_SCAN_MAX_READAHEAD    64
+#define SHARD_SCAN_PREFETCH_PAGES    128
+
+typedef struct ShardScanStateData
+{
+    int            nshards;
+    ShardID       *shards;            /* shards to scan, in scan order */
+    int            next_shard;        /* next shard whose chain is resolved */
+    ExtentID    last_eid;        /* last extent resolved in current chain */
+
+    /* resolved extents not yet scanned, as a ring */
+    ExtentID    ahead[SHARD_SCAN_MAX_READAHEAD];
+    int            ahead_start;
+    int            ahead_count;
+
+    /* blocks of the extent being scanned */
+    BlockNumber cur_block;
+    BlockNumber cur_end;
+
+    /* prefetch position, pf_idx is -1 while in the current extent */
+    int            pf_idx;
+    BlockNumber pf_block;
+    BlockNumber pf_end;
+    int            pf_distance;    /* prefetched blocks not yet scanned */
+} ShardScanStateData;
+#endif
+
 
 
 static HeapScanDesc heap_beginscan_internal(Relation relation,
@@ -109,6 +154,10 @@ static HeapScanDesc heap_beginscan_internal(Relation relation,
                         bool temp_snap);
 static void heap_parallelscan_startblock_init(HeapScanDesc scan);
 static BlockNumber heap_parallelscan_nextpage(HeapScanDesc scan);
+#ifdef _SHARDING_
+static void heap_shardscan_reset(HeapScanDesc scan);
+static BlockNumber heap_shardscan_nextpage(HeapScanDesc scan, bool skip_extent);
+#endif
 static HeapTuple heap_prepare_insert(Relation relation, HeapTuple tup,
                     TransactionId xid, CommandId cid, int options);
 static XLogRecPtr log_heap_update(Relation reln, Buffer oldbuf,
@@ -316,6 +365,10 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 
     scan->rs_numblocks = InvalidBlockNumber;
     scan->rs_inited = false;
+#ifdef _SHARDING_
+    if (scan->rs_shardscan != NULL)
+        heap_shardscan_reset(scan);
+#endif
 
     scan->rs_ctup.t_data = NULL;
     ItemPointerSetInvalid(&scan->rs_ctup.t_self);
@@ -563,6 +616,20 @@ heapgettup(HeapScanDesc scan,
                     return;
                 }
             }
+#ifdef _SHARDING_
+            else if (scan->rs_shardscan != NULL)
+            {
+                page = heap_shardscan_nextpage(scan, false);
+
+                /* none of the chosen shards has any extent */
+                if (page == InvalidBlockNumber)
+                {
+                    Assert(!BufferIsValid(scan->rs_cbuf));
+                    tuple->t_data = NULL;
+                    return;
+                }
+            }
+#endif
             else
                 page = scan->rs_startblock; /* first page */
             heapgetpage(scan, page);
@@ -590,6 +657,10 @@ heapgettup(HeapScanDesc scan,
     {
         /* backward parallel scan not supported */
         Assert(scan->rs_parallel == NULL);
+#ifdef _SHARDING_
+        if (scan->rs_shardscan != NULL)
+            elog(ERROR, "backward shard scan is not supported");
+#endif
 
         if (!scan->rs_inited)
         {
@@ -748,6 +819,13 @@ heapgettup(HeapScanDesc scan,
             page = heap_parallelscan_nextpage(scan);
             finished = (page == InvalidBlockNumber);
         }
+#ifdef _SHARDING_
+        else if (scan->rs_shardscan != NULL)
+        {
+            page = heap_shardscan_nextpage(scan, false);
+            finished = (page == InvalidBlockNumber);
+        }
+#endif
         else
         {
             page++;
@@ -825,6 +903,11 @@ get_next_page:
                     page = heap_parallelscan_nextpage(scan);
                     finished = (page == InvalidBlockNumber);
                 }
+                else if (scan->rs_shardscan != NULL)
+                {
+                    page = heap_shardscan_nextpage(scan, true);
+                    finished = (page == InvalidBlockNumber);
+                }
                 else if(ScanDirectionIsForward(dir))
                 {
                     if(RelationHasExtent(scan->rs_rd))
@@ -945,6 +1028,20 @@ heapgettup_pagemode(HeapScanDesc scan,
                     return;
                 }
             }
+#ifdef _SHARDING_
+            else if (scan->rs_shardscan != NULL)
+            {
+                page = heap_shardscan_nextpage(scan, false);
+
+                /* none of the chosen shards has any extent */
+                if (page == InvalidBlockNumber)
+                {
+                    Assert(!BufferIsValid(scan->rs_cbuf));
+                    tuple->t_data = NULL;
+                    return;
+                }
+            }
+#endif
             else
                 page = scan->rs_startblock; /* first page */
             heapgetpage(scan, page);
@@ -969,6 +1066,10 @@ heapgettup_pagemode(HeapScanDesc scan,
     {
         /* backward parallel scan not supported */
         Assert(scan->rs_parallel == NULL);
+#ifdef _SHARDING_
+        if (scan->rs_shardscan != NULL)
+            elog(ERROR, "backward shard scan is not supported");
+#endif
 
         if (!scan->rs_inited)
         {
@@ -1116,6 +1217,13 @@ heapgettup_pagemode(HeapScanDesc scan,
             page = heap_parallelscan_nextpage(scan);
             finished = (page == InvalidBlockNumber);
         }
+#ifdef _SHARDING_
+        else if (scan->rs_shardscan != NULL)
+        {
+            page = heap_shardscan_nextpage(scan, false);
+            finished = (page == InvalidBlockNumber);
+        }
+#endif
         else
         {
             page++;
@@ -1191,6 +1299,11 @@ get_next_page:
                     page = heap_parallelscan_nextpage(scan);
                     finished = (page == InvalidBlockNumber);
                 }
+                else if (scan->rs_shardscan != NULL)
+                {
+                    page = heap_shardscan_nextpage(scan, true);
+                    finished = (page == InvalidBlockNumber);
+                }
                 else if(ScanDirectionIsForward(dir))
                 {
                     BlockNumber oldpage = page;
@@ -1670,6 +1783,9 @@ heap_beginscan_internal(Relation relation, Snapshot snapshot,
     scan->rs_allow_sync = allow_sync;
     scan->rs_temp_snap = temp_snap;
     scan->rs_parallel = parallel_scan;
+#ifdef _SHARDING_
+    scan->rs_shardscan = NULL;
+#endif
 
     /*
      * we can use page-at-a-time mode if it's an MVCC-safe snapshot
@@ -1863,6 +1979,14 @@ heap_endscan(HeapScanDesc scan)
     if (scan->rs_temp_snap)
         UnregisterSnapshot(scan->rs_snapshot);
 
+#ifdef _SHARDING_
+    if (scan->rs_shardscan != NULL)
+    {
+        pfree(scan->rs_shardscan->shards);
+        pfree(scan->rs_shardscan);
+    }
+#endif
+
     pfree(scan);
 }
 
@@ -2041,6 +2165,179 @@ heap_parallelscan_nextpage(HeapScanDesc scan)
     return page;
 }
 
+#ifdef _SHARDING_
+/* ----------------
+ *        heap_beginscan_shards - begin a scan over some shards only
+ *
+ *        The scan reads only the extents owned by the given shards, in the
+ *        order of the array and following each shard's extent chain.  Only
+ *        forward scans are supported.
+ * ----------------
+ */
+HeapScanDesc
+heap_beginscan_shards(Relation relation, Snapshot snapshot,
+                      int nkeys, ScanKey key,
+                      int nshards, ShardID *shards)
+{
+    HeapScanDesc scan;
+    ShardScanStateData *ss;
+
+    if (!RelationHasExtent(relation))
+        elog(ERROR, "relation \"%s\" is not organized by shard",
+                    RelationGetRelationName(relation));
+
+    scan = heap_beginscan_internal(relation, snapshot, nkeys, key, NULL,
+                                   true, false, true, false, false, false);
+
+    ss = (ShardScanStateData *) palloc0(sizeof(ShardScanStateData));
+    ss->nshards = nshards;
+    ss->shards = (ShardID *) palloc(sizeof(ShardID) * Max(nshards, 1));
+    if (nshards > 0)
+        memcpy(ss->shards, shards, sizeof(ShardID) * nshards);
+    scan->rs_shardscan = ss;
+    heap_shardscan_reset(scan);
+
+    return scan;
+}
+
+static void
+heap_shardscan_reset(HeapScanDesc scan)
+{
+    ShardScanStateData *ss = scan->rs_shardscan;
+
+    ss->next_shard = 0;
+    ss->last_eid = InvalidExtentID;
+    ss->ahead_start = 0;
+    ss->ahead_count = 0;
+    ss->cur_block = ss->cur_end = 0;
+    ss->pf_idx = -1;
+    ss->pf_block = ss->pf_end = 0;
+    ss->pf_distance = 0;
+}
+
+/*
+ * Resolve the scan chains until shard_scan_readahead_extents extents are
+ * known ahead of the current one, moving on to the next shard whenever a
+ * chain ends.
+ */
+static void
+heap_shardscan_resolve(HeapScanDesc scan)
+{
+    ShardScanStateData *ss = scan->rs_shardscan;
+    int            readahead;
+
+    readahead = Max(1, Min(shard_scan_readahead_extents, SHARD_SCAN_MAX_READAHEAD));
+
+    while (ss->ahead_count < readahead)
+    {
+        ExtentID    eid;
+
+        if (ExtentIdIsValid(ss->last_eid))
+            eid = ema_next_scan(scan->rs_rd, ss->last_eid, false,
+                                NULL, NULL, NULL, NULL);
+        else if (ss->next_shard < ss->nshards)
+            eid = GetShardScanHead(scan->rs_rd, ss->shards[ss->next_shard++]);
+        else
+            break;
+
+        ss->last_eid = eid;
+        if (!ExtentIdIsValid(eid))
+            continue;
+
+        ss->ahead[(ss->ahead_start + ss->ahead_count) % SHARD_SCAN_MAX_READAHEAD] = eid;
+        ss->ahead_count++;
+    }
+}
+
+#ifdef USE_PREFETCH
+/*
+ * Keep up to SHARD_SCAN_PREFETCH_PAGES blocks prefetched ahead of the scan,
+ * crossing into the resolved extents once the current one is covered.
+ */
+static void
+heap_shardscan_prefetch(HeapScanDesc scan)
+{
+    ShardScanStateData *ss = scan->rs_shardscan;
+
+    while (ss->pf_distance < SHARD_SCAN_PREFETCH_PAGES)
+    {
+        if (ss->pf_block >= ss->pf_end)
+        {
+            ExtentID    eid;
+
+            if (ss->pf_idx + 1 >= ss->ahead_count)
+                break;
+
+            ss->pf_idx++;
+            eid = ss->ahead[(ss->ahead_start + ss->pf_idx) % SHARD_SCAN_MAX_READAHEAD];
+            ss->pf_block = EXTENT_FIRST_BLOCKNUMBER(eid);
+            ss->pf_end = Min(ss->pf_block + PAGES_PER_EXTENTS, scan->rs_nblocks);
+            continue;
+        }
+
+        PrefetchBuffer(scan->rs_rd, MAIN_FORKNUM, ss->pf_block);
+        ss->pf_block++;
+        ss->pf_distance++;
+    }
+}
+#endif
+
+/* ----------------
+ *        heap_shardscan_nextpage - get the next page of a shard scan
+ *
+ *        Returns InvalidBlockNumber once all chosen shards are done.  With
+ *        skip_extent the rest of the current extent is skipped, which is what
+ *        the other scans do for new pages and hidden shards.
+ * ----------------
+ */
+static BlockNumber
+heap_shardscan_nextpage(HeapScanDesc scan, bool skip_extent)
+{
+    ShardScanStateData *ss = scan->rs_shardscan;
+
+    Assert(ss != NULL);
+
+    if (skip_extent)
+        ss->cur_block = ss->cur_end;
+
+    while (ss->cur_block >= ss->cur_end)
+    {
+        ExtentID    eid;
+
+        heap_shardscan_resolve(scan);
+        if (ss->ahead_count == 0)
+            return InvalidBlockNumber;
+
+        eid = ss->ahead[ss->ahead_start];
+        ss->ahead_start = (ss->ahead_start + 1) % SHARD_SCAN_MAX_READAHEAD;
+        ss->ahead_count--;
+
+        /* extents allocated after the scan started are not visible anyway */
+        ss->cur_block = EXTENT_FIRST_BLOCKNUMBER(eid);
+        ss->cur_end = Min(ss->cur_block + PAGES_PER_EXTENTS, scan->rs_nblocks);
+
+        if (ss->pf_idx >= 0)
+            ss->pf_idx--;
+        else
+        {
+            /* prefetching never got past the extent we just left */
+            ss->pf_block = ss->cur_block;
+            ss->pf_end = ss->cur_end;
+            ss->pf_distance = 0;
+        }
+    }
+
+    heap_shardscan_resolve(scan);
+#ifdef USE_PREFETCH
+    heap_shardscan_prefetch(scan);
+#endif
+    if (ss->pf_distance > 0)
+        ss->pf_distance--;
+
+    return ss->cur_block++;
+}
+#endif
+
 /* ----------------
  *        heap_update_snapshot
  *
@@ -41,6 +41,12 @@
 #include "pgxc/nodemgr.h"
 #include "access/xlog.h"
 #include "storage/lmgr.h"
+#include "pgstat.h"
+#include "storage/condition_variable.h"
+#include "storage/ipc.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #endif
 
 /* To access sequences */
@@ -1334,11 +1340,14 @@ CloseGTM(void)
 }
 
 #ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
-GTM_Timestamp 
-GetGlobalTimestampGTM(void)
+/*
+ * Ask GTM for a global timestamp over this backend's own connection,
+ * resetting the connection and retrying once on failure.
+ */
+static Get_GTS_Result
+FetchGlobalTimestampGTM(void)
 {// #lizard forgives
     Get_GTS_Result gts_result = {InvalidGlobalTimestamp,false};
-    GTM_Timestamp  latest_gts = InvalidGlobalTimestamp;
     struct rusage start_r;
     struct timeval start_t;
 
@@ -1381,6 +1390,18 @@ GetGlobalTimestampGTM(void)
     if (log_gtm_stats)
         ShowUsageCommon("BeginTranGTM", &start_r, &start_t);
 
+    return gts_result;
+}
+
+/*
+ * Local checks and adjustments applied to every global timestamp handed out
+ * to the caller, whoever fetched it from GTM.
+ */
+static GTM_Timestamp
+AdjustGlobalTimestamp(Get_GTS_Result gts_result)
+{
+	GTM_Timestamp  latest_gts = InvalidGlobalTimestamp;
+
 	latest_gts = GetLatestCommitTS();
 	if (gts_result.gts != InvalidGlobalTimestamp && latest_gts > (gts_result.gts + GTM_CHECK_DELTA))
 	{
@@ -1404,6 +1425,160 @@ GetGlobalTimestampGTM(void)
 	
 	return gts_result.gts;
 }
+
+GTM_Timestamp 
+GetGlobalTimestampGTM(void)
+{
+    return AdjustGlobalTimestamp(FetchGlobalTimestampGTM());
+}
+
+/*
+ * GTS broker
+ *
+ * Snapshot start timestamps only need to be taken after the request for them
+ * was made, so every backend waiting for one at the same moment can share a
+ * single GTM round trip.  The first backend to arrive becomes the leader and
+ * asks GTM over its own connection; backends arriving meanwhile wait on the
+ * condition variable for the answer of the next request issued after they
+ * came, since the one in flight may already have been served by GTM.  The
+ * leader of that next request is whichever waiter wakes up first once the
+ * previous leader is done.
+ *
+ * Commit and prepare timestamps keep going through GetGlobalTimestampGTM(),
+ * as they must stay distinct from the snapshot timestamps of concurrent
+ * transactions.
+ */
+typedef struct GTSBrokerData
+{
+    slock_t            mutex;
+    bool            in_flight;    /* a leader is talking to GTM */
+    uint64            issued;        /* requests started by leaders */
+    uint64            answered;    /* request the result below belongs to */
+    Get_GTS_Result    result;
+    ConditionVariable cv;
+} GTSBrokerData;
+
+bool enable_gts_broker = true;
+
+static GTSBrokerData *GTSBroker = NULL;
+
+Size
+GTSBrokerShmemSize(void)
+{
+    return sizeof(GTSBrokerData);
+}
+
+void
+GTSBrokerShmemInit(void)
+{
+    bool found;
+
+    GTSBroker = (GTSBrokerData *) ShmemInitStruct("GTS Broker",
+                                                  GTSBrokerShmemSize(),
+                                                  &found);
+    if (!found)
+    {
+        SpinLockInit(&GTSBroker->mutex);
+        GTSBroker->in_flight = false;
+        GTSBroker->issued = 0;
+        GTSBroker->answered = 0;
+        GTSBroker->result.gts = InvalidGlobalTimestamp;
+        GTSBroker->result.gtm_readonly = false;
+        ConditionVariableInit(&GTSBroker->cv);
+    }
+}
+
+/*
+ * Give up leadership when the leader fails before publishing a result, so
+ * that one of the waiters takes over.
+ */
+static void
+GTSBrokerAbandon(int code, Datum arg)
+{
+    SpinLockAcquire(&GTSBroker->mutex);
+    GTSBroker->in_flight = false;
+    SpinLockRelease(&GTSBroker->mutex);
+
+    ConditionVariableBroadcast(&GTSBroker->cv);
+}
+
+static Get_GTS_Result
+GTSBrokerFetch(void)
+{// #lizard forgives
+    Get_GTS_Result result;
+    uint64         need;
+    uint64         mine;
+    bool           sleeping = false;
+
+    SpinLockAcquire(&GTSBroker->mutex);
+    need = GTSBroker->issued + 1;
+    for (;;)
+    {
+        if (GTSBroker->answered >= need)
+        {
+            result = GTSBroker->result;
+            SpinLockRelease(&GTSBroker->mutex);
+
+            if (sleeping)
+                ConditionVariableCancelSleep();
+            return result;
+        }
+
+        if (!GTSBroker->in_flight)
+            break;
+
+        SpinLockRelease(&GTSBroker->mutex);
+        ConditionVariableSleep(&GTSBroker->cv, WAIT_EVENT_GTS_BROKER);
+        sleeping = true;
+        SpinLockAcquire(&GTSBroker->mutex);
+    }
+
+    /* Nobody is talking to GTM, lead the next request ourselves */
+    GTSBroker->in_flight = true;
+    mine = ++GTSBroker->issued;
+    SpinLockRelease(&GTSBroker->mutex);
+
+    if (sleeping)
+        ConditionVariableCancelSleep();
+
+    PG_ENSURE_ERROR_CLEANUP(GTSBrokerAbandon, (Datum) 0);
+    {
+        result = FetchGlobalTimestampGTM();
+    }
+    PG_END_ENSURE_ERROR_CLEANUP(GTSBrokerAbandon, (Datum) 0);
+
+    /*
+     * Publish even an invalid result: the waiters would only repeat the
+     * reconnect-and-retry that just failed.
+     */
+    SpinLockAcquire(&GTSBroker->mutex);
+    GTSBroker->result = result;
+    GTSBroker->answered = mine;
+    GTSBroker->in_flight = false;
+    SpinLockRelease(&GTSBroker->mutex);
+
+    ConditionVariableBroadcast(&GTSBroker->cv);
+
+    return result;
+}
+
+/*
+ * Global timestamp to be used as a snapshot start timestamp.  Goes through
+ * the GTS broker when it is enabled.
+ */
+GTM_Timestamp
+GetSnapshotGlobalTimestampGTM(void)
+{
+    Get_GTS_Result gts_result;
+
+    if (enable_gts_broker && GTSBroker != NULL &&
+        IsUnderPostmaster && MyProc != NULL)
+        gts_result = GTSBrokerFetch();
+    else
+        gts_result = FetchGlobalTimestampGTM();
+
+    return AdjustGlobalTimestamp(gts_result);
+}
 #endif
 
 GlobalTransactionId
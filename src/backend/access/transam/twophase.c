@@ -121,6 +121,9 @@
 #include "access/gtm.h"
 #include "utils/timeout.h"
 #endif
+#ifdef __TWO_PHASE_TRANS__
+#include "access/twophase_journal.h"
+#endif
 #include "pgxc/execRemote.h"
 
 
@@ -2277,6 +2280,7 @@ CheckPointTwoPhase(XLogRecPtr redo_horizon)
     fsync_fname(TWOPHASE_DIR, true);
 #ifdef __TWO_PHASE_TRANS__    
     fsync_fname(TWOPHASE_RECORD_DIR, true);
+    CheckPointTwoPhaseJournal();
 #endif
 
     TRACE_POSTGRESQL_TWOPHASE_CHECKPOINT_DONE();
@@ -3137,9 +3141,7 @@ void record_2pc_involved_nodes_xid(const char * tid,
     int ret = 0;
     int size = 0;
     StringInfoData content;
-    struct stat fst;
     char path[MAXPGPATH];
-    off_t fileSize;
     char *result = NULL;
 #ifdef __TWO_PHASE_TESTS__
     XLogRecPtr xlogrec = 0;
@@ -3164,93 +3166,75 @@ void record_2pc_involved_nodes_xid(const char * tid,
         elog(PANIC, "record twophase txn gid: %s, participants is empty", tid);
     }
     
-    /* the 2pc dir is already created in initdb */
-    snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
+    initStringInfo(&content);
+    appendStringInfo(&content, "startnode:%s\n", startnode);
+    appendStringInfo(&content, "startxid:%u\n", startxid);
+    appendStringInfo(&content, "nodes:%s\n", nodestring);
+    appendStringInfo(&content, "xid:%u\n", xid);
 
-    /* if in_pg_clean, then check whether the file exists */
+    /* if in_pg_clean, then check whether the record exists */
     if (g_twophase_state.in_pg_clean)
     {
-        /* if file already exists, check content and return */
-        if (stat(path, &fst) >= 0)
+        /* if record already exists, check content and return */
+        result = get_2pc_record(tid);
+        if (result)
         {
-            fileSize = fst.st_size;
-            result = (char *)palloc0(fileSize + 1);
-            
-            fd = PathNameOpenFile(path, O_RDONLY, S_IRUSR | S_IWUSR);
-            if (fd < 0)
-            {   
-                ereport(ERROR,
-                    (errcode_for_file_access(),
-                    errmsg("could not open file \"%s\" for read", path)));
-            } 
-            ret = FileRead(fd, result, fileSize, WAIT_EVENT_BUFFILE_READ);
-            if(ret != fileSize)
+            if (strncmp(result, content.data, content.len) != 0)
             {
-                ereport(ERROR,
-                    (errcode_for_file_access(),
-                    errmsg("could not read file \"%s\"", path)));
+                elog(ERROR, "pg_clean attemp to write 2pc file conflict with file '%s', "
+                                                    "attemp to write startnode: %s, startxid: %u, "
+                                                    "nodestring: %s, xid: %u", tid, startnode, startxid, nodestring, xid);
             }
-            
-            FileClose(fd);
-            if (result)
+            else
             {
-                initStringInfo(&content);
-                appendStringInfo(&content, "startnode:%s\n", startnode);
-                appendStringInfo(&content, "startxid:%u\n", startxid);
-                appendStringInfo(&content, "nodes:%s\n", nodestring);
-                appendStringInfo(&content, "xid:%u\n", xid);
-                if (strncmp(result, content.data, content.len) != 0)
-                {
-                    elog(ERROR, "pg_clean attemp to write 2pc file conflict with file '%s', "
-                                                        "attemp to write startnode: %s, startxid: %u, "
-                                                        "nodestring: %s, xid: %u", tid, startnode, startxid, nodestring, xid);
-                }
-                else
-                {
-                    resetStringInfo(&content);
-                    pfree(content.data);
-                    return;
-                }
+                pfree(result);
+                pfree(content.data);
+                return;
             }
         }
     }
     
     /*
-     * we open 2pc file under the following two different situations:
+     * a record is created under the following two different situations:
      * a. if in recovery mode, 
-     *  the existed 2pc file can be trucated and reused.
+     *  the existed record can be overwritten.
      * b. if not under recovery progress, 
      *  we not allowed the implicit trans gid existed, 
      *  since the xid in startnode should not be truncate if the twophase trans is part commit or part abort.
+     *
+     * The journal only declines a record when its index is full, in which
+     * case the record goes to a file of its own.
      */
-    if (RecoveryInProgress())
+    if (!enable_2pc_journal ||
+        !TwoPhaseJournalCreate(tid, content.data, RecoveryInProgress()))
     {
-        fd = PathNameOpenFile(path, O_RDWR | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR);
-    }
-    else
-    {
-        fd = PathNameOpenFile(path, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
-    }
-    if (fd < 0)
-    {   
-        elog(ERROR, "could not create 2pc file \"%s\", errMsg:%s", path, strerror(errno));
-        return;
-    }
+        /* the 2pc dir is already created in initdb */
+        snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
 
-    initStringInfo(&content);
-    appendStringInfo(&content, "startnode:%s\n", startnode);
-    appendStringInfo(&content, "startxid:%u\n", startxid);
-    appendStringInfo(&content, "nodes:%s\n", nodestring);
-    appendStringInfo(&content, "xid:%u\n", xid);
-    size = strlen(content.data);
-    ret = FileWrite(fd, content.data, size, WAIT_EVENT_BUFFILE_WRITE);
-    if(ret != size)
-    {
-        elog(ERROR, "could not write 2pc file \"%s\", errMsg:%s", path, strerror(errno));
+        if (RecoveryInProgress())
+        {
+            fd = PathNameOpenFile(path, O_RDWR | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR);
+        }
+        else
+        {
+            fd = PathNameOpenFile(path, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        }
+        if (fd < 0)
+        {   
+            elog(ERROR, "could not create 2pc file \"%s\", errMsg:%s", path, strerror(errno));
+            return;
+        }
+
+        size = strlen(content.data);
+        ret = FileWrite(fd, content.data, size, WAIT_EVENT_BUFFILE_WRITE);
+        if(ret != size)
+        {
+            elog(ERROR, "could not write 2pc file \"%s\", errMsg:%s", path, strerror(errno));
+        }
+        FileClose(fd);
     }
     resetStringInfo(&content);
     pfree(content.data);
-    FileClose(fd);
     
     if (!RecoveryInProgress())
     {
@@ -3288,6 +3272,7 @@ void record_2pc_commit_timestamp(const char *tid, GlobalTimestamp commit_timesta
     int ret;
     int size;
     XLogRecPtr xlogrec = 0;
+    bool journaled;
 #if 0    
     int i;
     GlobalTransaction gxact = NULL;
@@ -3309,9 +3294,13 @@ void record_2pc_commit_timestamp(const char *tid, GlobalTimestamp commit_timesta
     /* the 2pc dir is already created in initdb */
     snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
 
-    /* the 2pc file exists already */ 
-    fd = open(path, O_RDWR | O_APPEND, S_IRUSR | S_IWUSR);//PathNameOpenFile(path, O_RDWR | O_APPEND, S_IRUSR | S_IWUSR);
-    if (fd < 0)
+    /* the 2pc record exists already, either in the journal or in a file */
+    journaled = TwoPhaseJournalExists(tid);
+    if (!journaled)
+    {
+        fd = open(path, O_RDWR | O_APPEND, S_IRUSR | S_IWUSR);//PathNameOpenFile(path, O_RDWR | O_APPEND, S_IRUSR | S_IWUSR);
+    }
+    if (!journaled && fd < 0)
     {   
         if (enable_distri_print)
         {
@@ -3356,6 +3345,15 @@ void record_2pc_commit_timestamp(const char *tid, GlobalTimestamp commit_timesta
         }
     }
 
+    if (journaled)
+    {
+        if (!TwoPhaseJournalSetTimestamp(tid, commit_timestamp))
+        {
+            elog(LOG, "2pc record of \"%s\" was removed before its commit timestamp could be appended", tid);
+        }
+        return;
+    }
+
     if (enable_distri_print)
     {
         read(fd, file_content, 2048);//FileRead(fd, file_content, 2048, WAIT_EVENT_BUFFILE_READ);
@@ -3402,6 +3400,10 @@ void remove_2pc_records(const char * tid, bool record_in_xlog)
         XLogRegisterData((char *)tid, strlen(tid)+1);
         XLogInsert(RM_XLOG_ID, XLOG_CLEAN_2PC_FILE);
     }
+    if (TwoPhaseJournalRemove(tid))
+    {
+        return;
+    }
     if (0 != unlink(path))
     {
         elog(LOG, "node: %s fail to remove 2pc file: %s", PGXCNodeName, tid);
@@ -3430,6 +3432,11 @@ void record_2pc_readonly(const char *gid)
         XLogInsert(RM_XLOG_ID, XLOG_CREATE_2PC_FILE);
     }
 
+    if (enable_2pc_journal &&
+        TwoPhaseJournalCreate(gid, content, RecoveryInProgress()))
+    {
+        return;
+    }
 
     /*
      * we open 2pc file under the following two different situations:
@@ -3462,5 +3469,84 @@ void record_2pc_readonly(const char *gid)
     
 }
 
+/*
+ * Text of the 2pc record of a transaction, as pg_clean reads it, or NULL if
+ * there is none.  The record lives in the journal, or in a file of its own
+ * if it was written without the journal.
+ */
+char *get_2pc_record(const char *tid)
+{
+    char path[MAXPGPATH];
+    struct stat fst;
+    char *result;
+    int fd;
+
+    result = TwoPhaseJournalLookup(tid);
+    if (result)
+    {
+        return result;
+    }
+
+    snprintf(path, MAXPGPATH, TWOPHASE_RECORD_DIR "/%s", tid);
+    fd = OpenTransientFile(path, O_RDONLY | PG_BINARY, 0);
+    if (fd < 0)
+    {
+        if (errno == ENOENT)
+        {
+            return NULL;
+        }
+        ereport(ERROR,
+            (errcode_for_file_access(),
+            errmsg("could not open file \"%s\" for read", path)));
+    }
+    if (fstat(fd, &fst) < 0)
+    {
+        ereport(ERROR,
+            (errcode_for_file_access(),
+            errmsg("could not get status of file \"%s\"", path)));
+    }
+
+    result = (char *)palloc0(fst.st_size + 1);
+    if (read(fd, result, fst.st_size) != fst.st_size)
+    {
+        ereport(ERROR,
+            (errcode_for_file_access(),
+            errmsg("could not read file \"%s\"", path)));
+    }
+    CloseTransientFile(fd);
+
+    return result;
+}
+
+/*
+ * GIDs of all transactions that have a 2pc record, journaled or not.
+ */
+List *get_2pc_record_list(void)
+{
+    List *result;
+    DIR *dir;
+    struct dirent *de;
+
+    result = TwoPhaseJournalGidList();
+
+    dir = AllocateDir(TWOPHASE_RECORD_DIR);
+    if (dir == NULL)
+    {
+        return result;
+    }
+    while ((de = ReadDir(dir, TWOPHASE_RECORD_DIR)) != NULL)
+    {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0 ||
+            strcmp(de->d_name, "journal") == 0)
+        {
+            continue;
+        }
+        result = lappend(result, pstrdup(de->d_name));
+    }
+    FreeDir(dir);
+
+    return result;
+}
+
 #endif
 
@@ -0,0 +1,760 @@
+/*-------------------------------------------------------------------------
+ *
+ * twophase_journal.c
+ *      Append-only journal for the pg_2pc records of distributed transactions
+ *
+ * Every two-phase transaction leaves a short text record describing its
+ * start node and participants, created when it prepares, completed with the
+ * commit timestamp and dropped once it has finished everywhere.  Kept as one
+ * file pg_2pc/<gid> per transaction, these records cost a file creation and
+ * an unlink per distributed commit, and the directory updates they cause are
+ * what a busy node ends up spending its I/O on.
+ *
+ * With enable_2pc_journal the records are appended to segment files under
+ * pg_2pc/journal instead, and a shared hash keyed by GID remembers where the
+ * text of every live record is.  Nothing is fsynced on the commit path: just
+ * like the per-GID files, the records are WAL-logged and redone after a
+ * crash, so the segments only have to be durable up to the redo pointer of
+ * the last checkpoint.  At checkpoint time all segments written since the
+ * previous one are fsynced in one go, the few records still live in older
+ * segments are copied forward into the current segment and the older
+ * segments are unlinked.
+ *
+ * The index is rebuilt from the segments by the first process touching the
+ * journal after startup, before WAL redo applies anything to it.  Appending
+ * then starts in a new segment, so that a record torn by the crash is never
+ * followed by a valid one in the same segment.
+ *
+ * pg_clean does not read pg_2pc itself anymore, but goes through
+ * get_2pc_record() and get_2pc_record_list() of twophase.c, which return the
+ * same text the files contained, whether it comes from the journal or from
+ * a per-GID file.  Such files are still written when the index is full, and
+ * may be left over from before the journal was enabled.
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * IDENTIFICATION
+ *      src/backend/access/transam/twophase_journal.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "access/twophase.h"
+#include "access/twophase_journal.h"
+#include "miscadmin.h"
+#include "port/pg_crc32c.h"
+#include "storage/fd.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/hsearch.h"
+#include "utils/timestamp.h"
+
+#define TWOPHASE_JOURNAL_DIR        "pg_2pc/journal"
+#define TWOPHASE_JOURNAL_SEG_SIZE    (16 * 1024 * 1024)
+
+#define TwoPhaseJournalSegPath(path, segno) \
+    snprintf(path, MAXPGPATH, TWOPHASE_JOURNAL_DIR "/%08X", (segno))
+
+/* journal record types */
+#define TPJ_CREATE        1        /* text of a new record */
+#define TPJ_TIMESTAMP    2        /* commit timestamp of a live record */
+#define TPJ_REMOVE        3        /* the transaction has finished */
+
+/*
+ * Header of a journal record, followed by the GID and, for TPJ_CREATE, the
+ * record text, neither of them terminated.
+ */
+typedef struct TwoPhaseJournalRecord
+{
+    uint32        tot_len;        /* header, GID and text */
+    pg_crc32c    crc;            /* of the whole record with crc zeroed */
+    uint16        gid_len;
+    uint8        type;
+    GlobalTimestamp commit_timestamp;
+} TwoPhaseJournalRecord;
+
+/* index entry of a live record */
+typedef struct TwoPhaseJournalEnt
+{
+    char        gid[GIDSIZE];    /* hash key */
+    uint32        segno;            /* segment holding the record text */
+    uint32        offset;            /* offset of the text in the segment */
+    uint32        len;            /* length of the text */
+    GlobalTimestamp commit_timestamp;    /* or InvalidGlobalTimestamp */
+} TwoPhaseJournalEnt;
+
+/* protected by TwoPhaseJournalLock, as is the index */
+typedef struct TwoPhaseJournalCtlData
+{
+    bool        loaded;            /* index rebuilt from the segments */
+    uint32        oldest_segno;    /* oldest segment that may exist */
+    uint32        unflushed_segno;    /* oldest segment not fsynced yet */
+    uint32        segno;            /* segment being appended to */
+    uint32        insert_offset;    /* end of the data in it */
+} TwoPhaseJournalCtlData;
+
+bool        enable_2pc_journal = true;
+
+static TwoPhaseJournalCtlData *TwoPhaseJournalCtl = NULL;
+static HTAB *TwoPhaseJournalIndex = NULL;
+
+/* segment this backend last appended to */
+static int    journal_fd = -1;
+static uint32 journal_fd_segno = 0;
+
+static long journal_index_size(void);
+static void journal_close_fd(void);
+static void journal_acquire(LWLockMode mode);
+static void journal_load(void);
+static void journal_replay_segment(uint32 segno);
+static uint32 journal_append(uint8 type, const char *gid,
+               GlobalTimestamp commit_timestamp,
+               const char *text, uint32 len);
+static char *journal_read_text(uint32 segno, uint32 offset, uint32 len,
+                  bool missing_ok);
+static void journal_fsync_segment(uint32 segno);
+static int    journal_segno_cmp(const void *a, const void *b);
+
+/*
+ * Live records belong to in-flight distributed transactions, plus the few
+ * that failed and wait for pg_clean.
+ */
+static long
+journal_index_size(void)
+{
+    return Max(1024, 4 * (MaxBackends + max_prepared_xacts));
+}
+
+Size
+TwoPhaseJournalShmemSize(void)
+{
+    Size        size;
+
+    size = MAXALIGN(sizeof(TwoPhaseJournalCtlData));
+    size = add_size(size, hash_estimate_size(journal_index_size(),
+                                             sizeof(TwoPhaseJournalEnt)));
+    return size;
+}
+
+void
+TwoPhaseJournalShmemInit(void)
+{
+    HASHCTL        info;
+    bool        found;
+
+    TwoPhaseJournalCtl = (TwoPhaseJournalCtlData *)
+        ShmemInitStruct("2PC Journal Ctl", sizeof(TwoPhaseJournalCtlData),
+                        &found);
+    if (!found)
+        MemSet(TwoPhaseJournalCtl, 0, sizeof(TwoPhaseJournalCtlData));
+
+    MemSet(&info, 0, sizeof(info));
+    info.keysize = GIDSIZE;
+    info.entrysize = sizeof(TwoPhaseJournalEnt);
+    TwoPhaseJournalIndex = ShmemInitHash("2PC Journal Index",
+                                         journal_index_size(),
+                                         journal_index_size(),
+                                         &info, HASH_ELEM | HASH_FIXED_SIZE);
+}
+
+/*
+ * Forget the segment this backend last appended to, so that it does not keep
+ * a segment open once appending has moved on and the checkpointer may
+ * unlink it.
+ */
+static void
+journal_close_fd(void)
+{
+    if (journal_fd >= 0)
+    {
+        close(journal_fd);
+        journal_fd = -1;
+    }
+}
+
+/*
+ * Take TwoPhaseJournalLock, loading the index first if nobody did yet.
+ */
+static void
+journal_acquire(LWLockMode mode)
+{
+    LWLockAcquire(TwoPhaseJournalLock, mode);
+    if (TwoPhaseJournalCtl->loaded)
+    {
+        if (journal_fd >= 0 && journal_fd_segno != TwoPhaseJournalCtl->segno)
+            journal_close_fd();
+        return;
+    }
+
+    if (mode != LW_EXCLUSIVE)
+    {
+        LWLockRelease(TwoPhaseJournalLock);
+        LWLockAcquire(TwoPhaseJournalLock, LW_EXCLUSIVE);
+    }
+    if (!TwoPhaseJournalCtl->loaded)
+        journal_load();
+    if (mode != LW_EXCLUSIVE)
+    {
+        LWLockRelease(TwoPhaseJournalLock);
+        LWLockAcquire(TwoPhaseJournalLock, mode);
+    }
+}
+
+/*
+ * Rebuild the index by replaying all segments in order.
+ */
+static void
+journal_load(void)
+{
+    DIR           *dir;
+    struct dirent *de;
+    uint32       *segs;
+    int            nsegs = 0;
+    int            maxsegs = 16;
+    int            i;
+
+    if (mkdir(TWOPHASE_JOURNAL_DIR, S_IRWXU) < 0 && errno != EEXIST)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not create directory \"%s\": %m",
+                        TWOPHASE_JOURNAL_DIR)));
+
+    segs = (uint32 *) palloc(maxsegs * sizeof(uint32));
+    dir = AllocateDir(TWOPHASE_JOURNAL_DIR);
+    while ((de = ReadDir(dir, TWOPHASE_JOURNAL_DIR)) != NULL)
+    {
+        if (strlen(de->d_name) != 8 ||
+            strspn(de->d_name, "0123456789ABCDEF") != 8)
+            continue;
+
+        if (nsegs >= maxsegs)
+        {
+            maxsegs *= 2;
+            segs = (uint32 *) repalloc(segs, maxsegs * sizeof(uint32));
+        }
+        segs[nsegs++] = (uint32) strtoul(de->d_name, NULL, 16);
+    }
+    FreeDir(dir);
+
+    qsort(segs, nsegs, sizeof(uint32), journal_segno_cmp);
+    for (i = 0; i < nsegs; i++)
+        journal_replay_segment(segs[i]);
+
+    TwoPhaseJournalCtl->oldest_segno = nsegs > 0 ? segs[0] : 0;
+    TwoPhaseJournalCtl->segno = nsegs > 0 ? segs[nsegs - 1] + 1 : 0;
+    TwoPhaseJournalCtl->unflushed_segno = TwoPhaseJournalCtl->segno;
+    TwoPhaseJournalCtl->insert_offset = 0;
+    TwoPhaseJournalCtl->loaded = true;
+
+    elog(DEBUG1, "loaded %ld 2pc records from %d journal segments",
+         hash_get_num_entries(TwoPhaseJournalIndex), nsegs);
+    pfree(segs);
+}
+
+/*
+ * Apply the records of one segment to the index, stopping at the first one
+ * that is not intact.  Anything after it was written after the last
+ * checkpoint, and WAL redo writes it again.
+ */
+static void
+journal_replay_segment(uint32 segno)
+{// #lizard forgives
+    char        path[MAXPGPATH];
+    struct stat st;
+    char       *buf;
+    uint32        size;
+    uint32        off = 0;
+    int            fd;
+
+    TwoPhaseJournalSegPath(path, segno);
+    fd = OpenTransientFile(path, O_RDONLY | PG_BINARY, 0);
+    if (fd < 0)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not open file \"%s\": %m", path)));
+    if (fstat(fd, &st) < 0)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not stat file \"%s\": %m", path)));
+
+    size = (uint32) Min(st.st_size, TWOPHASE_JOURNAL_SEG_SIZE);
+    buf = palloc(size + 1);
+    if (read(fd, buf, size) != size)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not read file \"%s\": %m", path)));
+    CloseTransientFile(fd);
+
+    while (off + sizeof(TwoPhaseJournalRecord) <= size)
+    {
+        TwoPhaseJournalRecord rec;
+        TwoPhaseJournalEnt *ent;
+        char        gid[GIDSIZE];
+        pg_crc32c    crc;
+        bool        found;
+
+        memcpy(&rec, buf + off, sizeof(rec));
+        if (rec.gid_len == 0 || rec.gid_len >= GIDSIZE ||
+            rec.tot_len < sizeof(rec) + rec.gid_len ||
+            rec.tot_len > size - off)
+            break;
+
+        rec.crc = 0;
+        INIT_CRC32C(crc);
+        COMP_CRC32C(crc, &rec, sizeof(rec));
+        COMP_CRC32C(crc, buf + off + sizeof(rec), rec.tot_len - sizeof(rec));
+        FIN_CRC32C(crc);
+        if (!EQ_CRC32C(crc, ((TwoPhaseJournalRecord *) (buf + off))->crc))
+            break;
+
+        memcpy(gid, buf + off + sizeof(rec), rec.gid_len);
+        gid[rec.gid_len] = '\0';
+
+        switch (rec.type)
+        {
+            case TPJ_CREATE:
+                ent = (TwoPhaseJournalEnt *)
+                    hash_search(TwoPhaseJournalIndex, gid, HASH_FIND, &found);
+                if (!found &&
+                    hash_get_num_entries(TwoPhaseJournalIndex) >= journal_index_size())
+                    ereport(ERROR,
+                            (errcode(ERRCODE_OUT_OF_MEMORY),
+                             errmsg("too many live records in the 2pc journal"),
+                             errhint("Increase max_connections or max_prepared_transactions.")));
+                if (!found)
+                    ent = (TwoPhaseJournalEnt *)
+                        hash_search(TwoPhaseJournalIndex, gid, HASH_ENTER, NULL);
+                ent->segno = segno;
+                ent->offset = off + sizeof(rec) + rec.gid_len;
+                ent->len = rec.tot_len - sizeof(rec) - rec.gid_len;
+                ent->commit_timestamp = rec.commit_timestamp;
+                break;
+
+            case TPJ_TIMESTAMP:
+                ent = (TwoPhaseJournalEnt *)
+                    hash_search(TwoPhaseJournalIndex, gid, HASH_FIND, NULL);
+                if (ent != NULL)
+                    ent->commit_timestamp = rec.commit_timestamp;
+                break;
+
+            case TPJ_REMOVE:
+                hash_search(TwoPhaseJournalIndex, gid, HASH_REMOVE, NULL);
+                break;
+
+            default:
+                elog(WARNING, "unexpected record type %d in 2pc journal segment \"%s\"",
+                     rec.type, path);
+                break;
+        }
+
+        off += rec.tot_len;
+    }
+
+    pfree(buf);
+}
+
+/*
+ * Append a record to the current segment, moving on to a new segment when
+ * it would not fit.  Returns the offset of the record text.  The caller
+ * holds TwoPhaseJournalLock exclusively.
+ */
+static uint32
+journal_append(uint8 type, const char *gid, GlobalTimestamp commit_timestamp,
+               const char *text, uint32 len)
+{
+    TwoPhaseJournalRecord *rec;
+    TwoPhaseJournalCtlData *ctl = TwoPhaseJournalCtl;
+    uint32        gid_len = strlen(gid);
+    uint32        tot_len = sizeof(TwoPhaseJournalRecord) + gid_len + len;
+    uint32        offset;
+    pg_crc32c    crc;
+    char       *buf;
+
+    Assert(gid_len > 0 && gid_len < GIDSIZE);
+
+    if (ctl->insert_offset > 0 &&
+        ctl->insert_offset + tot_len > TWOPHASE_JOURNAL_SEG_SIZE)
+    {
+        ctl->segno++;
+        ctl->insert_offset = 0;
+    }
+
+    if (journal_fd < 0 || journal_fd_segno != ctl->segno)
+    {
+        char        path[MAXPGPATH];
+
+        journal_close_fd();
+        TwoPhaseJournalSegPath(path, ctl->segno);
+        journal_fd = BasicOpenFile(path, O_RDWR | O_CREAT | PG_BINARY,
+                                   S_IRUSR | S_IWUSR);
+        if (journal_fd < 0)
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not open file \"%s\": %m", path)));
+        journal_fd_segno = ctl->segno;
+    }
+
+    buf = palloc0(tot_len);
+    rec = (TwoPhaseJournalRecord *) buf;
+    rec->tot_len = tot_len;
+    rec->gid_len = gid_len;
+    rec->type = type;
+    rec->commit_timestamp = commit_timestamp;
+    memcpy(buf + sizeof(TwoPhaseJournalRecord), gid, gid_len);
+    if (len > 0)
+        memcpy(buf + sizeof(TwoPhaseJournalRecord) + gid_len, text, len);
+
+    INIT_CRC32C(crc);
+    COMP_CRC32C(crc, buf, tot_len);
+    FIN_CRC32C(crc);
+    rec->crc = crc;
+
+    errno = 0;
+    if (lseek(journal_fd, (off_t) ctl->insert_offset, SEEK_SET) < 0 ||
+        write(journal_fd, buf, tot_len) != tot_len)
+    {
+        /* if write didn't set errno, assume problem is no disk space */
+        if (errno == 0)
+            errno = ENOSPC;
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not write to 2pc journal segment %08X: %m",
+                        ctl->segno)));
+    }
+    pfree(buf);
+
+    offset = ctl->insert_offset + sizeof(TwoPhaseJournalRecord) + gid_len;
+    ctl->insert_offset += tot_len;
+
+    return offset;
+}
+
+/*
+ * Read the text of a record.  Segments are only ever appended to, so the text
+ * stays valid for as long as its segment exists.  Without TwoPhaseJournalLock
+ * the checkpointer may have moved the record forward and unlinked the
+ * segment; with missing_ok NULL is returned then.
+ */
+static char *
+journal_read_text(uint32 segno, uint32 offset, uint32 len, bool missing_ok)
+{
+    char        path[MAXPGPATH];
+    char       *text;
+    int            fd;
+
+    TwoPhaseJournalSegPath(path, segno);
+    fd = OpenTransientFile(path, O_RDONLY | PG_BINARY, 0);
+    if (fd < 0 && missing_ok && errno == ENOENT)
+        return NULL;
+    if (fd < 0)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not open file \"%s\": %m", path)));
+
+    text = palloc(len + 1);
+    if (lseek(fd, (off_t) offset, SEEK_SET) < 0 ||
+        read(fd, text, len) != len)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not read file \"%s\": %m", path)));
+    CloseTransientFile(fd);
+    text[len] = '\0';
+
+    return text;
+}
+
+static void
+journal_fsync_segment(uint32 segno)
+{
+    char        path[MAXPGPATH];
+    int            fd;
+
+    TwoPhaseJournalSegPath(path, segno);
+    fd = OpenTransientFile(path, O_RDWR | PG_BINARY, 0);
+    if (fd < 0)
+    {
+        /* nothing was appended to it yet */
+        if (errno == ENOENT)
+            return;
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not open file \"%s\": %m", path)));
+    }
+    if (pg_fsync(fd) != 0)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not fsync file \"%s\": %m", path)));
+    CloseTransientFile(fd);
+}
+
+static int
+journal_segno_cmp(const void *a, const void *b)
+{
+    uint32        sa = *(const uint32 *) a;
+    uint32        sb = *(const uint32 *) b;
+
+    if (sa < sb)
+        return -1;
+    if (sa > sb)
+        return 1;
+    return 0;
+}
+
+/*
+ * Journal the record text of a new transaction.  An existing record of the
+ * same GID is an error unless overwrite is set, as it is during redo.
+ *
+ * Returns false, without writing anything, if the index is full; the caller
+ * then falls back to a per-GID file.
+ */
+bool
+TwoPhaseJournalCreate(const char *gid, const char *text, bool overwrite)
+{
+    TwoPhaseJournalEnt *ent;
+    uint32        len = strlen(text);
+    uint32        offset;
+    bool        found;
+
+    journal_acquire(LW_EXCLUSIVE);
+
+    hash_search(TwoPhaseJournalIndex, gid, HASH_FIND, &found);
+    if (!found &&
+        hash_get_num_entries(TwoPhaseJournalIndex) >= journal_index_size())
+    {
+        LWLockRelease(TwoPhaseJournalLock);
+        return false;
+    }
+    ent = (TwoPhaseJournalEnt *)
+        hash_search(TwoPhaseJournalIndex, gid, HASH_ENTER, &found);
+    if (found && !overwrite)
+    {
+        LWLockRelease(TwoPhaseJournalLock);
+        elog(ERROR, "2pc record of transaction \"%s\" already exists", gid);
+    }
+
+    PG_TRY();
+    {
+        offset = journal_append(TPJ_CREATE, gid, InvalidGlobalTimestamp,
+                                text, len);
+    }
+    PG_CATCH();
+    {
+        if (!found)
+            hash_search(TwoPhaseJournalIndex, gid, HASH_REMOVE, NULL);
+        PG_RE_THROW();
+    }
+    PG_END_TRY();
+
+    ent->segno = TwoPhaseJournalCtl->segno;
+    ent->offset = offset;
+    ent->len = len;
+    ent->commit_timestamp = InvalidGlobalTimestamp;
+
+    LWLockRelease(TwoPhaseJournalLock);
+    return true;
+}
+
+bool
+TwoPhaseJournalExists(const char *gid)
+{
+    bool        found;
+
+    journal_acquire(LW_SHARED);
+    hash_search(TwoPhaseJournalIndex, gid, HASH_FIND, &found);
+    LWLockRelease(TwoPhaseJournalLock);
+
+    return found;
+}
+
+/*
+ * Journal the commit timestamp of a live record.  Returns false if there is
+ * no such record in the journal.
+ */
+bool
+TwoPhaseJournalSetTimestamp(const char *gid, GlobalTimestamp commit_timestamp)
+{
+    TwoPhaseJournalEnt *ent;
+
+    journal_acquire(LW_EXCLUSIVE);
+
+    ent = (TwoPhaseJournalEnt *)
+        hash_search(TwoPhaseJournalIndex, gid, HASH_FIND, NULL);
+    if (ent == NULL)
+    {
+        LWLockRelease(TwoPhaseJournalLock);
+        return false;
+    }
+
+    journal_append(TPJ_TIMESTAMP, gid, commit_timestamp, NULL, 0);
+    ent->commit_timestamp = commit_timestamp;
+
+    LWLockRelease(TwoPhaseJournalLock);
+    return true;
+}
+
+/*
+ * Drop a record.  Returns false if there is no such record in the journal.
+ */
+bool
+TwoPhaseJournalRemove(const char *gid)
+{
+    bool        found;
+
+    journal_acquire(LW_EXCLUSIVE);
+
+    hash_search(TwoPhaseJournalIndex, gid, HASH_FIND, &found);
+    if (found)
+    {
+        journal_append(TPJ_REMOVE, gid, InvalidGlobalTimestamp, NULL, 0);
+        hash_search(TwoPhaseJournalIndex, gid, HASH_REMOVE, NULL);
+    }
+
+    LWLockRelease(TwoPhaseJournalLock);
+    return found;
+}
+
+/*
+ * Text of a record as the per-GID file would have it, or NULL if there is no
+ * such record in the journal.
+ *
+ * The location of the text is copied under TwoPhaseJournalLock and the text
+ * read after releasing it, so that the file I/O does not hold up commits.
+ * Should the checkpointer have moved the record meanwhile, look it up again.
+ */
+char *
+TwoPhaseJournalLookup(const char *gid)
+{
+    TwoPhaseJournalEnt *ent;
+    char       *text = NULL;
+    uint32        segno;
+    uint32        offset;
+    uint32        len;
+    GlobalTimestamp commit_timestamp;
+
+    while (text == NULL)
+    {
+        journal_acquire(LW_SHARED);
+
+        ent = (TwoPhaseJournalEnt *)
+            hash_search(TwoPhaseJournalIndex, gid, HASH_FIND, NULL);
+        if (ent == NULL)
+        {
+            LWLockRelease(TwoPhaseJournalLock);
+            return NULL;
+        }
+        segno = ent->segno;
+        offset = ent->offset;
+        len = ent->len;
+        commit_timestamp = ent->commit_timestamp;
+
+        LWLockRelease(TwoPhaseJournalLock);
+
+        text = journal_read_text(segno, offset, len, true);
+    }
+
+    if (GlobalTimestampIsValid(commit_timestamp))
+    {
+        char       *result;
+
+        result = psprintf("%sglobal_commit_timestamp:" INT64_FORMAT "\n",
+                          text, commit_timestamp);
+        pfree(text);
+        return result;
+    }
+
+    return text;
+}
+
+/*
+ * GIDs of all live records in the journal.
+ */
+List *
+TwoPhaseJournalGidList(void)
+{
+    HASH_SEQ_STATUS status;
+    TwoPhaseJournalEnt *ent;
+    List       *result = NIL;
+
+    journal_acquire(LW_SHARED);
+
+    hash_seq_init(&status, TwoPhaseJournalIndex);
+    while ((ent = (TwoPhaseJournalEnt *) hash_seq_search(&status)) != NULL)
+        result = lappend(result, pstrdup(ent->gid));
+
+    LWLockRelease(TwoPhaseJournalLock);
+    return result;
+}
+
+/*
+ * Make the journal durable up to now and get rid of the segments that were
+ * complete at the previous checkpoint.
+ *
+ * Live records of those segments are appended to the current one again,
+ * together with their commit timestamp, before everything written since the
+ * previous checkpoint is fsynced.  Only then are the old segments unlinked.
+ */
+void
+CheckPointTwoPhaseJournal(void)
+{
+    HASH_SEQ_STATUS status;
+    TwoPhaseJournalEnt *ent;
+    char        path[MAXPGPATH];
+    uint32        oldest;
+    uint32        cutoff;
+    uint32        flush_from;
+    uint32        flush_upto;
+    uint32        segno;
+
+    journal_acquire(LW_EXCLUSIVE);
+
+    oldest = TwoPhaseJournalCtl->oldest_segno;
+    cutoff = TwoPhaseJournalCtl->segno;
+    if (oldest < cutoff)
+    {
+        hash_seq_init(&status, TwoPhaseJournalIndex);
+        while ((ent = (TwoPhaseJournalEnt *) hash_seq_search(&status)) != NULL)
+        {
+            char       *text;
+
+            if (ent->segno >= cutoff)
+                continue;
+
+            text = journal_read_text(ent->segno, ent->offset, ent->len, false);
+            ent->offset = journal_append(TPJ_CREATE, ent->gid,
+                                         ent->commit_timestamp,
+                                         text, ent->len);
+            ent->segno = TwoPhaseJournalCtl->segno;
+            pfree(text);
+        }
+    }
+    flush_from = TwoPhaseJournalCtl->unflushed_segno;
+    flush_upto = TwoPhaseJournalCtl->segno;
+
+    LWLockRelease(TwoPhaseJournalLock);
+
+    for (segno = flush_from; segno <= flush_upto; segno++)
+        journal_fsync_segment(segno);
+
+    for (segno = oldest; segno < cutoff; segno++)
+    {
+        TwoPhaseJournalSegPath(path, segno);
+        if (unlink(path) < 0 && errno != ENOENT)
+            ereport(LOG,
+                    (errcode_for_file_access(),
+                     errmsg("could not remove file \"%s\": %m", path)));
+    }
+    fsync_fname(TWOPHASE_JOURNAL_DIR, true);
+
+    /* the segment being appended to is fsynced again next time */
+    LWLockAcquire(TwoPhaseJournalLock, LW_EXCLUSIVE);
+    TwoPhaseJournalCtl->unflushed_segno =
+        Max(TwoPhaseJournalCtl->unflushed_segno, flush_upto);
+    TwoPhaseJournalCtl->oldest_segno =
+        Max(TwoPhaseJournalCtl->oldest_segno, cutoff);
+    LWLockRelease(TwoPhaseJournalLock);
+}
@@ -30,6 +30,7 @@
 #include "gtm/gtm_gxid.h"
 #include "pgxc/execRemote.h"
 #include "pgxc/pause.h"
+#include "pgxc/commit_latency.h"
 /* PGXC_DATANODE */
 #include "postmaster/autovacuum.h"
 #include "libpq/pqformat.h"
@@ -70,6 +71,9 @@
 #include "storage/procarray.h"
 #include "storage/sinvaladt.h"
 #include "storage/smgr.h"
+#ifdef _SHARDING_
+#include "storage/extentmapping.h"
+#endif
 #ifdef XCP
 #include "tcop/tcopprot.h"
 #endif
@@ -930,6 +934,18 @@ AssignTransactionId(TransactionState s)
     if (!isSubXact)
         RegisterPredicateLockingXid(s->transactionId);
 
+#ifdef __TBASE__
+    /*
+     * Let the coordinator know this datanode is writing.  Participants that
+     * never report an xid are committed as read-only, without PREPARE.  Only
+     * sent when the coordinator asked for it, older ones do not know 'w'.
+     */
+    if (!isSubXact && IS_PGXC_DATANODE && IsConnFromCoord() &&
+        whereToSendOutput == DestRemote &&
+        (g_RemoteFeatures & REMOTE_FEATURE_XID_REPORT))
+        pq_putemptymessage('w');
+#endif
+
     /*
      * Acquire lock on the transaction XID.  (We assume this cannot block.) We
      * have to ensure that the lock is assigned to the transaction's own
@@ -1824,7 +1840,11 @@ RecordTransactionCommit(void)
             }
             else
             {
+                instr_time  latency_start;
+
+                CommitLatencyStart(latency_start);
                 global_committs = GetGlobalTimestampGTM();
+                CommitLatencyRecord(COMMIT_LATENCY_GTS, latency_start);
             }
     
             if(!GlobalTimestampIsValid(global_committs)){
@@ -2868,6 +2888,10 @@ CommitTransaction(void)
 
     /* close large objects before lower-level cleanup */
     AtEOXact_LargeObject(true);
+#ifdef _SHARDING_
+    /* forget the free extents remembered for allocation */
+    AtEOXact_ExtentReservations(true);
+#endif
 
     /*
      * Mark serializable transaction as complete for predicate locking
@@ -3352,6 +3376,10 @@ PrepareTransaction(void)
 
     /* close large objects before lower-level cleanup */
     AtEOXact_LargeObject(true);
+#ifdef _SHARDING_
+    /* forget the free extents remembered for allocation */
+    AtEOXact_ExtentReservations(true);
+#endif
 
     /*
      * Mark serializable transaction as complete for predicate locking
@@ -3971,6 +3999,10 @@ AbortTransaction(void)
     }
 
     AtEOXact_LargeObject(false);
+#ifdef _SHARDING_
+    /* forget the free extents remembered for allocation */
+    AtEOXact_ExtentReservations(false);
+#endif
     AtAbort_Notify();
     AtEOXact_RelationMap(false);
     AtAbort_Twophase();
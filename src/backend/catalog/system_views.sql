@@ -899,6 +899,9 @@ CREATE VIEW pg_stat_progress_vacuum AS
     FROM pg_stat_get_progress_info('VACUUM') AS S
 		LEFT JOIN pg_database D ON S.datid = D.oid;
 
+CREATE VIEW pg_stat_commit_latency AS
+    SELECT * FROM tbase_commit_latency();
+
 CREATE VIEW pg_user_mappings AS
     SELECT
         U.oid       AS umid,
@@ -62,6 +62,7 @@
 #include "storage/fd.h"
 #include "tcop/tcopprot.h"
 #include "utils/builtins.h"
+#include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/portal.h"
@@ -278,6 +279,30 @@ typedef struct
     uint64        processed;        /* # of tuples processed */
 } DR_copy;
 
+#ifdef __TBASE__
+/*
+ * Rows read by COPY FROM on the coordinator are buffered here, so that their
+ * target datanodes can be computed for the whole batch with one
+ * GET_NODES_BATCH call instead of one locator call per row.
+ */
+#define COPY_ROUTE_BATCH_ROWS   1000
+#define COPY_ROUTE_BATCH_BYTES  (64 * 1024)
+
+typedef struct CopyRouteBatch
+{
+    MemoryContext   context;        /* holds keys of pass-by-ref types */
+    bool            typbyval;       /* distribution column type info */
+    int16           typlen;
+    int             nrows;
+    Datum           values[COPY_ROUTE_BATCH_ROWS];
+    bool            nulls[COPY_ROUTE_BATCH_ROWS];
+    PGXCNodeHandle *targets[COPY_ROUTE_BATCH_ROWS];
+    int             linenos[COPY_ROUTE_BATCH_ROWS]; /* for error context */
+    int             offsets[COPY_ROUTE_BATCH_ROWS + 1];
+    StringInfoData  lines;          /* concatenated row data */
+} CopyRouteBatch;
+#endif
+
 
 /*
  * These macros centralize code used to process line_buf and raw_buf buffers.
@@ -375,6 +400,12 @@ static void CopyFromInsertBatch(CopyState cstate, EState *estate,
                     BulkInsertState bistate,
                     int nBufferedTuples, HeapTuple *bufferedTuples,
                     int firstBufferedLineNo);
+#ifdef __TBASE__
+static CopyRouteBatch *CopyFromInitRouteBatch(CopyState cstate, TupleDesc tupDesc);
+static void CopyFromRouteBatchAdd(CopyState cstate, CopyRouteBatch *batch,
+                    Datum value, bool isnull);
+static void CopyFromFlushRouteBatch(CopyState cstate, CopyRouteBatch *batch);
+#endif
 static bool CopyReadLine(CopyState cstate);
 static bool CopyReadLineText(CopyState cstate);
 #ifdef __TBASE__
@@ -2975,6 +3006,7 @@ CopyFrom(CopyState cstate)
     int         npart             = 0;
     bool        need_to_reset     = false;
     bool        nomore            = false;
+    CopyRouteBatch *routebatch    = NULL;
 #endif
 
     Assert(cstate->rel);
@@ -3237,6 +3269,9 @@ CopyFrom(CopyState cstate)
     }
 #endif
     econtext = GetPerTupleExprContext(estate);
+#ifdef __TBASE__
+    routebatch = CopyFromInitRouteBatch(cstate, tupDesc);
+#endif
 
     /* Set up callback to identify error line number */
     errcallback.callback = CopyFromErrorCallback;
@@ -3369,6 +3404,13 @@ readnextline:
             }
 #endif
 
+#ifdef __TBASE__
+            if (routebatch)
+            {
+                CopyFromRouteBatchAdd(cstate, routebatch, value, isnull);
+            }
+            else
+#endif
             if (DataNodeCopyIn(cstate->line_buf.data,
                                cstate->line_buf.len,
 #ifdef __COLD_HOT__
@@ -3804,6 +3846,17 @@ readnextline:
         }
 #endif
     }
+#ifdef __TBASE__
+    /* Send the rows still waiting for routing */
+    if (routebatch)
+    {
+        CopyFromFlushRouteBatch(cstate, routebatch);
+        MemoryContextDelete(routebatch->context);
+        pfree(routebatch->lines.data);
+        pfree(routebatch);
+        routebatch = NULL;
+    }
+#endif
     /* Flush any remaining buffered tuples */
 #ifdef __TBASE__
     if(IS_PGXC_DATANODE && npart > 0)
@@ -4012,6 +4065,146 @@ readnextline:
     return processed;
 }
 
+#ifdef __TBASE__
+/*
+ * Set up row batching for routing COPY FROM data on the coordinator. NULL is
+ * returned when the locator of the relation can not route a batch of values,
+ * or when erroneous lines are skipped, rows are sent one by one then.
+ */
+static CopyRouteBatch *
+CopyFromInitRouteBatch(CopyState cstate, TupleDesc tupDesc)
+{
+    RemoteCopyData *rcstate = cstate->remoteCopyState;
+    CopyRouteBatch *batch;
+    AttrNumber      dist_col;
+
+    if (!IS_PGXC_COORDINATOR || rcstate == NULL || rcstate->rel_loc == NULL ||
+        rcstate->locator == NULL)
+    {
+        return NULL;
+    }
+
+    /* a row must fail while it is the current line to be skipped */
+    if (g_enable_copy_silence)
+    {
+        return NULL;
+    }
+
+    dist_col = rcstate->rel_loc->partAttrNum;
+    if (!AttributeNumberIsValid(dist_col) ||
+#ifdef __COLD_HOT__
+        AttributeNumberIsValid(rcstate->rel_loc->secAttrNum) ||
+#endif
+        !LocatorSupportsBatch(rcstate->locator))
+    {
+        return NULL;
+    }
+
+    batch = (CopyRouteBatch *) palloc0(sizeof(CopyRouteBatch));
+    batch->context = AllocSetContextCreate(CurrentMemoryContext,
+                                           "COPY route batch",
+                                           ALLOCSET_DEFAULT_SIZES);
+    batch->typbyval = tupDesc->attrs[dist_col - 1]->attbyval;
+    batch->typlen   = tupDesc->attrs[dist_col - 1]->attlen;
+    initStringInfo(&batch->lines);
+    return batch;
+}
+
+/*
+ * Buffer the current line of the COPY stream together with its distribution
+ * key, flushing the batch to the datanodes once it is full.
+ */
+static void
+CopyFromRouteBatchAdd(CopyState cstate, CopyRouteBatch *batch,
+                      Datum value, bool isnull)
+{
+    int             row = batch->nrows;
+
+    if (isnull)
+    {
+        batch->values[row] = (Datum) 0;
+    }
+    else if (batch->typbyval)
+    {
+        batch->values[row] = value;
+    }
+    else
+    {
+        MemoryContext oldcontext = MemoryContextSwitchTo(batch->context);
+
+        batch->values[row] = datumCopy(value, false, batch->typlen);
+        MemoryContextSwitchTo(oldcontext);
+    }
+    batch->nulls[row] = isnull;
+    batch->linenos[row] = cstate->cur_lineno;
+
+    batch->offsets[row] = batch->lines.len;
+    appendBinaryStringInfo(&batch->lines, cstate->line_buf.data,
+                           cstate->line_buf.len);
+    batch->nrows++;
+
+    if (batch->nrows >= COPY_ROUTE_BATCH_ROWS ||
+        batch->lines.len >= COPY_ROUTE_BATCH_BYTES)
+    {
+        CopyFromFlushRouteBatch(cstate, batch);
+    }
+}
+
+/*
+ * Route all buffered rows with one locator call and send them to their
+ * datanodes in the order they were read.
+ */
+static void
+CopyFromFlushRouteBatch(CopyState cstate, CopyRouteBatch *batch)
+{
+    RemoteCopyData *rcstate = cstate->remoteCopyState;
+    int             save_cur_lineno;
+    int             i;
+
+    if (batch->nrows == 0)
+    {
+        return;
+    }
+
+    /*
+     * Report errors against the line of the row being sent, not the current
+     * one. Routing does not fail for single values, its errors are reported
+     * against the first row of the batch.
+     */
+    cstate->line_buf_valid = false;
+    save_cur_lineno = cstate->cur_lineno;
+    cstate->cur_lineno = batch->linenos[0];
+
+    if (!GET_NODES_BATCH(rcstate->locator, batch->values, batch->nulls,
+                         batch->nrows, batch->targets))
+    {
+        elog(ERROR, "locator of COPY does not support batch routing");
+    }
+
+    batch->offsets[batch->nrows] = batch->lines.len;
+    for (i = 0; i < batch->nrows; i++)
+    {
+        PGXCNodeHandle *handle = batch->targets[i];
+
+        cstate->cur_lineno = batch->linenos[i];
+        if (DataNodeCopyIn(batch->lines.data + batch->offsets[i],
+                           batch->offsets[i + 1] - batch->offsets[i],
+                           1, &handle,
+                           (cstate->binary || cstate->insert_into)))
+        {
+            ereport(ERROR,
+                        (errcode(ERRCODE_CONNECTION_EXCEPTION),
+                         errmsg("Copy failed on a data node:%s;", handle->error)));
+        }
+    }
+
+    cstate->cur_lineno = save_cur_lineno;
+    batch->nrows = 0;
+    resetStringInfo(&batch->lines);
+    MemoryContextReset(batch->context);
+}
+#endif
+
 /*
  * A subroutine of CopyFrom, to write the current batch of buffered heap
  * tuples to the heap. Also updates indexes and runs AFTER ROW INSERT
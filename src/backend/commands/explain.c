@@ -93,6 +93,10 @@ static void show_sort_keys(SortState *sortstate, List *ancestors,
                ExplainState *es);
 static void show_simple_sort_keys(RemoteSubplanState *remotestate,
                List *ancestors, ExplainState *es);
+#ifdef __TBASE__
+static void show_remote_setup_info(RemoteSubplanState *remotestate,
+               ExplainState *es);
+#endif
 static void show_merge_append_keys(MergeAppendState *mstate, List *ancestors,
                        ExplainState *es);
 static void show_agg_keys(AggState *astate, List *ancestors,
@@ -1619,6 +1623,11 @@ ExplainNode(PlanState *planstate, List *ancestors,
                 if (es->verbose)
                     show_simple_sort_keys((RemoteSubplanState *)planstate,
                                           ancestors, es);
+#ifdef __TBASE__
+                if (es->analyze && es->timing)
+                    show_remote_setup_info((RemoteSubplanState *) planstate,
+                                           es);
+#endif
             }
             break;
 #endif
@@ -2165,6 +2174,37 @@ show_sort_keys(SortState *sortstate, List *ancestors, ExplainState *es)
                          ancestors, es);
 }
 
+#ifdef __TBASE__
+/*
+ * Show how long it took to start the remote transactions and to ship the
+ * subplan to the nodes executing it.
+ */
+static void
+show_remote_setup_info(RemoteSubplanState *remotestate, ExplainState *es)
+{
+    if (remotestate->setup_nodes == 0)
+        return;
+
+    if (es->format != EXPLAIN_FORMAT_TEXT)
+    {
+        ExplainPropertyInteger("Setup Nodes", remotestate->setup_nodes, es);
+        ExplainPropertyFloat("Setup Begin Time",
+                             remotestate->setup_begin_time, 3, es);
+        ExplainPropertyFloat("Setup Dispatch Time",
+                             remotestate->setup_dispatch_time, 3, es);
+    }
+    else
+    {
+        appendStringInfoSpaces(es->str, es->indent * 2);
+        appendStringInfo(es->str,
+                         "Remote Setup: nodes=%d begin=%.3f ms dispatch=%.3f ms\n",
+                         remotestate->setup_nodes,
+                         remotestate->setup_begin_time,
+                         remotestate->setup_dispatch_time);
+    }
+}
+#endif
+
 /*
  * Show the sort keys for a SimpleSort node.
  */
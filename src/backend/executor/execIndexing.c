@@ -291,7 +291,9 @@ ExecOpenIndices(ResultRelInfo *resultRelInfo, bool speculative)
             temp_bms = bms_copy(resultRelInfo->partpruning);
             while((partidx = bms_first_member(temp_bms))>=0)
             {
-                ExecOpenIndices(resultRelInfo->part_relinfo[partidx], speculative);
+                /* not built yet if opened on first route */
+                if(resultRelInfo->part_relinfo[partidx])
+                    ExecOpenIndices(resultRelInfo->part_relinfo[partidx], speculative);
             }
 
             bms_free(temp_bms);
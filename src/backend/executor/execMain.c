@@ -1002,6 +1002,8 @@ InitPlan(QueryDesc *queryDesc, int eflags)
             {
                 resultRelInfo->ispartparent = true;
                 resultRelInfo->partpruning = bms_copy(plannedstmt->partpruning);
+                /* rows are routed by ExecInsert, which opens what it needs */
+                resultRelInfo->part_lazy = (operation == CMD_INSERT);
             }
             resultRelInfo->operation = operation;
 #endif
@@ -1569,8 +1571,22 @@ InitResultRelInfo(ResultRelInfo *resultRelInfo,
         
         resultRelInfo->part_relinfo= (ResultRelInfo**)palloc0(resultRelInfo->partarraysize * sizeof(void*));
 
+        /*
+         * With the expanding model, a statement may target every partition
+         * but touch only a few; leave the entries to ExecInitPartitionResultRel
+         * then, so that the others are neither opened nor locked.
+         */
+        if(resultRelInfo->arraymode == RESULT_RELINFO_MODE_EXPAND
+            && resultRelInfo->part_lazy)
+        {
+            bms_free(temp_bms);
+            temp_bms = NULL;
+        }
+        else
+            resultRelInfo->part_lazy = false;
+
         arrayidx = 0;
-        while((partidx = bms_first_member(temp_bms))>=0)
+        while(temp_bms && (partidx = bms_first_member(temp_bms))>=0)
         {
             resultpartinfo = (ResultRelInfo*)makeNode(ResultRelInfo);
             partoid = RelationGetPartition(resultRelationDesc, partidx, false);
@@ -1606,6 +1622,58 @@ InitResultRelInfo(ResultRelInfo *resultRelInfo,
 
 }
 
+#ifdef __TBASE__
+/*
+ * Build the ResultRelInfo of an interval partition that was left to be
+ * opened on first route, see InitResultRelInfo.  Returns NULL if the
+ * partition is not a target of the statement or does not exist anymore.
+ */
+ResultRelInfo *
+ExecInitPartitionResultRel(EState *estate, ResultRelInfo *parent, int partidx,
+                           bool speculative)
+{
+    ResultRelInfo *resultpartinfo;
+    MemoryContext oldcontext;
+    Oid         partoid;
+    Relation    partrel;
+
+    Assert(parent->ispartparent && parent->part_lazy);
+
+    if(partidx >= parent->partarraysize
+        || !bms_is_member(partidx, parent->partpruning))
+        return NULL;
+
+    if(parent->part_relinfo[partidx])
+        return parent->part_relinfo[partidx];
+
+    partoid = RelationGetPartition(parent->ri_RelationDesc, partidx, false);
+    if(!OidIsValid(partoid))
+        return NULL;
+
+    oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+    partrel = heap_open(partoid, RowExclusiveLock);
+
+    resultpartinfo = (ResultRelInfo*)makeNode(ResultRelInfo);
+    resultpartinfo->ispartparent = false;
+    resultpartinfo->operation = parent->operation;
+    resultpartinfo->part_index = partidx;
+    InitResultRelInfo(resultpartinfo, partrel, parent->ri_RangeTableIndex,
+                      parent->ri_PartitionRoot, estate->es_instrument);
+
+    /* the parent's indexes are open, so must the partition's be */
+    if(parent->ri_NumIndices > 0)
+        ExecOpenIndices(resultpartinfo, speculative);
+    resultpartinfo->ri_projectReturning = parent->ri_projectReturning;
+
+    parent->part_relinfo[partidx] = resultpartinfo;
+
+    MemoryContextSwitchTo(oldcontext);
+
+    return resultpartinfo;
+}
+#endif
+
 /*
  *        ExecGetTriggerResultRel
  *
@@ -0,0 +1,274 @@
+/*-------------------------------------------------------------------------
+ *
+ * execRuntimeFilter.c
+ *      Bloom filters pushed from a hash join build side down to the
+ *      producers of the probe side RemoteSubplan
+ *
+ * When the outer side of a hash join is a RemoteSubplan, every outer row is
+ * scanned, redistributed through a shared queue and shipped over the network
+ * only to be thrown away by the join if the (usually small) inner side has no
+ * match for it.  Once the hash table is built, nodeHashjoin.c summarizes the
+ * inner hash values in a bloom filter and ships it to the remote nodes ahead
+ * of the first Bind of the RemoteSubplan.  The producers of the subplan test
+ * each tuple against the filter of the consumer it is headed to and drop the
+ * tuples that cannot find a join partner before they are written to the
+ * shared queue.
+ *
+ * On the remote node the filter arrives as a protocol message just before the
+ * Bind it belongs to and is kept here as the "pending" filter.  PortalStart
+ * then either takes it for the local (SQ_CONS_SELF) consumer of a producer, or
+ * publishes it in a DSM segment whose handle a consumer session advertises in
+ * its shared queue slot, where the producer picks it up.
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * IDENTIFICATION
+ *      src/backend/executor/execRuntimeFilter.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "executor/execRuntimeFilter.h"
+#include "libpq/pqformat.h"
+#include "storage/dsm_impl.h"
+#include "utils/memutils.h"
+
+#define RUNTIME_FILTER_MAGIC    0x52544652    /* "RTFR" */
+
+bool        enable_runtime_filter = true;
+int            runtime_filter_max_rows = 1000000;
+
+/* filter received for the next Bind, kept in TopMemoryContext */
+static char *pending_filter = NULL;
+static int    pending_filter_len = 0;
+
+/*
+ * Serialize a filter.  The hash functions are those of the probe side
+ * (outer) key columns, and must produce hash values comparable to the ones
+ * the bloom filter was populated with.
+ */
+char *
+RuntimeFilterSerialize(int nkeys, AttrNumber *keyattnos, Oid *hashfuncids,
+                       bloom_filter *bloom, int *len)
+{
+    StringInfoData buf;
+    int            i;
+
+    initStringInfo(&buf);
+    pq_sendint(&buf, RUNTIME_FILTER_MAGIC, 4);
+    pq_sendint(&buf, nkeys, 4);
+    for (i = 0; i < nkeys; i++)
+    {
+        pq_sendint(&buf, keyattnos[i], 2);
+        pq_sendint(&buf, hashfuncids[i], 4);
+    }
+    pq_sendbytes(&buf, (char *) bloom, bloom_total_size(bloom));
+
+    *len = buf.len;
+    return buf.data;
+}
+
+/*
+ * Rebuild the local form of a serialized filter in the current memory
+ * context.  Returns NULL if the data is not a usable filter; filtering is
+ * only an optimization, so a bad filter is never a reason to fail the query.
+ */
+RuntimeFilter *
+RuntimeFilterDeserialize(const char *data, int len)
+{
+    RuntimeFilter *filter;
+    StringInfoData buf;
+    int            nkeys;
+    int            i;
+
+    buf.data = (char *) data;
+    buf.len = len;
+    buf.maxlen = len;
+    buf.cursor = 0;
+
+    if (len < 8 || pq_getmsgint(&buf, 4) != RUNTIME_FILTER_MAGIC)
+        return NULL;
+
+    nkeys = pq_getmsgint(&buf, 4);
+    if (nkeys <= 0 || nkeys > (len - buf.cursor) / 6)
+        return NULL;
+
+    filter = (RuntimeFilter *) palloc0(sizeof(RuntimeFilter));
+    filter->nkeys = nkeys;
+    filter->keyattnos = (AttrNumber *) palloc(nkeys * sizeof(AttrNumber));
+    filter->hashfunctions = (FmgrInfo *) palloc(nkeys * sizeof(FmgrInfo));
+    for (i = 0; i < nkeys; i++)
+    {
+        filter->keyattnos[i] = (AttrNumber) pq_getmsgint(&buf, 2);
+        fmgr_info((Oid) pq_getmsgint(&buf, 4), &filter->hashfunctions[i]);
+    }
+
+    filter->bloom = bloom_restore(buf.data + buf.cursor, len - buf.cursor);
+    if (filter->bloom == NULL)
+    {
+        RuntimeFilterFree(filter);
+        return NULL;
+    }
+
+    return filter;
+}
+
+/*
+ * Should the tuple be dropped?
+ *
+ * The hash value is computed exactly like ExecHashGetHashValue() does it for
+ * the outer side of the join.  Filters are only built for joins with strict
+ * hash operators that do not need unmatched outer rows, so a null key never
+ * joins and the tuple can be dropped as well.
+ */
+bool
+RuntimeFilterRejects(RuntimeFilter *filter, TupleTableSlot *slot)
+{
+    uint32        hashkey = 0;
+    int            i;
+
+    filter->nprobed++;
+
+    for (i = 0; i < filter->nkeys; i++)
+    {
+        Datum        keyval;
+        bool        isNull;
+
+        /* rotate hashkey left 1 bit at each step */
+        hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+        keyval = slot_getattr(slot, filter->keyattnos[i], &isNull);
+        if (isNull)
+        {
+            filter->nfiltered++;
+            return true;
+        }
+
+        hashkey ^= DatumGetUInt32(FunctionCall1(&filter->hashfunctions[i],
+                                                keyval));
+    }
+
+    if (bloom_lacks_hash(filter->bloom, hashkey))
+    {
+        filter->nfiltered++;
+        return true;
+    }
+
+    return false;
+}
+
+void
+RuntimeFilterFree(RuntimeFilter *filter)
+{
+    if (filter->bloom)
+        bloom_free(filter->bloom);
+    pfree(filter->keyattnos);
+    pfree(filter->hashfunctions);
+    pfree(filter);
+}
+
+/*
+ * Remember the filter received for the next Bind.
+ */
+void
+RuntimeFilterSetPending(const char *data, int len)
+{
+    RuntimeFilterResetPending();
+
+    pending_filter = MemoryContextAlloc(TopMemoryContext, len);
+    memcpy(pending_filter, data, len);
+    pending_filter_len = len;
+}
+
+/*
+ * Forget the pending filter.  Called once the Bind it was sent with has been
+ * processed, or failed, so that it can never leak into an unrelated portal.
+ */
+void
+RuntimeFilterResetPending(void)
+{
+    if (pending_filter)
+        pfree(pending_filter);
+    pending_filter = NULL;
+    pending_filter_len = 0;
+}
+
+/*
+ * Producer side: turn the pending filter into a local filter for the tuples
+ * the producer sends to its own parent.
+ */
+RuntimeFilter *
+RuntimeFilterTakePending(void)
+{
+    RuntimeFilter *filter = NULL;
+
+    if (pending_filter)
+    {
+        filter = RuntimeFilterDeserialize(pending_filter, pending_filter_len);
+        RuntimeFilterResetPending();
+    }
+
+    return filter;
+}
+
+/*
+ * Consumer side: copy the pending filter to a DSM segment the producer can
+ * attach to.  The segment belongs to the current resource owner, i.e. the
+ * consumer's portal, so it goes away together with the portal.
+ */
+dsm_handle
+RuntimeFilterPublishPending(void)
+{
+    dsm_segment *seg;
+    char       *addr;
+
+    if (pending_filter == NULL ||
+        dynamic_shared_memory_type == DSM_IMPL_NONE)
+    {
+        RuntimeFilterResetPending();
+        return DSM_HANDLE_INVALID;
+    }
+
+    seg = dsm_create(sizeof(int) + pending_filter_len,
+                     DSM_CREATE_NULL_IF_MAXSEGMENTS);
+    if (seg == NULL)
+    {
+        RuntimeFilterResetPending();
+        return DSM_HANDLE_INVALID;
+    }
+
+    addr = dsm_segment_address(seg);
+    memcpy(addr, &pending_filter_len, sizeof(int));
+    memcpy(addr + sizeof(int), pending_filter, pending_filter_len);
+    RuntimeFilterResetPending();
+
+    return dsm_segment_handle(seg);
+}
+
+/*
+ * Producer side: load the filter a consumer published.  Returns NULL if the
+ * consumer is already gone or the filter can not be used.
+ */
+RuntimeFilter *
+RuntimeFilterAttach(dsm_handle handle)
+{
+    RuntimeFilter *filter;
+    dsm_segment *seg;
+    char       *addr;
+    int            len;
+
+    seg = dsm_attach(handle);
+    if (seg == NULL)
+        return NULL;
+
+    addr = dsm_segment_address(seg);
+    memcpy(&len, addr, sizeof(int));
+    if (len <= 0 || sizeof(int) + len > dsm_segment_map_length(seg))
+        filter = NULL;
+    else
+        filter = RuntimeFilterDeserialize(addr + sizeof(int), len);
+    dsm_detach(seg);
+
+    return filter;
+}
@@ -116,6 +116,9 @@
 #include "utils/rel.h"
 #include "utils/typcache.h"
 #ifdef __TBASE__
+#include "nodes/makefuncs.h"
+#include "utils/datum.h"
+#include "utils/lsyscache.h"
 #include "utils/ruleutils.h"
 #endif
 
@@ -794,6 +797,92 @@ ExecOpenScanRelationPartition(EState *estate, Index scanrelid, int eflags, int p
     return partrel;
 }
 
+/*
+ * Drop the subplans of an interval partition Append or MergeAppend whose
+ * partitions cannot satisfy the partition key quals, now that the values of
+ * the Params in them are known.  Returns the subplans to initialize.
+ */
+List *
+ExecPruneIntervalSubplans(PlanState *planstate, List *subplans, List *quals)
+{// #lizard forgives
+    EState       *estate = planstate->state;
+    ExprContext  *econtext;
+    Scan         *scan;
+    Relation     rel;
+    Bitmapset    *parts;
+    List         *clauses = NIL;
+    List         *result = NIL;
+    ListCell     *lc;
+
+    if (quals == NIL || subplans == NIL || estate->es_param_list_info == NULL)
+        return subplans;
+
+    scan = (Scan *) linitial(subplans);
+    if (!scan->ispartchild)
+        return subplans;
+
+    econtext = GetPerTupleExprContext(estate);
+
+    /* replace the Params with their values */
+    foreach(lc, quals)
+    {
+        OpExpr     *opexpr = (OpExpr *) copyObject(lfirst(lc));
+        ListCell   *arg;
+        bool        usable = true;
+
+        foreach(arg, opexpr->args)
+        {
+            Param      *param = (Param *) lfirst(arg);
+            ExprState  *exprstate;
+            Datum        value;
+            bool        isnull;
+            int16        typlen;
+            bool        typbyval;
+
+            if (!IsA(param, Param))
+                continue;
+
+            exprstate = ExecInitExpr((Expr *) param, planstate);
+            value = ExecEvalExprSwitchContext(exprstate, econtext, &isnull);
+            if (isnull)
+            {
+                usable = false;
+                break;
+            }
+
+            get_typlenbyval(param->paramtype, &typlen, &typbyval);
+            lfirst(arg) = makeConst(param->paramtype, param->paramtypmod,
+                                    param->paramcollid, typlen,
+                                    datumCopy(value, typbyval, typlen),
+                                    false, typbyval);
+        }
+
+        if (usable)
+            clauses = lappend(clauses, opexpr);
+    }
+
+    ResetExprContext(econtext);
+
+    if (clauses == NIL)
+        return subplans;
+
+    rel = heap_open(getrelid(scan->scanrelid, estate->es_range_table), NoLock);
+    parts = RelationGetPartitionsByQuals(rel, clauses);
+    heap_close(rel, NoLock);
+
+    foreach(lc, subplans)
+    {
+        Scan *child = (Scan *) lfirst(lc);
+
+        if (!child->ispartchild || bms_is_member(child->childidx, parts))
+            result = lappend(result, child);
+    }
+
+    bms_free(parts);
+
+    return result;
+}
+
 #endif
 
 /* ----------------------------------------------------------------
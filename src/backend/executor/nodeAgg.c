@@ -245,6 +245,13 @@ bool g_hybrid_hash_agg_debug = false;
 int  g_default_hashagg_nbatches = 32;
 #endif
 
+#ifdef __TBASE__
+/* global GUC variables for adaptive partial hash agg */
+bool   enable_partial_agg_bypass = true;
+int    partial_agg_bypass_check_rows = 100000;
+double partial_agg_bypass_ratio = 0.5;
+#endif
+
 /*
  * AggStatePerTransData - per aggregate state value information
  *
@@ -609,6 +616,9 @@ static AggStatePerGroup *lookup_hash_entries(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+#ifdef __TBASE__
+static TupleTableSlot *agg_retrieve_bypass(AggState *aggstate);
+#endif
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
                           AggState *aggstate, EState *estate,
@@ -637,7 +647,12 @@ static void
 select_current_set(AggState *aggstate, int setno, bool is_hash)
 {
     if (is_hash)
+#ifdef __TBASE__
+        aggstate->curaggcontext = aggstate->bypass_streaming ?
+            aggstate->bypasscontext : aggstate->hashcontext;
+#else
         aggstate->curaggcontext = aggstate->hashcontext;
+#endif
     else
         aggstate->curaggcontext = aggstate->aggcontexts[setno];
 
@@ -3027,6 +3042,13 @@ ExecAgg(PlanState *pstate)
             case AGG_HASHED:
                 if (!node->table_filled)
                     agg_fill_hash_table(node);
+#ifdef __TBASE__
+                if (node->bypass_streaming)
+                {
+                    result = agg_retrieve_bypass(node);
+                    break;
+                }
+#endif
                 /* FALLTHROUGH */
             case AGG_MIXED:
                 result = agg_retrieve_hash_table(node);
@@ -3588,6 +3610,28 @@ agg_fill_hash_table(AggState *aggstate)
          * hash lookups do this too
          */
         ResetExprContext(aggstate->tmpcontext);
+
+#ifdef __TBASE__
+        /*
+         * A partial aggregate that hardly reduces its input only costs memory
+         * and hashing; once that is evident, stop filling the table and let
+         * the rest of the input pass through.
+         */
+        if (aggstate->agg_adaptive && !aggstate->state &&
+            ++aggstate->bypass_input_rows % partial_agg_bypass_check_rows == 0)
+        {
+            double        ngroups = aggstate->perhash[0].hashtable->hashtab->members;
+
+            if (ngroups > aggstate->bypass_input_rows * partial_agg_bypass_ratio)
+            {
+                elog(DEBUG1, "partial hash aggregate bypassed after " UINT64_FORMAT
+                     " rows formed %.0f groups",
+                     aggstate->bypass_input_rows, ngroups);
+                aggstate->agg_bypass = true;
+                break;
+            }
+        }
+#endif
     }
 
     aggstate->table_filled = true;
@@ -3680,6 +3724,14 @@ agg_retrieve_hash_table(AggState *aggstate)
             }
             else
             {
+#ifdef __TBASE__
+                /* hand the rest of the input over to the bypass */
+                if (aggstate->agg_bypass)
+                {
+                    aggstate->bypass_streaming = true;
+                    return agg_retrieve_bypass(aggstate);
+                }
+#endif
                 /* No more hashtables, so done */
                 aggstate->agg_done = TRUE;
                 return NULL;
@@ -3738,6 +3790,60 @@ agg_retrieve_hash_table(AggState *aggstate)
     return NULL;
 }
 
+#ifdef __TBASE__
+/*
+ * ExecAgg for a bypassed partial hash aggregate: the groups collected in the
+ * hash table have been returned, now turn every remaining input row into a
+ * group of its own.
+ *
+ * The output has the same shape as the groups from the hash table, so the
+ * final aggregate above the redistribution simply combines more partial
+ * states; it never knows the difference.
+ */
+static TupleTableSlot *
+agg_retrieve_bypass(AggState *aggstate)
+{
+    ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+    ExprContext *tmpcontext = aggstate->tmpcontext;
+    AggStatePerGroup pergroup = aggstate->bypass_pergroup;
+    TupleTableSlot *outerslot;
+    TupleTableSlot *result;
+
+    while (!aggstate->agg_done)
+    {
+        CHECK_FOR_INTERRUPTS();
+
+        outerslot = fetch_input_tuple(aggstate);
+        if (TupIsNull(outerslot))
+        {
+            aggstate->agg_done = TRUE;
+            break;
+        }
+
+        /* the previous row's output and transition values are gone now */
+        ResetExprContext(econtext);
+        ResetExprContext(aggstate->bypasscontext);
+
+        tmpcontext->ecxt_outertuple = outerslot;
+        select_current_set(aggstate, 0, true);
+        initialize_aggregates(aggstate, pergroup, -1);
+        aggstate->hash_pergroup[0] = pergroup;
+        advance_aggregates(aggstate, NULL, aggstate->hash_pergroup);
+        ResetExprContext(tmpcontext);
+
+        econtext->ecxt_outertuple = outerslot;
+        prepare_projection_slot(aggstate, outerslot, 0);
+        finalize_aggregates(aggstate, aggstate->peragg, pergroup);
+
+        result = project_aggregates(aggstate);
+        if (result)
+            return result;
+    }
+
+    return NULL;
+}
+#endif
+
 /* -----------------
  * ExecInitAgg
  *
@@ -3873,6 +3979,14 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
         aggstate->hashcontext = aggstate->ss.ps.ps_ExprContext;
     }
 
+#ifdef __TBASE__
+    if (node->adaptive && node->aggstrategy == AGG_HASHED)
+    {
+        ExecAssignExprContext(estate, &aggstate->ss.ps);
+        aggstate->bypasscontext = aggstate->ss.ps.ps_ExprContext;
+    }
+#endif
+
     ExecAssignExprContext(estate, &aggstate->ss.ps);
 
     /*
@@ -4593,6 +4707,33 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
                                                  NULL);
     ExecSetSlotDescriptor(aggstate->evalslot, aggstate->evaldesc);
 
+#ifdef __TBASE__
+    /*
+     * A partial aggregate below a redistribution may give up on its hash
+     * table at runtime and pass rows through as single-row groups.  That only
+     * works for plain transition functions over a single in-memory table.
+     */
+    if (aggstate->bypasscontext && enable_partial_agg_bypass &&
+        numHashes == 1 && !node->hybrid &&
+        DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit) &&
+        !DO_AGGSPLIT_COMBINE(aggstate->aggsplit))
+    {
+        aggstate->agg_adaptive = true;
+        for (transno = 0; transno < aggstate->numtrans; transno++)
+        {
+            if (pertransstates[transno].numSortCols > 0)
+            {
+                aggstate->agg_adaptive = false;
+                break;
+            }
+        }
+
+        if (aggstate->agg_adaptive)
+            aggstate->bypass_pergroup = (AggStatePerGroup)
+                palloc0(sizeof(AggStatePerGroupData) * aggstate->numtrans);
+    }
+#endif
+
     return aggstate;
 }
 
@@ -5073,6 +5214,10 @@ ExecEndAgg(AggState *node)
         ReScanExprContext(node->aggcontexts[setno]);
     if (node->hashcontext)
         ReScanExprContext(node->hashcontext);
+#ifdef __TBASE__
+    if (node->bypasscontext)
+        ReScanExprContext(node->bypasscontext);
+#endif
 
     /*
      * We don't actually free any ExprContexts here (see comment in
@@ -5115,9 +5260,14 @@ ExecReScanAgg(AggState *node)
          * If we do have the hash table, and the subplan does not have any
          * parameter changes, and none of our own parameter changes affect
          * input expressions of the aggregated functions, then we can just
-         * rescan the existing hash table; no need to build it again.
+         * rescan the existing hash table; no need to build it again.  A
+         * bypassed table only holds part of the input, though.
          */
+#ifdef __TBASE__
+        if (outerPlan->chgParam == NULL && !node->agg_bypass &&
+#else
         if (outerPlan->chgParam == NULL &&
+#endif
             !bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
         {
             ResetTupleHashIterator(node->perhash[0].hashtable,
@@ -5179,6 +5329,13 @@ ExecReScanAgg(AggState *node)
         build_hash_table(node);
         node->table_filled = false;
         /* iterator will be reset when the table is filled */
+#ifdef __TBASE__
+        if (node->bypasscontext)
+            ReScanExprContext(node->bypasscontext);
+        node->agg_bypass = false;
+        node->bypass_streaming = false;
+        node->bypass_input_rows = 0;
+#endif
     }
 
     if (node->aggstrategy != AGG_HASHED)
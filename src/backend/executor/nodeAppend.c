@@ -123,6 +123,7 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
 {
     AppendState *appendstate = makeNode(AppendState);
     PlanState **appendplanstates;
+    List       *appendplans;
     int            nplans;
     int            i;
     ListCell   *lc;
@@ -165,12 +166,20 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
      */
     ExecInitResultTupleSlot(estate, &appendstate->ps);
 
+    appendplans = node->appendplans;
+#ifdef __TBASE__
+    /* skip the partitions excluded by the values of the Params */
+    if (node->interval)
+        appendplans = ExecPruneIntervalSubplans(&appendstate->ps, appendplans,
+                                                node->partprunequals);
+#endif
+
     /*
      * call ExecInitNode on each of the plans to be executed and save the
      * results into the array "appendplans".
      */
     i = 0;
-    foreach(lc, node->appendplans)
+    foreach(lc, appendplans)
     {
         Plan       *initNode = (Plan *) lfirst(lc);
 
@@ -209,6 +218,12 @@ ExecAppend(PlanState *pstate)
 {
     AppendState *node = castNode(AppendState, pstate);
 
+#ifdef __TBASE__
+    /* all partitions were pruned or dropped */
+    if (node->as_nplans == 0)
+        return ExecClearTuple(node->ps.ps_ResultTupleSlot);
+#endif
+
     for (;;)
     {
         PlanState  *subnode;
@@ -38,6 +38,7 @@
 #include "utils/syscache.h"
 #ifdef __TBASE__
 #include "executor/execParallel.h"
+#include "lib/bloomfilter.h"
 #include "pgxc/nodemgr.h"
 #include "optimizer/cost.h"
 #endif
@@ -135,6 +136,10 @@ MultiExecHash(HashState *node)
                 ExecHashTableInsert(hashtable, slot, hashvalue);
             }
             hashtable->totalTuples += 1;
+#ifdef __TBASE__
+            if (node->runtime_filter)
+                bloom_add_hash(node->runtime_filter, hashvalue);
+#endif
         }
     }
 
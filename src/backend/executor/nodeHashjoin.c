@@ -25,6 +25,9 @@
 #ifdef __TBASE__
 #include "access/xact.h"
 #include "executor/execParallel.h"
+#include "executor/execRuntimeFilter.h"
+#include "pgxc/execRemote.h"
+#include "utils/lsyscache.h"
 #endif
 
 /*
@@ -60,6 +63,13 @@ static HashJoinTable ExecMergeShmHashTable(HashJoinState * hjstate, volatile Par
                                 Hash *node, List *hashOperators, bool keepNulls);
 static void ExecFormNewOuterBufFile(HashJoinState * hjstate, volatile ParallelHashJoinState *parallelState, 
                                  Hash *node);
+static void ExecHashJoinInitRuntimeFilter(HashJoinState *hjstate, HashJoin *node,
+                                 int eflags);
+static void ExecHashJoinPushRuntimeFilter(HashJoinState *hjstate,
+                                 HashState *hashNode);
+
+/* a filter with more bits set than this would hardly drop anything */
+#define RUNTIME_FILTER_MAX_FILL    0.5
 
 #endif
 /* ----------------------------------------------------------------
@@ -157,6 +167,13 @@ ExecHashJoin(PlanState *pstate)
                     /* no chance to not build the hash table */
                     node->hj_FirstOuterTupleSlot = NULL;
                 }
+#ifdef __TBASE__
+                else if (node->hj_PushRuntimeFilter)
+                {
+                    /* outer side must wait for the filter built with the hash table */
+                    node->hj_FirstOuterTupleSlot = NULL;
+                }
+#endif
                 else if (HJ_FILL_OUTER(node) ||
                          (outerNode->plan->startup_cost < hashNode->ps.plan->total_cost &&
                           !node->hj_OuterNotEmpty))
@@ -321,6 +338,19 @@ ExecHashJoin(PlanState *pstate)
                                                 HJ_FILL_INNER(node));
                 node->hj_HashTable = hashtable;
 
+#ifdef __TBASE__
+                /*
+                 * Collect the inner hash values for the outer RemoteSubplan,
+                 * unless it has already been started by an earlier scan.
+                 */
+                if (node->hj_PushRuntimeFilter &&
+                    !castNode(RemoteSubplanState, outerNode)->bound)
+                    hashNode->runtime_filter =
+                        bloom_create(Min(hashNode->ps.plan->plan_rows,
+                                         runtime_filter_max_rows),
+                                     work_mem, 0);
+#endif
+
                 /*
                  * execute the Hash node, to build the hash table
                  */
@@ -343,6 +373,11 @@ ExecHashJoin(PlanState *pstate)
                     return NULL;
                 }
 
+#ifdef __TBASE__
+                if (hashNode->runtime_filter)
+                    ExecHashJoinPushRuntimeFilter(node, hashNode);
+#endif
+
                 /*
                  * need to remember whether nbatch has increased since we
                  * began scanning the outer relation
@@ -764,6 +799,8 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 #ifdef __TBASE__
     hjstate->hj_OuterInited = false;
     hjstate->hj_InnerInited = false;
+
+    ExecHashJoinInitRuntimeFilter(hjstate, node, eflags);
 #endif
 
     return hjstate;
@@ -1951,4 +1988,132 @@ ParallelHashJoinEreport(void)
         statusParallelWorker = NULL;
     }
 }
+
+/*
+ * Decide whether a runtime filter can be pushed down to the outer side.
+ *
+ * The outer side must be a RemoteSubplan, so that its producers can drop the
+ * rows for us, and every outer hash key must be a plain column of the remote
+ * tuples.  Rows without a join partner may only be dropped if the join does
+ * not emit unmatched outer rows, and a null key must never match, i.e. all
+ * the hash operators are strict.  The build side is expected to be small,
+ * otherwise the filter would neither fit nor be selective.
+ */
+static void
+ExecHashJoinInitRuntimeFilter(HashJoinState *hjstate, HashJoin *node, int eflags)
+{
+    Plan       *outerNode = outerPlan(node);
+    Plan       *remoteNode;
+    int            nkeys = list_length(node->hashclauses);
+    AttrNumber *attnos;
+    Oid           *hashfuncs;
+    ListCell   *l;
+    int            i = 0;
+
+    hjstate->hj_PushRuntimeFilter = false;
+
+    if (!enable_runtime_filter || IsParallelWorker() ||
+        (eflags & EXEC_FLAG_EXPLAIN_ONLY) != 0)
+        return;
+
+    if (node->join.jointype != JOIN_INNER &&
+        node->join.jointype != JOIN_SEMI &&
+        node->join.jointype != JOIN_RIGHT)
+        return;
+
+    if (!IsA(outerPlanState(hjstate), RemoteSubplanState) ||
+        ((RemoteSubplanState *) outerPlanState(hjstate))->local_exec)
+        return;
+
+    if (innerPlan(node)->plan_rows > runtime_filter_max_rows)
+        return;
+
+    /* the remote tuples are formed by the subplan's target list */
+    remoteNode = outerNode->lefttree;
+    if (remoteNode == NULL ||
+        list_length(remoteNode->targetlist) != list_length(outerNode->targetlist))
+        return;
+
+    attnos = (AttrNumber *) palloc(nkeys * sizeof(AttrNumber));
+    hashfuncs = (Oid *) palloc(nkeys * sizeof(Oid));
+    foreach(l, node->hashclauses)
+    {
+        OpExpr       *hclause = lfirst_node(OpExpr, l);
+        Var           *var = (Var *) linitial(hclause->args);
+        Oid            left_hashfn;
+        Oid            right_hashfn;
+        ListCell   *lc;
+        AttrNumber    attno = 0;
+
+        if (!IsA(var, Var) || var->varno != OUTER_VAR ||
+            var->varattno <= 0 ||
+            var->varattno > list_length(remoteNode->targetlist))
+            break;
+
+        if (!op_strict(hclause->opno) ||
+            !get_op_hash_functions(hclause->opno, &left_hashfn, &right_hashfn))
+            break;
+
+        /* junk columns are filtered out before the producer sees the tuple */
+        foreach(lc, remoteNode->targetlist)
+        {
+            TargetEntry *tle = lfirst_node(TargetEntry, lc);
+
+            if (tle->resno == var->varattno)
+            {
+                attno = tle->resjunk ? 0 : attno + 1;
+                break;
+            }
+            if (!tle->resjunk)
+                attno++;
+        }
+        if (attno == 0)
+            break;
+
+        attnos[i] = attno;
+        hashfuncs[i] = left_hashfn;
+        i++;
+    }
+
+    if (i < nkeys)
+    {
+        pfree(attnos);
+        pfree(hashfuncs);
+        return;
+    }
+
+    hjstate->hj_PushRuntimeFilter = true;
+    hjstate->hj_RuntimeFilterAttnos = attnos;
+    hjstate->hj_RuntimeFilterHashFuncs = hashfuncs;
+}
+
+/*
+ * Hand the filter collected while building the hash table over to the outer
+ * RemoteSubplan, which sends it to the remote producers with its first Bind.
+ * The filter is not worth shipping if the inner side turned out much larger
+ * than expected.
+ */
+static void
+ExecHashJoinPushRuntimeFilter(HashJoinState *hjstate, HashState *hashNode)
+{
+    bloom_filter *bloom = hashNode->runtime_filter;
+
+    hashNode->runtime_filter = NULL;
+
+    if (hjstate->hj_HashTable->totalTuples <= runtime_filter_max_rows &&
+        bloom_prop_bits_set(bloom) <= RUNTIME_FILTER_MAX_FILL)
+    {
+        char       *data;
+        int            len;
+
+        data = RuntimeFilterSerialize(list_length(hjstate->hj_HashOperators),
+                                      hjstate->hj_RuntimeFilterAttnos,
+                                      hjstate->hj_RuntimeFilterHashFuncs,
+                                      bloom, &len);
+        ExecRemoteSubplanSetRuntimeFilter(
+                        (RemoteSubplanState *) outerPlanState(hjstate), data, len);
+    }
+
+    bloom_free(bloom);
+}
 #endif
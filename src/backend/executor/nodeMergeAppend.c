@@ -65,6 +65,7 @@ ExecInitMergeAppend(MergeAppend *node, EState *estate, int eflags)
 {
     MergeAppendState *mergestate = makeNode(MergeAppendState);
     PlanState **mergeplanstates;
+    List       *mergeplans;
     int            nplans;
     int            i;
     ListCell   *lc;
@@ -92,6 +93,17 @@ ExecInitMergeAppend(MergeAppend *node, EState *estate, int eflags)
     mergestate->ps.state = estate;
     mergestate->ps.ExecProcNode = ExecMergeAppend;
     mergestate->mergeplans = mergeplanstates;
+
+    mergeplans = node->mergeplans;
+#ifdef __TBASE__
+    /* skip the partitions excluded by the values of the Params */
+    if (node->interval)
+    {
+        mergeplans = ExecPruneIntervalSubplans(&mergestate->ps, mergeplans,
+                                               node->partprunequals);
+        nplans = list_length(mergeplans);
+    }
+#endif
     mergestate->ms_nplans = nplans;
 
     mergestate->ms_slots = (TupleTableSlot **) palloc0(sizeof(TupleTableSlot *) * nplans);
@@ -116,7 +128,7 @@ ExecInitMergeAppend(MergeAppend *node, EState *estate, int eflags)
      * results into the array "mergeplans".
      */
     i = 0;
-    foreach(lc, node->mergeplans)
+    foreach(lc, mergeplans)
     {
         Plan       *initNode = (Plan *) lfirst(lc);
 
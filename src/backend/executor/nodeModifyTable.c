@@ -337,8 +337,6 @@ ExecInsert(ModifyTableState *mtstate,
         bool        isnull;
         int         partidx;
         ResultRelInfo    *partRel;
-		char *partname = NULL;
-		Oid partoid = InvalidOid;
     
         /* router for tuple */
         partkey = RelationGetPartitionColumnIndex(resultRelationDesc);
@@ -355,26 +353,32 @@ ExecInsert(ModifyTableState *mtstate,
         {
             elog(ERROR, "inserted value is not in range of partitioned table, please check the value of paritition key");
         }
-        
-		partname = GetPartitionName(RelationGetRelid(resultRelInfo->ri_RelationDesc), partidx, false);
-		partoid = get_relname_relid(partname, RelationGetNamespace(resultRelInfo->ri_RelationDesc));
-		if(InvalidOid == partoid)
-		{
-			/* the partition have dropped */
-			elog(ERROR, "inserted value is not in range of partitioned table, please check the value of paritition key");
-		}
 
+        /*
+         * The ResultRelInfos were built for the partitions that existed at
+         * executor startup, or are built when a partition gets its first
+         * row, so a missing entry means the partition has been dropped, or
+         * the plan was pruned to other partitions.  This avoids looking the
+         * partition up in the catalog for every row.
+         */
         switch(resultRelInfo->arraymode)
         { 
             case RESULT_RELINFO_MODE_EXPAND:
                 {
-                    partRel = resultRelInfo->part_relinfo[partidx];
+                    partRel = NULL;
+                    if(partidx < resultRelInfo->partarraysize)
+                        partRel = resultRelInfo->part_relinfo[partidx];
+                    if(!partRel && resultRelInfo->part_lazy)
+                        partRel = ExecInitPartitionResultRel(estate, resultRelInfo, partidx,
+                                                             mtstate->mt_onconflict != ONCONFLICT_NONE);
                     remoterel_index = partidx;
                 }
                 break;
             case RESULT_RELINFO_MODE_COMPACT:
                 {
                     partRel = resultRelInfo->part_relinfo[0];
+                    if(partRel->part_index != partidx)
+                        partRel = NULL;
                     remoterel_index = 0;
                 }
                 break;
@@ -383,6 +387,11 @@ ExecInsert(ModifyTableState *mtstate,
                 break;
         }
 
+        if(!partRel)
+        {
+            elog(ERROR, "inserted value is not in range of partitioned table, please check the value of paritition key");
+        }
+
         if (arbiterIndexes)
         {
             int partidx = partRel->part_index;
@@ -3118,7 +3127,10 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
             {
                 int i;
                 for(i = 0; i < resultRelInfo->partarraysize; i++)
-                    resultRelInfo->part_relinfo[i]->ri_projectReturning = resultRelInfo->ri_projectReturning;
+                {
+                    if(resultRelInfo->part_relinfo[i])
+                        resultRelInfo->part_relinfo[i]->ri_projectReturning = resultRelInfo->ri_projectReturning;
+                }
             }
 #endif
 
@@ -21,6 +21,7 @@
 #include "tcop/pquery.h"
 #include "utils/tuplestore.h"
 #include "utils/timestamp.h"
+#include "utils/memutils.h"
 #include "postmaster/postmaster.h"
 
 typedef struct
@@ -48,9 +49,58 @@ typedef struct
 #ifdef __TBASE__
     uint64      send_tuples;        /* number of tuples sent to remote */
     TimestampTz send_total_time;    /* total time to send tuples */
+    RuntimeFilter *selffilter;      /* runtime filter of the self consumer */
+    RuntimeFilter **consfilters;    /* runtime filters published by consumers */
+    bool       *consfilter_loaded;  /* consfilters entry is final */
+    long        filtercount;        /* tuples dropped by runtime filters */
 #endif
 } ProducerState;
 
+#ifdef __TBASE__
+/*
+ * Check the tuple against the runtime filter of its consumer.  A consumer
+ * publishes its filter when it binds to the shared queue, which may happen
+ * after we started producing, so keep looking until the handle shows up.
+ */
+static bool
+producerFilterRejects(ProducerState *myState, int consumerIdx,
+                      TupleTableSlot *slot)
+{
+    RuntimeFilter *filter;
+
+    if (consumerIdx == SQ_CONS_SELF)
+        filter = myState->selffilter;
+    else
+    {
+        if (myState->consfilters == NULL)
+            return false;
+
+        if (!myState->consfilter_loaded[consumerIdx])
+        {
+            dsm_handle    handle;
+            MemoryContext oldcontext;
+
+            handle = SharedQueueGetConsumerFilter(myState->squeue, consumerIdx);
+            if (handle == DSM_HANDLE_INVALID)
+                return false;
+
+            oldcontext = MemoryContextSwitchTo(GetMemoryChunkContext(myState));
+            myState->consfilters[consumerIdx] = RuntimeFilterAttach(handle);
+            MemoryContextSwitchTo(oldcontext);
+            myState->consfilter_loaded[consumerIdx] = true;
+        }
+        filter = myState->consfilters[consumerIdx];
+    }
+
+    if (filter != NULL && RuntimeFilterRejects(filter, slot))
+    {
+        myState->filtercount++;
+        return true;
+    }
+    return false;
+}
+#endif
+
 
 /*
  * Prepare to receive tuples from executor.
@@ -141,6 +191,12 @@ producerReceiveSlot(TupleTableSlot *slot, DestReceiver *self)
         {
             continue;
         }
+#ifdef __TBASE__
+        else if (producerFilterRejects(myState, consumerIdx, slot))
+        {
+            continue;
+        }
+#endif
         else if (consumerIdx == SQ_CONS_SELF)
         {
             Assert(myState->consumer);
@@ -226,6 +282,11 @@ producerDestroyReceiver(DestReceiver *self)
 
     elog(DEBUG2, "Producer stats: total %ld tuples, %ld tuples to self, %ld to other nodes",
          myState->tcount, myState->selfcount, myState->othercount);
+#ifdef __TBASE__
+    if (myState->filtercount > 0)
+        elog(DEBUG2, "Producer stats: %ld tuples dropped by runtime filters",
+             myState->filtercount);
+#endif
 
     if (myState->consumer)
     {
@@ -301,6 +362,10 @@ CreateProducerDestReceiver(void)
     self->send_tuples     = 0;
     self->send_total_time = 0;
     self->nodeMap = NULL;
+    self->selffilter = NULL;
+    self->consfilters = NULL;
+    self->consfilter_loaded = NULL;
+    self->filtercount = 0;
 #endif
 
     return (DestReceiver *) self;
@@ -336,8 +401,17 @@ SetProducerDestReceiverParams(DestReceiver *self,
     myState->distNodes = (int *) getLocatorResults(locator);
     if (squeue)
 #ifdef __TBASE__
+    {
         myState->tstores = (Tuplestorestate **)
             palloc0(getLocatorNodeCount(locator) * sizeof(Tuplestorestate *));
+        if (enable_runtime_filter)
+        {
+            myState->consfilters = (RuntimeFilter **)
+                palloc0(getLocatorNodeCount(locator) * sizeof(RuntimeFilter *));
+            myState->consfilter_loaded = (bool *)
+                palloc0(getLocatorNodeCount(locator) * sizeof(bool));
+        }
+    }
 #else
         myState->tstores = (Tuplestorestate **)
             palloc0(NumDataNodes * sizeof(Tuplestorestate *));
@@ -414,4 +488,16 @@ SetProducerNodeMap(DestReceiver *self, int16 *nodemap)
 
     memcpy(myState->nodeMap, nodemap, sizeof(int16) * MAX_NODES_NUMBER);
 }
+
+/*
+ * Set the runtime filter for tuples targeted to "self"
+ */
+void
+SetProducerRuntimeFilter(DestReceiver *self, RuntimeFilter *filter)
+{
+    ProducerState *myState = (ProducerState *) self;
+
+    Assert(myState->pub.mydest == DestProducer);
+    myState->selffilter = filter;
+}
 #endif
@@ -0,0 +1,256 @@
+/*-------------------------------------------------------------------------
+ *
+ * bloomfilter.c
+ *      Space-efficient set membership testing
+ *
+ * A Bloom filter answers "is this hash definitely absent from the set?" with
+ * no false negatives and a tunable rate of false positives.  Callers feed it
+ * 32-bit hash values they have already computed (typically the hash join
+ * hash value of a tuple), and the filter derives its k probe positions from
+ * that value using enhanced double hashing.
+ *
+ * The whole filter lives in one palloc'd chunk with no internal pointers, so
+ * that it can be copied verbatim into a protocol message or a DSM segment and
+ * restored on the other side with bloom_restore().
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * IDENTIFICATION
+ *      src/backend/lib/bloomfilter.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/hash.h"
+#include "lib/bloomfilter.h"
+
+#define BLOOM_MAGIC             0x424C4D46    /* "BLMF" */
+#define MAX_HASH_FUNCS          10
+#define BLOOM_BITS_PER_ELEM     10
+#define BLOOM_MIN_BITS          ((uint64) 8192)
+
+struct bloom_filter
+{
+    uint32        magic;
+    int            k_hash_funcs;
+    uint32        seed;
+    uint64        m;                /* number of bits, always a power of two */
+    unsigned char bitset[FLEXIBLE_ARRAY_MEMBER];
+};
+
+static int    my_bloom_power(uint64 target_bitset_bits);
+static int    optimal_k(uint64 bitset_bits, int64 total_elems);
+static void k_hashes(bloom_filter *filter, uint32 *hashes, uint32 hash);
+
+/*
+ * Create Bloom filter sized for total_elems elements, using at most
+ * bloom_work_mem kilobytes of memory for the bitset.
+ *
+ * The bitset gets about BLOOM_BITS_PER_ELEM bits per element, which gives a
+ * false positive rate of roughly 1% when the estimate is accurate.  If the
+ * memory budget is too small for that, the filter still works, only with a
+ * higher false positive rate; callers can check bloom_prop_bits_set() once
+ * the filter is populated to decide whether it is still worth using.
+ */
+bloom_filter *
+bloom_create(int64 total_elems, int bloom_work_mem, uint32 seed)
+{
+    bloom_filter *filter;
+    int            bloom_power;
+    uint64        bitset_bytes;
+    uint64        bitset_bits;
+
+    total_elems = Max(total_elems, 1);
+
+    bitset_bits = Max(BLOOM_MIN_BITS, (uint64) total_elems * BLOOM_BITS_PER_ELEM);
+    bitset_bits = Min(bitset_bits, (uint64) Max(bloom_work_mem, 1) * 1024 * BITS_PER_BYTE);
+
+    bloom_power = my_bloom_power(bitset_bits);
+    bitset_bits = UINT64CONST(1) << bloom_power;
+    bitset_bytes = bitset_bits / BITS_PER_BYTE;
+
+    filter = palloc0(offsetof(bloom_filter, bitset) + bitset_bytes);
+    filter->magic = BLOOM_MAGIC;
+    filter->k_hash_funcs = optimal_k(bitset_bits, total_elems);
+    filter->seed = seed;
+    filter->m = bitset_bits;
+
+    return filter;
+}
+
+/*
+ * Free Bloom filter
+ */
+void
+bloom_free(bloom_filter *filter)
+{
+    pfree(filter);
+}
+
+/*
+ * Add a hash value to the set
+ */
+void
+bloom_add_hash(bloom_filter *filter, uint32 hash)
+{
+    uint32        hashes[MAX_HASH_FUNCS];
+    int            i;
+
+    k_hashes(filter, hashes, hash);
+
+    for (i = 0; i < filter->k_hash_funcs; i++)
+    {
+        filter->bitset[hashes[i] >> 3] |= 1 << (hashes[i] & 7);
+    }
+}
+
+/*
+ * Return true if the hash value is definitely not in the set.  A false
+ * return means the value may or may not have been added.
+ */
+bool
+bloom_lacks_hash(bloom_filter *filter, uint32 hash)
+{
+    uint32        hashes[MAX_HASH_FUNCS];
+    int            i;
+
+    k_hashes(filter, hashes, hash);
+
+    for (i = 0; i < filter->k_hash_funcs; i++)
+    {
+        if (!(filter->bitset[hashes[i] >> 3] & (1 << (hashes[i] & 7))))
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * What proportion of bits are currently set?
+ *
+ * A value approaching 1.0 means nearly every probe passes and the filter is
+ * no longer discriminating anything.
+ */
+double
+bloom_prop_bits_set(bloom_filter *filter)
+{
+    int            bitset_bytes = filter->m / BITS_PER_BYTE;
+    uint64        bits_set = 0;
+    int            i;
+
+    for (i = 0; i < bitset_bytes; i++)
+    {
+        unsigned char byte = filter->bitset[i];
+
+        while (byte)
+        {
+            bits_set++;
+            byte &= (byte - 1);
+        }
+    }
+
+    return bits_set / (double) filter->m;
+}
+
+/*
+ * Number of bytes occupied by the filter, starting at the filter pointer
+ */
+Size
+bloom_total_size(bloom_filter *filter)
+{
+    return offsetof(bloom_filter, bitset) + filter->m / BITS_PER_BYTE;
+}
+
+/*
+ * Rebuild a filter from bytes previously copied out of another filter.
+ *
+ * Returns NULL if the bytes do not look like a filter of the given length,
+ * so a damaged or truncated image is simply ignored rather than trusted.
+ */
+bloom_filter *
+bloom_restore(const char *data, Size len)
+{
+    bloom_filter *filter;
+    bloom_filter  header;
+
+    if (len < offsetof(bloom_filter, bitset))
+        return NULL;
+
+    memcpy(&header, data, offsetof(bloom_filter, bitset));
+    if (header.magic != BLOOM_MAGIC ||
+        header.k_hash_funcs < 1 || header.k_hash_funcs > MAX_HASH_FUNCS ||
+        header.m < BITS_PER_BYTE || (header.m & (header.m - 1)) != 0 ||
+        len != offsetof(bloom_filter, bitset) + header.m / BITS_PER_BYTE)
+        return NULL;
+
+    filter = palloc(len);
+    memcpy(filter, data, len);
+
+    return filter;
+}
+
+/*
+ * Which element in the sequence of powers of two is less than or equal to
+ * target_bitset_bits?  The result is capped at 2^32 bits (512MB), which keeps
+ * probe positions within uint32 and the allocation within MaxAllocSize.
+ */
+static int
+my_bloom_power(uint64 target_bitset_bits)
+{
+    int            bloom_power = -1;
+
+    while (target_bitset_bits > 0 && bloom_power < 32)
+    {
+        bloom_power++;
+        target_bitset_bits >>= 1;
+    }
+
+    return bloom_power;
+}
+
+/*
+ * Determine optimal number of hash functions based on size of filter in
+ * bits, and projected total number of elements.  The optimal number is the
+ * number that minimizes the false positive rate.
+ */
+static int
+optimal_k(uint64 bitset_bits, int64 total_elems)
+{
+    int            k = rint(log(2.0) * bitset_bits / total_elems);
+
+    return Max(1, Min(k, MAX_HASH_FUNCS));
+}
+
+/*
+ * Generate k probe positions for a hash value.
+ *
+ * The incoming value is remixed with the filter seed first, so that filters
+ * keyed on hash join hash values do not inherit the bucket correlation of the
+ * hash table they were built from.
+ */
+static void
+k_hashes(bloom_filter *filter, uint32 *hashes, uint32 hash)
+{
+    uint64        mask = filter->m - 1;
+    uint32        x;
+    uint32        y;
+    int            i;
+
+    x = DatumGetUInt32(hash_uint32(hash ^ filter->seed));
+    y = DatumGetUInt32(hash_uint32(x ^ 0x9E3779B9));
+
+    /* Accumulate hashes */
+    x = x & mask;
+    y = y & mask;
+    hashes[0] = x;
+    for (i = 1; i < filter->k_hash_funcs; i++)
+    {
+        x = (x + y) & mask;
+        y = (y + i) & mask;
+
+        hashes[i] = x;
+    }
+}
@@ -295,6 +295,7 @@ _copyAppend(const Append *from)
     COPY_NODE_FIELD(appendplans);
 #ifdef __TBASE__
     COPY_SCALAR_FIELD(interval);
+    COPY_NODE_FIELD(partprunequals);
 #endif
 
     return newnode;
@@ -325,6 +326,7 @@ _copyMergeAppend(const MergeAppend *from)
     COPY_POINTER_FIELD(nullsFirst, from->numCols * sizeof(bool));
 #ifdef __TBASE__
     COPY_SCALAR_FIELD(interval);
+    COPY_NODE_FIELD(partprunequals);
 #endif
 
     return newnode;
@@ -1048,6 +1050,7 @@ _copyAgg(const Agg *from)
 	COPY_SCALAR_FIELD(entrySize);
 	COPY_SCALAR_FIELD(hybrid);
 	COPY_SCALAR_FIELD(noDistinct);
+	COPY_SCALAR_FIELD(adaptive);
 #endif
 
     return newnode;
@@ -707,6 +707,7 @@ _outAppend(StringInfo str, const Append *node)
     WRITE_NODE_FIELD(appendplans);
 #ifdef __TBASE__
     WRITE_BOOL_FIELD(interval);
+    WRITE_NODE_FIELD(partprunequals);
 #endif
 }
 
@@ -783,6 +784,7 @@ _outMergeAppend(StringInfo str, const MergeAppend *node)
         appendStringInfo(str, " %s", booltostr(node->nullsFirst[i]));
 #ifdef __TBASE__
     WRITE_BOOL_FIELD(interval);
+    WRITE_NODE_FIELD(partprunequals);
 #endif
 }
 
@@ -1331,6 +1333,7 @@ _outAgg(StringInfo str, const Agg *node)
 	WRITE_UINT_FIELD(entrySize);
 	WRITE_BOOL_FIELD(hybrid);
 	WRITE_BOOL_FIELD(noDistinct);
+	WRITE_BOOL_FIELD(adaptive);
 #endif
 }
 
@@ -3319,6 +3322,7 @@ _outAggPath(StringInfo str, const AggPath *node)
 	WRITE_UINT_FIELD(entrySize);
 	WRITE_BOOL_FIELD(hybrid);
 	WRITE_BOOL_FIELD(noDistinct);
+	WRITE_BOOL_FIELD(adaptive);
 #endif
 }
 
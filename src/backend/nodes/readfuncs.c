@@ -2452,6 +2452,7 @@ _readAppend(void)
     READ_NODE_FIELD(appendplans);
 #ifdef __TBASE__
     READ_BOOL_FIELD(interval);
+    READ_NODE_FIELD(partprunequals);
 #endif
 
     READ_DONE();
@@ -2549,6 +2550,7 @@ _readMergeAppend(void)
     READ_BOOL_ARRAY(nullsFirst, local_node->numCols);
 #ifdef __TBASE__
     READ_BOOL_FIELD(interval);
+    READ_NODE_FIELD(partprunequals);
 #endif
 
     READ_DONE();
@@ -3280,6 +3282,7 @@ _readAgg(void)
 	READ_UINT_FIELD(entrySize);
 	READ_BOOL_FIELD(hybrid);
 	READ_BOOL_FIELD(noDistinct);
+	READ_BOOL_FIELD(adaptive);
 #endif
 
     READ_DONE();
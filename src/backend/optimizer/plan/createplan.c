@@ -64,6 +64,7 @@
 #include "commands/tablecmds.h"
 #endif /* PGXC */
 #include "utils/lsyscache.h"
+#include "utils/typcache.h"
 #ifdef __TBASE__
 #include "pgxc/nodemgr.h"
 #include "pgxc/squeue.h"
@@ -348,6 +349,7 @@ static bool set_plan_parallel(Plan *plan);
 static void set_plan_nonparallel(Plan *plan);
 static Plan *materialize_top_remote_subplan(Plan *node);
 static bool contain_node_walker(Plan *node, NodeTag type, bool search_nonparallel);
+static List *interval_runtime_pruning_quals(RelOptInfo *rel, Relation relation);
 #endif
 static RemoteSubplan *find_push_down_plan(Plan *plan, bool force);
 
@@ -1024,6 +1026,7 @@ create_scan_plan(PlannerInfo *root, Path *best_path, int flags)
                         mappend->plan.qual = NULL;
                     }
                     mappend->interval = true;
+                    mappend->partprunequals = interval_runtime_pruning_quals(rel, relation);
                     mappend->plan.parallel_aware = best_path->parallel_aware;
                     plan = (Plan *)mappend;
                 }
@@ -1032,6 +1035,7 @@ create_scan_plan(PlannerInfo *root, Path *best_path, int flags)
                     Append *append = NULL;
                     append = make_append(scanlist, tlist, NULL);
                     append->interval = true;
+                    append->partprunequals = interval_runtime_pruning_quals(rel, relation);
                     append->plan.parallel_aware = best_path->parallel_aware;
                     plan = (Plan *)append;
                 }
@@ -2339,6 +2343,7 @@ create_agg_plan(PlannerInfo *root, AggPath *best_path)
 	}
 
 	plan->noDistinct = best_path->noDistinct;
+	plan->adaptive = best_path->adaptive;
 #endif
 
     return plan;
@@ -8034,6 +8039,7 @@ make_agg(List *tlist, List *qual,
 	node->hybrid = false;
 	node->entrySize = 0;
 	node->noDistinct = false;
+	node->adaptive = false;
 #endif
     plan->qual = qual;
     plan->targetlist = tlist;
@@ -8656,6 +8662,7 @@ make_modifytable(PlannerInfo *root,
             {
                 Relation tempresultrel;
                 AttrNumber partkey;
+                TargetEntry *targetentry = NULL;
                 tempresultrel = heap_open(rte->relid, NoLock);
                 if(RELATION_IS_INTERVAL(tempresultrel))
                 {
@@ -8671,18 +8678,19 @@ make_modifytable(PlannerInfo *root,
                     partoffset = i;
                     node->haspartparent = true;
                     node->partrelidx = rti;
-                    /* pruning */
+                    /*
+                     * pruning. A partition key that is not a constant, such as
+                     * a Param of a generic plan, leaves all partitions as
+                     * targets and ExecInsert routes the row at run time.
+                     */
                     if(operation == CMD_INSERT && root->parse->isSingleValues)
                     {
-                        TargetEntry * targetentry;
-                        
                         partkey = RelationGetPartitionColumnIndex(tempresultrel);
                         targetentry = get_tle_by_resno(root->parse->targetList,partkey);
-                        if(!targetentry || !IsA(targetentry->expr,Const))
-                        {
-                            elog(ERROR, "the row inserted to partitioned table must have const value in partition key.");
-                        }
-                        
+                    }
+
+                    if(targetentry && IsA(targetentry->expr,Const))
+                    {
                         node->partpruning = RelationGetPartitionByValue(tempresultrel,(Const*)targetentry->expr);
                     }
                     else
@@ -10021,5 +10029,86 @@ set_plan_nonparallel(Plan *plan)
 
     subplan->parallel_aware = false;
 }
+
+/*
+ * Collect the restriction clauses of an interval partitioned relation that
+ * compare its partition key with an external Param.  Plan-time pruning keeps
+ * every partition for them, so the Append over the partitions carries them
+ * and prunes its subplans at executor startup, once the values are known.
+ */
+static List *
+interval_runtime_pruning_quals(RelOptInfo *rel, Relation relation)
+{// #lizard forgives
+    List       *result = NIL;
+    AttrNumber  partkey;
+    ListCell   *lc;
+
+    partkey = RelationGetPartitionColumnIndex(relation);
+
+    foreach(lc, rel->baserestrictinfo)
+    {
+        RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+        OpExpr     *opexpr = (OpExpr *) rinfo->clause;
+        Node       *leftarg;
+        Node       *rightarg;
+        Var        *var;
+        Param      *param;
+        TypeCacheEntry *typentry;
+
+        if (!IsA(opexpr, OpExpr) || list_length(opexpr->args) != 2)
+            continue;
+
+        leftarg = (Node *) linitial(opexpr->args);
+        rightarg = (Node *) lsecond(opexpr->args);
+
+        if (IsA(leftarg, Var) && IsA(rightarg, Param))
+        {
+            var = (Var *) leftarg;
+            param = (Param *) rightarg;
+        }
+        else if (IsA(leftarg, Param) && IsA(rightarg, Var))
+        {
+            var = (Var *) rightarg;
+            param = (Param *) leftarg;
+        }
+        else
+            continue;
+
+        if (var->varattno != partkey || param->paramkind != PARAM_EXTERN)
+            continue;
+
+        /* only the value types the partition router understands */
+        switch (var->vartype)
+        {
+            case INT2OID:
+            case INT4OID:
+            case INT8OID:
+                if (param->paramtype != INT2OID &&
+                    param->paramtype != INT4OID &&
+                    param->paramtype != INT8OID)
+                    continue;
+                break;
+            case TIMESTAMPOID:
+                if (param->paramtype != TIMESTAMPOID)
+                    continue;
+                break;
+            default:
+                continue;
+        }
+
+        /*
+         * The operator must be an ordering or equality operator of the key's
+         * btree family, whatever it is called.
+         */
+        typentry = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+        if (!OidIsValid(typentry->btree_opf) ||
+            get_op_opfamily_strategy(opexpr->opno, typentry->btree_opf) == 0)
+            continue;
+
+        result = lappend(result, copyObject(opexpr));
+    }
+
+    return result;
+}
 #endif
 
@@ -4688,6 +4688,14 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 
 						aggpath->hybrid = true;
 					}
+
+					/*
+					 * The partial aggregate is only worth its hash table if it
+					 * shrinks what is sent to the final aggregate; let it pass
+					 * rows through at runtime if it turns out not to.
+					 */
+					if (enable_partial_agg_bypass && !((AggPath *) agg_path)->hybrid)
+						((AggPath *) agg_path)->adaptive = true;
 #endif
 
 #ifdef __TBASE__
@@ -7749,6 +7757,10 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 
 							aggpath->hybrid = true;
                         }
+
+						/* may pass rows through if it does not reduce them */
+						if (enable_partial_agg_bypass && !((AggPath *) path)->hybrid)
+							((AggPath *) path)->adaptive = true;
 #endif
 
 						/* step 2 */
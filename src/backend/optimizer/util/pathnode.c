@@ -6229,6 +6229,7 @@ create_agg_path(PlannerInfo *root,
 #ifdef __TBASE__
 	pathnode->hybrid = false;
 	pathnode->entrySize = 0;
+	pathnode->adaptive = false;
 #endif
 
     cost_agg(&pathnode->path, root,
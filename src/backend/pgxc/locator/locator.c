@@ -2148,6 +2148,92 @@ GET_NODES(Locator *self, Datum value, bool isnull,
 #endif
 }
 
+#ifdef __TBASE__
+/*
+ * Can the locator route a vector of values with GET_NODES_BATCH? Only shard
+ * locators without the cold-hot router qualify, every value maps to exactly
+ * one node there.
+ */
+bool
+LocatorSupportsBatch(Locator *self)
+{
+    if (self->locatorType != LOCATOR_TYPE_SHARD ||
+        self->locatefunc != locate_shard_insert ||
+        self->listType == LOCATOR_LIST_LIST)
+    {
+        return false;
+    }
+#ifdef __COLD_HOT__
+    if (self->need_shardmap_router)
+    {
+        return false;
+    }
+#endif
+    return true;
+}
+
+/*
+ * GET_NODES_BATCH
+ *
+ * Route a vector of distribution values at once. Returns false if the locator
+ * does not support it, the caller has to fall back to GET_NODES row by row
+ * then. On success results[i] receives what GET_NODES would have stored in
+ * the first result slot for values[i], so results must have room for nvalues
+ * entries of the locator list type.
+ */
+bool
+GET_NODES_BATCH(Locator *self, Datum *values, bool *nulls, int nvalues,
+                void *results)
+{// #lizard forgives
+    int     i;
+    long   *hashvalues;
+    int32  *global_indexes;
+
+    if (!LocatorSupportsBatch(self))
+    {
+        return false;
+    }
+
+    if (nvalues <= 0)
+    {
+        return true;
+    }
+
+    hashvalues     = (long *) palloc(sizeof(long) * nvalues);
+    global_indexes = (int32 *) palloc(sizeof(int32) * nvalues);
+
+    compute_hash_batch(self->dataType, values, nulls, nvalues,
+                       LOCATOR_TYPE_SHARD, hashvalues);
+    GetNodeIndexByHashValues(self->groupid, hashvalues, nvalues, global_indexes);
+
+    for (i = 0; i < nvalues; i++)
+    {
+        int global_index = global_indexes[i];
+
+        switch (self->listType)
+        {
+            case LOCATOR_LIST_NONE:
+            case LOCATOR_LIST_INT:
+                ((int *) results)[i] = global_index;
+                break;
+            case LOCATOR_LIST_OID:
+                ((Oid *) results)[i] = ((Oid *) self->nodeMap)[global_index];
+                break;
+            case LOCATOR_LIST_POINTER:
+                ((void **) results)[i] =
+                    ((void **) self->nodeMap)[self->nodeindexMap[global_index]];
+                break;
+            default:
+                break;
+        }
+    }
+
+    pfree(hashvalues);
+    pfree(global_indexes);
+    return true;
+}
+#endif
+
 #ifdef __TBASE__
 char
 getLocatorDisType(Locator *self)
@@ -0,0 +1,302 @@
+/*-------------------------------------------------------------------------
+ *
+ * commit_latency.c
+ *      Latency histograms of the phases of distributed commit
+ *
+ * The coordinator times the PREPARE round of implicit two-phase commit, the
+ * prepare and commit timestamp requests to GTM, and the COMMIT or COMMIT
+ * PREPARED round that ends a transaction.  Datanodes time the commit
+ * timestamp requests of their local commits.  Every sample goes into a
+ * shared histogram of its phase, from which pg_stat_commit_latency reports
+ * percentiles.
+ *
+ * Buckets are log-linear: values below 2^SUB_BITS microseconds have a
+ * bucket each, above that every power of two is split into 2^SUB_BITS
+ * buckets, so a reported percentile is within 1/2^SUB_BITS of the true
+ * value.
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * IDENTIFICATION
+ *      src/backend/pgxc/pool/commit_latency.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/htup_details.h"
+#include "catalog/pg_type.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "pgxc/commit_latency.h"
+#include "port/atomics.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+
+#define SUB_BITS            3
+#define SUB_BUCKETS            (1 << SUB_BITS)
+#define MAX_VALUE_BITS        40        /* about 12 days in microseconds */
+#define NUM_BUCKETS            ((MAX_VALUE_BITS - SUB_BITS + 2) * SUB_BUCKETS)
+
+typedef struct CommitLatencyHist
+{
+    pg_atomic_uint64 total_us;
+    pg_atomic_uint64 max_us;
+    pg_atomic_uint64 buckets[NUM_BUCKETS];
+} CommitLatencyHist;
+
+typedef struct CommitLatencyData
+{
+    CommitLatencyHist phases[COMMIT_LATENCY_NPHASES];
+} CommitLatencyData;
+
+bool        track_commit_latency = true;
+
+static CommitLatencyData *CommitLatency = NULL;
+
+static const char *const phase_names[COMMIT_LATENCY_NPHASES] = {
+    "prepare",
+    "gts",
+    "commit"
+};
+
+static int
+latency_bucket(uint64 us)
+{
+    int            msb = SUB_BITS;
+
+    if (us < SUB_BUCKETS)
+        return (int) us;
+
+    if (us >= (UINT64CONST(1) << (MAX_VALUE_BITS + 1)))
+        return NUM_BUCKETS - 1;
+
+    while ((us >> (msb + 1)) != 0)
+        msb++;
+
+    return (msb - SUB_BITS + 1) * SUB_BUCKETS +
+        (int) ((us >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+/* largest value that falls into the bucket */
+static uint64
+latency_bucket_upper(int bucket)
+{
+    int            msb;
+    uint64        sub;
+
+    if (bucket < SUB_BUCKETS)
+        return (uint64) bucket;
+
+    msb = bucket / SUB_BUCKETS + SUB_BITS - 1;
+    sub = bucket % SUB_BUCKETS;
+
+    return ((SUB_BUCKETS + sub + 1) << (msb - SUB_BITS)) - 1;
+}
+
+Size
+CommitLatencyShmemSize(void)
+{
+    return sizeof(CommitLatencyData);
+}
+
+void
+CommitLatencyShmemInit(void)
+{
+    bool        found;
+
+    CommitLatency = (CommitLatencyData *)
+        ShmemInitStruct("Commit Latency", CommitLatencyShmemSize(), &found);
+
+    if (!found)
+    {
+        int            i;
+        int            j;
+
+        for (i = 0; i < COMMIT_LATENCY_NPHASES; i++)
+        {
+            CommitLatencyHist *hist = &CommitLatency->phases[i];
+
+            pg_atomic_init_u64(&hist->total_us, 0);
+            pg_atomic_init_u64(&hist->max_us, 0);
+            for (j = 0; j < NUM_BUCKETS; j++)
+                pg_atomic_init_u64(&hist->buckets[j], 0);
+        }
+    }
+}
+
+/*
+ * Record the time elapsed since start for a phase.
+ */
+void
+CommitLatencyRecord(CommitLatencyPhase phase, instr_time start)
+{
+    CommitLatencyHist *hist;
+    instr_time    duration;
+    uint64        us;
+    uint64        max_us;
+
+    if (CommitLatency == NULL || INSTR_TIME_IS_ZERO(start))
+        return;
+
+    INSTR_TIME_SET_CURRENT(duration);
+    INSTR_TIME_SUBTRACT(duration, start);
+    us = INSTR_TIME_GET_MICROSEC(duration);
+
+    hist = &CommitLatency->phases[phase];
+    pg_atomic_fetch_add_u64(&hist->buckets[latency_bucket(us)], 1);
+    pg_atomic_fetch_add_u64(&hist->total_us, us);
+
+    max_us = pg_atomic_read_u64(&hist->max_us);
+    while (us > max_us)
+    {
+        if (pg_atomic_compare_exchange_u64(&hist->max_us, &max_us, us))
+            break;
+    }
+}
+
+/* value below which the given fraction of the samples fall, in ms */
+static double
+latency_percentile(uint64 *buckets, uint64 count, uint64 max_us,
+                   double fraction)
+{
+    uint64        target = (uint64) ceil(fraction * count);
+    uint64        seen = 0;
+    int            i;
+
+    if (target == 0)
+        target = 1;
+
+    for (i = 0; i < NUM_BUCKETS; i++)
+    {
+        seen += buckets[i];
+        if (seen >= target)
+            return Min(latency_bucket_upper(i), max_us) / 1000.0;
+    }
+
+    return max_us / 1000.0;
+}
+
+/*
+ * Show count, mean and percentiles of the latency of each commit phase.
+ */
+Datum
+tbase_commit_latency(PG_FUNCTION_ARGS)
+{
+#define COMMIT_LATENCY_NCOLUMNS 8
+    FuncCallContext *funcctx;
+    int            phase;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        MemoryContext oldcontext;
+        TupleDesc    tupdesc;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        tupdesc = CreateTemplateTupleDesc(COMMIT_LATENCY_NCOLUMNS, false);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 1, "phase",
+                           TEXTOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 2, "calls",
+                           INT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 3, "total_time",
+                           FLOAT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 4, "mean_time",
+                           FLOAT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 5, "p50_time",
+                           FLOAT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 6, "p90_time",
+                           FLOAT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 7, "p99_time",
+                           FLOAT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 8, "max_time",
+                           FLOAT8OID, -1, 0);
+
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+        funcctx->max_calls = CommitLatency ? COMMIT_LATENCY_NPHASES : 0;
+
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    phase = funcctx->call_cntr;
+
+    if (phase < funcctx->max_calls)
+    {
+        CommitLatencyHist *hist = &CommitLatency->phases[phase];
+        uint64        buckets[NUM_BUCKETS];
+        uint64        count = 0;
+        uint64        total_us;
+        uint64        max_us;
+        Datum        values[COMMIT_LATENCY_NCOLUMNS];
+        bool        nulls[COMMIT_LATENCY_NCOLUMNS];
+        HeapTuple    tuple;
+        int            i;
+
+        for (i = 0; i < NUM_BUCKETS; i++)
+        {
+            buckets[i] = pg_atomic_read_u64(&hist->buckets[i]);
+            count += buckets[i];
+        }
+        total_us = pg_atomic_read_u64(&hist->total_us);
+        max_us = pg_atomic_read_u64(&hist->max_us);
+
+        MemSet(nulls, 0, sizeof(nulls));
+        values[0] = CStringGetTextDatum(phase_names[phase]);
+        values[1] = Int64GetDatum(count);
+        values[2] = Float8GetDatum(total_us / 1000.0);
+        if (count > 0)
+        {
+            values[3] = Float8GetDatum(total_us / 1000.0 / count);
+            values[4] = Float8GetDatum(latency_percentile(buckets, count, max_us, 0.5));
+            values[5] = Float8GetDatum(latency_percentile(buckets, count, max_us, 0.9));
+            values[6] = Float8GetDatum(latency_percentile(buckets, count, max_us, 0.99));
+            values[7] = Float8GetDatum(max_us / 1000.0);
+        }
+        else
+        {
+            for (i = 3; i < COMMIT_LATENCY_NCOLUMNS; i++)
+                nulls[i] = true;
+        }
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    }
+
+    SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * Forget the samples collected so far.  Samples recorded concurrently may be
+ * partly lost.
+ */
+Datum
+tbase_reset_commit_latency(PG_FUNCTION_ARGS)
+{
+    int            i;
+    int            j;
+
+    if (!superuser())
+        ereport(ERROR,
+                (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                 errmsg("must be superuser to reset commit latency statistics")));
+
+    if (CommitLatency == NULL)
+        PG_RETURN_VOID();
+
+    for (i = 0; i < COMMIT_LATENCY_NPHASES; i++)
+    {
+        CommitLatencyHist *hist = &CommitLatency->phases[i];
+
+        for (j = 0; j < NUM_BUCKETS; j++)
+            pg_atomic_write_u64(&hist->buckets[j], 0);
+        pg_atomic_write_u64(&hist->total_us, 0);
+        pg_atomic_write_u64(&hist->max_us, 0);
+    }
+
+    PG_RETURN_VOID();
+}
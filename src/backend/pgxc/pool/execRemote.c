@@ -17,6 +17,8 @@
  */
 
 #include <time.h>
+#include <poll.h>
+#include <sys/socket.h>
 #include "postgres.h"
 #include "access/twophase.h"
 #include "access/gtm.h"
@@ -43,6 +45,7 @@
 #include "pgxc/nodemgr.h"
 #include "pgxc/poolmgr.h"
 #include "storage/ipc.h"
+#include "storage/latch.h"
 #include "storage/proc.h"
 #include "utils/datum.h"
 #include "utils/lsyscache.h"
@@ -66,6 +69,10 @@
 #include "executor/nodeModifyTable.h"
 #include "utils/syscache.h"
 #include "nodes/print.h"
+#include "pgxc/commit_latency.h"
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 #endif
 /*
  * We do not want it too long, when query is terminating abnormally we just
@@ -92,6 +99,9 @@ List *executed_node_list = NULL;
 #ifdef __TBASE__
 /* GUC parameter */
 int DataRowBufferSize = 0;  /* MBytes */
+bool g_CopySenderThread = false;
+int  g_CopySenderQueueSize = 4096; /* KBytes */
+bool enable_onephase_commit = true;
 
 #define DATA_ROW_BUFFER_SIZE(n) (DataRowBufferSize * 1024 * 1024 * (n))
 #endif
@@ -116,6 +126,42 @@ struct find_params_context
 #define COPY_BUFFER_SIZE 8192
 #define PRIMARY_NODE_WRITEAHEAD 1024 * 1024
 
+#ifdef __TBASE__
+/*
+ * COPY FROM sender threads. With enable_copy_sender_thread the backend still
+ * parses and routes the rows, but full connection buffers are handed over to
+ * a thread per datanode connection which writes them to the socket, so that
+ * parsing and sending of the rows overlap. Buffers are handed over in whole
+ * messages, a sender thread never touches anything but its queue and the
+ * socket.
+ */
+#define COPY_SENDER_CHUNK_SIZE (64 * 1024)
+#define COPY_SENDER_POLL_TIMEOUT 1000 /* ms */
+
+typedef struct
+{
+    int             len;
+    char            data[FLEXIBLE_ARRAY_MEMBER];
+} CopySenderChunk;
+
+typedef struct
+{
+    int             sock;           /* socket of the datanode connection */
+    PGPipe         *queue;          /* chunks waiting to be sent */
+    ThreadSema      send_sem;       /* wake up the sender */
+    Latch          *latch;          /* of the backend, set on progress */
+    volatile bool   exited;         /* sender has exited */
+    volatile bool   need_quit;      /* send everything queued, then exit */
+    volatile bool   need_abort;     /* drop everything queued, then exit */
+    volatile int    send_errno;     /* errno of the failed send, 0 if none */
+} CopySender;
+
+static CopySender *CopySenderStart(PGXCNodeHandle *handle);
+static int  CopySenderPush(PGXCNodeHandle *handle, char *data, int len);
+static bool CopySenderStop(PGXCNodeHandle *handle, bool abort);
+static void *CopySenderThread(void *arg);
+#endif
+
 /*
  * Flag to track if a temporary object is accessed by the current transaction
  */
@@ -151,6 +197,8 @@ static void pgxc_abort_connections(PGXCNodeAllHandles *all_handles);
 static void pgxc_node_remote_commit(TranscationType txn_type, bool need_release_handle);
 static void pgxc_node_remote_abort(TranscationType txn_type, bool need_release_handle);
 static int pgxc_node_remote_commit_internal(PGXCNodeAllHandles *handles, TranscationType txn_type);
+static int pgxc_node_remote_finish_flush(PGXCNodeHandle **connections,
+                              int *conn_count, bool commit);
 #endif
 
 static void pgxc_connections_cleanup(ResponseCombiner *combiner);
@@ -963,6 +1011,60 @@ HandleDatanodeCommandId(ResponseCombiner *combiner, char *msg_body, size_t len)
         SetReceivedCommandId(cid);
 }
 
+#ifdef __TBASE__
+/*
+ * HandleDataRowBatch ('B') message from a data pump sender
+ *
+ * The message carries zlib compressed DataRow messages, see
+ * DataPumpSendBatch in squeue.c. Inflate them in place of the batch message,
+ * so the following handle_response iterations see plain DataRows.
+ */
+static void
+HandleDataRowBatch(PGXCNodeHandle *conn, char *msg_body, size_t len)
+{
+#ifdef HAVE_LIBZ
+    uint32        n32;
+    uLongf        rawlen;
+    uLongf        destlen;
+    size_t        remaining;
+    char       *rows;
+
+    Assert(msg_body != NULL);
+    Assert(len >= 4);
+
+    memcpy(&n32, &msg_body[0], 4);
+    rawlen = destlen = ntohl(n32);
+
+    rows = (char *) palloc(rawlen);
+    if (uncompress((Bytef *) rows, &destlen,
+                   (Bytef *) msg_body + 4, len - 4) != Z_OK ||
+        destlen != rawlen)
+    {
+        PGXCNodeSetConnectionState(conn, DN_CONNECTION_STATE_ERROR_FATAL);
+        ereport(ERROR,
+                (errcode(ERRCODE_DATA_CORRUPTED),
+                 errmsg("could not decompress DataRow batch from node %s",
+                        conn->nodename)));
+    }
+
+    /* the batch is consumed, put the rows in front of the unread data */
+    remaining = conn->inEnd - conn->inStart;
+    if (ensure_in_buffer_capacity(rawlen + remaining, conn) != 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_OUT_OF_MEMORY),
+                 errmsg("out of memory")));
+    memmove(conn->inBuffer + rawlen, conn->inBuffer + conn->inStart, remaining);
+    memcpy(conn->inBuffer, rows, rawlen);
+    conn->inStart = conn->inCursor = 0;
+    conn->inEnd = rawlen + remaining;
+
+    pfree(rows);
+#else
+    elog(ERROR, "received DataRow batch, but zlib is not supported by this build");
+#endif
+}
+#endif
+
 /*
  * Record waited-for XIDs received from the remote nodes into the transaction
  * state
@@ -3196,6 +3298,12 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
                 }
                 break;
                 
+#ifdef __TBASE__
+            case 'B':            /* DataRow batch */
+                HandleDataRowBatch(conn, msg, msg_len);
+                break;
+#endif
+
             case 's':            /* PortalSuspended */
                 /* No activity is expected on the connection until next query */
                 PGXCNodeSetConnectionState(conn, DN_CONNECTION_STATE_IDLE);
@@ -3233,6 +3341,10 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
             case 'E':            /* ErrorResponse */
                 HandleError(combiner, msg, msg_len, conn);
                 add_error_message_from_combiner(conn, combiner);
+#ifdef __TBASE__
+                /* the node skips what we queued after the failed message */
+                pgxc_node_forget_cached_plans(conn);
+#endif
                 /*
                  * In case the remote node was running an extended query
                  * protocol and reported an error, it will keep ignoring all
@@ -3281,6 +3393,8 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
 #endif
 
 #ifdef __TBASE__
+                if (conn->transaction_status == 'I')
+                    conn->xid_assigned = false;
                 if (enable_statistic)
                 {
                     elog(LOG, "ConnectionFetchDatarows: remote_node %s remote_pid %d, datarows %ld", conn->nodename, conn->backend_pid, conn->recv_datarows);
@@ -3332,6 +3446,9 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
                 return RESPONSE_ASSIGN_GXID;
                 
 #ifdef __TBASE__
+			case 'w': /* remote transaction assigned an xid */
+				conn->xid_assigned = true;
+				break;
 			case 'i': /* Remote Instrument */
 				if (msg_len > 0)
 					HandleRemoteInstr(msg, msg_len, conn->nodeid, combiner);
@@ -3388,6 +3505,11 @@ is_data_node_ready(PGXCNodeHandle * conn)
 
 
         msg_type = get_message(conn, &msg_len, &msg);
+#ifdef __TBASE__
+        /* the remote transaction is writing, it must not be demoted */
+        if ('w' == msg_type)
+            conn->xid_assigned = true;
+#endif
         if ('Z' == msg_type)
         {
             /*
@@ -3441,6 +3563,14 @@ pgxc_node_begin(int conn_count, PGXCNodeHandle **connections,
 
     for (i = 0; i < conn_count; i++)
     {
+#ifdef __TBASE__
+        /*
+         * Decide for each connection on its own; callers batch connections
+         * that are and are not in a transaction block already.
+         */
+        need_send_begin = false;
+        cmd = begin_cmd;
+#endif
         if (!readOnly && !IsConnFromDatanode())
             connections[i]->read_only = false;
         /*
@@ -3833,6 +3963,9 @@ pgxc_node_remote_prepare(char *prepareGID, bool localNode, bool implicit)
 #ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
     GlobalTimestamp global_prepare_ts = InvalidGlobalTimestamp;
 #endif
+#ifdef __TBASE__
+    instr_time      latency_start;
+#endif
 #ifdef __TWO_PHASE_TRANS__
     /* conn_state_index record index in g_twophase_state.conn_state or g_twophase_state.datanode_state */
     int             conn_state_index = 0; 
@@ -3863,7 +3996,9 @@ pgxc_node_remote_prepare(char *prepareGID, bool localNode, bool implicit)
         {
             elog(LOG, "prepare remote transaction xid %d gid %s", GetTopTransactionIdIfAny(), prepareGID);
         }
+        CommitLatencyStart(latency_start);
         global_prepare_ts = GetGlobalTimestampGTM();
+        CommitLatencyRecord(COMMIT_LATENCY_GTS, latency_start);
 
 #ifdef __TWO_PHASE_TESTS__
     if (PART_PREPARE_GET_TIMESTAMP == twophase_exception_case)
@@ -3884,6 +4019,10 @@ pgxc_node_remote_prepare(char *prepareGID, bool localNode, bool implicit)
     }
 #endif
 
+#ifdef __TBASE__
+    CommitLatencyStart(latency_start);
+#endif
+
 #ifdef __TWO_PHASE_TRANS__
     /* 
      *g_twophase_state is cleared under the following circumstances:
@@ -4410,6 +4549,10 @@ pgxc_node_remote_prepare(char *prepareGID, bool localNode, bool implicit)
         pfree(connections);
         connections = NULL;
     }
+#ifdef __TBASE__
+    if (conn_count > 0)
+        CommitLatencyRecord(COMMIT_LATENCY_PREPARE, latency_start);
+#endif
     return nodestr.data;
 
 prepare_err:
@@ -4761,8 +4904,13 @@ pgxc_node_remote_commit(TranscationType txn_type, bool need_release_handle)
 	ResponseCombiner combiner;
 	PGXCNodeHandle **connections = NULL;
 	int				conn_count = 0;
+#ifdef __TBASE__
+	instr_time		latency_start;
+#endif
 
 #ifdef __TBASE__
+    CommitLatencyStart(latency_start);
+
     switch (txn_type)
     {
         case TXN_TYPE_CommitTxn:
@@ -4844,7 +4992,7 @@ pgxc_node_remote_commit(TranscationType txn_type, bool need_release_handle)
             }
 #endif
 
-            if (pgxc_node_send_query(conn, commitCmd))
+            if (pgxc_node_queue_query(conn, commitCmd))
             {
                 /*
                  * Do not bother with clean up, just bomb out. The error handler
@@ -4893,7 +5041,7 @@ pgxc_node_remote_commit(TranscationType txn_type, bool need_release_handle)
             }
 #endif
 
-            if (pgxc_node_send_query(conn, commitCmd))
+            if (pgxc_node_queue_query(conn, commitCmd))
             {
                 /*
                  * Do not bother with clean up, just bomb out. The error handler
@@ -4912,6 +5060,19 @@ pgxc_node_remote_commit(TranscationType txn_type, bool need_release_handle)
         }
     }
 
+    /* Put the COMMIT for all the nodes on the wire together */
+    if (pgxc_node_flush_all(conn_count, connections))
+    {
+        for (i = 0; i < conn_count; i++)
+        {
+            if (connections[i]->state == DN_CONNECTION_STATE_ERROR_FATAL)
+                ereport(ERROR,
+                        (errcode(ERRCODE_INTERNAL_ERROR),
+                         errmsg("pgxc_node_remote_commit failed to send COMMIT command to the node %s, pid:%d",
+                                connections[i]->nodename, connections[i]->backend_pid)));
+        }
+    }
+
     /*
      * Release the BarrierLock.
      */
@@ -4948,6 +5109,10 @@ pgxc_node_remote_commit(TranscationType txn_type, bool need_release_handle)
 			}
 		}
 		CloseCombiner(&combiner);
+#ifdef __TBASE__
+		if (TXN_TYPE_CommitTxn == txn_type)
+			CommitLatencyRecord(COMMIT_LATENCY_COMMIT, latency_start);
+#endif
 	}
 
 #ifndef __TBASE__
@@ -6001,9 +6166,15 @@ DataNodeCopyIn(char *data_row, int len,
         {
             /* precalculate to speed up access */
             int bytes_needed = handle->outEnd + 1 + msgLen;
+            int flush_size   = COPY_BUFFER_SIZE;
 
+#ifdef __TBASE__
+            /* hand bigger chunks over to the sender thread */
+            if (g_CopySenderThread || handle->copy_sender)
+                flush_size = COPY_SENDER_CHUNK_SIZE;
+#endif
             /* flush buffer if it is almost full */
-            if (bytes_needed > COPY_BUFFER_SIZE)
+            if (bytes_needed > flush_size)
             {
                 int to_send = handle->outEnd;
 
@@ -6045,6 +6216,20 @@ DataNodeCopyIn(char *data_row, int len,
                 if (DN_CONNECTION_STATE_ERROR(handle))
                     return EOF;
 
+#ifdef __TBASE__
+                if (to_send && (g_CopySenderThread || handle->copy_sender))
+                {
+                    int ret = CopySenderPush(handle, handle->outBuffer, to_send);
+
+                    if (ret < 0)
+                        return EOF;
+                    if (ret > 0)
+                    {
+                        handle->outEnd = 0;
+                        to_send = 0;
+                    }
+                }
+#endif
                 /*
                  * Try to send down buffered data if we have
                  */
@@ -6190,6 +6375,259 @@ DataNodeCopyFinish(int conn_count, PGXCNodeHandle** connections)
         CloseCombiner(&combiner);
 }
 
+#ifdef __TBASE__
+/*
+ * Start the COPY sender thread of a connection. NULL is returned if the
+ * thread can not be created, the caller sends the data itself then.
+ */
+static CopySender *
+CopySenderStart(PGXCNodeHandle *handle)
+{
+    CopySender     *sender;
+    MemoryContext   oldcontext;
+    int             nchunks;
+
+    /* outlives an error in the middle of the copy, freed by CopySenderStop */
+    oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+    nchunks = Max((int) (g_CopySenderQueueSize * 1024L / COPY_SENDER_CHUNK_SIZE), 2);
+    sender = (CopySender *) palloc0(sizeof(CopySender));
+    sender->sock = handle->sock;
+    sender->queue = CreatePipe(nchunks + 1);
+    MemoryContextSwitchTo(oldcontext);
+
+    ThreadSemaInit(&sender->send_sem, 0);
+    sender->latch = MyLatch;
+
+    if (CreateThread(CopySenderThread, (void *) sender, MT_THR_DETACHED) != 0)
+    {
+        elog(LOG, "could not create copy sender thread for node %s, errno %d",
+             handle->nodename, errno);
+        DestoryPipe(sender->queue);
+        pfree(sender);
+        return NULL;
+    }
+
+    handle->copy_sender = sender;
+    return sender;
+}
+
+/*
+ * Queue a buffer of complete COPY messages for the sender thread of the
+ * connection, starting the thread if needed. Waits while the queue is full.
+ * Returns 1 if the data was queued, 0 if there is no sender thread and the
+ * caller has to send the data itself, and -1 on error.
+ */
+static int
+CopySenderPush(PGXCNodeHandle *handle, char *data, int len)
+{
+    CopySender      *sender = (CopySender *) handle->copy_sender;
+    CopySenderChunk *chunk;
+
+    if (sender == NULL)
+    {
+        if (handle->sock == NO_SOCKET)
+            return 0;
+        sender = CopySenderStart(handle);
+        if (sender == NULL)
+            return 0;
+    }
+
+    /* the sender sets our latch whenever it takes a chunk off the queue */
+    for (;;)
+    {
+        int     rc;
+
+        ResetLatch(MyLatch);
+        if (!PipeIsFull(sender->queue) || sender->send_errno != 0)
+            break;
+
+        rc = WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+                       COPY_SENDER_POLL_TIMEOUT, WAIT_EVENT_MQ_SEND);
+        if (rc & WL_POSTMASTER_DEATH)
+            proc_exit(1);
+        CHECK_FOR_INTERRUPTS();
+    }
+
+    if (sender->send_errno)
+    {
+        add_error_message(handle, "failed to send data to data node");
+        return -1;
+    }
+
+    chunk = (CopySenderChunk *) malloc(offsetof(CopySenderChunk, data) + len);
+    if (chunk == NULL)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_OUT_OF_MEMORY),
+                 errmsg("out of memory")));
+    }
+    chunk->len = len;
+    memcpy(chunk->data, data, len);
+
+    /* only the backend puts, so there is room */
+    (void) PipePut(sender->queue, chunk);
+    ThreadSemaUp(&sender->send_sem);
+    return 1;
+}
+
+/*
+ * Tell the sender thread of the connection to exit and wait for it. Queued
+ * data is sent out first unless abort is set. Returns false if not all the
+ * data could be sent, the connection is not usable for the copy then.
+ *
+ * The wait can be cancelled or terminated: the rest of the data is dropped
+ * then, which the sender notices within COPY_SENDER_POLL_TIMEOUT even if the
+ * datanode does not read anymore, and the interrupt is processed once it has
+ * exited.
+ */
+static bool
+CopySenderStop(PGXCNodeHandle *handle, bool abort)
+{
+    CopySender *sender = (CopySender *) handle->copy_sender;
+    bool        succeed;
+    bool        interrupted = false;
+
+    if (sender == NULL)
+        return true;
+
+    if (abort)
+        sender->need_abort = true;
+    else
+        sender->need_quit = true;
+    ThreadSemaUp(&sender->send_sem);
+
+    for (;;)
+    {
+        int     rc;
+
+        ResetLatch(MyLatch);
+        if (sender->exited)
+            break;
+
+        /* only a cancel or a termination ends the copy, not other interrupts */
+        if (!sender->need_abort && (QueryCancelPending || ProcDiePending) &&
+            InterruptHoldoffCount == 0 && CritSectionCount == 0)
+        {
+            sender->need_abort = true;
+            interrupted = true;
+        }
+
+        rc = WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+                       COPY_SENDER_POLL_TIMEOUT, WAIT_EVENT_MQ_SEND);
+        if (rc & WL_POSTMASTER_DEATH)
+            proc_exit(1);
+    }
+    pg_read_barrier();
+
+    succeed = (sender->send_errno == 0 && !interrupted);
+    if (!succeed)
+    {
+        add_error_message(handle, "failed to send data to data node");
+        /* a message may have been cut in the middle, do not reuse */
+        PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_ERROR_FATAL);
+    }
+
+    DestoryPipe(sender->queue);
+    pfree(sender);
+    handle->copy_sender = NULL;
+
+    if (interrupted)
+        CHECK_FOR_INTERRUPTS();
+    return succeed;
+}
+
+/*
+ * Write one chunk to the socket. Returns 0 or the errno of the failure.
+ */
+static int
+CopySenderSendChunk(CopySender *sender, CopySenderChunk *chunk)
+{
+    char *ptr = chunk->data;
+    int   len = chunk->len;
+
+    while (len > 0)
+    {
+        int sent = send(sender->sock, ptr, len, 0);
+
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                struct pollfd pfd;
+
+                /* the other side does not read, give up on abort */
+                if (sender->need_abort)
+                    return ECONNABORTED;
+
+                pfd.fd = sender->sock;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+                if (poll(&pfd, 1, COPY_SENDER_POLL_TIMEOUT) < 0 && errno != EINTR)
+                    return errno;
+                continue;
+            }
+            return errno;
+        }
+
+        ptr += sent;
+        len -= sent;
+    }
+    return 0;
+}
+
+/*
+ * Send or drop, on abort or after a failure, all queued chunks.
+ */
+static void
+CopySenderDrain(CopySender *sender)
+{
+    CopySenderChunk *chunk;
+
+    while ((chunk = (CopySenderChunk *) PipeGet(sender->queue)) != NULL)
+    {
+        /* there is room in the queue again */
+        SetLatch(sender->latch);
+        if (!sender->need_abort && sender->send_errno == 0)
+            sender->send_errno = CopySenderSendChunk(sender, chunk);
+        free(chunk);
+    }
+}
+
+/*
+ * COPY sender thread main loop.
+ */
+static void *
+CopySenderThread(void *arg)
+{
+    CopySender *sender = (CopySender *) arg;
+    Latch      *latch;
+
+    ThreadSigmask();
+    while (1)
+    {
+        ThreadSemaDown(&sender->send_sem);
+
+        CopySenderDrain(sender);
+        if (sender->need_quit || sender->need_abort)
+        {
+            /* pick up what was queued right before the request */
+            CopySenderDrain(sender);
+            break;
+        }
+    }
+
+    /* Tell the backend quit is done, it may free the sender right away. */
+    latch = sender->latch;
+    pg_write_barrier();
+    sender->exited = true;
+    SetLatch(latch);
+    return NULL;
+}
+#endif
+
 /*
  * End copy process on a connection
  */
@@ -6201,6 +6639,12 @@ DataNodeCopyEnd(PGXCNodeHandle *handle, bool is_error)
     if (handle == NULL)
         return true;
 
+#ifdef __TBASE__
+    /* rows queued for the sender thread go out before the end of copy */
+    if (handle->copy_sender && !CopySenderStop(handle, is_error))
+        return true;
+#endif
+
     /* msgType + msgLen */
     if (ensure_out_buffer_capacity(handle->outEnd + 1 + 4, handle) != 0)
         return true;
@@ -7688,6 +8132,11 @@ PreAbort_Remote(TranscationType txn_type, bool need_release_handle)
     for (i = 0; i < all_handles->dn_conn_count; i++)
     {
         PGXCNodeHandle *handle = all_handles->datanode_handles[i];
+#ifdef __TBASE__
+        /* queued COPY rows are of no use any more */
+        if (handle->copy_sender)
+            CopySenderStop(handle, true);
+#endif
 		if (handle->sock != NO_SOCKET)
 		{		
 			if (handle->state == DN_CONNECTION_STATE_COPY_IN ||
@@ -8084,6 +8533,20 @@ IsTwoPhaseCommitRequired(bool localWrite)
         PGXCNodeHandle *conn = handles->datanode_handles[i];
 
 #ifdef __TBASE__
+        /*
+         * A datanode that was begun writable but never assigned an xid has
+         * nothing to prepare.  Commit it like a read-only participant, so
+         * that a single remaining writer is committed without 2PC.  The
+         * connection must be idle, or its xid report may still be unread,
+         * and the node must have agreed to report xids at all.
+         */
+        if (enable_onephase_commit && conn->sock != NO_SOCKET &&
+            (conn->remote_features & REMOTE_FEATURE_XID_REPORT) &&
+            !conn->read_only && !conn->xid_assigned &&
+            conn->transaction_status == 'T' &&
+            conn->state == DN_CONNECTION_STATE_IDLE)
+            conn->read_only = true;
+
 		elog(DEBUG5, "IsTwoPhaseCommitRequired, conn->nodename=%s, conn->sock=%d, conn->read_only=%d, conn->transaction_status=%c", 
 			conn->nodename, conn->sock, conn->read_only, conn->transaction_status);
 #endif
@@ -8465,6 +8928,9 @@ pgxc_node_remote_finish(char *prepareGID, bool commit,
 #ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
     GlobalTimestamp    global_committs;
 #endif
+#ifdef __TBASE__
+    instr_time         latency_start;
+#endif
 #ifdef __TWO_PHASE_TRANS__
     /* 
      *any send error in twophase trans will set all_conn_healthy to false 
@@ -8514,7 +8980,9 @@ pgxc_node_remote_finish(char *prepareGID, bool commit,
         pg_usleep(delay_before_acquire_committs);
     }
 
+    CommitLatencyStart(latency_start);
     global_committs = GetGlobalTimestampGTM();
+    CommitLatencyRecord(COMMIT_LATENCY_GTS, latency_start);
     if(!GlobalTimestampIsValid(global_committs)){
         ereport(ERROR,
         (errcode(ERRCODE_INTERNAL_ERROR),
@@ -8533,6 +9001,9 @@ pgxc_node_remote_finish(char *prepareGID, bool commit,
     }
     SetGlobalCommitTimestamp(global_committs);/* Save for local commit */
 #endif
+#ifdef __TBASE__
+    CommitLatencyStart(latency_start);
+#endif
 
     nodename = strtok(nodestring, ",");
     while (nodename != NULL)
@@ -8659,7 +9130,7 @@ pgxc_node_remote_finish(char *prepareGID, bool commit,
         }
 #endif
 
-        if (pgxc_node_send_query(conn, finish_cmd))
+        if (pgxc_node_queue_query(conn, finish_cmd))
         {
 #ifdef __TWO_PHASE_TRANS__
             // record conn state :send gxid fail
@@ -8690,6 +9161,17 @@ pgxc_node_remote_finish(char *prepareGID, bool commit,
     }
 
     /* Make sure datanode commit first */
+    if (conn_count && is_txn_has_parallel_ddl)
+    {
+        /* participants the command could not be written to are dropped */
+        if (pgxc_node_remote_finish_flush(connections, &conn_count, commit))
+        {
+#ifdef __TWO_PHASE_TRANS__
+            all_conn_healthy = false;
+#endif
+        }
+    }
+
     if (conn_count && is_txn_has_parallel_ddl)
     {
         InitResponseCombiner(&combiner, conn_count, COMBINE_TYPE_NONE);
@@ -8754,7 +9236,7 @@ pgxc_node_remote_finish(char *prepareGID, bool commit,
         }
 #endif
 
-        if (pgxc_node_send_query(conn, finish_cmd))
+        if (pgxc_node_queue_query(conn, finish_cmd))
         {
 #ifdef __TWO_PHASE_TRANS__
             g_twophase_state.coord_state[twophase_index].conn_state = 
@@ -8782,6 +9264,17 @@ pgxc_node_remote_finish(char *prepareGID, bool commit,
         }
     }
 
+    if (conn_count)
+    {
+        /* participants the command could not be written to are dropped */
+        if (pgxc_node_remote_finish_flush(connections, &conn_count, commit))
+        {
+#ifdef __TWO_PHASE_TRANS__
+            all_conn_healthy = false;
+#endif
+        }
+    }
+
     if (conn_count)
     {
         InitResponseCombiner(&combiner, conn_count, COMBINE_TYPE_NONE);
@@ -8852,10 +9345,82 @@ pgxc_node_remote_finish(char *prepareGID, bool commit,
         pfree(connections);
         connections = NULL;
     }
+
+#ifdef __TBASE__
+    if (commit)
+        CommitLatencyRecord(COMMIT_LATENCY_COMMIT, latency_start);
+#endif
     
     return prepared_local;
 }
 
+#ifdef __TBASE__
+/*
+ * Send the COMMIT/ROLLBACK PREPARED queued for a batch of participants in
+ * one go.  A participant the command could not be written to is recorded as
+ * a send failure, just like one the command could not be queued for, and is
+ * removed from the batch so that no response is awaited from it.  Returns
+ * the number of such participants; *conn_count is reduced accordingly.
+ */
+static int
+pgxc_node_remote_finish_flush(PGXCNodeHandle **connections, int *conn_count,
+                              bool commit)
+{
+    int     nfailed;
+    int     nleft = 0;
+    int     i;
+#ifdef __TWO_PHASE_TRANS__
+    /* the batch was registered last in g_twophase_state.connections */
+    int     first = g_twophase_state.connections_num - *conn_count;
+#endif
+
+    nfailed = pgxc_node_flush_all(*conn_count, connections);
+    if (nfailed == 0)
+        return 0;
+
+    for (i = 0; i < *conn_count; i++)
+    {
+#ifdef __TWO_PHASE_TRANS__
+        ConnTransState *conn_state;
+        int             index;
+#endif
+
+        if (connections[i]->state != DN_CONNECTION_STATE_ERROR_FATAL)
+        {
+            /*
+             * Keep connections[] and g_twophase_state.connections in step,
+             * responses are matched to the latter by position.
+             */
+            connections[nleft] = connections[i];
+#ifdef __TWO_PHASE_TRANS__
+            g_twophase_state.connections[first + nleft] =
+                g_twophase_state.connections[first + i];
+#endif
+            nleft++;
+            continue;
+        }
+
+#ifdef __TWO_PHASE_TRANS__
+        index = g_twophase_state.connections[first + i].conn_trans_state_index;
+        if (g_twophase_state.connections[first + i].node_type == PGXC_NODE_DATANODE)
+            conn_state = &g_twophase_state.datanode_state[index];
+        else
+            conn_state = &g_twophase_state.coord_state[index];
+
+        conn_state->conn_state = TWO_PHASE_SEND_QUERY_ERROR;
+        conn_state->state = commit ? TWO_PHASE_COMMIT_ERROR : TWO_PHASE_ABORT_ERROR;
+#endif
+    }
+
+#ifdef __TWO_PHASE_TRANS__
+    g_twophase_state.connections_num -= *conn_count - nleft;
+#endif
+    *conn_count = nleft;
+
+    return nfailed;
+}
+#endif
+
 /*****************************************************************************
  *
  * Simplified versions of ExecInitRemoteQuery, ExecRemoteQuery and
@@ -9955,6 +10520,9 @@ ExecInitRemoteSubplan(RemoteSubplan *node, EState *estate, int eflags)
     Oid                    reloid  = InvalidOid;
     ListCell *table;
 #endif
+#ifdef __TBASE__
+    int                 cache_slot;
+#endif
 
     if (log_remotesubplan_stats)
         ResetUsageCommon(&start_r, &start_t);
@@ -10361,6 +10929,24 @@ ExecInitRemoteSubplan(RemoteSubplan *node, EState *estate, int eflags)
          * else which gets reset in case of errors. But for now, this seems
          * enough.
          */
+#ifdef __TBASE__
+        /* the text of a plan executed before by this backend may be cached */
+        cache_slot = RemotePlanCacheLookup(node->cache_id, rstmt.nParamRemote,
+                                           rstmt.remoteparams);
+        if (cache_slot >= 0)
+        {
+#ifdef __AUDIT__
+            /* it carries the source query if it did when it was encoded */
+            if (IS_PGXC_COORDINATOR && IsConnFromApp() && 
+                estate->es_plannedstmt->parseTree != NULL &&
+                estate->es_remote_subplan_num == 0)
+                estate->es_remote_subplan_num++;
+#endif
+            remotestate->subplanstr = RemotePlanCacheGetText(cache_slot);
+        }
+        else
+        {
+#endif
         PG_TRY();
         {
             set_portable_output(true);
@@ -10392,6 +10978,11 @@ ExecInitRemoteSubplan(RemoteSubplan *node, EState *estate, int eflags)
         }
         PG_END_TRY();
         set_portable_output(false);
+#ifdef __TBASE__
+            RemotePlanCacheStore(remotestate->subplanstr, rstmt.nParamRemote,
+                                 rstmt.remoteparams, &node->cache_id);
+        }
+#endif
 
         /*
          * Connect to remote nodes and send down subplan.
@@ -10454,6 +11045,12 @@ ExecFinishInitRemoteSubplan(RemoteSubplanState *node)
     int                 i;
     bool                is_read_only;
     char                cursor[NAMEDATALEN];
+    int                 cache_slot = -1;
+    uint32              cache_id = 0;
+#ifdef __TBASE__
+    instr_time          setup_start;
+    instr_time          setup_end;
+#endif
     
 #ifdef __TBASE__
     node->finish_init = true;
@@ -10574,6 +11171,106 @@ ExecFinishInitRemoteSubplan(RemoteSubplanState *node)
     }
 #endif 
 
+#ifdef __TBASE__
+    if (estate->es_instrument & INSTRUMENT_TIMER)
+        INSTR_TIME_SET_CURRENT(setup_start);
+
+    /*
+     * Start the transaction on all nodes at once, so that the BEGIN round
+     * trips overlap instead of being paid one node after another.
+     */
+    if (pgxc_node_begin(combiner->conn_count, combiner->connections, gxid, true,
+                        is_read_only, PGXC_NODE_DATANODE))
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("Could not begin transaction on data nodes.")));
+
+    if (estate->es_instrument & INSTRUMENT_TIMER)
+    {
+        INSTR_TIME_SET_CURRENT(setup_end);
+        INSTR_TIME_SUBTRACT(setup_end, setup_start);
+        node->setup_begin_time = INSTR_TIME_GET_MILLISEC(setup_end);
+        INSTR_TIME_SET_CURRENT(setup_start);
+    }
+
+    /* nodes that received this plan before only need its cache slot */
+    cache_slot = RemotePlanCacheLookup(plan->cache_id, node->nParamRemote,
+                                       node->remoteparams);
+    if (cache_slot < 0)
+        cache_slot = RemotePlanCacheStore(node->subplanstr, node->nParamRemote,
+                                          node->remoteparams, &plan->cache_id);
+    cache_id = plan->cache_id;
+
+    /*
+     * Queue everything a node needs to store the subplan in its output
+     * buffer, and only then flush the buffers, so that each node receives
+     * one write and all nodes work on it concurrently.
+     */
+    for (i = 0; i < combiner->conn_count; i++)
+    {
+        PGXCNodeHandle *connection = combiner->connections[i];
+
+        /* pgxc_node_begin has queued the timestamp already if it is valid */
+        if (!GlobalTimestampIsValid(timestamp) &&
+            pgxc_node_send_timestamp(connection, timestamp))
+        {
+            combiner->conn_count = 0;
+            pfree(combiner->connections);
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("Failed to send command to data nodes")));
+        }
+        if (snapshot && pgxc_node_send_snapshot(connection, snapshot))
+        {
+            combiner->conn_count = 0;
+            pfree(combiner->connections);
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("Failed to send snapshot to data nodes")));
+        }
+        if (pgxc_node_send_cmd_id(connection, estate->es_snapshot->curcid) < 0 )
+        {
+            combiner->conn_count = 0;
+            pfree(combiner->connections);
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("Failed to send command ID to data nodes")));
+        }
+        pgxc_node_send_plan(connection, cursor, "Remote Subplan",
+							node->subplanstr, node->nParamRemote, paramtypes, estate->es_instrument,
+							cache_slot, cache_id);
+
+		if (enable_statistic)
+		{
+			elog(LOG, "Plan Message:pid:%d,remote_pid:%d,remote_ip:%s,"
+					  "remote_port:%d,fd:%d,cursor:%s",
+				      MyProcPid, connection->backend_pid, connection->nodehost,
+					  connection->nodeport, connection->sock, cursor);
+		}
+	}
+
+	for (i = 0; i < combiner->conn_count; i++)
+	{
+		PGXCNodeHandle *connection = combiner->connections[i];
+
+		if (pgxc_node_flush(connection))
+		{
+			combiner->conn_count = 0;
+			pfree(combiner->connections);
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("Failed to send subplan to data nodes")));
+		}
+	}
+
+    node->setup_nodes = combiner->conn_count;
+    if (estate->es_instrument & INSTRUMENT_TIMER)
+    {
+        INSTR_TIME_SET_CURRENT(setup_end);
+        INSTR_TIME_SUBTRACT(setup_end, setup_start);
+        node->setup_dispatch_time = INSTR_TIME_GET_MILLISEC(setup_end);
+    }
+#else
     for (i = 0; i < combiner->conn_count; i++)
     {
         PGXCNodeHandle *connection = combiner->connections[i];
@@ -10610,7 +11307,8 @@ ExecFinishInitRemoteSubplan(RemoteSubplanState *node)
                      errmsg("Failed to send command ID to data nodes")));
         }
         pgxc_node_send_plan(connection, cursor, "Remote Subplan",
-							node->subplanstr, node->nParamRemote, paramtypes, estate->es_instrument);
+							node->subplanstr, node->nParamRemote, paramtypes, estate->es_instrument,
+							cache_slot, cache_id);
 
 		if (enable_statistic)
 		{
@@ -10629,6 +11327,7 @@ ExecFinishInitRemoteSubplan(RemoteSubplanState *node)
 					 errmsg("Failed to send subplan to data nodes")));
 		}
 	}
+#endif
 }
 
 
@@ -11042,6 +11741,24 @@ primary_mode_phase_two:
                              errmsg("Failed to send snapshot to data nodes")));
                 }
 
+#ifdef __TBASE__
+                /*
+                 * runtime filter goes right before the Bind it applies to,
+                 * nodes that did not announce filters scan without one
+                 */
+                if (node->runtime_filter &&
+                    (conn->remote_features & REMOTE_FEATURE_RUNTIME_FILTER) &&
+                    pgxc_node_send_runtime_filter(conn, node->runtime_filter,
+                                                  node->runtime_filter_len))
+                {
+                    combiner->conn_count = 0;
+                    pfree(combiner->connections);
+                    ereport(ERROR,
+                            (errcode(ERRCODE_INTERNAL_ERROR),
+                             errmsg("Failed to send runtime filter to data nodes")));
+                }
+#endif
+
                 /* bind */
 				pgxc_node_send_bind(conn, cursor, cursor, paramlen, paramdata,
 				                    epqctxlen, epqctxdata);
@@ -11076,6 +11793,16 @@ primary_mode_phase_two:
                 }
             }
 
+#ifdef __TBASE__
+            /* the filter describes the first scan only, never resend it */
+            if (node->runtime_filter)
+            {
+                pfree(node->runtime_filter);
+                node->runtime_filter = NULL;
+                node->runtime_filter_len = 0;
+            }
+#endif
+
             /*
              * On second phase of primary mode connections are backed up
              * already, so do not copy.
@@ -11188,6 +11915,28 @@ primary_mode_phase_two:
 }
 
 
+#ifdef __TBASE__
+/*
+ * Hand a serialized runtime filter over to the subplan, to be sent to the
+ * remote nodes with its first Bind.  Too late if the subplan is already
+ * running, and useless if it is executed locally; the filter is dropped then.
+ */
+void
+ExecRemoteSubplanSetRuntimeFilter(RemoteSubplanState *node, char *data, int len)
+{
+    if (node->bound || node->local_exec)
+    {
+        pfree(data);
+        return;
+    }
+
+    if (node->runtime_filter)
+        pfree(node->runtime_filter);
+    node->runtime_filter = data;
+    node->runtime_filter_len = len;
+}
+#endif
+
 void
 ExecReScanRemoteSubplan(RemoteSubplanState *node)
 {
@@ -32,6 +32,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include "access/gtm.h"
+#include "access/hash.h"
 #include "access/transam.h"
 #include "access/xact.h"
 #include "access/htup_details.h"
@@ -57,6 +58,7 @@
 #include "utils/syscache.h"
 #include "utils/lsyscache.h"
 #include "utils/formatting.h"
+#include "utils/inval.h"
 #include "utils/tqual.h"
 #include "../interfaces/libpq/libpq-int.h"
 #include "../interfaces/libpq/libpq-fe.h"
@@ -112,6 +114,8 @@ pgxc_check_socket_health(int sock, int forRead, int forWrite, time_t end_time);
 
 static int	pgxc_coordinator_proc_pid = 0;
 static TransactionId pgxc_coordinator_proc_vxid = InvalidTransactionId;
+
+int         g_RemoteFeatures = 0;
 #endif
 
 /* Current size of dn_handles and co_handles */
@@ -164,6 +168,8 @@ static void PGXCNodeHandleError(PGXCNodeHandle *handle, char *msg_body, int len)
 static PGXCNodeAllHandles * get_empty_handles(void);
 static void get_current_dn_handles_internal(PGXCNodeAllHandles *result);
 static void get_current_cn_handles_internal(PGXCNodeAllHandles *result);
+static bool pgxc_node_park_handles(void);
+static void pgxc_node_unpark_handles(void);
 #endif
 
 /*
@@ -195,6 +201,8 @@ init_pgxc_handle(PGXCNodeHandle *pgxc_handle)
 	pgxc_handle->sock_fatal_occurred = false;
     pgxc_handle->plpgsql_need_begin_sub_txn = false;
     pgxc_handle->plpgsql_need_begin_txn = false;
+    pgxc_handle->copy_sender = NULL;
+    pgxc_node_forget_cached_plans(pgxc_handle);
 #endif
 #ifndef __USE_GLOBAL_SNAPSHOT__
     pgxc_handle->sendGxidVersion = 0;
@@ -662,6 +670,9 @@ pgxc_node_init(PGXCNodeHandle *handle, int sock, bool global_session, int pid)
     handle->transaction_status = 'I';
     PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_IDLE);
     handle->read_only = true;
+#ifdef __TBASE__
+    handle->xid_assigned = false;
+#endif
     handle->ck_resp_rollback = false;
     handle->combiner = NULL;
 #ifdef DN_CONNECTION_DEBUG
@@ -679,6 +690,9 @@ pgxc_node_init(PGXCNodeHandle *handle, int sock, bool global_session, int pid)
     handle->plpgsql_need_begin_txn = false;
     handle->sendGxidVersion = 0;
 	handle->sock_fatal_occurred = false;
+	handle->remote_features = 0;
+	/* a different remote backend may be behind the handle now */
+	pgxc_node_forget_cached_plans(handle);
 #endif
     /*
      * We got a new connection, set on the remote node the session parameters
@@ -687,6 +701,15 @@ pgxc_node_init(PGXCNodeHandle *handle, int sock, bool global_session, int pid)
     if (global_session)
     {
         init_str = PGXCNodeGetSessionParamStr();
+#ifdef __TBASE__
+        /* negotiate the protocol features in the same round trip */
+        init_str = psprintf("SET %s = %d;%s",
+                            REMOTE_FEATURES_GUC, REMOTE_FEATURES_SUPPORTED,
+                            init_str ? init_str : "");
+        pgxc_node_set_query(handle, init_str);
+        pfree(init_str);
+        init_str = NULL;
+#endif
         if (init_str)
         {
             pgxc_node_set_query(handle, init_str);
@@ -1077,6 +1100,9 @@ pgxc_print_pending_data(PGXCNodeHandle *handle, bool reset)
             case 'x':
                 elog(LOG, "LEFT_OVER RESPONSE_ASSIGN_GXID found");
                 break;
+            case 'w':
+                elog(LOG, "LEFT_OVER xid assigned found");
+                break;
             default:
                 elog(LOG, "LEFT_OVER invalid status found");
                 break;
@@ -1086,6 +1112,9 @@ pgxc_print_pending_data(PGXCNodeHandle *handle, bool reset)
 DONE:    
     handle->state = DN_CONNECTION_STATE_IDLE;
     handle->transaction_status = 'I';    
+#ifdef __TBASE__
+    handle->xid_assigned = false;
+#endif
     handle->error[0] = '\0';
     
     /* reset the status */
@@ -1101,6 +1130,9 @@ DONE:
         handle->inEnd = 0;
         handle->inCursor = 0;
         handle->needSync = false;
+#ifdef __TBASE__
+        pgxc_node_forget_cached_plans(handle);
+#endif
     }
 }
 
@@ -1377,6 +1409,143 @@ get_message(PGXCNodeHandle *conn, int *len, char **msg)
 }
 
 
+#ifdef __TBASE__
+/*
+ * Can the handle be parked?  Only clean connections are, since the pooler
+ * may hand a parked connection to another session at any time.
+ */
+static bool
+pgxc_node_handle_parkable(PGXCNodeHandle *handle)
+{
+	if (handle->sock == NO_SOCKET)
+	{
+		return true;
+	}
+
+	return handle->state == DN_CONNECTION_STATE_IDLE &&
+		handle->transaction_status == 'I' &&
+		!handle->sock_fatal_occurred &&
+		pgxc_node_is_data_enqueued(handle) == 0;
+}
+
+/*
+ * Forget the transaction state of a parked handle.  Unlike pgxc_node_init()
+ * this keeps what we know about the remote session, which stays the same.
+ */
+static void
+pgxc_node_reset_parked(PGXCNodeHandle *handle)
+{
+	if (handle->sock == NO_SOCKET)
+	{
+		return;
+	}
+
+	handle->read_only = true;
+	handle->xid_assigned = false;
+	handle->ck_resp_rollback = false;
+	handle->combiner = NULL;
+	handle->error[0] = '\0';
+	handle->needSync = false;
+	handle->recv_datarows = 0;
+	handle->plpgsql_need_begin_sub_txn = false;
+	handle->plpgsql_need_begin_txn = false;
+#ifndef __USE_GLOBAL_SNAPSHOT__
+	handle->sendGxidVersion = 0;
+#endif
+}
+
+/*
+ * Keep the connections of the session at the end of the transaction instead
+ * of giving them back to the pooler, see PoolManagerParkConnections().
+ * Returns false if the connections have to be released as usual.
+ */
+static bool
+pgxc_node_park_handles(void)
+{
+	int			i;
+
+	if (!PoolerFastPath)
+	{
+		return false;
+	}
+
+	for (i = 0; i < NumDataNodes; i++)
+	{
+		if (!pgxc_node_handle_parkable(&dn_handles[i]))
+			return false;
+	}
+	for (i = 0; i < NumSlaveDataNodes; i++)
+	{
+		if (!pgxc_node_handle_parkable(&sdn_handles[i]))
+			return false;
+	}
+	if (IS_PGXC_COORDINATOR)
+	{
+		for (i = 0; i < NumCoords; i++)
+		{
+			if (!pgxc_node_handle_parkable(&co_handles[i]))
+				return false;
+		}
+	}
+
+	if (!PoolManagerParkConnections())
+	{
+		return false;
+	}
+
+	for (i = 0; i < NumDataNodes; i++)
+		pgxc_node_reset_parked(&dn_handles[i]);
+	for (i = 0; i < NumSlaveDataNodes; i++)
+		pgxc_node_reset_parked(&sdn_handles[i]);
+	if (IS_PGXC_COORDINATOR)
+	{
+		for (i = 0; i < NumCoords; i++)
+			pgxc_node_reset_parked(&co_handles[i]);
+	}
+
+	return true;
+}
+
+/*
+ * Called before the handles are used: make sure the connections parked at
+ * the end of the last transaction still belong to the session.  If the
+ * pooler took them back, only close our copies of the sockets, the pool
+ * already has the connections.
+ */
+static void
+pgxc_node_unpark_handles(void)
+{
+	int			i;
+
+	if (PoolManagerUnparkConnections())
+	{
+		return;
+	}
+
+	elog(DEBUG1, "parked connections were reclaimed by the pooler");
+
+	if (dn_handles)
+	{
+		for (i = 0; i < NumDataNodes; i++)
+			pgxc_node_free(&dn_handles[i]);
+	}
+	if (sdn_handles)
+	{
+		for (i = 0; i < NumSlaveDataNodes; i++)
+			pgxc_node_free(&sdn_handles[i]);
+	}
+	if (co_handles)
+	{
+		for (i = 0; i < NumCoords; i++)
+			pgxc_node_free(&co_handles[i]);
+	}
+
+	datanode_count = 0;
+	coord_count = 0;
+	slavedatanode_count = 0;
+}
+#endif
+
 /*
  * Release all Datanode and Coordinator connections
  * back to pool and release occupied memory.
@@ -1388,6 +1557,10 @@ release_handles(bool force)
 	bool		destroy = false;
 	int			i;
 	int		 	nbytes	= 0;	
+
+#ifdef __TBASE__
+	pgxc_node_unpark_handles();
+#endif
 	if (!force)
 	{
 		/* don't free connection if holding a cluster lock */
@@ -1406,6 +1579,14 @@ release_handles(bool force)
         {
             return;
         }
+
+#ifdef __TBASE__
+		/* keep clean connections for the next transaction if we can */
+		if (pgxc_node_park_handles())
+		{
+			return;
+		}
+#endif
     }
     
     /* Free Datanodes handles */
@@ -1541,6 +1722,9 @@ reset_handles(void)
 {
 	int			i;
 
+#ifdef __TBASE__
+	pgxc_node_unpark_handles();
+#endif
 	/* don't reset connection if holding a cluster lock */
 	if (cluster_ex_lock_held)
 	{
@@ -1602,6 +1786,10 @@ validate_handles(void)
 {
     int            i;    
     int            ret;
+
+#ifdef __TBASE__
+    pgxc_node_unpark_handles();
+#endif
     
     /* Free Datanodes handles */
     for (i = 0; i < NumDataNodes; i++)
@@ -2173,7 +2361,8 @@ pgxc_node_send_parse(PGXCNodeHandle * handle, const char* statement,
 int
 pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
                     const char *query, const char *planstr,
-					short num_params, Oid *param_types, int instrument_options)
+					short num_params, Oid *param_types, int instrument_options,
+					int cache_slot, uint32 cache_id)
 {
     int            stmtLen;
     int            queryLen;
@@ -2183,11 +2372,33 @@ pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
     char      **paramTypes = (char **)palloc(sizeof(char *) * num_params);
     int            i;
     short        tmp_num_params;
+#ifdef __TBASE__
+    int         cacheLen = 0;
+    uint32        n32;
+#endif
 
     /* Invalid connection state, return error */
     if (handle->state != DN_CONNECTION_STATE_IDLE)
         return EOF;
 
+#ifdef __TBASE__
+    /* nodes that did not announce the plan cache get the original message */
+    if (!(handle->remote_features & REMOTE_FEATURE_PLAN_CACHE))
+        cache_slot = -1;
+
+    /*
+     * If the node already holds this plan in its cache, refer to it by the
+     * slot instead of sending it again; otherwise send it for the node to
+     * store in the slot.
+     */
+    if (cache_slot >= 0)
+    {
+        cacheLen = 8;
+        if (handle->plan_cache_ids[cache_slot] == cache_id)
+            planstr = "";
+    }
+#endif
+
     /* statement name size (do not allow NULL) */
     stmtLen = strlen(statement) + 1;
     /* source query size (do not allow NULL) */
@@ -2204,6 +2415,10 @@ pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
     }
 	/* size + pnameLen + queryLen + parameters + instrument_options */
 	msgLen = 4 + queryLen + stmtLen + planLen + paramTypeLen + 4;
+#ifdef __TBASE__
+	/* + plan cache slot and id */
+	msgLen += cacheLen;
+#endif
 
     /* msgType + msgLen */
     if (ensure_out_buffer_capacity(handle->outEnd + 1 + msgLen, handle) != 0)
@@ -2247,6 +2462,19 @@ pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
 	instrument_options = htonl(instrument_options);
 	memcpy(handle->outBuffer + handle->outEnd, &instrument_options, 4);
 	handle->outEnd += 4;
+#ifdef __TBASE__
+	/* plan cache slot and plan id */
+	if (cache_slot >= 0)
+	{
+		n32 = htonl(cache_slot);
+		memcpy(handle->outBuffer + handle->outEnd, &n32, 4);
+		handle->outEnd += 4;
+		n32 = htonl(cache_id);
+		memcpy(handle->outBuffer + handle->outEnd, &n32, 4);
+		handle->outEnd += 4;
+		handle->plan_cache_ids[cache_slot] = cache_id;
+	}
+#endif
 
     handle->last_command = 'a';
 
@@ -2254,6 +2482,350 @@ pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
      return 0;
 }
 
+#ifdef __TBASE__
+/*
+ * Remote plan cache
+ *
+ * Repeated executions of a statement ship the same serialized subplan to the
+ * same nodes over and over.  To avoid that, the coordinator session assigns
+ * each recently sent plan one of REMOTE_PLAN_CACHE_SLOTS slots and an id, and
+ * the remote backend keeps a copy of the plan text in the same slot.  Each
+ * handle records which plan ids its remote backend has been sent, so that a
+ * plan already held there is referred to by slot and id only.
+ *
+ * The remote side never changes a slot on its own, so the coordinator's view
+ * stays accurate as long as the handle talks to the same remote backend and
+ * every message it queued was processed.  The view is dropped whenever that
+ * may not hold: a new connection behind the handle, discarded output, or an
+ * error reported by the node (which then skips messages until Sync).  If the
+ * views still disagree, the remote side reports an error rather than running
+ * a different plan.
+ *
+ * The coordinator finds the cached text of a subplan through the id kept in
+ * its RemoteSubplan node, so a statement executed again is not serialized
+ * again.  The id changes whenever the slot is reused, and the text is only
+ * reused if it was built for the same parameters.  The remote side keeps the
+ * parsed plan next to the text, shared by the prepared statements built from
+ * it, and throws it away on any relcache or syscache invalidation, as names
+ * in the text may then resolve to other objects.  Plans containing
+ * RemoteSubplan nodes are parsed every time, as their execution modifies the
+ * plan tree.
+ */
+bool		enable_remote_plan_cache = true;
+
+/* remote side: a parsed plan, shared by the statements using it */
+typedef struct RemotePlanTree
+{
+	MemoryContext context;		/* holds this struct and the plan */
+	RemoteStmt *rstmt;
+	int			refcount;		/* statements using it, plus one if cached */
+} RemotePlanTree;
+
+typedef struct RemotePlanCacheEntry
+{
+	uint32		id;				/* 0 if the slot is unused */
+	int			len;			/* length of the plan text */
+	char	   *planstr;		/* plan text, in TopMemoryContext */
+	uint64		lastused;		/* for LRU replacement */
+	/* coordinator side */
+	int			nparams;		/* parameters the text was built for */
+	RemoteParam *params;
+	/* remote side */
+	bool		shareable;		/* may the parsed plan be shared */
+	RemotePlanTree *tree;		/* parsed plan, if any */
+} RemotePlanCacheEntry;
+
+/* coordinator side: plans this session has assigned to slots */
+static RemotePlanCacheEntry sent_plans[REMOTE_PLAN_CACHE_SLOTS];
+static uint32 sent_plans_last_id = 0;
+static uint64 sent_plans_clock = 0;
+
+/* remote side: plans stored on request of the session using this backend */
+static RemotePlanCacheEntry stored_plans[REMOTE_PLAN_CACHE_SLOTS];
+static bool stored_plans_callbacks = false;
+static uint64 stored_plans_invalidations = 0;
+
+/*
+ * Find the cache slot of the plan text cached under the given id, provided
+ * it was built for the same parameters.  Returns -1 if there is none.
+ */
+int
+RemotePlanCacheLookup(uint32 id, int nparams, RemoteParam *params)
+{
+	RemotePlanCacheEntry *entry;
+	int			i;
+
+	if (!enable_remote_plan_cache || id == 0)
+		return -1;
+
+	for (i = 0; i < REMOTE_PLAN_CACHE_SLOTS; i++)
+	{
+		entry = &sent_plans[i];
+
+		if (entry->id != id)
+			continue;
+
+		if (entry->nparams != nparams ||
+			(nparams > 0 &&
+			 memcmp(entry->params, params, nparams * sizeof(RemoteParam)) != 0))
+			return -1;
+
+		entry->lastused = ++sent_plans_clock;
+		return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Return a copy of the plan text cached in the given slot.
+ */
+char *
+RemotePlanCacheGetText(int slot)
+{
+	RemotePlanCacheEntry *entry = &sent_plans[slot];
+	char	   *planstr;
+
+	Assert(slot >= 0 && slot < REMOTE_PLAN_CACHE_SLOTS && entry->id != 0);
+
+	planstr = (char *) palloc(entry->len + 1);
+	memcpy(planstr, entry->planstr, entry->len + 1);
+	return planstr;
+}
+
+/*
+ * Assign a plan about to be sent the least recently used slot, and a fresh
+ * id returned in *id.  Returns the slot, or -1 if plans are not cached.
+ */
+int
+RemotePlanCacheStore(const char *planstr, int nparams, RemoteParam *params,
+					 uint32 *id)
+{
+	RemotePlanCacheEntry *entry;
+	int			victim = 0;
+	int			i;
+
+	*id = 0;
+	if (!enable_remote_plan_cache)
+		return -1;
+
+	for (i = 1; i < REMOTE_PLAN_CACHE_SLOTS; i++)
+	{
+		if (sent_plans[i].lastused < sent_plans[victim].lastused)
+			victim = i;
+	}
+
+	entry = &sent_plans[victim];
+	entry->id = 0;
+	if (entry->planstr)
+		pfree(entry->planstr);
+	entry->planstr = NULL;
+	if (entry->params)
+		pfree(entry->params);
+	entry->params = NULL;
+
+	entry->len = strlen(planstr);
+	entry->planstr = MemoryContextStrdup(TopMemoryContext, planstr);
+	entry->nparams = nparams;
+	if (nparams > 0)
+	{
+		entry->params = (RemoteParam *)
+			MemoryContextAlloc(TopMemoryContext, nparams * sizeof(RemoteParam));
+		memcpy(entry->params, params, nparams * sizeof(RemoteParam));
+	}
+	entry->lastused = ++sent_plans_clock;
+
+	/* a fresh id, so handles and plans still knowing the old one do not match */
+	if (++sent_plans_last_id == 0)
+		++sent_plans_last_id;
+	entry->id = sent_plans_last_id;
+
+	*id = entry->id;
+	return victim;
+}
+
+/*
+ * Drop a reference to a parsed plan.  Also the reset callback of the
+ * contexts of the statements using it.
+ */
+static void
+RemotePlanTreeRelease(void *arg)
+{
+	RemotePlanTree *tree = (RemotePlanTree *) arg;
+
+	if (--tree->refcount == 0)
+		MemoryContextDelete(tree->context);
+}
+
+/*
+ * Remote side: forget all parsed plans, they are parsed again on next use.
+ */
+static void
+RemotePlanCacheDropTrees(void)
+{
+	int			i;
+
+	stored_plans_invalidations++;
+	for (i = 0; i < REMOTE_PLAN_CACHE_SLOTS; i++)
+	{
+		RemotePlanCacheEntry *entry = &stored_plans[i];
+
+		if (entry->tree)
+		{
+			RemotePlanTree *tree = entry->tree;
+
+			entry->tree = NULL;
+			RemotePlanTreeRelease(tree);
+		}
+	}
+}
+
+static void
+RemotePlanCacheRelCallback(Datum arg, Oid relid)
+{
+	RemotePlanCacheDropTrees();
+}
+
+static void
+RemotePlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	RemotePlanCacheDropTrees();
+}
+
+/*
+ * Remote side: return the plan text of a Plan message.  An empty text refers
+ * to the plan stored in the given slot; a non-empty one is stored there for
+ * later messages.  A negative slot means the plan is not cached.
+ */
+const char *
+RemotePlanCacheResolve(const char *planstr, int slot, uint32 id)
+{
+	RemotePlanCacheEntry *entry;
+
+	if (slot < 0)
+		return planstr;
+
+	if (slot >= REMOTE_PLAN_CACHE_SLOTS || id == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("invalid remote plan cache slot %d", slot)));
+
+	entry = &stored_plans[slot];
+
+	if (planstr[0] != '\0')
+	{
+		entry->id = 0;
+		if (entry->tree)
+		{
+			RemotePlanTree *tree = entry->tree;
+
+			entry->tree = NULL;
+			RemotePlanTreeRelease(tree);
+		}
+		if (entry->planstr)
+			pfree(entry->planstr);
+		entry->planstr = MemoryContextStrdup(TopMemoryContext, planstr);
+		entry->shareable = (strstr(planstr, "{REMOTESUBPLAN") == NULL);
+		entry->id = id;
+		return planstr;
+	}
+
+	if (entry->id != id)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("remote plan %u is not cached in slot %d", id, slot)));
+
+	return entry->planstr;
+}
+
+/*
+ * Remote side: return the parsed plan stored in the given slot, kept until
+ * plan_context is deleted.  Returns NULL if the plan may not be shared, and
+ * the caller has to parse the text itself.
+ */
+RemoteStmt *
+RemotePlanCacheGetStmt(int slot, MemoryContext plan_context)
+{
+	RemotePlanCacheEntry *entry;
+	RemotePlanTree *tree;
+	MemoryContextCallback *cb;
+
+	Assert(slot >= 0 && slot < REMOTE_PLAN_CACHE_SLOTS);
+	entry = &stored_plans[slot];
+	if (entry->id == 0 || !entry->shareable)
+		return NULL;
+
+	cb = (MemoryContextCallback *)
+		MemoryContextAlloc(plan_context, sizeof(MemoryContextCallback));
+
+	if (!stored_plans_callbacks)
+	{
+		CacheRegisterRelcacheCallback(RemotePlanCacheRelCallback, (Datum) 0);
+		CacheRegisterSyscacheCallback(PROCOID, RemotePlanCacheSysCallback, (Datum) 0);
+		CacheRegisterSyscacheCallback(TYPEOID, RemotePlanCacheSysCallback, (Datum) 0);
+		CacheRegisterSyscacheCallback(OPEROID, RemotePlanCacheSysCallback, (Datum) 0);
+		CacheRegisterSyscacheCallback(COLLOID, RemotePlanCacheSysCallback, (Datum) 0);
+		CacheRegisterSyscacheCallback(NAMESPACEOID, RemotePlanCacheSysCallback, (Datum) 0);
+		stored_plans_callbacks = true;
+	}
+
+	tree = entry->tree;
+	if (tree == NULL)
+	{
+		MemoryContext context;
+		MemoryContext oldcontext;
+		uint64		invalidations = stored_plans_invalidations;
+
+		context = AllocSetContextCreate(TopMemoryContext,
+										"RemotePlanTree",
+										ALLOCSET_SMALL_SIZES);
+		oldcontext = MemoryContextSwitchTo(context);
+		tree = (RemotePlanTree *) palloc(sizeof(RemotePlanTree));
+		tree->context = context;
+		tree->refcount = 0;
+
+		PG_TRY();
+		{
+			set_portable_input(true);
+			tree->rstmt = (RemoteStmt *) stringToNode(entry->planstr);
+		}
+		PG_CATCH();
+		{
+			set_portable_input(false);
+			MemoryContextSwitchTo(oldcontext);
+			MemoryContextDelete(context);
+			PG_RE_THROW();
+		}
+		PG_END_TRY();
+		set_portable_input(false);
+		MemoryContextSwitchTo(oldcontext);
+
+		/* parsing may have seen an invalidation, then the plan is not kept */
+		if (invalidations == stored_plans_invalidations)
+		{
+			tree->refcount++;
+			entry->tree = tree;
+		}
+	}
+
+	cb->func = RemotePlanTreeRelease;
+	cb->arg = tree;
+	MemoryContextRegisterResetCallback(plan_context, cb);
+	tree->refcount++;
+
+	return tree->rstmt;
+}
+
+/*
+ * Forget which plans the remote backend behind the handle holds.
+ */
+void
+pgxc_node_forget_cached_plans(PGXCNodeHandle *handle)
+{
+	memset(handle->plan_cache_ids, 0, sizeof(handle->plan_cache_ids));
+}
+#endif
+
 /*
  * Send BIND message down to the Datanode
  */
@@ -2697,7 +3269,7 @@ pgxc_node_flush_read(PGXCNodeHandle *handle)
  */
 static int
 pgxc_node_send_query_internal(PGXCNodeHandle * handle, const char *query,
-        bool rollback)
+        bool rollback, bool flush)
 {
     int            strLen;
     int            msgLen;
@@ -2737,6 +3309,8 @@ pgxc_node_send_query_internal(PGXCNodeHandle * handle, const char *query,
     PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_QUERY);
 
     handle->in_extended_query = false;
+    if (!flush)
+        return 0;
      return pgxc_node_flush(handle);
 }
 
@@ -2749,7 +3323,7 @@ pgxc_node_send_rollback(PGXCNodeHandle *handle, const char *query)
         capacity_stack = SEND_ROLLBACK;
     }
 #endif
-    return pgxc_node_send_query_internal(handle, query, true);
+    return pgxc_node_send_query_internal(handle, query, true, true);
 }
 
 int
@@ -2764,9 +3338,172 @@ pgxc_node_send_query(PGXCNodeHandle *handle, const char *query)
         capacity_stack = SEND_QUERY;
     }
 #endif
-    return pgxc_node_send_query_internal(handle, query, false);
+    return pgxc_node_send_query_internal(handle, query, false, true);
+}
+
+#ifdef __TBASE__
+/*
+ * Like pgxc_node_send_query(), but leave the query in the output buffer.
+ * The caller puts it on the wire with pgxc_node_flush_all(), together with
+ * the queries for the other nodes.
+ */
+int
+pgxc_node_queue_query(PGXCNodeHandle *handle, const char *query)
+{
+#ifdef __TWO_PHASE_TESTS__
+     if ((IN_REMOTE_PREPARE == twophase_in && !handle->read_only) ||
+        IN_PREPARE_ERROR == twophase_in ||
+        IN_REMOTE_FINISH == twophase_in ||
+        IN_PG_CLEAN == twophase_in)
+    {
+        capacity_stack = SEND_QUERY;
+    }
+#endif
+    return pgxc_node_send_query_internal(handle, query, false, false);
 }
 
+/*
+ * Mark a handle whose output could not be sent as broken.
+ */
+static void
+pgxc_node_flush_failed(PGXCNodeHandle *handle, const char *message)
+{
+    elog(LOG, "pgxc_node_flush_all data to node:%s fd:%d failed: %s",
+         handle->nodename, handle->sock, message);
+    add_error_message(handle, message);
+    handle->outEnd = 0;
+    PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_ERROR_FATAL);
+}
+
+/*
+ * Send the output buffers of several handles at once.
+ *
+ * Unlike calling pgxc_node_flush() for each handle in turn, a node whose
+ * socket is full does not hold up the others: every socket gets whatever it
+ * accepts right away, and the ones that still have data are waited for with
+ * a single poll.  A handle that can not be written to is marked as broken.
+ * The wait can be interrupted, the handles not sent completely are then
+ * marked as broken too, since a partly sent message can not be taken back.
+ * Returns the number of such handles.
+ */
+int
+pgxc_node_flush_all(int conn_count, PGXCNodeHandle **connections)
+{// #lizard forgives
+    PGXCNodeHandle **pending;
+    struct pollfd   *pfds;
+    nfds_t           npoll;
+    int              npending = 0;
+    int              nfailed = 0;
+    int              i;
+
+    if (conn_count <= 0)
+        return 0;
+
+    pending = (PGXCNodeHandle **) palloc(sizeof(PGXCNodeHandle *) * conn_count);
+    pfds = (struct pollfd *) palloc(sizeof(struct pollfd) * conn_count);
+
+    for (i = 0; i < conn_count; i++)
+    {
+        if (connections[i]->outEnd > 0)
+            pending[npending++] = connections[i];
+    }
+
+    while (npending > 0)
+    {
+        int            nleft = 0;
+        int            poll_ret;
+
+        /* the same test CHECK_FOR_INTERRUPTS does before acting */
+        if (InterruptPending && InterruptHoldoffCount == 0 && CritSectionCount == 0)
+        {
+            for (i = 0; i < npending; i++)
+                pgxc_node_flush_failed(pending[i], "flush interrupted");
+            nfailed += npending;
+            pfree(pending);
+            pfree(pfds);
+            CHECK_FOR_INTERRUPTS();
+            return nfailed;
+        }
+
+        /* give every socket as much as it takes without blocking */
+        for (i = 0; i < npending; i++)
+        {
+            PGXCNodeHandle *handle = pending[i];
+            ssize_t         sent;
+
+            sent = send(handle->sock, handle->outBuffer, handle->outEnd, 0);
+            if (sent < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    pgxc_node_flush_failed(handle, "failed to send data to node");
+                    nfailed++;
+                    continue;
+                }
+            }
+            else if (sent < handle->outEnd)
+            {
+                memmove(handle->outBuffer, handle->outBuffer + sent,
+                        handle->outEnd - sent);
+                handle->outEnd -= sent;
+            }
+            else
+                handle->outEnd = 0;
+
+            if (handle->outEnd > 0)
+                pending[nleft++] = handle;
+        }
+
+        npending = nleft;
+        if (npending == 0)
+            break;
+
+        /* wait until some of the remaining sockets can take more */
+        npoll = 0;
+        for (i = 0; i < npending; i++)
+        {
+            pfds[npoll].fd = pending[i]->sock;
+            pfds[npoll].events = POLLOUT;
+            pfds[npoll].revents = 0;
+            npoll++;
+        }
+
+        poll_ret = poll(pfds, npoll, 1000);
+        if (poll_ret < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+
+            for (i = 0; i < npending; i++)
+                pgxc_node_flush_failed(pending[i], "poll failed");
+            nfailed += npending;
+            break;
+        }
+
+        nleft = 0;
+        for (i = 0; i < npending; i++)
+        {
+            if (pfds[i].revents & (POLLHUP | POLLERR | POLLNVAL))
+            {
+                pgxc_node_flush_failed(pending[i],
+                                       (pfds[i].revents & POLLHUP) ?
+                                       "remote end disconnected" :
+                                       "socket error");
+                nfailed++;
+            }
+            else
+                pending[nleft++] = pending[i];
+        }
+        npending = nleft;
+    }
+
+    pfree(pending);
+    pfree(pfds);
+
+    return nfailed;
+}
+#endif
+
 /*
  * Send the GID down to the PGXC node
  */
@@ -3119,6 +3856,41 @@ pgxc_node_send_cmd_id(PGXCNodeHandle *handle, CommandId cid)
     return 0;
 }
 
+#ifdef __TBASE__
+/*
+ * Send a runtime filter down to the PGXC node.  It applies to the portal
+ * created by the Bind message that follows.
+ */
+int
+pgxc_node_send_runtime_filter(PGXCNodeHandle *handle, const char *data, int len)
+{
+    int            msglen = 4 + len;
+
+    /* Invalid connection state, return error */
+    if (handle->state != DN_CONNECTION_STATE_IDLE)
+    {
+        elog(LOG, "pgxc_node_send_runtime_filter datanode:%u invalid stauts:%d, no need to send data, return NOW", handle->nodeoid, handle->state);
+        return EOF;
+    }
+
+    /* msgType + msgLen */
+    if (ensure_out_buffer_capacity(handle->outEnd + 1 + msglen, handle) != 0)
+    {
+        add_error_message(handle, "out of memory");
+        return EOF;
+    }
+
+    handle->outBuffer[handle->outEnd++] = 'y';
+    msglen = htonl(msglen);
+    memcpy(handle->outBuffer + handle->outEnd, &msglen, 4);
+    handle->outEnd += 4;
+    memcpy(handle->outBuffer + handle->outEnd, data, len);
+    handle->outEnd += len;
+
+    return 0;
+}
+#endif
+
 /*
  * Send the snapshot down to the PGXC node
  */
@@ -3629,6 +4401,10 @@ get_any_handle(List *datanodelist)
                  errmsg("Invalid NULL node list")));
     }
 
+#ifdef __TBASE__
+    pgxc_node_unpark_handles();
+#endif
+
     if (HandlesInvalidatePending)
         if (DoInvalidateRemoteHandles())
             ereport(ERROR,
@@ -3772,6 +4548,10 @@ get_handles(List *datanodelist, List *coordlist, bool is_coord_only_query, bool
     /* index of the result array */
     int            i = 0;
 
+#ifdef __TBASE__
+    pgxc_node_unpark_handles();
+#endif
+
     if (HandlesInvalidatePending)
         if (DoInvalidateRemoteHandles())
             ereport(ERROR,
@@ -4124,7 +4904,10 @@ PGXCNodeAllHandles *
 get_current_handles(void)
 {
 #ifdef __TBASE__
-    PGXCNodeAllHandles *result = get_empty_handles();
+    PGXCNodeAllHandles *result;
+
+    pgxc_node_unpark_handles();
+    result = get_empty_handles();
 #else
 	PGXCNodeAllHandles *result;
 	PGXCNodeHandle	   *node_handle;
@@ -4185,7 +4968,10 @@ get_current_handles(void)
 PGXCNodeAllHandles *
 get_current_cn_handles(void)
 {
-    PGXCNodeAllHandles *result = get_empty_handles();
+    PGXCNodeAllHandles *result;
+
+    pgxc_node_unpark_handles();
+    result = get_empty_handles();
 
     get_current_cn_handles_internal(result);
     return result;
@@ -4194,7 +4980,10 @@ get_current_cn_handles(void)
 PGXCNodeAllHandles *
 get_current_dn_handles(void)
 {
-    PGXCNodeAllHandles *result = get_empty_handles();
+    PGXCNodeAllHandles *result;
+
+    pgxc_node_unpark_handles();
+    result = get_empty_handles();
 
     get_current_dn_handles_internal(result);
     return result;
@@ -4979,6 +5768,16 @@ pgxc_node_set_query(PGXCNodeHandle *handle, const char *set_query)
             break;
         }
 
+#ifdef __TBASE__
+        if (msgtype == 'w') /* remote transaction assigned an xid */
+            handle->xid_assigned = true;
+
+        /* ParameterStatus, the features the remote node agreed to */
+        if (msgtype == 'S' && strcmp(msg, REMOTE_FEATURES_GUC) == 0 &&
+            strlen(msg) + 1 < msglen)
+            handle->remote_features = atoi(msg + strlen(msg) + 1) & REMOTE_FEATURES_SUPPORTED;
+#endif
+
         if (msgtype == 'Z') /* ReadyForQuery */
         {
             handle->transaction_status = msg[0];
@@ -39,24 +39,37 @@ static int    pool_discardbytes(PoolPort *port, size_t len);
 
 #ifdef HAVE_UNIX_SOCKETS
 
-#define POOLER_UNIXSOCK_PATH(path, port, sockdir) \
-    snprintf(path, sizeof(path), "%s/.s.PGPOOL.%d", \
-            ((sockdir) && *(sockdir) != '\0') ? (sockdir) : \
-            DEFAULT_PGSOCKET_DIR, \
-            (port))
+/*
+ * The first pooler process keeps the historical socket name, the other
+ * pooler processes of a sharded pooler append their shard number.
+ */
+#define POOLER_UNIXSOCK_PATH(path, port, sockdir, shard) \
+    do { \
+        if ((shard) == 0) \
+            snprintf(path, sizeof(path), "%s/.s.PGPOOL.%d", \
+                    ((sockdir) && *(sockdir) != '\0') ? (sockdir) : \
+                    DEFAULT_PGSOCKET_DIR, \
+                    (port)); \
+        else \
+            snprintf(path, sizeof(path), "%s/.s.PGPOOL.%d.%d", \
+                    ((sockdir) && *(sockdir) != '\0') ? (sockdir) : \
+                    DEFAULT_PGSOCKET_DIR, \
+                    (port), (shard)); \
+    } while (0)
 
 static char sock_path[MAXPGPATH];
 
 static void StreamDoUnlink(int code, Datum arg);
 
-static int    Lock_AF_UNIX(unsigned short port, const char *unixSocketName);
+static int    Lock_AF_UNIX(unsigned short port, const char *unixSocketName,
+                         int shard);
 #endif
 
 /*
  * Open server socket on specified port to accept connection from sessions
  */
 int
-pool_listen(unsigned short port, const char *unixSocketName)
+pool_listen(unsigned short port, const char *unixSocketName, int shard)
 {
     int            fd,
                 len;
@@ -65,7 +78,7 @@ pool_listen(unsigned short port, const char *unixSocketName)
 
 
 #ifdef HAVE_UNIX_SOCKETS
-    if (Lock_AF_UNIX(port, unixSocketName) < 0)
+    if (Lock_AF_UNIX(port, unixSocketName, shard) < 0)
         return -1;
 
     /* create a Unix domain stream socket */
@@ -128,9 +141,9 @@ StreamDoUnlink(int code, Datum arg)
 
 #ifdef HAVE_UNIX_SOCKETS
 static int
-Lock_AF_UNIX(unsigned short port, const char *unixSocketName)
+Lock_AF_UNIX(unsigned short port, const char *unixSocketName, int shard)
 {
-    POOLER_UNIXSOCK_PATH(sock_path, port, unixSocketName);
+    POOLER_UNIXSOCK_PATH(sock_path, port, unixSocketName, shard);
 
     CreateSocketLockFile(sock_path, true, "");
 
@@ -144,7 +157,7 @@ Lock_AF_UNIX(unsigned short port, const char *unixSocketName)
  * Connect to pooler listening on specified port
  */
 int
-pool_connect(unsigned short port, const char *unixSocketName)
+pool_connect(unsigned short port, const char *unixSocketName, int shard)
 {
     int            fd,
                 len;
@@ -156,7 +169,7 @@ pool_connect(unsigned short port, const char *unixSocketName)
         return -1;
 
     /* fill socket address structure w/server's addr */
-    POOLER_UNIXSOCK_PATH(sock_path, port, unixSocketName);
+    POOLER_UNIXSOCK_PATH(sock_path, port, unixSocketName, shard);
 
     memset(&unix_addr, 0, sizeof(unix_addr));
     unix_addr.sun_family = AF_UNIX;
@@ -56,6 +56,14 @@
 #include "pgxc/pgxc.h"
 #include "pgxc/nodemgr.h"
 #include "pgxc/poolutils.h"
+#ifdef __TBASE__
+#include "access/hash.h"
+#include "port/atomics.h"
+#include "postmaster/bgworker.h"
+#include "storage/ipc.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#endif
 #include "../interfaces/libpq/libpq-fe.h"
 #include "../interfaces/libpq/libpq-int.h"
 #include "postmaster/postmaster.h"        /* For Unix_socket_directories */
@@ -99,6 +107,79 @@ char        *g_unpooled_user         = "mls_admin";
 bool         PoolConnectDebugPrint  = false; /* Pooler connect debug print */
 bool         PoolerStuckExit         = true;  /* Pooler exit when stucked */
 bool         PoolSubThreadLogPrint  = true;  /* Pooler sub thread log print */
+#ifdef __TBASE__
+bool         PoolerFastPath         = true;  /* park idle connections in the session */
+bool         PoolerStickyConnections = false; /* keep parked connections while idle */
+int          PoolerStickyIdleTimeout = 300;   /* idle time before sticky connections are evicted, in seconds */
+bool         PoolerPredictiveWarm   = true;  /* grow pools ahead of the demand seen in the past */
+int          PoolerWarmLeadTime     = 300;   /* how far ahead to look for demand, in seconds */
+
+/*
+ * Parked connections
+ *
+ * Giving the connections back to the pooler at the end of every transaction
+ * and asking for them again at the start of the next one costs two trips
+ * through the single pooler process.  A session can instead "park" its idle
+ * connections: it keeps its sockets and publishes the fact in shared memory,
+ * where the next transaction of the session takes them back with one atomic
+ * operation.  The pooler still owns the parked connections.  When a node pool
+ * runs out of connections it can take a parked set away from its session with
+ * the same atomic operation and put it back in the pool, and the session then
+ * closes its copies of the sockets and goes through the pooler again.
+ *
+ * The state word of a session holds its pid and the state of its parked set,
+ * so that the pooler never acts on the state left behind by an earlier
+ * session of the same PGPROC.
+ */
+#define POOLER_PARK_NONE        0    /* nothing parked, sockets in use if any */
+#define POOLER_PARK_PARKED      1    /* parked, may be taken by either side */
+#define POOLER_PARK_RECLAIMED   2    /* taken back by the pooler */
+
+#define PoolerParkState(pid, state)    (((uint64) (uint32) (pid) << 32) | (state))
+#define PoolerParkPid(value)        ((int) ((value) >> 32))
+
+typedef struct PoolerParkSlot
+{
+    pg_atomic_uint64 state;
+    pg_time_t    parked_at;        /* when the connections were parked */
+    bool        sticky;            /* parked in sticky mode */
+} PoolerParkSlot;
+
+static PoolerParkSlot *PoolerParkSlots = NULL;
+
+/* did this session park its connections? */
+static bool connections_parked = false;
+
+/* did this transaction send local parameters to the agent? */
+static bool local_params_sent = false;
+
+/*
+ * Sharded pooler
+ *
+ * With pooler_processes > 1 the database pools are split between several
+ * pooler processes by a hash of database and user name, so that one
+ * (database, user) pair always lands in the same process whatever its
+ * session options.  Each of them runs its own PoolerLoop, helper threads and
+ * socket.  The first one is the usual pooler auxiliary process listening on
+ * .s.PGPOOL.<port>; the others are background workers listening on
+ * .s.PGPOOL.<port>.<shard>.  A session talks only to the pooler owning its
+ * own database pool.  Commands concerning all the database pools of the node
+ * (lock, reload, refresh, abort, clean and close) are replayed by the session
+ * on every other pooler through a short lived connection.
+ */
+int          PoolerProcesses        = 1;     /* number of pooler processes */
+int          PoolerShardIndex       = 0;     /* shard served by this pooler */
+
+/* shard of the session's own agent, and the names it connected with */
+static int   session_pooler_shard   = 0;
+static char *session_pooler_database = NULL;
+static char *session_pooler_user    = NULL;
+
+/* is the session replaying a command on the other poolers? */
+static bool  pooler_replaying       = false;
+
+typedef void (*PoolerReplayCommand) (void *arg);
+#endif
 
 #define      POOL_ASYN_WARM_PIPE_LEN      32   /* length of asyn warm pipe */
 #define      POOL_ASYN_WARN_NUM           1      /* how many connections to warm once maintaince per node pool */
@@ -509,6 +590,15 @@ static int cancel_query_on_connections(PoolAgent *agent, List *datanodelist, Lis
 static PGXCNodePoolSlot *acquire_connection(DatabasePool *dbPool, PGXCNodePool **pool,int32 nodeidx, Oid node, bool bCoord);
 static void agent_release_connections(PoolAgent *agent, bool force_destroy);
 static void agent_return_connections(PoolAgent *agent);
+#ifdef __TBASE__
+static PoolerParkSlot *pooler_my_park_slot(void);
+static bool reclaim_parked_connections(DatabasePool *dbPool, int32 nodeidx, bool bCoord);
+static void evict_idle_parked_connections(void);
+static void pooler_replay_on_other_shards(PoolerReplayCommand command, void *arg);
+static void pooler_replay_refresh(void *arg);
+static void pooler_note_demand(DatabasePool *dbPool, PGXCNodePool *nodePool);
+static void pooler_predictive_warm(DatabasePool *dbPool);
+#endif
 
 static bool agent_reset_session(PoolAgent *agent);
 static void release_connection(DatabasePool *dbPool, PGXCNodePoolSlot *slot,
@@ -753,6 +843,81 @@ IsPGXCPoolerProcess(void)
     return am_pgxc_pooler;
 }
 
+#ifdef __TBASE__
+/*
+ * Which pooler process owns the database pools of a database and user?
+ */
+int
+PoolerShardOf(const char *database, const char *user_name)
+{
+    uint32        hash;
+
+    if (PoolerProcesses <= 1)
+    {
+        return 0;
+    }
+
+    hash = DatumGetUInt32(hash_any((const unsigned char *) database,
+                                   strlen(database)));
+    hash = (hash << 1) | (hash >> 31);
+    hash ^= DatumGetUInt32(hash_any((const unsigned char *) user_name,
+                                    strlen(user_name)));
+
+    return (int) (hash % PoolerProcesses);
+}
+
+/*
+ * Register the pooler processes beyond the first one as background workers.
+ * Called from the postmaster before shared memory is sized.
+ */
+void
+PoolerShardsRegister(void)
+{
+    BackgroundWorker bgw;
+    int                shard;
+
+    if (PoolerProcesses - 1 > max_worker_processes)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("\"pooler_processes\" (%d) requires \"max_worker_processes\" to be at least %d",
+                        PoolerProcesses, PoolerProcesses - 1)));
+    }
+
+    for (shard = 1; shard < PoolerProcesses; shard++)
+    {
+        memset(&bgw, 0, sizeof(bgw));
+        bgw.bgw_flags = BGWORKER_SHMEM_ACCESS;
+        bgw.bgw_start_time = BgWorkerStart_ConsistentState;
+        snprintf(bgw.bgw_library_name, BGW_MAXLEN, "postgres");
+        snprintf(bgw.bgw_function_name, BGW_MAXLEN, "PoolerShardMain");
+        snprintf(bgw.bgw_name, BGW_MAXLEN, "pooler process %d", shard);
+        bgw.bgw_restart_time = 1;
+        bgw.bgw_notify_pid = 0;
+        bgw.bgw_main_arg = Int32GetDatum(shard);
+
+        RegisterBackgroundWorker(&bgw);
+    }
+}
+
+/*
+ * Entry point of the pooler processes beyond the first one
+ */
+void
+PoolerShardMain(Datum main_arg)
+{
+    PoolerShardIndex = DatumGetInt32(main_arg);
+
+    PGXCPoolerProcessIam();
+
+    /* the PGPROC was set up before we knew we are a pooler */
+    MyProc->isPooler = true;
+
+    PoolManagerInit();
+    proc_exit(1);                /* should never return */
+}
+#endif
+
 /*
  * Initialize internal structures
  */
@@ -950,12 +1115,21 @@ PoolManagerDestroy(void)
  */
 PoolHandle *
 GetPoolManagerHandle(void)
+{
+    return GetPoolManagerShardHandle(0);
+}
+
+/*
+ * Get handle to one of the pooler processes of a sharded pooler
+ */
+PoolHandle *
+GetPoolManagerShardHandle(int shard)
 {
     PoolHandle *handle;
     int            fdsock;
 
     /* Connect to the pooler */
-    fdsock = pool_connect(PoolerPort, Unix_socket_directories);
+    fdsock = pool_connect(PoolerPort, Unix_socket_directories, shard);
     if (fdsock < 0)
     {
         int            saved_errno = errno;
@@ -1061,6 +1235,9 @@ agent_create(int new_fd)
     agent->is_temp = false;
     agent->pid = 0;
     agent->agentindex = agentindex;
+#ifdef __TBASE__
+    agent->park_index = -1;
+#endif
 
     /* Append new agent to the list */    
     poolAgents[agentindex] = agent;
@@ -1220,6 +1397,14 @@ PoolManagerSetCommand(PGXCNodeHandle **connections, int32 count, PoolCommandType
     {
         elog(LOG, "[PoolManagerSetCommand]recv command_type=%d, count=%d set_command=%s", command_type, count, set_command);
     }
+
+#ifdef __TBASE__
+    /* the agent forgets local parameters only when connections are released */
+    if (command_type == POOL_CMD_LOCAL_SET)
+    {
+        local_params_sent = true;
+    }
+#endif
     
     if (set_command)
     {
@@ -1472,6 +1657,14 @@ PoolManagerSendLocalCommand(int dn_count, int* dn_list, int co_count, int* co_li
 	return pool_recvres(&poolHandle->port, true);
 }
 
+#ifdef __TBASE__
+static void
+pooler_replay_lock(void *arg)
+{
+	PoolManagerLock(*(bool *) arg);
+}
+#endif
+
 /*
  * Lock/unlock pool manager
  * During locking, the only operations not permitted are abort, connection and
@@ -1504,6 +1697,10 @@ PoolManagerLock(bool is_lock)
     pool_flush(&poolHandle->port);
 
     RESUME_POOLER_RELOAD();
+
+#ifdef __TBASE__
+    pooler_replay_on_other_shards(pooler_replay_lock, &is_lock);
+#endif
 }
 
 /*
@@ -1795,6 +1992,15 @@ PoolManagerDisconnect(void)
     {
         Assert(poolHandle);
 
+#ifdef __TBASE__
+        /* the agent releases the parked connections when it goes away */
+        if (connections_parked)
+        {
+            pg_atomic_write_u64(&pooler_my_park_slot()->state,
+                                PoolerParkState(MyProcPid, POOLER_PARK_RECLAIMED));
+        }
+#endif
+
         pool_putmessage(&poolHandle->port, 'd', NULL, 0);
         pool_flush(&poolHandle->port);
 
@@ -1920,6 +2126,43 @@ PoolManagerGetConnections(List *datanodelist, List *coordlist, bool raise_error,
     return fds;
 }
 
+#ifdef __TBASE__
+typedef struct PoolerReplayAbort
+{
+    char       *dbname;
+    char       *username;
+    int           *pids;            /* pids signaled by all the poolers */
+    int            npids;
+} PoolerReplayAbort;
+
+static void
+pooler_replay_abort(void *arg)
+{
+    PoolerReplayAbort *abort_arg = (PoolerReplayAbort *) arg;
+    int           *pids = NULL;
+    int            npids;
+
+    npids = PoolManagerAbortTransactions(abort_arg->dbname, abort_arg->username, &pids);
+    if (npids <= 0)
+    {
+        return;
+    }
+
+    if (abort_arg->pids)
+    {
+        abort_arg->pids = (int *) repalloc(abort_arg->pids,
+                                           (abort_arg->npids + npids) * sizeof(int));
+    }
+    else
+    {
+        abort_arg->pids = (int *) palloc(npids * sizeof(int));
+    }
+    memcpy(abort_arg->pids + abort_arg->npids, pids, npids * sizeof(int));
+    abort_arg->npids += npids;
+    pfree(pids);
+}
+#endif
+
 /*
  * Abort active transactions using pooler.
  * Take a lock forbidding access to Pooler for new transactions.
@@ -1967,10 +2210,50 @@ PoolManagerAbortTransactions(char *dbname, char *username, int **proc_pids)
     /* Then Get back Pids from Pooler */
     num_proc_ids = pool_recvpids(&poolHandle->port, proc_pids);
 
+#ifdef __TBASE__
+    /* sessions of other databases and users are known to other poolers */
+    if (PoolerProcesses > 1 && !pooler_replaying)
+    {
+        PoolerReplayAbort abort_arg;
+
+        abort_arg.dbname = dbname;
+        abort_arg.username = username;
+        abort_arg.pids = num_proc_ids > 0 ? *proc_pids : NULL;
+        abort_arg.npids = num_proc_ids > 0 ? num_proc_ids : 0;
+
+        pooler_replay_on_other_shards(pooler_replay_abort, &abort_arg);
+
+        if (abort_arg.npids > 0)
+        {
+            *proc_pids = abort_arg.pids;
+        }
+        num_proc_ids = abort_arg.npids;
+    }
+#endif
+
     return num_proc_ids;
 }
 
 
+#ifdef __TBASE__
+typedef struct PoolerReplayClean
+{
+    List       *datanodelist;
+    List       *coordlist;
+    char       *dbname;
+    char       *username;
+} PoolerReplayClean;
+
+static void
+pooler_replay_clean(void *arg)
+{
+    PoolerReplayClean *clean_arg = (PoolerReplayClean *) arg;
+
+    PoolManagerCleanConnection(clean_arg->datanodelist, clean_arg->coordlist,
+                               clean_arg->dbname, clean_arg->username);
+}
+#endif
+
 /*
  * Clean up Pooled connections
  */
@@ -2049,9 +2332,32 @@ PoolManagerCleanConnection(List *datanodelist, List *coordlist, char *dbname, ch
 				(errcode(ERRCODE_INTERNAL_ERROR),
 				 errmsg(POOL_MGR_PREFIX"Clean connections not completed. HINT: cannot drop the currently open database")));
 	}
+
+#ifdef __TBASE__
+	{
+		PoolerReplayClean clean_arg;
+
+		clean_arg.datanodelist = datanodelist;
+		clean_arg.coordlist = coordlist;
+		clean_arg.dbname = dbname;
+		clean_arg.username = username;
+		pooler_replay_on_other_shards(pooler_replay_clean, &clean_arg);
+	}
+#endif
 }
 
 
+#ifdef __TBASE__
+static void
+pooler_replay_check(void *arg)
+{
+    if (!PoolManagerCheckConnectionInfo())
+    {
+        *(bool *) arg = false;
+    }
+}
+#endif
+
 /*
  * Check connection information consistency cached in pooler with catalog information
  */
@@ -2075,13 +2381,30 @@ PoolManagerCheckConnectionInfo(void)
 
 	res = pool_recvres(&poolHandle->port, true);
 
+#ifdef __TBASE__
+    {
+        bool        consistent = (res == POOL_CHECK_SUCCESS);
+
+        pooler_replay_on_other_shards(pooler_replay_check, &consistent);
+        return consistent;
+    }
+#else
     if (res == POOL_CHECK_SUCCESS)
         return true;
 
     return false;
+#endif
 }
 
 
+#ifdef __TBASE__
+static void
+pooler_replay_reload(void *arg)
+{
+    PoolManagerReloadConnectionInfo();
+}
+#endif
+
 /*
  * Reload connection data in pooler and drop all the existing connections of pooler
  */
@@ -2092,6 +2415,10 @@ PoolManagerReloadConnectionInfo(void)
 	PgxcNodeListAndCountWrapTransaction();
     pool_putmessage(&poolHandle->port, 'p', NULL, 0);
     pool_flush(&poolHandle->port);
+
+#ifdef __TBASE__
+    pooler_replay_on_other_shards(pooler_replay_reload, NULL);
+#endif
 }
 
 /*
@@ -3786,69 +4113,397 @@ cancel_query_on_connections(PoolAgent *agent, List *datanodelist, List *coordlis
         }
         else
         {
-            
-#ifdef _POOLER_CHECK_    
-            elog(LOG, POOL_MGR_PREFIX"pid:%d dispatch async CANCLE_QUERY coordinator nodeindex:%d connection failed, no such connection", 
-                                                                                                            agent->pid, node);
-#endif
+            
+#ifdef _POOLER_CHECK_    
+            elog(LOG, POOL_MGR_PREFIX"pid:%d dispatch async CANCLE_QUERY coordinator nodeindex:%d connection failed, no such connection", 
+                                                                                                            agent->pid, node);
+#endif
+        }
+    }
+
+    if (nCount)
+    {
+        ret = dispatch_cancle_request(asyncTaskCtl,
+                                        true,
+                                        agent,
+                                        0,
+                                        true,
+                                        signal);
+        if (!ret)
+        {
+            goto FATAL_ERROR;
+        }
+    }
+    return nCount;
+    
+FATAL_ERROR:
+    /* record the task control, in case of memory leak */
+    if (asyncTaskCtl)
+    {
+        agent->task_control = asyncTaskCtl;
+    }
+    elog(LOG, POOL_MGR_PREFIX"cancel_query_on_connections failed pid:%d ", agent->pid);
+    return -1;
+}
+
+/*
+ * Return connections back to the pool
+ */
+void
+PoolManagerReleaseConnections(bool force)
+{
+    char msgtype = 'r';
+    int n32;
+    int msglen = 8;
+
+#ifdef __TBASE__
+    local_params_sent = false;
+#endif
+
+    /* If disconnected from pooler all the connections already released */
+    if (!poolHandle)
+    {
+        return;
+    }
+
+    elog(DEBUG1, "Returning connections back to the pool");
+
+    /* Message type */
+    pool_putbytes(&poolHandle->port, &msgtype, 1);
+
+    /* Message length */
+    n32 = htonl(msglen);
+    pool_putbytes(&poolHandle->port, (char *) &n32, 4);
+
+    /* Lock information */
+    n32 = htonl((int) force);
+    pool_putbytes(&poolHandle->port, (char *) &n32, 4);
+    pool_flush(&poolHandle->port);
+}
+
+#ifdef __TBASE__
+Size
+PoolerParkShmemSize(void)
+{
+    return mul_size(MaxBackends, sizeof(PoolerParkSlot));
+}
+
+void
+PoolerParkShmemInit(void)
+{
+    bool        found;
+    int            i;
+
+    PoolerParkSlots = (PoolerParkSlot *)
+        ShmemInitStruct("Pooler Parked Connections", PoolerParkShmemSize(), &found);
+
+    if (!found)
+    {
+        for (i = 0; i < MaxBackends; i++)
+        {
+            pg_atomic_init_u64(&PoolerParkSlots[i].state, PoolerParkState(0, POOLER_PARK_NONE));
+            PoolerParkSlots[i].parked_at = 0;
+            PoolerParkSlots[i].sticky = false;
+        }
+    }
+}
+
+static PoolerParkSlot *
+pooler_my_park_slot(void)
+{
+    if (PoolerParkSlots == NULL || MyProc == NULL || MyProc->pgprocno >= MaxBackends)
+        return NULL;
+
+    return &PoolerParkSlots[MyProc->pgprocno];
+}
+
+/*
+ * Park the connections of the session instead of releasing them.
+ *
+ * Returns false if they can not be parked, and the caller has to release them
+ * as usual.  Once this returns true, the sockets must not be used again before
+ * PoolManagerUnparkConnections() says they still belong to the session.
+ */
+bool
+PoolManagerParkConnections(void)
+{
+    PoolerParkSlot *slot;
+
+    if (!PoolerFastPath || poolHandle == NULL || local_params_sent)
+    {
+        return false;
+    }
+
+    slot = pooler_my_park_slot();
+    if (slot == NULL)
+    {
+        return false;
+    }
+
+    Assert(!connections_parked);
+    slot->parked_at = (pg_time_t) time(NULL);
+    slot->sticky = PoolerStickyConnections;
+    pg_write_barrier();
+    pg_atomic_write_u64(&slot->state, PoolerParkState(MyProcPid, POOLER_PARK_PARKED));
+    connections_parked = true;
+    return true;
+}
+
+/*
+ * Take back the parked connections of the session, if any.
+ *
+ * Returns false if the pooler reclaimed them.  The caller must then close its
+ * copies of the sockets, without telling the pooler, which already put the
+ * connections back in the pool.
+ */
+bool
+PoolManagerUnparkConnections(void)
+{
+    PoolerParkSlot *slot;
+    uint64            expected;
+
+    if (!connections_parked)
+    {
+        return true;
+    }
+    connections_parked = false;
+
+    slot = pooler_my_park_slot();
+    expected = PoolerParkState(MyProcPid, POOLER_PARK_PARKED);
+    if (pg_atomic_compare_exchange_u64(&slot->state, &expected,
+                                       PoolerParkState(MyProcPid, POOLER_PARK_NONE)))
+    {
+        return true;
+    }
+
+    pg_atomic_write_u64(&slot->state, PoolerParkState(MyProcPid, POOLER_PARK_NONE));
+    return false;
+}
+
+/*
+ * Pooler side: the park slot of an agent, if its session has parked its
+ * connections and the pooler may take them back.  Sessions with session
+ * parameters or temporary objects keep their connections anyway, so they are
+ * never candidates.
+ */
+static PoolerParkSlot *
+agent_parked_slot(PoolAgent *agent)
+{
+    PoolerParkSlot *slot;
+    uint64        value;
+    int            i;
+
+    if (PoolerParkSlots == NULL || agent->pid == 0 ||
+        agent->session_params || agent->is_temp ||
+        agent_pending(agent) || agent->ref_count > 0)
+    {
+        return NULL;
+    }
+
+    /* find the slot of the session, it does not move while the agent lives */
+    if (agent->park_index < 0 ||
+        PoolerParkPid(pg_atomic_read_u64(&PoolerParkSlots[agent->park_index].state)) != agent->pid)
+    {
+        agent->park_index = -1;
+        for (i = 0; i < MaxBackends; i++)
+        {
+            if (PoolerParkPid(pg_atomic_read_u64(&PoolerParkSlots[i].state)) == agent->pid)
+            {
+                agent->park_index = i;
+                break;
+            }
+        }
+
+        if (agent->park_index < 0)
+        {
+            return NULL;
+        }
+    }
+
+    slot = &PoolerParkSlots[agent->park_index];
+    value = pg_atomic_read_u64(&slot->state);
+    if (value != PoolerParkState(agent->pid, POOLER_PARK_PARKED))
+    {
+        return NULL;
+    }
+
+    /* parked_at and sticky were written before the state */
+    pg_read_barrier();
+    return slot;
+}
+
+/*
+ * Take the parked connections of an agent back and put them in the pool.
+ * Fails if the session has just started using them again.
+ */
+static bool
+agent_reclaim_parked(PoolAgent *agent, PoolerParkSlot *slot)
+{
+    uint64        expected;
+
+    expected = PoolerParkState(agent->pid, POOLER_PARK_PARKED);
+    if (!pg_atomic_compare_exchange_u64(&slot->state, &expected,
+                                        PoolerParkState(agent->pid, POOLER_PARK_RECLAIMED)))
+    {
+        return false;
+    }
+
+    agent_release_connections(agent, false);
+    return true;
+}
+
+/*
+ * The pool of a node has no free connection left and can not grow: put the
+ * connections parked by some other idle session of the same database pool
+ * back in the pool.  Sessions in sticky mode are only asked when no other
+ * session has the node parked, the one idle for the longest time first.
+ */
+static bool
+reclaim_parked_connections(DatabasePool *dbPool, int32 nodeidx, bool bCoord)
+{
+    PoolAgent        *victim = NULL;
+    PoolerParkSlot   *victim_slot = NULL;
+    int32            i;
+
+    RebuildAgentIndex();
+
+    for (i = 0; i < agentCount; i++)
+    {
+        PoolAgent        *agent = poolAgents[agentIndexes[i]];
+        PoolerParkSlot   *park;
+        PGXCNodePoolSlot *slot;
+
+        if (agent->pool != dbPool)
+        {
+            continue;
+        }
+
+        if (bCoord)
+        {
+            slot = (agent->coord_connections && nodeidx < agent->num_coord_connections) ?
+                    agent->coord_connections[nodeidx] : NULL;
+        }
+        else
+        {
+            slot = (agent->dn_connections && nodeidx < agent->num_dn_connections) ?
+                    agent->dn_connections[nodeidx] : NULL;
+        }
+
+        if (slot == NULL || (park = agent_parked_slot(agent)) == NULL)
+        {
+            continue;
+        }
+
+        if (victim == NULL ||
+            (victim_slot->sticky && !park->sticky) ||
+            (victim_slot->sticky == park->sticky && park->parked_at < victim_slot->parked_at))
+        {
+            victim = agent;
+            victim_slot = park;
+        }
+    }
+
+    if (victim == NULL || !agent_reclaim_parked(victim, victim_slot))
+    {
+        return false;
+    }
+
+    if (PoolConnectDebugPrint)
+    {
+        elog(LOG, POOL_MGR_PREFIX"reclaim parked connections of pid:%d sticky:%d",
+             victim->pid, victim_slot->sticky);
+    }
+    return true;
+}
+
+/*
+ * How busy are the node pools an agent holds connections of?  Returns the
+ * largest share of max_pool_size in use, between 0 and 1.
+ */
+static double
+agent_pool_pressure(PoolAgent *agent)
+{
+    double        pressure = 0;
+    int            i;
+
+    for (i = 0; i < agent->num_dn_connections + agent->num_coord_connections; i++)
+    {
+        PGXCNodePool *nodePool;
+        Oid            node;
+        double        used;
+
+        if (i < agent->num_dn_connections)
+        {
+            if (agent->dn_connections[i] == NULL)
+                continue;
+            node = agent->dn_conn_oids[i];
+        }
+        else
+        {
+            if (agent->coord_connections[i - agent->num_dn_connections] == NULL)
+                continue;
+            node = agent->coord_conn_oids[i - agent->num_dn_connections];
         }
-    }
 
-    if (nCount)
-    {
-        ret = dispatch_cancle_request(asyncTaskCtl,
-                                        true,
-                                        agent,
-                                        0,
-                                        true,
-                                        signal);
-        if (!ret)
+        nodePool = (PGXCNodePool *) hash_search(agent->pool->nodePools, &node,
+                                                HASH_FIND, NULL);
+        if (nodePool == NULL)
         {
-            goto FATAL_ERROR;
+            continue;
         }
+
+        used = (double) (nodePool->size - nodePool->freeSize) / MaxPoolSize;
+        pressure = Max(pressure, used);
     }
-    return nCount;
-    
-FATAL_ERROR:
-    /* record the task control, in case of memory leak */
-    if (asyncTaskCtl)
-    {
-        agent->task_control = asyncTaskCtl;
-    }
-    elog(LOG, POOL_MGR_PREFIX"cancel_query_on_connections failed pid:%d ", agent->pid);
-    return -1;
+
+    return Min(pressure, 1.0);
 }
 
 /*
- * Return connections back to the pool
+ * Give back the connections parked by sessions that stayed idle too long.
+ *
+ * A session in sticky mode may stay idle for pooler_sticky_idle_timeout, any
+ * other session for one maintenance period.  Both limits shrink as the node
+ * pools the session holds connections of fill up, so that idle sessions give
+ * way before busy ones have to wait for connections.
  */
-void
-PoolManagerReleaseConnections(bool force)
+static void
+evict_idle_parked_connections(void)
 {
-    char msgtype = 'r';
-    int n32;
-    int msglen = 8;
+    pg_time_t    now = (pg_time_t) time(NULL);
+    int32        i;
+    int            evicted = 0;
 
-    /* If disconnected from pooler all the connections already released */
-    if (!poolHandle)
+    RebuildAgentIndex();
+
+    /* agent_release_connections() does not change the agent list */
+    for (i = 0; i < agentCount; i++)
     {
-        return;
-    }
+        PoolAgent      *agent = poolAgents[agentIndexes[i]];
+        PoolerParkSlot *park;
+        double            limit;
 
-    elog(DEBUG1, "Returning connections back to the pool");
+        if ((!agent->dn_connections && !agent->coord_connections) ||
+            (park = agent_parked_slot(agent)) == NULL)
+        {
+            continue;
+        }
 
-    /* Message type */
-    pool_putbytes(&poolHandle->port, &msgtype, 1);
+        limit = park->sticky ? PoolerStickyIdleTimeout : PoolMaintenanceTimeout;
+        limit *= 1.0 - agent_pool_pressure(agent);
 
-    /* Message length */
-    n32 = htonl(msglen);
-    pool_putbytes(&poolHandle->port, (char *) &n32, 4);
+        if (now - park->parked_at >= limit && agent_reclaim_parked(agent, park))
+        {
+            evicted++;
+        }
+    }
 
-    /* Lock information */
-    n32 = htonl((int) force);
-    pool_putbytes(&poolHandle->port, (char *) &n32, 4);
-    pool_flush(&poolHandle->port);
+    if (evicted && PoolConnectDebugPrint)
+    {
+        elog(LOG, POOL_MGR_PREFIX"evicted parked connections of %d idle sessions", evicted);
+    }
 }
+#endif
 
 /*
  * Cancel Query
@@ -4384,6 +5039,12 @@ create_database_pool(const char *database, const char *user_name, const char *pg
     databasePool->nodePools = hash_create(hash_name, TBASE_MAX_DATANODE_NUMBER + TBASE_MAX_COORDINATOR_NUMBER,
                                           &hinfo, hflags);
 
+#ifdef __TBASE__
+    hinfo.entrysize = sizeof(PoolDemandHistory);
+    snprintf(hash_name, NODE_POOL_NAME_LEN, "%s_%s_Demand_History", database, user_name);
+    databasePool->demandHistory = hash_create(hash_name, 64, &hinfo, hflags);
+#endif
+
     MemoryContextSwitchTo(oldcontext);
 
     /* Insert into the list */
@@ -4565,6 +5226,14 @@ acquire_connection(DatabasePool *dbPool, PGXCNodePool **pool,int32 nodeidx, Oid
     nodePool = (PGXCNodePool *) hash_search(dbPool->nodePools, &node, HASH_FIND,
                                             NULL);
 
+#ifdef __TBASE__
+    /* the pool can not grow, take back connections parked by idle sessions */
+    if (nodePool && nodePool->freeSize == 0 && nodePool->size >= MaxPoolSize)
+    {
+        reclaim_parked_connections(dbPool, nodeidx, bCoord);
+    }
+#endif
+
     /*
      * When a Coordinator pool is initialized by a Coordinator Postmaster,
      * it has a NULL size and is below minimum size that is 1
@@ -4683,6 +5352,9 @@ retry:
     if (slot)
     {
         PgxcNodeUpdateHealth(node, true);
+#ifdef __TBASE__
+        pooler_note_demand(dbPool, nodePool);
+#endif
     }
     
     /* prebuild connection before next acquire */
@@ -4954,6 +5626,9 @@ grow_pool(DatabasePool *dbPool, int32 nodeidx, Oid node, bool bCoord)
         nodePool->coord      = bCoord;        
         nodePool->nwarming   = 0;
         nodePool->nquery     = 0;
+#ifdef __TBASE__
+        nodePool->warm_target = 0;
+#endif
 
         name_str = get_node_name_by_nodeoid(node);
         if (NULL == name_str)
@@ -5455,7 +6130,7 @@ PoolerLoop(void)
             int         saved_errno;
 
             /* Connect to the pooler */
-            server_fd = pool_listen(PoolerPort, socketdir);
+            server_fd = pool_listen(PoolerPort, socketdir, PoolerShardIndex);
             if (server_fd < 0)
             {
                 saved_errno = errno;
@@ -5923,6 +6598,14 @@ shrink_pool(DatabasePool *pool)
         for (i = 0; i < nodePool->freeSize && freeCount < MAX_FREE_CONNECTION_NUM && nodePool->size >= MinPoolSize && nodePool->freeSize >= MinFreeSize; )
         {
             PGXCNodePoolSlot *slot = nodePool->slot[i];
+
+#ifdef __TBASE__
+            /* keep the connections predicted to be needed soon */
+            if (nodePool->size <= nodePool->warm_target)
+            {
+                break;
+            }
+#endif
             if (slot)
             {
                 /* no need to shrik warmed slot, only discard them when they use too much memroy */
@@ -6087,9 +6770,19 @@ pools_maintenance(void)
     int                count = 0;
     
 
+#ifdef __TBASE__
+    /* idle sessions give back their parked connections before pools shrink */
+    evict_idle_parked_connections();
+#endif
+
     /* Iterate over the pools */
     while (curr)
     {
+#ifdef __TBASE__
+        /* grow ahead of the demand expected soon, and protect it from shrink */
+        pooler_predictive_warm(curr);
+#endif
+
         /*
          * If current pool has connections to close and it is emptied after
          * shrink remove the pool and free memory.
@@ -6729,6 +7422,9 @@ static void pooler_sync_connections_to_nodepool(void)
                     nodePool->coord      = false; /* in this case, only datanode */
                     nodePool->nwarming   = 0;
                     nodePool->nquery     = 0;
+#ifdef __TBASE__
+                    nodePool->warm_target = 0;
+#endif
 					nodePool->m_version = time(NULL);
 
                     name_str = get_node_name_by_nodeoid(asyncInfo->node);
@@ -6889,6 +7585,9 @@ static void pooler_sync_connections_to_nodepool(void)
                         nodePool->coord      = connRsp->bCoord; 
                         nodePool->nwarming   = 0;
                         nodePool->nquery     = 0;
+#ifdef __TBASE__
+                        nodePool->warm_target = 0;
+#endif
 
                         name_str = get_node_name_by_nodeoid(connRsp->nodeoid);
                         if (NULL == name_str)
@@ -7364,6 +8063,18 @@ connect_pools(void)
                 p = sep + 1;
             }
 
+#ifdef __TBASE__
+            /* the pool is warmed by the pooler that owns it */
+            if (PoolerShardOf(db, user) != PoolerShardIndex)
+            {
+                if (NULL == sep)
+                {
+                    break;
+                }
+                continue;
+            }
+#endif
+
             /* warm db pool */
             elog(LOG, POOL_MGR_PREFIX"Pooler: db:%s user:%s need precreate and warm ", db, user);
             dbpool = find_database_pool((char*)db, (char*)user, session_options());
@@ -7448,6 +8159,9 @@ preconnect_and_warm(DatabasePool *dbPool)
             nodePool->coord    = false;
             nodePool->nwarming   = 0;
             nodePool->nquery     = 0;
+#ifdef __TBASE__
+            nodePool->warm_target = 0;
+#endif
 
             name_str = get_node_name_by_nodeoid(dnOids[i]);
             if (NULL == name_str)
@@ -7561,6 +8275,175 @@ preconnect_and_warm(DatabasePool *dbPool)
     return true;
 }
 
+#ifdef __TBASE__
+/*
+ * Predictive pool warming
+ *
+ * Connection demand tends to follow the clock, the same workload comes back
+ * at the same time every day.  Each database pool remembers, for each node,
+ * the peak number of connections in use in every quarter hour of the day,
+ * smoothed over the days.  Pool maintenance grows a node pool ahead of a
+ * quarter hour that used to need more connections than the pool has, so a
+ * recurring burst finds them already connected, and keeps shrink_pool from
+ * closing them while the demand is expected.  Once the predicted demand goes
+ * down again the idle connections age out as usual.
+ */
+#define PoolDemandSlotOf(t) \
+    ((int) (((t) % 86400) / (86400 / POOL_DEMAND_SLOTS)))
+
+/*
+ * Fold the peaks of the quarter hours that have passed into the history
+ */
+static void
+pooler_roll_demand(PoolDemandHistory *history, time_t now)
+{
+    int         slot = PoolDemandSlotOf(now);
+    int         n;
+
+    for (n = 0; history->slot != slot && n < POOL_DEMAND_SLOTS; n++)
+    {
+        uint16     *demand = &history->demand[history->slot];
+
+        /* learn a new peak quickly, forget an old one slowly */
+        if (history->peak > *demand)
+        {
+            *demand = (*demand + history->peak + 1) / 2;
+        }
+        else
+        {
+            *demand = (*demand * 3 + history->peak) / 4;
+        }
+
+        history->peak = 0;
+        history->slot = (history->slot + 1) % POOL_DEMAND_SLOTS;
+    }
+    history->slot = slot;
+}
+
+/*
+ * Record the connections in use of a node pool after an acquisition
+ */
+static void
+pooler_note_demand(DatabasePool *dbPool, PGXCNodePool *nodePool)
+{
+    PoolDemandHistory *history;
+    time_t        now;
+    bool        found;
+    int            in_use;
+
+    if (!PoolerPredictiveWarm)
+    {
+        return;
+    }
+
+    now = time(NULL);
+    history = (PoolDemandHistory *) hash_search(dbPool->demandHistory, &nodePool->nodeoid,
+                                                HASH_ENTER, &found);
+    if (!found)
+    {
+        history->coord = nodePool->coord;
+        history->slot = PoolDemandSlotOf(now);
+        history->peak = 0;
+        memset(history->demand, 0, sizeof(history->demand));
+    }
+
+    pooler_roll_demand(history, now);
+
+    in_use = nodePool->size - nodePool->freeSize;
+    if (in_use > history->peak)
+    {
+        history->peak = in_use;
+    }
+}
+
+/*
+ * Grow the node pools of a database pool to the demand expected within
+ * pooler_warm_lead_time, and tell shrink_pool how much of them to keep.
+ */
+static void
+pooler_predictive_warm(DatabasePool *dbPool)
+{// #lizard forgives
+    HASH_SEQ_STATUS    hseq_status;
+    PoolDemandHistory *history;
+    time_t            now = time(NULL);
+    int                first = PoolDemandSlotOf(now);
+    int                last = PoolDemandSlotOf(now + PoolerWarmLeadTime);
+
+    if (NULL == g_nodemap)
+    {
+        create_node_map();
+    }
+
+    hash_seq_init(&hseq_status, dbPool->demandHistory);
+    while ((history = (PoolDemandHistory *) hash_seq_search(&hseq_status)))
+    {
+        PGXCNodePool   *nodePool;
+        int32            nodeidx;
+        int                target = 0;
+        int                slot;
+
+        /* forget the nodes dropped since */
+        if (hash_search(g_nodemap, &history->nodeoid, HASH_FIND, NULL) == NULL)
+        {
+            hash_search(dbPool->demandHistory, &history->nodeoid, HASH_REMOVE, NULL);
+            continue;
+        }
+
+        pooler_roll_demand(history, now);
+
+        if (PoolerPredictiveWarm)
+        {
+            for (slot = first;; slot = (slot + 1) % POOL_DEMAND_SLOTS)
+            {
+                target = Max(target, history->demand[slot]);
+                if (slot == last)
+                {
+                    break;
+                }
+            }
+            target = Min(target, MaxPoolSize);
+        }
+
+        nodePool = (PGXCNodePool *) hash_search(dbPool->nodePools, &history->nodeoid,
+                                                HASH_FIND, NULL);
+        if (nodePool)
+        {
+            nodePool->warm_target = target;
+        }
+
+        if (0 == target || !dbPool->bneed_pool ||
+            (nodePool && (nodePool->asyncInProgress || nodePool->size >= target)))
+        {
+            continue;
+        }
+
+        nodeidx = get_node_index_by_nodeoid(history->nodeoid);
+        if (NULL == nodePool)
+        {
+            nodePool = grow_pool(dbPool, nodeidx, history->nodeoid, history->coord);
+            nodePool->warm_target = target;
+            if (nodePool->asyncInProgress || nodePool->size >= target)
+            {
+                continue;
+            }
+        }
+
+        if (pooler_async_build_connection(dbPool, nodePool->m_version, nodeidx, history->nodeoid,
+                                          target - nodePool->size, nodePool->connstr, history->coord))
+        {
+            nodePool->asyncInProgress = true;
+            if (PoolConnectDebugPrint)
+            {
+                elog(LOG, POOL_MGR_PREFIX"predictive warm of database:%s user:%s node:%s "
+                          "size:%d freeSize:%d target:%d",
+                     dbPool->database, dbPool->user_name, nodePool->node_name,
+                     nodePool->size, nodePool->freeSize, target);
+            }
+        }
+    }
+}
+#endif
+
 /*
  * Thread that will build connection async
  */
@@ -11060,11 +11943,31 @@ PoolManagerRefreshConnectionInfo(void)
 
     RESUME_POOLER_RELOAD();
 
+#ifdef __TBASE__
+    {
+        bool        refreshed = (res == POOL_CHECK_SUCCESS);
+
+        pooler_replay_on_other_shards(pooler_replay_refresh, &refreshed);
+        return refreshed;
+    }
+#else
     if (res == POOL_CHECK_SUCCESS)
         return true;
 
     return false;
+#endif
+}
+
+#ifdef __TBASE__
+static void
+pooler_replay_refresh(void *arg)
+{
+    if (!PoolManagerRefreshConnectionInfo())
+    {
+        *(bool *) arg = false;
+    }
 }
+#endif
 
 
 static void reset_pooler_statistics(void)
@@ -11211,6 +12114,28 @@ static bool connection_need_pool(char *filter, const char *name)
 }
 
 
+#ifdef __TBASE__
+typedef struct PoolerReplayClose
+{
+    const char *dbname;
+    const char *username;
+    int            res;            /* first failure of the poolers, if any */
+} PoolerReplayClose;
+
+static void
+pooler_replay_close(void *arg)
+{
+    PoolerReplayClose *close_arg = (PoolerReplayClose *) arg;
+    int            res;
+
+    res = PoolManagerClosePooledConnections(close_arg->dbname, close_arg->username);
+    if (res != POOL_CONN_RELEASE_SUCCESS && close_arg->res == POOL_CONN_RELEASE_SUCCESS)
+    {
+        close_arg->res = res;
+    }
+}
+#endif
+
 /* close pooled connection */
 int
 PoolManagerClosePooledConnections(const char *dbname, const char *username)
@@ -11261,6 +12186,18 @@ PoolManagerClosePooledConnections(const char *dbname, const char *username)
 
     RESUME_POOLER_RELOAD();
 
+#ifdef __TBASE__
+    {
+        PoolerReplayClose close_arg;
+
+        close_arg.dbname = dbname;
+        close_arg.username = username;
+        close_arg.res = res;
+        pooler_replay_on_other_shards(pooler_replay_close, &close_arg);
+        res = close_arg.res;
+    }
+#endif
+
     return res;
 }
 
@@ -11336,21 +12273,94 @@ ConnectPoolManager(void)
 {
 	bool need_abort = false;
 	PoolHandle *handle = NULL;
+	char *database = NULL;
+	char *user_name = NULL;
 	
-	handle = GetPoolManagerHandle();
 	if (!IsTransactionOrTransactionBlock())
 	{
 		StartTransactionCommand();
 		need_abort = true;
 	}
-	PoolManagerConnect(handle, get_database_name(MyDatabaseId),
-					   GetClusterUserName(), session_options());
+	database = get_database_name(MyDatabaseId);
+	user_name = GetClusterUserName();
+
+	/* remember where the session's agent lives for replayed commands */
+	if (session_pooler_database)
+	{
+		pfree(session_pooler_database);
+		pfree(session_pooler_user);
+	}
+	session_pooler_database = MemoryContextStrdup(TopMemoryContext, database);
+	session_pooler_user = MemoryContextStrdup(TopMemoryContext, user_name);
+	session_pooler_shard = PoolerShardOf(database, user_name);
+
+	handle = GetPoolManagerShardHandle(session_pooler_shard);
+	PoolManagerConnect(handle, database, user_name, session_options());
 	if (need_abort)
 	{
 		AbortCurrentTransaction();
 	}
 
 }
+
+/*
+ * Run a command concerning all the database pools on the poolers other than
+ * the one of the session.  The command is the public function that sent it to
+ * the session's pooler; it runs again with poolHandle switched to a temporary
+ * agent on each of the other poolers.
+ */
+static void
+pooler_replay_on_other_shards(PoolerReplayCommand command, void *arg)
+{
+	PoolHandle *session_handle = poolHandle;
+	int			shard;
+
+	if (PoolerProcesses <= 1 || pooler_replaying || session_pooler_database == NULL)
+	{
+		return;
+	}
+
+	HOLD_POOLER_RELOAD();
+	pooler_replaying = true;
+
+	PG_TRY();
+	{
+		for (shard = 0; shard < PoolerProcesses; shard++)
+		{
+			if (shard == session_pooler_shard)
+			{
+				continue;
+			}
+
+			poolHandle = NULL;
+			PoolManagerConnect(GetPoolManagerShardHandle(shard),
+							   session_pooler_database, session_pooler_user,
+							   session_options());
+
+			command(arg);
+
+			pool_putmessage(&poolHandle->port, 'd', NULL, 0);
+			pool_flush(&poolHandle->port);
+			PoolManagerCloseHandle(poolHandle);
+			poolHandle = session_handle;
+		}
+	}
+	PG_CATCH();
+	{
+		if (poolHandle && poolHandle != session_handle)
+		{
+			PoolManagerCloseHandle(poolHandle);
+		}
+		poolHandle = session_handle;
+		pooler_replaying = false;
+		RESUME_POOLER_RELOAD();
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	pooler_replaying = false;
+	RESUME_POOLER_RELOAD();
+}
 #endif
 
 /*
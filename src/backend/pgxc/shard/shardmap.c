@@ -75,6 +75,7 @@
 #include "pgxc/shardmap.h"
 #include "pgxc/pgxc.h"
 #include "pgxc/pgxcnode.h"
+#include "pgxc/execRemote.h"
 #include "pgxc/nodemgr.h"
 #include "pgxc/locator.h"
 #include "nodes/bitmapset.h"
@@ -111,6 +112,9 @@
 #include "utils/memutils.h"
 #include "postmaster/postmaster.h"
 #include "utils/ruleutils.h"
+#include "access/tuptoaster.h"
+#include "executor/executor.h"
+#include "storage/bufmgr.h"
 #endif
 
 /* 12 month for a year */
@@ -236,6 +240,9 @@ typedef struct
 } ShmMgr_State;
 
 bool  show_all_shard_stat = false;
+#ifdef __TBASE__
+bool  g_ShardPhysicalMove = false;
+#endif
 
 #ifdef __COLD_HOT__
 /* lock access info, use on datanode */
@@ -333,6 +340,10 @@ static void GetShardNodes_DN(Oid group, int32 ** nodes, int32 *num_nodes, bool *
 
 extern Datum  pg_stat_table_shard(PG_FUNCTION_ARGS);
 extern Datum  pg_stat_all_shard(PG_FUNCTION_ARGS);
+#ifdef __TBASE__
+extern Datum  tbase_shard_export(PG_FUNCTION_ARGS);
+static void PgxcPullShards_DN(MoveDataStmt *stmt);
+#endif
 
 static void RefreshShardStatistic(ShardStat *shardstat);
 
@@ -1326,6 +1337,95 @@ int32  GetNodeIndexByHashValue(Oid group, long hashvalue)
     return nodeIdx;
 }
 
+#ifdef __TBASE__
+/*
+ * Batch version of GetNodeIndexByHashValue. The group lookup and the shard map
+ * lock are taken once for the whole vector instead of once per row, and the
+ * shard map entries are prefetched a few rows ahead. Results are identical to
+ * calling GetNodeIndexByHashValue for each hash value.
+ */
+#define SHARD_MAP_PREFETCH_DISTANCE 8
+
+void GetNodeIndexByHashValues(Oid group, long *hashvalues, int nvalues, int32 *nodeindexes)
+{// #lizard forgives
+    int            i;
+    int            shardIdx;
+    int            numShards = 0;
+    bool           needLock = false;
+    bool           found;
+    GroupLookupTag tag;
+    GroupLookupEnt *ent;
+    ShardMapItemDef *shardmap = NULL;
+    int slot = 0;
+
+    if (nvalues <= 0)
+    {
+        return;
+    }
+    
+    if(IS_PGXC_COORDINATOR && !OidIsValid(group))
+    {
+        elog(PANIC, "[GetNodeIndexByHashValues]group oid can not be invalid.");
+    }
+
+    if (IS_PGXC_COORDINATOR)
+    {
+        needLock  = g_GroupShardingMgr->needLock;
+        if (needLock)
+        {
+            LWLockAcquire(ShardMapLock, LW_SHARED);
+        }
+
+        tag.group =  group;
+        ent = (GroupLookupEnt*)hash_search(g_GroupHashTab, (void *) &tag, HASH_FIND, &found);            
+        if (!found)
+        {
+            elog(ERROR , "no shard group of %u found", group);
+        }
+
+        slot = ent->shardIndex;
+
+        numShards = g_GroupShardingMgr->members[slot]->shmemNumShards;
+        shardmap  = g_GroupShardingMgr->members[slot]->shmemshardmap;
+    }
+    else if (IS_PGXC_DATANODE)
+    {
+        needLock  = g_GroupShardingMgr_DN->needLock;
+        if (needLock)
+        {
+            LWLockAcquire(ShardMapLock, LW_SHARED);
+        }
+
+        numShards = g_GroupShardingMgr_DN->members->shmemNumShards;
+        shardmap  = g_GroupShardingMgr_DN->members->shmemshardmap;
+    }
+
+    if (shardmap == NULL)
+    {
+        memset(nodeindexes, 0, sizeof(int32) * nvalues);
+    }
+    else
+    {
+        for (i = 0; i < nvalues; i++)
+        {
+#if defined(__GNUC__)
+            if (i + SHARD_MAP_PREFETCH_DISTANCE < nvalues)
+            {
+                __builtin_prefetch(&shardmap[abs(hashvalues[i + SHARD_MAP_PREFETCH_DISTANCE]) % numShards]);
+            }
+#endif
+            shardIdx       = abs(hashvalues[i]) % numShards;
+            nodeindexes[i] = shardmap[shardIdx].nodeindex;
+        }
+    }
+
+    if (needLock)
+    {
+        LWLockRelease(ShardMapLock);
+    }
+}
+#endif
+
 /* Get node index map of group. */
 void  GetGroupNodeIndexMap(Oid group, int32 *map)
 {// #lizard forgives
@@ -1756,6 +1856,12 @@ void PgxcMoveData_DN(MoveDataStmt* stmt)
             {
                 elog(LOG,"[PgxcMoveData_DN]When using strategy MOVE_DATA_STRATEGY_SHARD, no need to"
                          " truncate all non-shard tables.");
+#ifdef __TBASE__
+                if (g_ShardPhysicalMove)
+                {
+                    PgxcPullShards_DN(stmt);
+                }
+#endif
             }
             break;
          case MOVE_DATA_STRATEGY_AT:
@@ -2343,6 +2449,524 @@ TruncateShard(Oid reloid, ShardID sid, int pausetime)
     
     return tuples;
 }
+
+#ifdef __TBASE__
+/*
+ * Physical shard move.
+ *
+ * tbase_shard_export() walks the extent scan chain of one shard and returns
+ * the tuples visible to the current snapshot packed into chunks. The shard is
+ * read with heap_beginscan_shards(), so only its extents are visited, with
+ * extent read-ahead, and tuples never go through the executor or the type
+ * output functions.
+ * With enable_shard_physical_move set, MOVE DATA with the shard strategy
+ * makes the target datanode pull every moved shard from the source with
+ * tbase_shard_export() and load the chunks into the same relation with
+ * heap_multi_insert, inserting the index entries.
+ *
+ * Page images are not copied as they are: xids on them mean nothing on the
+ * target node, so the tuples are stamped by the importing transaction and
+ * WAL-logged by the multi-insert records. Toasted values are inlined on
+ * export. Writes to the shard must be stopped, e.g. by a shard barrier, while
+ * it is exported.
+ *
+ * A chunk is a sequence of { uint32 t_len; t_len bytes of HeapTupleHeader }.
+ */
+#define SHARD_EXPORT_CHUNK_SIZE (1024 * 1024)
+#define SHARD_IMPORT_BATCH      1000
+
+typedef struct
+{
+    Relation     rel;
+    HeapScanDesc scan;      /* NULL once the scan is ended */
+} ShardExportState;
+
+/*
+ * End the shard scan, also when the caller stops fetching early.
+ */
+static void
+ShardExportShutdown(Datum arg)
+{
+    ShardExportState *state = (ShardExportState *) DatumGetPointer(arg);
+
+    if (state->scan != NULL)
+    {
+        heap_endscan(state->scan);
+        heap_close(state->rel, NoLock);
+        state->scan = NULL;
+    }
+}
+
+/*
+ * Append one tuple to the chunk, inlining toasted values since toast
+ * pointers are only valid on this node.
+ */
+static void
+ShardExportTuple(Relation rel, HeapTuple tuple, StringInfo chunk)
+{
+    HeapTuple   flat = tuple;
+    uint32      len;
+
+    if (HeapTupleHasExternal(tuple))
+        flat = toast_flatten_tuple(tuple, RelationGetDescr(rel));
+
+    len = flat->t_len;
+    appendBinaryStringInfo(chunk, (char *) &len, sizeof(len));
+    appendBinaryStringInfo(chunk, (char *) flat->t_data, len);
+
+    if (flat != tuple)
+        heap_freetuple(flat);
+}
+
+Datum
+tbase_shard_export(PG_FUNCTION_ARGS)
+{// #lizard forgives
+#define SHARD_EXPORT_NCOLUMNS 3
+    FuncCallContext  *funcctx;
+    ShardExportState *state;
+    StringInfoData    chunk;
+    HeapTuple         tuple;
+    ExtentID          first_eid = InvalidExtentID;
+    int               ntuples = 0;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        MemoryContext  oldcontext;
+        TupleDesc      tupdesc;
+        ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+        Oid            relid = PG_GETARG_OID(0);
+        int32          sid = PG_GETARG_INT32(1);
+        ShardID        shard;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        tupdesc = CreateTemplateTupleDesc(SHARD_EXPORT_NCOLUMNS, false);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 1, "extent_id",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 2, "ntuples",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 3, "data",
+                           BYTEAOID, -1, 0);
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        /* raw tuples bypass column privileges and row level security */
+        if (!superuser())
+            ereport(ERROR,
+                    (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                     errmsg("must be superuser to export shards")));
+
+        if (sid < 0 || sid >= MAX_SHARDS)
+        {
+            elog(ERROR, "shard id %d is out of range", sid);
+        }
+
+        if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("set-valued function called in context that cannot accept a set")));
+
+        state = (ShardExportState *) palloc0(sizeof(ShardExportState));
+        state->rel = heap_open(relid, AccessShareLock);
+        if (!RelationHasExtent(state->rel))
+        {
+            elog(ERROR, "only sharded table can be exported by shard.");
+        }
+
+        shard = (ShardID) sid;
+        state->scan = heap_beginscan_shards(state->rel, GetActiveSnapshot(),
+                                            0, NULL, 1, &shard);
+        RegisterExprContextCallback(rsinfo->econtext, ShardExportShutdown,
+                                    PointerGetDatum(state));
+
+        funcctx->user_fctx = (void *) state;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    state = (ShardExportState *) funcctx->user_fctx;
+
+    initStringInfo(&chunk);
+    while (chunk.len < SHARD_EXPORT_CHUNK_SIZE &&
+           (tuple = heap_getnext(state->scan, ForwardScanDirection)) != NULL)
+    {
+        CHECK_FOR_INTERRUPTS();
+
+        if (ntuples == 0)
+            first_eid = ItemPointerGetBlockNumber(&tuple->t_self) / PAGES_PER_EXTENTS;
+
+        ShardExportTuple(state->rel, tuple, &chunk);
+        ntuples++;
+    }
+
+    if (ntuples == 0)
+    {
+        pfree(chunk.data);
+        ShardExportShutdown(PointerGetDatum(state));
+        /* the state goes away with the call context */
+        UnregisterExprContextCallback(((ReturnSetInfo *) fcinfo->resultinfo)->econtext,
+                                      ShardExportShutdown, PointerGetDatum(state));
+        SRF_RETURN_DONE(funcctx);
+    }
+    else
+    {
+        Datum       values[SHARD_EXPORT_NCOLUMNS];
+        bool        nulls[SHARD_EXPORT_NCOLUMNS];
+        bytea      *data;
+        HeapTuple   result;
+
+        data = (bytea *) palloc(VARHDRSZ + chunk.len);
+        SET_VARSIZE(data, VARHDRSZ + chunk.len);
+        memcpy(VARDATA(data), chunk.data, chunk.len);
+        pfree(chunk.data);
+
+        MemSet(nulls, 0, sizeof(nulls));
+        values[0] = Int32GetDatum(first_eid);
+        values[1] = Int32GetDatum(ntuples);
+        values[2] = PointerGetDatum(data);
+
+        result = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(result));
+    }
+}
+
+/*
+ * Check that a tuple from a shard chunk can be stored in the relation.
+ *
+ * The chunk comes from another node, so nothing in it is trusted: the header
+ * must agree with the tuple descriptor and every attribute must lie inside
+ * the tuple, otherwise deforming it later could read past the end.
+ */
+static void
+ShardImportCheckTuple(Relation rel, HeapTuple tuple)
+{// #lizard forgives
+    TupleDesc       tupdesc = RelationGetDescr(rel);
+    HeapTupleHeader tup = tuple->t_data;
+    uint32          len = tuple->t_len;
+    int             natts = HeapTupleHeaderGetNatts(tup);
+    bool            hasnulls = HeapTupleHasNulls(tuple);
+    Size            hoff;
+    char           *tp;
+    bits8          *bp = tup->t_bits;
+    Size            datalen;
+    Size            off = 0;
+    int             i;
+
+    hoff = SizeofHeapTupleHeader;
+    if (hasnulls)
+        hoff += BITMAPLEN(natts);
+    if (tup->t_infomask & HEAP_HASOID)
+        hoff += sizeof(Oid);
+    hoff = MAXALIGN(hoff);
+
+    if (natts > tupdesc->natts ||
+        tup->t_hoff != hoff || tup->t_hoff > len ||
+        ((tup->t_infomask & HEAP_HASOID) != 0) != rel->rd_rel->relhasoids ||
+        (tup->t_infomask & HEAP_HASEXTERNAL) != 0)
+    {
+        elog(ERROR, "invalid shard chunk: tuple does not match relation \"%s\"",
+             RelationGetRelationName(rel));
+    }
+
+    tp = (char *) tup + tup->t_hoff;
+    datalen = len - tup->t_hoff;
+    for (i = 0; i < natts; i++)
+    {
+        Form_pg_attribute att = tupdesc->attrs[i];
+
+        if (hasnulls && att_isnull(i, bp))
+            continue;
+
+        if (off >= datalen && att->attlen != 0)
+            break;
+        off = att_align_pointer(off, att->attalign, att->attlen, tp + off);
+
+        if (att->attlen > 0)
+        {
+            off += att->attlen;
+        }
+        else if (att->attlen == -1)
+        {
+            if (off >= datalen ||
+                (!VARATT_IS_1B(tp + off) && datalen - off < VARHDRSZ) ||
+                VARATT_IS_EXTERNAL(tp + off))
+                break;
+            off += VARSIZE_ANY(tp + off);
+        }
+        else
+        {
+            if (off >= datalen || strnlen(tp + off, datalen - off) == datalen - off)
+                break;
+            off += strlen(tp + off) + 1;
+        }
+
+        if (off > datalen)
+            break;
+    }
+
+    if (i < natts)
+    {
+        elog(ERROR, "invalid shard chunk: attribute %d of relation \"%s\" is corrupted",
+             i + 1, RelationGetRelationName(rel));
+    }
+}
+
+/*
+ * Load a chunk produced by tbase_shard_export() into the shard of the local
+ * relation, returns the number of tuples loaded.
+ *
+ * Rows are moved, not inserted, so no triggers are fired; relations with row
+ * insert triggers have to be moved through the SQL path. Constraints are
+ * checked as for COPY.
+ */
+static int64
+ShardImportChunk(Relation rel, ShardID sid, bytea *data)
+{// #lizard forgives
+    char           *ptr = VARDATA(data);
+    char           *end = VARDATA(data) + VARSIZE(data) - VARHDRSZ;
+    EState         *estate;
+    ResultRelInfo  *resultRelInfo;
+    TupleTableSlot *slot;
+    BulkInsertState bistate;
+    CommandId       mycid = GetCurrentCommandId(true);
+    HeapTuple      *tuples;
+    HeapTupleData  *tupdata;
+    int             ntuples = 0;
+    int64           loaded = 0;
+
+    if (!RelationHasExtent(rel))
+    {
+        elog(ERROR, "only sharded table can be imported by shard.");
+    }
+    if (rel->trigdesc &&
+        (rel->trigdesc->trig_insert_before_row || rel->trigdesc->trig_insert_after_row))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("cannot move shard of relation \"%s\" physically because it has row insert triggers",
+                        RelationGetRelationName(rel))));
+    }
+
+    estate = CreateExecutorState();
+    resultRelInfo = makeNode(ResultRelInfo);
+    InitResultRelInfo(resultRelInfo, rel, 1, NULL, 0);
+    ExecOpenIndices(resultRelInfo, false);
+    estate->es_result_relations = resultRelInfo;
+    estate->es_num_result_relations = 1;
+    estate->es_result_relation_info = resultRelInfo;
+    slot = ExecInitExtraTupleSlot(estate);
+    ExecSetSlotDescriptor(slot, RelationGetDescr(rel));
+    bistate = GetBulkInsertState();
+
+    tuples = (HeapTuple *) palloc(sizeof(HeapTuple) * SHARD_IMPORT_BATCH);
+    tupdata = (HeapTupleData *) palloc(sizeof(HeapTupleData) * SHARD_IMPORT_BATCH);
+
+    while (ptr < end || ntuples > 0)
+    {
+        if (ptr < end)
+        {
+            HeapTuple   tuple = &tupdata[ntuples];
+            uint32      len;
+
+            if (end - ptr < sizeof(len))
+            {
+                elog(ERROR, "invalid shard chunk: truncated tuple length");
+            }
+            memcpy(&len, ptr, sizeof(len));
+            ptr += sizeof(len);
+            if (len < SizeofHeapTupleHeader || len > MaxHeapTupleSize || end - ptr < len)
+            {
+                elog(ERROR, "invalid shard chunk: tuple length %u", len);
+            }
+
+            /* tuples are not aligned inside the chunk */
+            tuple->t_len = len;
+            tuple->t_data = (HeapTupleHeader) MemoryContextAlloc(GetPerTupleMemoryContext(estate), len);
+            memcpy(tuple->t_data, ptr, len);
+            tuple->t_tableOid = RelationGetRelid(rel);
+            ItemPointerSetInvalid(&tuple->t_self);
+            ptr += len;
+
+            ShardImportCheckTuple(rel, tuple);
+            if (HeapTupleHeaderGetShardId(tuple->t_data) != sid)
+            {
+                elog(ERROR, "invalid shard chunk: tuple of shard %d, expected %d",
+                     HeapTupleHeaderGetShardId(tuple->t_data), sid);
+            }
+
+            if (rel->rd_att->constr)
+            {
+                ExecStoreTuple(tuple, slot, InvalidBuffer, false);
+                ExecConstraints(resultRelInfo, slot, estate);
+            }
+
+            tuples[ntuples++] = tuple;
+            if (ntuples < SHARD_IMPORT_BATCH && ptr < end)
+                continue;
+        }
+
+        heap_multi_insert(rel, tuples, ntuples, mycid, 0, bistate);
+        if (resultRelInfo->ri_NumIndices > 0)
+        {
+            int i;
+
+            for (i = 0; i < ntuples; i++)
+            {
+                List *recheckIndexes;
+
+                ExecStoreTuple(tuples[i], slot, InvalidBuffer, false);
+                recheckIndexes = ExecInsertIndexTuples(slot, &(tuples[i]->t_self),
+                                                       estate, false, NULL, NIL);
+                list_free(recheckIndexes);
+            }
+        }
+        loaded += ntuples;
+        ntuples = 0;
+        ResetPerTupleExprContext(estate);
+        CHECK_FOR_INTERRUPTS();
+    }
+
+    pfree(tuples);
+    pfree(tupdata);
+    FreeBulkInsertState(bistate);
+    ExecResetTupleTable(estate->es_tupleTable, false);
+    ExecCloseIndices(resultRelInfo);
+    FreeExecutorState(estate);
+
+    return loaded;
+}
+
+/*
+ * Pull one shard of a relation from the source datanode with
+ * tbase_shard_export() and load it locally.
+ */
+static int64
+ShardPullFromNode(Relation rel, ShardID sid, int nodeindex)
+{
+    EState           *estate;
+    MemoryContext     oldcontext;
+    RemoteQuery      *plan;
+    RemoteQueryState *pstate;
+    TupleTableSlot   *result;
+    Var              *dummy;
+    StringInfoData    query;
+    int64             loaded = 0;
+
+    initStringInfo(&query);
+    appendStringInfo(&query,
+                     "SELECT data FROM pg_catalog.tbase_shard_export(%s::regclass, %d)",
+                     quote_literal_cstr(quote_qualified_identifier(
+                             get_namespace_name(RelationGetNamespace(rel)),
+                             RelationGetRelationName(rel))),
+                     sid);
+
+    plan = makeNode(RemoteQuery);
+    plan->combine_type = COMBINE_TYPE_NONE;
+    plan->exec_nodes = makeNode(ExecNodes);
+    plan->exec_nodes->nodeList = list_make1_int(nodeindex);
+    plan->exec_type = EXEC_ON_DATANODES;
+    plan->sql_statement = query.data;
+    plan->force_autocommit = false;
+    dummy = makeVar(1, 1, BYTEAOID, -1, InvalidOid, 0);
+    plan->scan.plan.targetlist = list_make1(makeTargetEntry((Expr *) dummy, 1, NULL, false));
+
+    estate = CreateExecutorState();
+    oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+    estate->es_snapshot = GetActiveSnapshot();
+    pstate = ExecInitRemoteQuery(plan, estate, 0);
+    MemoryContextSwitchTo(oldcontext);
+
+    result = ExecRemoteQuery((PlanState *) pstate);
+    while (result != NULL && !TupIsNull(result))
+    {
+        bool    isnull;
+        Datum   datum = slot_getattr(result, 1, &isnull);
+
+        if (!isnull)
+            loaded += ShardImportChunk(rel, sid, DatumGetByteaP(datum));
+        result = ExecRemoteQuery((PlanState *) pstate);
+    }
+    ExecEndRemoteQuery(pstate);
+    FreeExecutorState(estate);
+    pfree(query.data);
+
+    return loaded;
+}
+
+/*
+ * Physical mode of MOVE DATA with the shard strategy, run on the target
+ * datanode: every shard being moved is pulled from the source datanode.
+ *
+ * The source walks the extent chain of the shard and ships its tuples as
+ * they are stored, so it neither plans nor evaluates anything; the target
+ * inserts them in batches. Extents and their WAL are not shipped as such,
+ * since extent ids, the EMA pages and the WAL are local to each datanode.
+ *
+ * This replaces copying the shards beforehand, it does not follow it: if
+ * the target already has extents of a moved shard, the shards were copied
+ * already and pulling them would duplicate their rows, so nothing is
+ * pulled.
+ */
+static void
+PgxcPullShards_DN(MoveDataStmt *stmt)
+{
+    List       *reloids;
+    ListCell   *lc;
+    char        ntype = PGXC_NODE_DATANODE;
+    int         nodeindex;
+    int         i;
+
+    if (!superuser())
+        ereport(ERROR,
+                (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                 errmsg("must be superuser to move shards physically")));
+
+    nodeindex = PGXCNodeGetNodeId(stmt->fromid, &ntype);
+    if (nodeindex < 0 || ntype != PGXC_NODE_DATANODE)
+    {
+        elog(ERROR, "source node %u of shard move is not a datanode", stmt->fromid);
+    }
+
+    reloids = GetShardRelations(false);
+    foreach(lc, reloids)
+    {
+        Relation    rel = heap_open(lfirst_oid(lc), RowExclusiveLock);
+
+        if (RelationHasExtent(rel))
+        {
+            for (i = 0; i < stmt->num_shard; i++)
+            {
+                if (ExtentIdIsValid(GetShardScanHead(rel, (ShardID) stmt->arr_shard[i])))
+                    ereport(ERROR,
+                            (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                             errmsg("shard %d of relation \"%s\" already has data on this datanode",
+                                    stmt->arr_shard[i], RelationGetRelationName(rel)),
+                             errhint("Either copy the shards or set enable_shard_physical_move, not both.")));
+            }
+        }
+        heap_close(rel, NoLock);
+    }
+
+    foreach(lc, reloids)
+    {
+        Relation    rel = heap_open(lfirst_oid(lc), RowExclusiveLock);
+
+        if (RelationHasExtent(rel))
+        {
+            for (i = 0; i < stmt->num_shard; i++)
+            {
+                int64 loaded = ShardPullFromNode(rel, (ShardID) stmt->arr_shard[i], nodeindex);
+
+                elog(LOG, "[PgxcMoveData_DN]moved %ld tuples of shard %d of relation %s physically",
+                     (long) loaded, stmt->arr_shard[i], RelationGetRelationName(rel));
+            }
+        }
+        heap_close(rel, NoLock);
+    }
+    list_free(reloids);
+}
+#endif
+
 void StatShardRelation(Oid relid, ShardStat *shardstat, int32 shardnumber)
 {
     int32        shardid;
@@ -32,6 +32,7 @@
 #include "pgxc/pgxc.h"
 #include "pgxc/pgxcnode.h"
 #include "pgxc/squeue.h"
+#include "storage/ipc.h"
 #include "storage/latch.h"
 #include "storage/lwlock.h"
 #include "storage/shmem.h"
@@ -59,6 +60,11 @@
 #include "utils/memutils.h"
 #include "utils/elog.h"
 #include "commands/vacuum.h"
+#include "funcapi.h"
+#include "utils/builtins.h"
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 #endif
 int   NSQueues = 64;
 int   SQueueSize = 64;
@@ -71,8 +77,12 @@ bool  g_DataPumpDebug       = false;/* enable debug info */
 int32 g_SndThreadNum        = 8;    /* Two sender threads default.  */
 int32 g_SndThreadBufferSize = 16;   /* in Kilo bytes. */
 int32 g_SndBatchSize        = 8;    /* in Kilo bytes. */
+int32 g_SndCompressLevel    = 0;    /* zlib level of DataRow batches, 0 disables batching. */
 int   consumer_connect_timeout = 128; /* in seconds */
 int   g_DisConsumer_timeout = 60; /* in minutes */
+bool  g_SqueueMinimalTuple  = false;/* pass MinimalTuples through the queue */
+int   g_SqueueSpillMemory   = 0;    /* in Kilo bytes, 0 means work_mem per datanode */
+int   g_SqueueSpillDelay    = 0;    /* in milliseconds */
 
 #define MAX_CURSOR_LEN      64 
 #define DATA_PUMP_SOCKET_DIR  "pg_datapump"   /* socket dir for data pump */
@@ -158,6 +168,7 @@ typedef struct
 #ifdef __TBASE__
     bool        send_fd;        /* true if send fd to producer */
     bool        cs_done;
+    dsm_handle  cs_filter;      /* runtime filter published by the consumer */
 #endif
 #ifdef SQUEUE_STAT
     long         stat_writes;
@@ -195,6 +206,11 @@ typedef struct SQueueHeader
     bool        producer_done;
     int         nConsumer_done;
     slock_t        lock;
+    /* spill statistic, written by the producer, read by any backend */
+    pg_atomic_uint32 spill_consumers; /* consumers which rows were buffered */
+    pg_atomic_uint64 spill_tuples;    /* rows put to the local tuplestores */
+    pg_atomic_uint64 spill_bytes;     /* bytes the tuplestores wrote to disk */
+    pg_atomic_uint64 spill_reserved;  /* kB taken from SQueueSpillReserved */
 #endif
     int            sq_nconsumers;    /* Number of consumers */
     ConsState     sq_consumers[0];/* variable length array */
@@ -284,6 +300,22 @@ typedef struct DisConsumer
 } DisConsumer;
 
 static HTAB *DisConsumerHash = NULL;
+
+/*
+ * Kilo bytes of squeue_spill_memory currently given to the tuplestores of
+ * all producers on this node, see SharedQueueReserveSpill.
+ */
+static pg_atomic_uint64 *SQueueSpillReserved = NULL;
+
+static int  SharedQueueReserveSpill(SharedQueue squeue, int fallback_kbytes);
+static void SharedQueueReleaseSpill(SharedQueue squeue);
+static Tuplestorestate *SharedQueueBeginStore(SharedQueue squeue,
+                                    char *storename, int fallback_kbytes,
+                                    MemoryContext tmpcxt);
+static void SharedQueuePutStore(SharedQueue squeue, Tuplestorestate *tuplestore,
+                                    TupleTableSlot *slot, bool datapump);
+static int32 DataPumpSendDataRowWait(SharedQueue squeue, int32 consumerIdx,
+                                    int32 nodeid, RemoteDataRow datarow);
 #endif
 
 #ifdef __TBASE__
@@ -360,6 +392,19 @@ typedef struct
     size_t                nfast_send;  /* counter for tuple */
 
     size_t                sleep_count; /* counter sleep */
+
+    /* DataRow batching, used only if batch_buf is not NULL */
+    int32               compress_level; /* zlib compression level */
+    char                *batch_stage; /* contiguous copy of the batched rows */
+    char                *batch_buf;   /* batch message being sent */
+    uint32              batch_size;   /* allocated size of batch_buf */
+    uint32              batch_len;    /* length of the pending batch, 0 if none */
+    uint32              batch_sent;   /* bytes of the pending batch sent */
+    uint32              batch_rawlen; /* buffer bytes covered by the pending batch */
+    uint32              raw_remaining;/* bytes of a long DataRow to pass through */
+
+    /* set by the producer while it waits for buffer space of the node */
+    Latch * volatile    space_latch;
 }DataPumpNodeControl;
 
 typedef struct
@@ -586,6 +631,7 @@ static uint32 DataSize(DataPumpBuf *buf);
 static uint32 FreeSpace(DataPumpBuf *buf);
 static char  *GetData(DataPumpBuf *buf, uint32 *uiLen);
 static void   IncDataOff(DataPumpBuf *buf, uint32 uiLen);
+static void   DataPumpNotifySpace(DataPumpNodeControl *node);
 static char  *GetWriteOff(DataPumpBuf *buf, uint32 *uiLen);
 static void   IncWriteOff(DataPumpBuf *buf, uint32 uiLen);
 static char  *GetWriteOff(DataPumpBuf *buf, uint32 *uiLen);
@@ -623,6 +669,9 @@ static void DataPumpWakeupSender(void *sndctl, int32 nodeindex);
 static bool ExecFastSendDatarow(TupleTableSlot *slot, void *sndctl, int32 nodeindex, MemoryContext tmpcxt);
 static int  ReturnSpace(DataPumpBuf *buf, uint32 offset);
 static uint32 BufferOffsetAdd(DataPumpBuf *buf, uint32 pointer, uint32 offset);
+static void  CopyOutData(DataPumpBuf *buf, uint32 offset, char *p, uint32 len);
+static int   DataPumpSendBatch(DataPumpNodeControl *node, int32 *reason);
+static bool  DataPumpSendBatchLoop(DataPumpNodeControl *node);
 
 static ParallelSendControl* BuildParallelSendControl(SharedQueue sq);
 static void InitParallelSendNodeControl(int32 nodeId, ParallelSendNodeControl *control, int32 numParallelWorkers);
@@ -764,6 +813,14 @@ SharedQueuesInit(void)
             }
         }
     }
+#ifdef __TBASE__
+    SQueueSpillReserved = (pg_atomic_uint64 *) ShmemInitStruct("Shared Queues Spill",
+                                  sizeof(pg_atomic_uint64), &found);
+    if (!found)
+    {
+        pg_atomic_init_u64(SQueueSpillReserved, 0);
+    }
+#endif
 }
 
 
@@ -775,6 +832,8 @@ SharedQueueShmemSize(void)
     sqs_size = mul_size(NUM_SQUEUES, SQUEUE_SYNC_SIZE);
 
 #ifdef __TBASE__
+    sqs_size = add_size(sqs_size, sizeof(pg_atomic_uint64));
+
     if (g_UseDataPump)
     {
         sqs_size = add_size(sqs_size, hash_estimate_size(NUM_SQUEUES, sizeof(DisConsumer)));
@@ -867,6 +926,11 @@ tryagain:
         sq->producer_done = false;
         sq->nConsumer_done = 0;
 
+        pg_atomic_init_u32(&sq->spill_consumers, 0);
+        pg_atomic_init_u64(&sq->spill_tuples, 0);
+        pg_atomic_init_u64(&sq->spill_bytes, 0);
+        pg_atomic_init_u64(&sq->spill_reserved, 0);
+
         SpinLockInit(&sq->lock);
 #endif
         /*
@@ -925,6 +989,7 @@ tryagain:
 #ifdef __TBASE__
             cstate->send_fd = false;
             cstate->cs_done = false;
+            cstate->cs_filter = DSM_HANDLE_INVALID;
             InitSharedLatch(&sqsync->sqs_consumer_sync[i].cs_latch);
 #endif
             heapPtr += qsize;
@@ -1304,7 +1369,7 @@ SharedQueueBind(const char *sqname, List *consNodes,
                     }
 
                     /* store nodeid, consumerIdx, sockfd */
-                    if(DataPumpSetNodeSocket(sq->sender, pro_index, pro_nodeid, MyProcPort->sock) != DataPumpOK)
+                    if(DataPumpSetNodeSocket(sq->sender, pro_index, pro_nodeid, MyProcPort->sock, g_RemoteFeatures) != DataPumpOK)
                     {
                         LWLockRelease(sq->sq_sync->sqs_producer_lwlock);
                         elog(ERROR, "could not set sockfd of producer.");
@@ -1680,10 +1745,45 @@ SharedQueueWrite(SharedQueue squeue, int consumerIdx,
             cstate->stat_buff_writes++;
 #endif
             LWLockRelease(clwlock);
+#ifdef __TBASE__
+            SharedQueuePutStore(squeue, *tuplestore, slot, false);
+#else
             tuplestore_puttupleslot(*tuplestore, slot);
+#endif
+            return;
+        }
+    }
+
+#ifdef __TBASE__
+    /*
+     * Producer and consumer share the same tuple descriptor, so a tuple which
+     * is not a DataRow yet may be passed as MinimalTuple. This saves calling
+     * the type output functions for every attribute in the producer, the
+     * consumer serializes the tuple only if it has to send it out. Entries of
+     * this kind are marked by negative length. Tuples that do not fit the
+     * queue take the usual DataRow path.
+     */
+    if (g_SqueueMinimalTuple && slot->tts_datarow == NULL &&
+        cstate->cs_status == CONSUMER_ACTIVE)
+    {
+        MinimalTuple mintuple = ExecFetchSlotMinimalTuple(slot);
+        int          tuplen = mintuple->t_len;
+
+        if (QUEUE_FREE_SPACE(cstate) >= sizeof(int) + tuplen)
+        {
+            int marker = -tuplen;
+
+            QUEUE_WRITE(cstate, sizeof(int), (char *) &marker);
+            QUEUE_WRITE(cstate, tuplen, (char *) mintuple);
+            /* Increment tuple counter. If it was 0 consumer may be waiting for
+             * data so try to wake it up */
+            if ((cstate->cs_ntuples)++ == 0)
+                SetLatch(&sqsync->sqs_consumer_sync[consumerIdx].cs_latch);
+            LWLockRelease(clwlock);
             return;
         }
     }
+#endif
 
     /* Get datarow from the tuple slot */
     if (slot->tts_datarow)
@@ -1712,16 +1812,21 @@ SharedQueueWrite(SharedQueue squeue, int consumerIdx,
         /* Create tuplestore if does not exist */
         if (*tuplestore == NULL)
         {
+#ifndef __TBASE__
             int            ptrno PG_USED_FOR_ASSERTS_ONLY;
+#endif
             char         storename[64];
 
 #ifdef SQUEUE_STAT
             elog(DEBUG1, "Start buffering %s node %d, %d tuples in queue, %ld writes and %ld reads so far",
                  squeue->sq_key, cstate->cs_node, cstate->cs_ntuples, cstate->stat_writes, cstate->stat_reads);
 #endif
+            snprintf(storename, 64, "%s node %d", squeue->sq_key, cstate->cs_node);
+#ifdef __TBASE__
+            *tuplestore = SharedQueueBeginStore(squeue, storename, work_mem, tmpcxt);
+#else
             *tuplestore = tuplestore_begin_datarow(false, work_mem, tmpcxt);
             /* We need is to be able to remember/restore the read position */
-            snprintf(storename, 64, "%s node %d", squeue->sq_key, cstate->cs_node);
             tuplestore_collect_stat(*tuplestore, storename);
             /*
              * Allocate a second read pointer to read from the store. We know
@@ -1729,13 +1834,18 @@ SharedQueueWrite(SharedQueue squeue, int consumerIdx,
              */
             ptrno = tuplestore_alloc_read_pointer(*tuplestore, 0);
             Assert(ptrno == 1);
+#endif
         }
 
 #ifdef SQUEUE_STAT
         cstate->stat_buff_writes++;
 #endif
         /* Append the slot to the store... */
+#ifdef __TBASE__
+        SharedQueuePutStore(squeue, *tuplestore, slot, false);
+#else
         tuplestore_puttupleslot(*tuplestore, slot);
+#endif
 
         /* ... and exit */
         return;
@@ -2008,14 +2118,27 @@ SharedQueueRead(SharedQueue squeue, int consumerIdx,
 
     /* have at least one row, read it in and store to slot */
     QUEUE_READ(cstate, sizeof(int), (char *) (&datalen));
-    datarow = (RemoteDataRow) palloc(sizeof(RemoteDataRowData) + datalen);
-    datarow->msgnode = InvalidOid;
-    datarow->msglen = datalen;
-    if (datalen > cstate->cs_qlength - sizeof(int))
-        sq_pull_long_tuple(cstate, datarow, consumerIdx, sqsync);
+#ifdef __TBASE__
+    if (datalen < 0)
+    {
+        /* MinimalTuple written by the producer, see SharedQueueWrite */
+        MinimalTuple mintuple = (MinimalTuple) palloc(-datalen);
+
+        QUEUE_READ(cstate, -datalen, (char *) mintuple);
+        ExecStoreMinimalTuple(mintuple, slot, true);
+    }
     else
-        QUEUE_READ(cstate, datalen, datarow->msg);
-    ExecStoreDataRowTuple(datarow, slot, true);
+#endif
+    {
+        datarow = (RemoteDataRow) palloc(sizeof(RemoteDataRowData) + datalen);
+        datarow->msgnode = InvalidOid;
+        datarow->msglen = datalen;
+        if (datalen > cstate->cs_qlength - sizeof(int))
+            sq_pull_long_tuple(cstate, datarow, consumerIdx, sqsync);
+        else
+            QUEUE_READ(cstate, datalen, datarow->msg);
+        ExecStoreDataRowTuple(datarow, slot, true);
+    }
     (cstate->cs_ntuples)--;
 #ifdef SQUEUE_STAT
     cstate->stat_reads++;
@@ -3186,6 +3309,9 @@ CHECK:
 
     /* All is done, clean up */
     DisownLatch(&sqsync->sqs_producer_latch);
+#ifdef __TBASE__
+    SharedQueueReleaseSpill(squeue);
+#endif
 
 #if 0
     if (--squeue->sq_refcnt == 0)
@@ -3372,6 +3498,10 @@ done:
      */
     if (sq && --sq->sq_refcnt == 0)
     {
+#ifdef __TBASE__
+        /* Give back the spill memory if the producer did not unbind */
+        SharedQueueReleaseSpill(sq);
+#endif
         /* Now it is OK to remove hash table entry */
         sq->sq_sync->queue = NULL;
         sq->sq_sync = NULL;
@@ -3687,6 +3817,19 @@ char *GetData(DataPumpBuf *buf, uint32 *uiLen)
     }
 }
 
+/*
+ * Wake up the producer if it waits for free space of the node buffer.
+ */
+void DataPumpNotifySpace(DataPumpNodeControl *node)
+{
+    Latch *latch = node->space_latch;
+
+    if (latch)
+    {
+        SetLatch(latch);
+    }
+}
+
 /* Increate data offset, used after finishing read data from queue. */
 void IncDataOff(DataPumpBuf *buf, uint32 uiLen)
 {
@@ -3847,6 +3990,28 @@ void FillReserveSpace(DataPumpBuf *buf, uint32 offset, char *p, uint32 len)
     }
 }
 
+/* Copy data out of the buffer, counterpart of FillReserveSpace */
+void CopyOutData(DataPumpBuf *buf, uint32 offset, char *p, uint32 len)
+{
+    uint32 bytes2end      = 0;
+    uint32 bytesfrombegin = 0;
+
+    if (buf)
+    {
+        bytes2end = buf->m_Length - offset;
+        if (len <= bytes2end)
+        {
+            memcpy(p, buf->m_buf + offset, len);
+        }
+        else
+        {
+            bytesfrombegin = len - bytes2end;
+            memcpy(p, buf->m_buf + offset, bytes2end);
+            memcpy((char*)p + bytes2end, buf->m_buf, bytesfrombegin);
+        }
+    }
+}
+
 /* Return free space of the buffer. */
 uint32 FreeSpace(DataPumpBuf *buf)
 {
@@ -3943,7 +4108,7 @@ int32 CreateThread(void *(*f) (void *), void *arg, int32 mode)
 }
 
 /* ignore all signals, leave signal for main thread to process */
-static void ThreadSigmask(void)
+void ThreadSigmask(void)
 {
     sigset_t  new_mask;
     sigemptyset(&new_mask);
@@ -3991,6 +4156,17 @@ void InitDataPumpNodeControl(int32 nodeindex, DataPumpNodeControl *control)
     control->buffer      = BuildDataPumpBuf();
     control->ntuples_get = 0;
     control->ntuples_put = 0;
+
+#ifdef HAVE_LIBZ
+    /* Batching needs the length word of the DataRow messages. */
+    if (g_SndCompressLevel > 0 && PG_PROTOCOL_MAJOR(FrontendProtocol) >= 3)
+    {
+        control->compress_level = g_SndCompressLevel;
+        control->batch_size     = compressBound(control->buffer->m_Length) + 9;
+        control->batch_stage    = (char*)palloc(control->buffer->m_Length);
+        control->batch_buf      = (char*)palloc(control->batch_size);
+    }
+#endif
 }
 /*
  * Build data pump thread control.
@@ -4136,6 +4312,12 @@ void DestoryDataPumpSenderControl (void* sndctl, int nodeid)
         {        
             DestoryDataPumpBuf(sender->nodes[i].buffer);
 
+            if (sender->nodes[i].batch_buf)
+            {
+                pfree(sender->nodes[i].batch_stage);
+                pfree(sender->nodes[i].batch_buf);
+            }
+
             if (sender->nodes[i].sock != NO_SOCKET && sender->nodes[i].nodeindex != nodeid)
             {
                 close(sender->nodes[i].sock);
@@ -4155,6 +4337,174 @@ void DestoryDataPumpBuf(DataPumpBuf *buffer)
     pfree(buffer->m_buf);
 }
 
+/*
+ * Send the complete DataRow messages between tail and border of the node
+ * buffer as one batch message:
+ *
+ *     'B' | int32 length | int32 raw length | zlib compressed DataRows
+ *
+ * The receiver inflates the batch back into its input buffer, see
+ * HandleDataRowBatch in execRemote.c. Rows which do not compress are sent as
+ * plain DataRows, DataRows longer than the available data are passed through.
+ * Buffer space is released only after the whole batch has been sent.
+ * Return bytes written, 0 if there is nothing to send, or EOF.
+ */
+static int DataPumpSendBatch(DataPumpNodeControl *node, int32 *reason)
+{// #lizard forgives
+    DataPumpBuf *buf    = node->buffer;
+    int          ret    = 0;
+    uint32       border = 0;
+    uint32       tail   = 0;
+    uint32       avail  = 0;
+    uint32       total  = 0;
+    uint32       n32    = 0;
+
+    if (0 == node->batch_len)
+    {
+        spinlock_lock(&(buf->pointerlock));
+        border = buf->m_Border;
+        tail   = buf->m_Tail;
+        spinlock_unlock(&(buf->pointerlock));
+
+        if (INVALID_BORDER == border || border == tail)
+        {
+            return 0;
+        }
+        avail = (border + buf->m_Length - tail) % buf->m_Length;
+
+        if (0 == node->raw_remaining)
+        {
+            /* Collect complete messages, each one is 'D' | int32 length | data. */
+            while (total + 1 + sizeof(n32) <= avail)
+            {
+                CopyOutData(buf, BufferOffsetAdd(buf, tail, total + 1), (char*)&n32, sizeof(n32));
+                if (total + 1 + ntohl(n32) > avail)
+                {
+                    break;
+                }
+                total += 1 + ntohl(n32);
+            }
+
+            if (0 == total)
+            {
+                if (avail < 1 + sizeof(n32))
+                {
+                    return 0;
+                }
+                /* Long tuple is still being written, pass it through. */
+                node->raw_remaining = 1 + ntohl(n32);
+            }
+        }
+
+        if (node->raw_remaining)
+        {
+            uint32 len = Min(node->raw_remaining, avail);
+
+            /* Send up to the end of the buffer, the rest goes next time. */
+            len = Min(len, buf->m_Length - tail);
+            ret = DataPumpRawSendData(node, node->sock, buf->m_buf + tail, len, reason);
+            if (EOF == ret)
+            {
+                return EOF;
+            }
+            IncDataOff(buf, ret);
+            DataPumpNotifySpace(node);
+            node->raw_remaining -= ret;
+            return ret;
+        }
+
+        CopyOutData(buf, tail, node->batch_stage, total);
+#ifdef HAVE_LIBZ
+        {
+            uLongf clen = node->batch_size - 9;
+
+            if (node->compress_level > 0 &&
+                Z_OK == compress2((Bytef*)node->batch_buf + 9, &clen,
+                                  (Bytef*)node->batch_stage, total,
+                                  node->compress_level) &&
+                clen + 9 < total)
+            {
+                node->batch_buf[0] = 'B';
+                n32 = htonl((uint32) (clen + 8));
+                memcpy(node->batch_buf + 1, &n32, sizeof(n32));
+                n32 = htonl(total);
+                memcpy(node->batch_buf + 5, &n32, sizeof(n32));
+                node->batch_len = clen + 9;
+            }
+        }
+#endif
+        if (0 == node->batch_len)
+        {
+            memcpy(node->batch_buf, node->batch_stage, total);
+            node->batch_len = total;
+        }
+        node->batch_rawlen = total;
+        node->batch_sent   = 0;
+
+        /* Same as GetData, no more complete tuples until next border. */
+        spinlock_lock(&(buf->pointerlock));
+        if (total == avail && border == buf->m_Border)
+        {
+            buf->m_Border = INVALID_BORDER;
+        }
+        spinlock_unlock(&(buf->pointerlock));
+    }
+
+    ret = DataPumpRawSendData(node, node->sock, node->batch_buf + node->batch_sent,
+                              node->batch_len - node->batch_sent, reason);
+    if (EOF == ret)
+    {
+        return EOF;
+    }
+    node->batch_sent += ret;
+    if (node->batch_sent == node->batch_len)
+    {
+        IncDataOff(buf, node->batch_rawlen);
+        DataPumpNotifySpace(node);
+        node->batch_len = 0;
+    }
+    return ret;
+}
+
+/*
+ * Send batches to the node until there is no more complete tuples, return
+ * true if the socket got stuck.
+ */
+static bool DataPumpSendBatchLoop(DataPumpNodeControl *node)
+{
+    int32  reason = 0;
+    int32  status = 0;
+    int    ret    = 0;
+
+    do
+    {
+        reason = 0;
+        ret = DataPumpSendBatch(node, &reason);
+        if (EOF == ret)
+        {
+            /* We got error. */
+            spinlock_lock(&node->lock);
+            node->status  = DataPumpSndStatus_error;
+            node->errorno = errno;
+            spinlock_unlock(&node->lock);
+            return false;
+        }
+
+        /* Socket got stuck. */
+        if (reason == EAGAIN || reason == EWOULDBLOCK)
+        {
+            return true;
+        }
+
+        /* Get status. */
+        spinlock_lock(&node->lock);
+        status = node->status;
+        spinlock_unlock(&node->lock);
+    } while (ret > 0 && status >= DataPumpSndStatus_set_socket && status <= DataPumpSndStatus_data_sending);
+
+    return false;
+}
+
 void DataPumpSendLoop(DataPumpNodeControl  *nodes, DataPumpThreadControl* control)
 {// #lizard forgives
     int32  stuck_nodes = 0;
@@ -4178,6 +4528,15 @@ void DataPumpSendLoop(DataPumpNodeControl  *nodes, DataPumpThreadControl* contro
             /* status is valid */
             if (status >= DataPumpSndStatus_set_socket && status  <= DataPumpSndStatus_data_sending)
             {
+                if (nodes[nodeindex].batch_buf)
+                {
+                    if (DataPumpSendBatchLoop(&nodes[nodeindex]))
+                    {
+                        stuck_nodes++;
+                    }
+                    continue;
+                }
+
                 do 
                 {
                     data = GetData(nodes[nodeindex].buffer, &len);
@@ -4196,6 +4555,7 @@ void DataPumpSendLoop(DataPumpNodeControl  *nodes, DataPumpThreadControl* contro
                         
                         /* increase data offset */
                         IncDataOff(nodes[nodeindex].buffer, ret);    
+                        DataPumpNotifySpace(&nodes[nodeindex]);
                         
                         /* Socket got stuck. */
                         if (reason == EAGAIN || reason == EWOULDBLOCK)
@@ -4252,6 +4612,41 @@ bool DataPumpFlushAllData(DataPumpNodeControl  *nodes, DataPumpThreadControl* co
             /* status is valid */
             if (status >= DataPumpSndStatus_set_socket && status  <= DataPumpSndStatus_data_sending)
             {
+                if (nodes[nodeindex].batch_buf)
+                {
+                    /* Data left in buffer, send them all. */
+                    if (nodes[nodeindex].buffer->m_Tail != nodes[nodeindex].buffer->m_Head)
+                    {
+                        nodes[nodeindex].buffer->m_Border = nodes[nodeindex].buffer->m_Head;
+                    }
+
+                    if (DataPumpSendBatchLoop(&nodes[nodeindex]))
+                    {
+                        stuck_nodes++;
+                        continue;
+                    }
+
+                    spinlock_lock(&nodes[nodeindex].lock);
+                    if (nodes[nodeindex].status == DataPumpSndStatus_error)
+                    {
+                        succeed = false;
+                    }
+                    else if (nodes[nodeindex].batch_len || nodes[nodeindex].raw_remaining ||
+                             DataSize(nodes[nodeindex].buffer))
+                    {
+                        nodes[nodeindex].status  = DataPumpSndStatus_incomplete_data;
+                        nodes[nodeindex].errorno = errno;
+                        succeed = false;
+                    }
+                    else
+                    {
+                        /* Job done, set status. */
+                        nodes[nodeindex].status  = DataPumpSndStatus_done;
+                    }
+                    spinlock_unlock(&nodes[nodeindex].lock);
+                    continue;
+                }
+
                 do 
                 {
                     /* Data left in buffer, send them all. */
@@ -4847,7 +5242,7 @@ void DataPumpCleanThread(DataPumpSenderControl *sender)
 /*
  * Set node socket.
  */
-int32  DataPumpSetNodeSocket(void *sndctl, int32 nodeindex, int32 nodeId,  int32 socket)
+int32  DataPumpSetNodeSocket(void *sndctl, int32 nodeindex, int32 nodeId,  int32 socket, int32 features)
 {
     DataPumpNodeControl   *node     = NULL;
     DataPumpSenderControl *sender   = (DataPumpSenderControl*)sndctl;
@@ -4868,6 +5263,11 @@ int32  DataPumpSetNodeSocket(void *sndctl, int32 nodeindex, int32 nodeId,  int32
     spinlock_lock(&node->lock);
     if (NO_SOCKET == node->sock && DataPumpSndStatus_no_socket == node->status)
     {
+        /* a consumer that did not ask for batches gets plain DataRows */
+        if (!(features & REMOTE_FEATURE_DATAROW_BATCH))
+        {
+            node->compress_level = 0;
+        }
         node->sock   = socket;
         node->status = DataPumpSndStatus_set_socket;
         spinlock_unlock(&node->lock);
@@ -5161,6 +5561,25 @@ send_fd_with_nodeid(char *sqname, int nodeid, int consumerIdx)
             elog(ERROR, "could not send consumerIdx to convert, errmsg:%s.", strerror(err));
     }
 
+    /* send the protocol features the consumer agreed to */
+    n32 = htonl(g_RemoteFeatures);
+    ret = send(fd, (char *)&n32, 4, 0);
+    if(ret != 4)
+    {
+        err = errno;
+        
+        close(fd);
+
+        if (err == EPIPE || err == ECONNRESET)
+        {
+            /* producer may have finished work, and we do not need to send anything. */
+            elog(LOG, "could not send features to convert, errmsg:%s; producer may have finished work.", strerror(err));
+            return false;
+        }
+        else
+            elog(ERROR, "could not send features to convert, errmsg:%s.", strerror(err));
+    }
+
     /* send fd */
     if(convert_sendfds(fd, (int *)&MyProcPort->sock, 1, &err) != 0)
     {
@@ -5188,6 +5607,7 @@ ConvertThreadMain(void *arg)
     bool exit_flag = false;
     int nodeid;
     int consumerIdx;
+    int features;
     int sockfd;
     int listen_fd;
     int con_fd;
@@ -5282,6 +5702,20 @@ ConvertThreadMain(void *arg)
 
         consumerIdx = ntohl(consumerIdx);
 
+        /* recv protocol features of the consumer */
+        ret = recv(con_fd, (char *)&features, 4, 0);
+        if(ret != 4)
+        {
+            close(con_fd);
+            close(listen_fd);
+            control->convert_control.errNO = errno;
+            control->convert_control.cstatus = ConvertRecvNodeindexError;
+            unlink(sock_path);
+            break;
+        }
+
+        features = ntohl(features);
+
         /* recv fd */
         if(convert_recvfds(con_fd, (int *)&sockfd, 1) != 0)
         {
@@ -5294,7 +5728,7 @@ ConvertThreadMain(void *arg)
         }
 
         /* store nodeid, consumerIdx, sockfd */
-        if(DataPumpSetNodeSocket(arg, consumerIdx, nodeid, sockfd) != DataPumpOK)
+        if(DataPumpSetNodeSocket(arg, consumerIdx, nodeid, sockfd, features) != DataPumpOK)
         {
             close(con_fd);
             close(listen_fd);
@@ -5387,6 +5821,171 @@ RETRY:
     return succeed;
 }
 
+/*
+ * Memory in kilo bytes the producer may use to buffer rows of one consumer.
+ * squeue_spill_memory is shared by all producers of the node: a consumer
+ * asks for its even share of the queue, but never gets more than is left in
+ * the node budget, so under pressure the rows go straight to disk. The
+ * memory is given back when the producer unbinds the queue. Without a
+ * budget the store gets fallback_kbytes, as it did before.
+ */
+static int
+SharedQueueReserveSpill(SharedQueue squeue, int fallback_kbytes)
+{
+    uint64 budget;
+    uint64 share;
+    uint64 grant;
+    uint64 reserved;
+
+    if (g_SqueueSpillMemory <= 0)
+    {
+        return fallback_kbytes;
+    }
+
+    budget = (uint64) g_SqueueSpillMemory;
+    share  = Max(budget / squeue->sq_nconsumers, 64);
+
+    reserved = pg_atomic_read_u64(SQueueSpillReserved);
+    do
+    {
+        grant = reserved >= budget ? 0 : Min(share, budget - reserved);
+        if (grant == 0)
+        {
+            break;
+        }
+    } while (!pg_atomic_compare_exchange_u64(SQueueSpillReserved, &reserved, reserved + grant));
+
+    pg_atomic_fetch_add_u64(&squeue->spill_reserved, grant);
+
+    return (int) grant;
+}
+
+/*
+ * Give the spill memory of the queue back to the node budget.
+ */
+static void
+SharedQueueReleaseSpill(SharedQueue squeue)
+{
+    uint64 reserved = pg_atomic_exchange_u64(&squeue->spill_reserved, 0);
+
+    if (reserved > 0)
+    {
+        pg_atomic_fetch_sub_u64(SQueueSpillReserved, (int64) reserved);
+    }
+}
+
+/*
+ * Create the tuplestore to buffer rows of a consumer the queue or the sender
+ * can not take at the moment.
+ */
+static Tuplestorestate *
+SharedQueueBeginStore(SharedQueue squeue, char *storename, int fallback_kbytes,
+                      MemoryContext tmpcxt)
+{
+    Tuplestorestate *tuplestore;
+    int              ptrno PG_USED_FOR_ASSERTS_ONLY;
+
+    tuplestore = tuplestore_begin_datarow(false,
+                                          SharedQueueReserveSpill(squeue, fallback_kbytes),
+                                          tmpcxt);
+    /* We need is to be able to remember/restore the read position */
+    tuplestore_collect_stat(tuplestore, storename);
+    /*
+     * Allocate a second read pointer to read from the store. We know
+     * it must have index 1, so needn't store that.
+     */
+    ptrno = tuplestore_alloc_read_pointer(tuplestore, 0);
+    Assert(ptrno == 1);
+
+    pg_atomic_fetch_add_u32(&squeue->spill_consumers, 1);
+
+    return tuplestore;
+}
+
+/*
+ * Append the slot to the consumer tuplestore and account it in the spill
+ * statistic of the queue. Rows going out through the data pump may carry
+ * composite values with their row descriptions.
+ */
+static void
+SharedQueuePutStore(SharedQueue squeue, Tuplestorestate *tuplestore, TupleTableSlot *slot,
+                    bool datapump)
+{
+    int64 spill_bytes = tuplestore_spill_bytes(tuplestore);
+
+    in_data_pump = datapump;
+    tuplestore_puttupleslot(tuplestore, slot);
+    in_data_pump = false;
+
+    pg_atomic_fetch_add_u64(&squeue->spill_tuples, 1);
+    spill_bytes = tuplestore_spill_bytes(tuplestore) - spill_bytes;
+    if (spill_bytes > 0)
+    {
+        pg_atomic_fetch_add_u64(&squeue->spill_bytes, (uint64) spill_bytes);
+    }
+}
+
+/*
+ * Send the datarow, if the sender buffer of the consumer is full wake up the
+ * sender and wait up to squeue_spill_delay for free space. Short stalls of a
+ * consumer are absorbed this way instead of starting to buffer its rows,
+ * which is expensive to drain once the store went to disk. The sender thread
+ * sets our latch each time it frees space of the node.
+ */
+static int32
+DataPumpSendDataRowWait(SharedQueue squeue, int32 consumerIdx, int32 nodeid, RemoteDataRow datarow)
+{
+    int32                  ret;
+    long                   timeout;
+    TimestampTz            deadline;
+    DataPumpSenderControl *sender = (DataPumpSenderControl *) squeue->sender;
+    DataPumpNodeControl   *node   = &sender->nodes[consumerIdx];
+
+    ret = DataPumpSendDataRow(squeue->sender, consumerIdx, nodeid, datarow->msg, datarow->msglen);
+    if (DataPumpSndError_no_space != ret || g_SqueueSpillDelay <= 0)
+    {
+        return ret;
+    }
+
+    deadline = TimestampTzPlusMilliseconds(GetCurrentTimestamp(), g_SqueueSpillDelay);
+    node->space_latch = MyLatch;
+    pg_memory_barrier();
+    for (;;)
+    {
+        long secs;
+        int  usecs;
+        int  rc;
+
+        ResetLatch(MyLatch);
+        ret = DataPumpSendDataRow(squeue->sender, consumerIdx, nodeid, datarow->msg, datarow->msglen);
+        if (DataPumpSndError_no_space != ret)
+        {
+            break;
+        }
+
+        TimestampDifference(GetCurrentTimestamp(), deadline, &secs, &usecs);
+        timeout = secs * 1000L + usecs / 1000;
+        if (timeout <= 0)
+        {
+            break;
+        }
+
+        DataPumpWakeupSender(squeue->sender, consumerIdx);
+        rc = WaitLatch(MyLatch, WL_LATCH_SET | WL_POSTMASTER_DEATH | WL_TIMEOUT,
+                       timeout, WAIT_EVENT_MQ_SEND);
+        if (rc & WL_POSTMASTER_DEATH)
+        {
+            proc_exit(1);
+        }
+
+        /* a stale space_latch after an error only causes spurious wakeups */
+        CHECK_FOR_INTERRUPTS();
+    }
+    node->space_latch = NULL;
+
+    return ret;
+}
+
 void
 SendDataRemote(SharedQueue squeue, int32 consumerIdx, TupleTableSlot *slot, Tuplestorestate **tuplestore, MemoryContext tmpcxt)
 {// #lizard forgives    
@@ -5472,7 +6071,7 @@ SendDataRemote(SharedQueue squeue, int32 consumerIdx, TupleTableSlot *slot, Tupl
                 in_data_pump = false;
                 free_datarow = true;
             }
-            ret = DataPumpSendDataRow(squeue->sender, consumerIdx, nodeid, datarow->msg, datarow->msglen);    
+            ret = DataPumpSendDataRowWait(squeue, consumerIdx, nodeid, datarow);
             if(DataPumpOK == ret)
             {
                 if(free_datarow)
@@ -5542,7 +6141,7 @@ SendDataRemote(SharedQueue squeue, int32 consumerIdx, TupleTableSlot *slot, Tupl
                     free_datarow = true;
                 }
                 
-                ret = DataPumpSendDataRow(squeue->sender, consumerIdx, nodeid, datarow->msg, datarow->msglen);    
+                ret = DataPumpSendDataRowWait(squeue, consumerIdx, nodeid, datarow);
                 if(DataPumpOK == ret)
                 {
                     if(free_datarow)
@@ -5674,28 +6273,16 @@ SendDataRemote(SharedQueue squeue, int32 consumerIdx, TupleTableSlot *slot, Tupl
     /* Create tuplestore if does not exist.*/
     if (NULL == *tuplestore)
     {
-        int            ptrno PG_USED_FOR_ASSERTS_ONLY;
-        char         storename[64];
-
+        char storename[64];
 
-        *tuplestore = tuplestore_begin_datarow(false, work_mem / NumDataNodes, tmpcxt);
-        /* We need is to be able to remember/restore the read position */
         snprintf(storename, 64, "%s node %d", squeue->sq_key, cstate->cs_node);
-        tuplestore_collect_stat(*tuplestore, storename);
-        /*
-         * Allocate a second read pointer to read from the store. We know
-         * it must have index 1, so needn't store that.
-         */
-        ptrno = tuplestore_alloc_read_pointer(*tuplestore, 0);
-        Assert(ptrno == 1);
+        *tuplestore = SharedQueueBeginStore(squeue, storename, work_mem / NumDataNodes, tmpcxt);
 
         if(g_DataPumpDebug)
             elog(LOG, "create tuplestore with nodeid %d, cursor %s.", nodeid, squeue->sq_key);
     }
-    in_data_pump = true;
     /* Append the slot to the store... */
-    tuplestore_puttupleslot(*tuplestore, slot);
-    in_data_pump = false;
+    SharedQueuePutStore(squeue, *tuplestore, slot, true);
 
     node->ntuples_put++;
     
@@ -6745,6 +7332,7 @@ ParallelConvertThreadMain(void *arg)
     bool exit_flag = false;
     int nodeid;
     int consumerIdx;
+    int features;
     int sockfd;
     int listen_fd;
     int con_fd;
@@ -6839,6 +7427,18 @@ ParallelConvertThreadMain(void *arg)
 
         consumerIdx = ntohl(consumerIdx);
 
+        /* recv protocol features of the consumer, parallel send does not batch */
+        ret = recv(con_fd, (char *)&features, 4, 0);
+        if(ret != 4)
+        {
+            close(con_fd);
+            close(listen_fd);
+            control->convertControl.errNO = errno;
+            control->convertControl.cstatus = ConvertRecvNodeindexError;
+            unlink(sock_path);
+            break;
+        }
+
         /* recv fd */
         if(convert_recvfds(con_fd, (int *)&sockfd, 1) != 0)
         {
@@ -7837,27 +8437,14 @@ SendNodeDataRemote(SharedQueue squeue, ParallelWorkerControl *control, ParallelS
     /* Create tuplestore if does not exist.*/
     if (NULL == *tuplestore)
     {
-        int            ptrno PG_USED_FOR_ASSERTS_ONLY;
         char         storename[64];
 
-
-        *tuplestore = tuplestore_begin_datarow(false, work_mem / NumDataNodes, tmpcxt);
-        /* We need is to be able to remember/restore the read position */
         snprintf(storename, 64, "worker %d node %d", buf->parallelWorkerNum, buf->nodeId);
-        tuplestore_collect_stat(*tuplestore, storename);
-        /*
-         * Allocate a second read pointer to read from the store. We know
-         * it must have index 1, so needn't store that.
-         */
-        ptrno = tuplestore_alloc_read_pointer(*tuplestore, 0);
-        Assert(ptrno == 1);
+        *tuplestore = SharedQueueBeginStore(squeue, storename, work_mem / NumDataNodes, tmpcxt);
     }
-    in_data_pump = true;
     
     /* Append the slot to the store... */
-    tuplestore_puttupleslot(*tuplestore, slot);
-
-    in_data_pump = false;
+    SharedQueuePutStore(squeue, *tuplestore, slot, true);
 
     buf->tuples_put++;
     
@@ -9102,6 +9689,30 @@ GetConsumerIdx(SharedQueue sq, int nodeid)
     return sq->nodeMap[nodeid];
 }
 
+/*
+ * Advertise the DSM segment holding the runtime filter of a consumer.  The
+ * segment must be fully written before its handle becomes visible.
+ */
+void
+SharedQueueSetConsumerFilter(SharedQueue sq, int consumerIdx, dsm_handle handle)
+{
+    pg_write_barrier();
+    sq->sq_consumers[consumerIdx].cs_filter = handle;
+}
+
+/*
+ * Handle of the runtime filter a consumer published, DSM_HANDLE_INVALID if
+ * it did not publish one (yet).
+ */
+dsm_handle
+SharedQueueGetConsumerFilter(SharedQueue sq, int consumerIdx)
+{
+    dsm_handle    handle = sq->sq_consumers[consumerIdx].cs_filter;
+
+    pg_read_barrier();
+    return handle;
+}
+
 bool
 IsSqueueProducer(void)
 {
@@ -9458,3 +10069,118 @@ SqueueName(SharedQueue sq)
 {
 	return sq->sq_key;
 }
+
+#ifdef __TBASE__
+typedef struct
+{
+    char        sq_key[SQUEUE_KEYSIZE];
+    int         sq_pid;
+    int         nconsumers;
+    int         spill_consumers;
+    int64       spill_tuples;
+    int64       spill_bytes;
+} SQueueSpillStat;
+
+typedef struct
+{
+    int              currIdx;
+    int              nelems;
+    SQueueSpillStat *rec;
+} SQueueSpillStatState;
+
+/*
+ * Show how many rows and bytes the producers of the active shared queues had
+ * to buffer because their consumers could not take them.
+ */
+Datum
+tbase_squeue_spill_statistic(PG_FUNCTION_ARGS)
+{
+#define SQUEUE_SPILL_NCOLUMNS 6
+    FuncCallContext      *funcctx;
+    SQueueSpillStatState *status;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        MemoryContext    oldcontext;
+        TupleDesc        tupdesc;
+        HASH_SEQ_STATUS  hash_seq;
+        SharedQueue      sq;
+        int              nalloc;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        tupdesc = CreateTemplateTupleDesc(SQUEUE_SPILL_NCOLUMNS, false);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 1, "squeue",
+                           TEXTOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 2, "producer_pid",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 3, "consumers",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 4, "spill_consumers",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 5, "spill_tuples",
+                           INT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 6, "spill_bytes",
+                           INT8OID, -1, 0);
+
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        status = (SQueueSpillStatState *) palloc0(sizeof(SQueueSpillStatState));
+        funcctx->user_fctx = (void *) status;
+
+        nalloc = NUM_SQUEUES;
+        status->rec = (SQueueSpillStat *) palloc0(sizeof(SQueueSpillStat) * nalloc);
+
+        LWLockAcquire(SQueuesLock, LW_SHARED);
+        hash_seq_init(&hash_seq, SharedQueues);
+        while ((sq = (SharedQueue) hash_seq_search(&hash_seq)) != NULL)
+        {
+            SQueueSpillStat *rec;
+
+            if (status->nelems >= nalloc)
+            {
+                hash_seq_term(&hash_seq);
+                break;
+            }
+
+            rec = &status->rec[status->nelems++];
+            memcpy(rec->sq_key, sq->sq_key, SQUEUE_KEYSIZE);
+            rec->sq_pid          = sq->sq_pid;
+            rec->nconsumers      = sq->sq_nconsumers;
+            rec->spill_consumers = (int) pg_atomic_read_u32(&sq->spill_consumers);
+            rec->spill_tuples    = (int64) pg_atomic_read_u64(&sq->spill_tuples);
+            rec->spill_bytes     = (int64) pg_atomic_read_u64(&sq->spill_bytes);
+        }
+        LWLockRelease(SQueuesLock);
+
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    status  = (SQueueSpillStatState *) funcctx->user_fctx;
+
+    if (status->currIdx < status->nelems)
+    {
+        SQueueSpillStat *rec = &status->rec[status->currIdx++];
+        Datum            values[SQUEUE_SPILL_NCOLUMNS];
+        bool             nulls[SQUEUE_SPILL_NCOLUMNS];
+        HeapTuple        tuple;
+
+        MemSet(nulls, 0, sizeof(nulls));
+        rec->sq_key[SQUEUE_KEYSIZE - 1] = '\0';
+        values[0] = CStringGetTextDatum(rec->sq_key);
+        values[1] = Int32GetDatum(rec->sq_pid);
+        values[2] = Int32GetDatum(rec->nconsumers);
+        values[3] = Int32GetDatum(rec->spill_consumers);
+        values[4] = Int64GetDatum(rec->spill_tuples);
+        values[5] = Int64GetDatum(rec->spill_bytes);
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    }
+
+    SRF_RETURN_DONE(funcctx);
+}
+#endif
@@ -99,7 +99,9 @@
 #ifdef __TBASE__
 #include "executor/nodeAgg.h"
 #include "executor/nodeHashjoin.h"
+#include "pgxc/poolmgr.h"
 #include "pgxc/squeue.h"
+#include "postmaster/partmaint.h"
 #endif
 #ifdef __AUDIT_FGA__
 #include "audit/audit_fga.h"
@@ -203,6 +205,14 @@ static const struct
         "ApplyAuditFgaMain", ApplyAuditFgaMain
     }
 #endif
+#ifdef __TBASE__
+    ,{
+        "PoolerShardMain", PoolerShardMain
+    }
+    ,{
+        "PartitionMaintenanceMain", PartitionMaintenanceMain
+    }
+#endif
 };
 
 /* Private functions. */
@@ -0,0 +1,557 @@
+/*-------------------------------------------------------------------------
+ *
+ * partmaint.c
+ *      Background worker that maintains interval partitions
+ *
+ * Inserts into an interval partitioned table fail once the partition key
+ * runs past the last partition, so tables partitioned by timestamp need
+ * ALTER TABLE ... ADD PARTITIONS before every period boundary, and old
+ * partitions have to be dropped by hand.  This worker does both for the
+ * tables of partition_maintenance_database:
+ *
+ * - it keeps partition_premake partitions (or the table's partition_premake
+ *   storage parameter) created beyond the one holding the current time;
+ *
+ * - it drops the partitions older than the table's partition_retention
+ *   most recent past ones.  Tables that do not set partition_retention are
+ *   never pruned.
+ *
+ * Every statement runs in a transaction of its own under a lock_timeout of
+ * partition_maintenance_lock_timeout.  Each expired partition is dropped
+ * separately, so the exclusive lock of a drop covers one partition for a
+ * short moment.  A statement that cannot get its locks gives up instead of
+ * making the queries behind it wait, and is retried in the next run.
+ *
+ * The worker runs on every coordinator but only one of them, the first
+ * coordinator by name that is up and maintains the same database, does the
+ * work.  Its DDL reaches the other nodes like any other DDL.
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * IDENTIFICATION
+ *      src/backend/postmaster/partmaint.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/xact.h"
+#include "catalog/pg_collation.h"
+#include "catalog/pg_partition_interval.h"
+#include "catalog/pg_type.h"
+#include "executor/spi.h"
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "pgxc/pgxc.h"
+#include "pgxc/pgxcnode.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/partmaint.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/proc.h"
+#include "tcop/tcopprot.h"
+#include "utils/builtins.h"
+#include "utils/formatting.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/ruleutils.h"
+#include "utils/snapmgr.h"
+#include "utils/timestamp.h"
+
+char       *partition_maintenance_database = NULL;
+int            partition_maintenance_naptime = 60;
+int            partition_maintenance_lock_timeout = 1000;
+int            partition_premake = 2;
+
+static volatile sig_atomic_t got_SIGHUP = false;
+
+/* lives across the transactions of a run */
+static MemoryContext PartMaintContext = NULL;
+
+static void partmaint_sighup(SIGNAL_ARGS);
+static void partmaint_run(void);
+static bool partmaint_is_leader(void);
+static List *partmaint_get_tables(void);
+static List *partmaint_table(Oid relid);
+static void partmaint_drop(const char *relname);
+static void partmaint_begin(const char *activity);
+static void partmaint_commit(void);
+static void partmaint_set_lock_timeout(void);
+
+/*
+ * Register the worker.  Called from the postmaster before shared memory is
+ * sized.
+ */
+void
+PartitionMaintenanceRegister(void)
+{
+    BackgroundWorker bgw;
+
+    if (!IS_PGXC_COORDINATOR || partition_maintenance_database == NULL ||
+        partition_maintenance_database[0] == '\0')
+        return;
+
+    memset(&bgw, 0, sizeof(bgw));
+    bgw.bgw_flags = BGWORKER_SHMEM_ACCESS |
+        BGWORKER_BACKEND_DATABASE_CONNECTION;
+    bgw.bgw_start_time = BgWorkerStart_RecoveryFinished;
+    snprintf(bgw.bgw_library_name, BGW_MAXLEN, "postgres");
+    snprintf(bgw.bgw_function_name, BGW_MAXLEN, "PartitionMaintenanceMain");
+    snprintf(bgw.bgw_name, BGW_MAXLEN, "partition maintenance worker");
+    bgw.bgw_restart_time = 60;
+    bgw.bgw_notify_pid = 0;
+    bgw.bgw_main_arg = (Datum) 0;
+
+    RegisterBackgroundWorker(&bgw);
+}
+
+static void
+partmaint_sighup(SIGNAL_ARGS)
+{
+    int            save_errno = errno;
+
+    got_SIGHUP = true;
+    SetLatch(MyLatch);
+
+    errno = save_errno;
+}
+
+/*
+ * Entry point of the worker
+ */
+void
+PartitionMaintenanceMain(Datum main_arg)
+{
+    pqsignal(SIGHUP, partmaint_sighup);
+    pqsignal(SIGTERM, die);
+    BackgroundWorkerUnblockSignals();
+
+    BackgroundWorkerInitializeConnection(partition_maintenance_database, NULL);
+
+    /* the DDL is sent to the other nodes, this must be done in a transaction */
+    StartTransactionCommand();
+    InitMultinodeExecutor(false);
+    if (PGXCNodeIdentifier == 0)
+    {
+        char       *node_name;
+
+        node_name = str_tolower(PGXCNodeName, strlen(PGXCNodeName), DEFAULT_COLLATION_OID);
+        PGXCNodeIdentifier = get_pgxc_node_id(get_pgxc_nodeoid(node_name));
+        pfree(node_name);
+    }
+    CommitTransactionCommand();
+
+    PartMaintContext = AllocSetContextCreate(TopMemoryContext,
+                                             "Partition maintenance",
+                                             ALLOCSET_DEFAULT_SIZES);
+
+    ereport(LOG,
+            (errmsg("partition maintenance worker started for database \"%s\"",
+                    partition_maintenance_database)));
+
+    for (;;)
+    {
+        int            rc;
+
+        CHECK_FOR_INTERRUPTS();
+
+        if (got_SIGHUP)
+        {
+            got_SIGHUP = false;
+            ProcessConfigFile(PGC_SIGHUP);
+        }
+
+        partmaint_run();
+
+        rc = WaitLatch(MyLatch,
+                       WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+                       partition_maintenance_naptime * 1000L,
+                       WAIT_EVENT_PARTITION_MAINTENANCE_MAIN);
+        ResetLatch(MyLatch);
+
+        if (rc & WL_POSTMASTER_DEATH)
+            proc_exit(1);
+    }
+}
+
+/*
+ * One run over all the interval partitioned tables of the database.
+ */
+static void
+partmaint_run(void)
+{
+    List       *relids;
+    ListCell   *lc;
+
+    MemoryContextReset(PartMaintContext);
+
+    relids = partmaint_get_tables();
+
+    foreach(lc, relids)
+    {
+        List       *expired;
+        ListCell   *lc2;
+
+        CHECK_FOR_INTERRUPTS();
+
+        expired = partmaint_table(lfirst_oid(lc));
+
+        foreach(lc2, expired)
+        {
+            CHECK_FOR_INTERRUPTS();
+            partmaint_drop((const char *) lfirst(lc2));
+        }
+    }
+}
+
+/*
+ * Whether this coordinator does the maintenance.
+ *
+ * The acting leader is the first coordinator, by name, that answers and runs
+ * the worker for the same database: a coordinator that is down or does not
+ * maintain this database hands the work over to the next one, so the loss of
+ * a node does not stop the maintenance.  The acting leader is logged when it
+ * changes.
+ */
+static bool
+partmaint_is_leader(void)
+{// #lizard forgives
+    static char    last_leader[NAMEDATALEN] = "";
+    MemoryContext oldcontext = CurrentMemoryContext;
+    char       *leader = NULL;
+    List       *coords = NIL;
+    ListCell   *lc;
+    int            ret;
+    uint64        i;
+
+    ret = SPI_execute("SELECT node_name FROM pg_catalog.pgxc_node "
+                      "WHERE node_type = 'C' ORDER BY node_name",
+                      true, 0);
+    if (ret != SPI_OK_SELECT)
+        elog(ERROR, "could not look up the coordinators: error code %d", ret);
+
+    for (i = 0; i < SPI_processed; i++)
+        coords = lappend(coords, SPI_getvalue(SPI_tuptable->vals[i],
+                                              SPI_tuptable->tupdesc, 1));
+
+    foreach(lc, coords)
+    {
+        char       *node = (char *) lfirst(lc);
+        char       *volatile database = NULL;
+
+        if (strcmp(node, PGXCNodeName) == 0)
+        {
+            leader = node;
+            break;
+        }
+
+        BeginInternalSubTransaction(NULL);
+        PG_TRY();
+        {
+            /* sent to the node as it is, so no doubled quotes */
+            ret = SPI_execute_direct("SELECT pg_catalog.current_setting("
+                                     "'partition_maintenance_database')",
+                                     node);
+            if (ret == SPI_OK_SELECT && SPI_processed == 1)
+                database = SPI_getvalue(SPI_tuptable->vals[0],
+                                        SPI_tuptable->tupdesc, 1);
+            ReleaseCurrentSubTransaction();
+            MemoryContextSwitchTo(oldcontext);
+        }
+        PG_CATCH();
+        {
+            ErrorData  *edata;
+
+            MemoryContextSwitchTo(oldcontext);
+            edata = CopyErrorData();
+            FlushErrorState();
+            RollbackAndReleaseCurrentSubTransaction();
+            MemoryContextSwitchTo(oldcontext);
+
+            ereport(DEBUG1,
+                    (errmsg("partition maintenance could not reach coordinator \"%s\": %s",
+                            node, edata->message)));
+            FreeErrorData(edata);
+        }
+        PG_END_TRY();
+
+        if (database != NULL &&
+            strcmp(database, partition_maintenance_database) == 0)
+        {
+            leader = node;
+            break;
+        }
+    }
+
+    if (leader != NULL && strcmp(leader, last_leader) != 0)
+    {
+        if (strcmp(leader, PGXCNodeName) == 0)
+            ereport(LOG,
+                    (errmsg("partition maintenance of database \"%s\" is done by this coordinator",
+                            partition_maintenance_database)));
+        else
+            ereport(LOG,
+                    (errmsg("partition maintenance of database \"%s\" is done by coordinator \"%s\"",
+                            partition_maintenance_database, leader)));
+        strlcpy(last_leader, leader, NAMEDATALEN);
+    }
+
+    return leader != NULL && strcmp(leader, PGXCNodeName) == 0;
+}
+
+/*
+ * The interval partitioned tables to maintain, or none when another
+ * coordinator is the acting leader.
+ */
+static List *
+partmaint_get_tables(void)
+{
+    List       *result = NIL;
+    int            ret;
+    uint64        i;
+
+    partmaint_begin("partition maintenance: listing tables");
+
+    if (partmaint_is_leader())
+    {
+        ret = SPI_execute("SELECT p.partrelid FROM pg_catalog.pg_partition_interval p "
+                          "JOIN pg_catalog.pg_class c ON c.oid = p.partrelid "
+                          "WHERE c.relkind = 'r' "
+                          "AND p.partdatatype = 'pg_catalog.timestamp'::pg_catalog.regtype",
+                          true, 0);
+        if (ret != SPI_OK_SELECT)
+            elog(ERROR, "could not look up the interval partitioned tables: error code %d", ret);
+
+        for (i = 0; i < SPI_processed; i++)
+        {
+            bool        isnull;
+            Datum        relid;
+            MemoryContext oldcontext;
+
+            relid = SPI_getbinval(SPI_tuptable->vals[i],
+                                  SPI_tuptable->tupdesc, 1, &isnull);
+            if (isnull)
+                continue;
+
+            oldcontext = MemoryContextSwitchTo(PartMaintContext);
+            result = lappend_oid(result, DatumGetObjectId(relid));
+            MemoryContextSwitchTo(oldcontext);
+        }
+    }
+
+    partmaint_commit();
+
+    return result;
+}
+
+/*
+ * Create the missing future partitions of a table, and return the qualified
+ * names of its expired partitions.
+ */
+static List *
+partmaint_table(Oid relid)
+{// #lizard forgives
+    MemoryContext oldcontext = CurrentMemoryContext;
+    List       *expired = NIL;
+
+    PG_TRY();
+    {
+        Relation    rel;
+        Timestamp    now;
+        int            nparts;
+        int            curidx;
+        int            premake;
+        int            retention;
+        int            nadd;
+        char       *nspname;
+        char       *relname;
+
+        partmaint_begin("partition maintenance: adding partitions");
+
+        rel = try_relation_open(relid, AccessShareLock);
+        if (rel != NULL && RELATION_IS_INTERVAL(rel) &&
+            rel->rd_partitions_info != NULL &&
+            rel->rd_partitions_info->partdatatype == TIMESTAMPOID)
+        {
+            Form_pg_partition_interval routerinfo = rel->rd_partitions_info;
+
+            now = DatumGetTimestamp(DirectFunctionCall1(timestamptz_timestamp,
+                                                        TimestampTzGetDatum(GetCurrentTimestamp())));
+
+            /* the partition holding the current time, if there were enough */
+            nparts = routerinfo->partnparts;
+            curidx = GetPartitionIndex(routerinfo->partstartvalue_ts,
+                                       routerinfo->partinterval_int,
+                                       routerinfo->partinterval_type,
+                                       MAX_NUM_INTERVAL_PARTITIONS, now);
+            if (curidx < 0)
+                curidx = -1;
+
+            premake = RelationGetPartitionPremake(rel, partition_premake);
+            retention = RelationGetPartitionRetention(rel);
+            nspname = get_namespace_name(RelationGetNamespace(rel));
+            relname = quote_qualified_identifier(nspname, RelationGetRelationName(rel));
+
+            nadd = curidx + 1 + premake - nparts;
+            if (nadd > MAX_NUM_INTERVAL_PARTITIONS - nparts)
+                nadd = MAX_NUM_INTERVAL_PARTITIONS - nparts;
+
+            /* the partitions that fell out of the retention window */
+            if (retention > 0)
+            {
+                int            partidx;
+
+                for (partidx = 0; partidx < curidx - retention && partidx < nparts; partidx++)
+                {
+                    char       *partname;
+
+                    if (!OidIsValid(RelationGetPartition(rel, partidx, false)))
+                        continue;
+
+                    partname = GetPartitionName(relid, partidx, false);
+
+                    MemoryContextSwitchTo(PartMaintContext);
+                    expired = lappend(expired,
+                                      quote_qualified_identifier(nspname, partname));
+                    MemoryContextSwitchTo(oldcontext);
+                }
+            }
+
+            relation_close(rel, NoLock);
+
+            if (nadd > 0)
+            {
+                StringInfoData sql;
+                int            ret;
+
+                initStringInfo(&sql);
+                appendStringInfo(&sql, "ALTER TABLE %s ADD PARTITIONS %d",
+                                 relname, nadd);
+
+                partmaint_set_lock_timeout();
+                pgstat_report_activity(STATE_RUNNING, sql.data);
+
+                ret = SPI_execute(sql.data, false, 0);
+                if (ret != SPI_OK_UTILITY)
+                    elog(ERROR, "%s failed: error code %d", sql.data, ret);
+
+                ereport(LOG,
+                        (errmsg("partition maintenance added %d partitions to \"%s\"",
+                                nadd, relname)));
+            }
+        }
+        else if (rel != NULL)
+            relation_close(rel, NoLock);
+
+        partmaint_commit();
+    }
+    PG_CATCH();
+    {
+        ErrorData  *edata;
+
+        MemoryContextSwitchTo(oldcontext);
+        edata = CopyErrorData();
+        FlushErrorState();
+        AbortCurrentTransaction();
+
+        ereport(LOG,
+                (errmsg("partition maintenance could not add partitions to relation %u: %s",
+                        relid, edata->message)));
+        FreeErrorData(edata);
+
+        /* keep the partitions until the table can be looked at again */
+        expired = NIL;
+    }
+    PG_END_TRY();
+
+    return expired;
+}
+
+/*
+ * Drop one expired partition.
+ */
+static void
+partmaint_drop(const char *relname)
+{
+    MemoryContext oldcontext = CurrentMemoryContext;
+
+    PG_TRY();
+    {
+        StringInfoData sql;
+        int            ret;
+
+        partmaint_begin("partition maintenance: dropping partition");
+
+        initStringInfo(&sql);
+        appendStringInfo(&sql, "DROP TABLE IF EXISTS %s", relname);
+
+        partmaint_set_lock_timeout();
+        pgstat_report_activity(STATE_RUNNING, sql.data);
+
+        ret = SPI_execute(sql.data, false, 0);
+        if (ret != SPI_OK_UTILITY)
+            elog(ERROR, "%s failed: error code %d", sql.data, ret);
+
+        partmaint_commit();
+
+        ereport(LOG,
+                (errmsg("partition maintenance dropped expired partition \"%s\"",
+                        relname)));
+    }
+    PG_CATCH();
+    {
+        ErrorData  *edata;
+
+        MemoryContextSwitchTo(oldcontext);
+        edata = CopyErrorData();
+        FlushErrorState();
+        AbortCurrentTransaction();
+
+        ereport(LOG,
+                (errmsg("partition maintenance could not drop expired partition \"%s\": %s",
+                        relname, edata->message)));
+        FreeErrorData(edata);
+    }
+    PG_END_TRY();
+}
+
+static void
+partmaint_begin(const char *activity)
+{
+    SetCurrentStatementStartTimestamp();
+    StartTransactionCommand();
+    SPI_connect();
+    PushActiveSnapshot(GetTransactionSnapshot());
+    pgstat_report_activity(STATE_RUNNING, activity);
+}
+
+static void
+partmaint_commit(void)
+{
+    SPI_finish();
+    PopActiveSnapshot();
+    CommitTransactionCommand();
+    pgstat_report_stat(false);
+    pgstat_report_activity(STATE_IDLE, NULL);
+}
+
+/*
+ * Bound the time the DDL of this transaction may wait for its locks.  SET
+ * LOCAL goes to the remote nodes of the transaction as well.
+ */
+static void
+partmaint_set_lock_timeout(void)
+{
+    char        sql[64];
+    int            ret;
+
+    snprintf(sql, sizeof(sql), "SET LOCAL lock_timeout = %d",
+             partition_maintenance_lock_timeout);
+
+    ret = SPI_execute(sql, false, 0);
+    if (ret != SPI_OK_UTILITY)
+        elog(ERROR, "%s failed: error code %d", sql, ret);
+}
@@ -3591,6 +3591,11 @@ pgstat_get_wait_activity(WaitEventActivity w)
         case WAIT_EVENT_AUDIT_FGA_MAIN:
             event_name = "AuditFgaMain";
             break;
+#endif
+#ifdef __TBASE__
+        case WAIT_EVENT_PARTITION_MAINTENANCE_MAIN:
+            event_name = "PartitionMaintenanceMain";
+            break;
 #endif
         case WAIT_EVENT_CLUSTER_MONITOR_MAIN:
             event_name = "ClusterMonitorMain";
@@ -3708,6 +3713,11 @@ pgstat_get_wait_ipc(WaitEventIPC w)
         case WAIT_EVENT_SYNC_REP:
             event_name = "SyncRep";
             break;
+#ifdef __TBASE__
+        case WAIT_EVENT_GTS_BROKER:
+            event_name = "GTSBroker";
+            break;
+#endif
             /* no default case, so that compiler will warn */
     }
 
@@ -122,6 +122,9 @@
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/fork_process.h"
 #include "postmaster/pgarch.h"
+#ifdef __TBASE__
+#include "postmaster/partmaint.h"
+#endif
 #include "postmaster/postmaster.h"
 #include "postmaster/syslogger.h"
 #include "replication/logicallauncher.h"
@@ -1145,6 +1148,14 @@ PostmasterMain(int argc, char *argv[])
         */
     ApplyAuditFgaRegister();
 
+#ifdef __TBASE__
+    /* Register the pooler processes of a sharded pooler */
+    PoolerShardsRegister();
+
+    /* Register the interval partition maintenance worker */
+    PartitionMaintenanceRegister();
+#endif
+
     /*
      * process any libraries that should be preloaded at postmaster start
      */
@@ -94,6 +94,7 @@
 #include "storage/extentmapping.h"
 #include "storage/freespace.h"
 #include "storage/extent_xlog.h"
+#include "storage/extent_cache.h"
 #include "storage/lmgr.h"
 #include "storage/smgr.h"
 #include "utils/builtins.h"
@@ -128,6 +129,7 @@ static void     shard_remove_extent_from_scanlist(Relation rel, ExtentID eid, bo
 
 /* for system functions */
 static Oid         string_to_reloid(char *str);
+static void        ema_read_eme(Relation rel, ExtentID eid, ExtentMappingElement *eme);
 
 /*-----------------------------------------------------------------------------
  *
@@ -630,6 +632,9 @@ eob_mark_extent(Relation rel, ExtentID eid, bool setfree)
 
     MarkBufferDirty(buf);
     UnlockReleaseBuffer(buf);
+
+    if(setfree)
+        EOBSummaryUpdate(rel->rd_node, addr.physical_page_number - EOBPAGE_OFFSET, true);
 }
 
 void 
@@ -722,6 +727,79 @@ eob_get_free_extent(Relation rel)
     return eob_address_to_eid(addr);
 }
 
+/*
+ * Free extents seen by this backend but not handed out yet.
+ *
+ * When an allocation has to look for a free extent on the EOB pages, it
+ * claims one and remembers up to extent_reserve_batch - 1 more free extents
+ * of the same page here, so that the following allocations of the
+ * transaction can go to that page directly instead of walking the EOB pages
+ * again.  The remembered extents stay free on the page: other backends may
+ * take them meanwhile, and an extent is only marked busy once it is handed
+ * out, exactly like one found by the walk.  Nothing has to be given back
+ * then, the list is simply forgotten at the end of the transaction.
+ */
+#define MAX_EXTENT_RESERVE_BATCH        64
+#define EXTENT_RESERVATION_RELS            4
+
+typedef struct ExtentReservation
+{
+    RelFileNode rnode;
+    int            nextents;
+    ExtentID    extents[MAX_EXTENT_RESERVE_BATCH];
+} ExtentReservation;
+
+int            g_ExtentReserveBatch = 8;
+
+static ExtentReservation extent_reservations[EXTENT_RESERVATION_RELS];
+static int    n_extent_reservations = 0;
+
+static ExtentReservation *
+extent_reservation_lookup(RelFileNode rnode)
+{
+    int            i;
+
+    for(i = 0; i < n_extent_reservations; i++)
+    {
+        if(RelFileNodeEquals(extent_reservations[i].rnode, rnode))
+            return &extent_reservations[i];
+    }
+
+    return NULL;
+}
+
+/*
+ * Mark a remembered extent busy if it is still free.
+ */
+static bool
+eob_claim_extent(Relation rel, ExtentID eid)
+{
+    EOBAddress    addr = eob_eid_to_address(eid);
+    Buffer        buf;
+    EOBPage        pg;
+    bool        claimed = false;
+
+    buf = extent_readbuffer(rel, addr.physical_page_number, true);
+    if(BufferIsInvalid(buf))
+        return false;
+
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    pg = BufferGetEOBPage(buf);
+    if(addr.local_bms_offset < pg->n_bits &&
+        bms_is_member(addr.local_bms_offset, &(pg->eob_bits)))
+    {
+        eob_page_mark_extent(pg, addr.local_bms_offset, false);
+        MarkBufferDirty(buf);
+        if(pg->first_empty_extent < 0)
+            EOBSummaryUpdate(rel->rd_node,
+                             addr.physical_page_number - EOBPAGE_OFFSET, false);
+        claimed = true;
+    }
+    UnlockReleaseBuffer(buf);
+
+    return claimed;
+}
+
 ExtentID
 eob_get_free_extent_and_set_busy(Relation rel)
 {// #lizard forgives
@@ -730,9 +808,57 @@ eob_get_free_extent_and_set_busy(Relation rel)
     EOBPage    pg;
     int        next_free;
     EOBAddress addr;
+    uint32    summary[EOB_SUMMARY_WORDS];
+    int        pages[EOB_MAXPAGES];
+    int        npages;
+    int        unused_from;
+    int        i;
+    uint32    cursor;
+    ExtentReservation *resv;
+    int        batch;
+    ExtentID result = InvalidExtentID;
+
+    resv = extent_reservation_lookup(rel->rd_node);
+    while(resv != NULL && resv->nextents > 0)
+    {
+        ExtentID    eid = resv->extents[--resv->nextents];
+
+        if(eob_claim_extent(rel, eid))
+            return eid;
+    }
+
+    /* extents beyond the first one can only be remembered with a free slot */
+    batch = Max(1, Min(g_ExtentReserveBatch, MAX_EXTENT_RESERVE_BATCH));
+    if(resv == NULL && n_extent_reservations >= EXTENT_RESERVATION_RELS)
+        batch = 1;
+
+    /* pages known to have no free extent are skipped without being locked */
+    EOBSummaryGet(rel->rd_node, summary);
+    npages = 0;
+    for(i = 0; i < EOB_MAXPAGES; i++)
+    {
+        if(summary[i / 32] & ((uint32) 1 << (i % 32)))
+            pages[npages++] = i;
+    }
+    if(npages == 0)
+        return InvalidExtentID;
+
+    /*
+     * Concurrent allocations get different cursor values: they start at
+     * different pages, and look at different bits of a page they share.
+     */
+    cursor = EOBSummaryAdvanceCursor(rel->rd_node, (uint32) batch);
+    unused_from = EOB_MAXPAGES;
     
-    for(blk = EOBPAGE_OFFSET; blk < ESAPAGE_OFFSET; blk++)
+    for(i = 0; i < npages; i++)
     {
+        int        page_idx = pages[(cursor / batch + i) % npages];
+        int        from;
+        
+        if(page_idx >= unused_from)
+            continue;
+        
+        blk = EOBPAGE_OFFSET + page_idx;
         next_free = -1;        
         
         buf = extent_readbuffer(rel, blk, true);
@@ -751,9 +877,18 @@ eob_get_free_extent_and_set_busy(Relation rel)
 
         if(pg->n_bits <= 0)
         {
-            /* this eob page has not be used.*/
+            int        p;
+            
+            /* 
+             * this eob page has not be used, nor have the ones after it. 
+             * Extending only adds busy extents, so they stay without free
+             * extents until one is freed.
+             */
+            for(p = page_idx; p < EOB_MAXPAGES; p++)
+                EOBSummaryUpdate(rel->rd_node, p, false);
+            unused_from = page_idx;
             UnlockReleaseBuffer(buf);
-            break;
+            continue;
         }
 
         if(pg->first_empty_extent >= 0)
@@ -774,27 +909,64 @@ eob_get_free_extent_and_set_busy(Relation rel)
             MarkBufferDirty(buf);
         }
 
+        /* start at the cursor, wrapping around to the first free extent */
+        from = (int) (cursor % (uint32) pg->n_bits);
+        if(next_free >= 0 && from > next_free)
+        {
+            int        n = EOB_NEXT_FREE(pg, from - 1);
+
+            if(n >= 0)
+                next_free = n;
+        }
+
+        addr.physical_page_number = blk;
         if(next_free >= 0)
         {
             eob_page_mark_extent(pg, next_free, false);
             MarkBufferDirty(buf);
+            addr.local_bms_offset = next_free;
+            result = eob_address_to_eid(addr);
+            next_free = EOB_NEXT_FREE(pg, next_free);
+        }
+
+        if(pg->first_empty_extent < 0)
+            EOBSummaryUpdate(rel->rd_node, page_idx, false);
+
+        /* remember the following free extents, they stay free on the page */
+        while(next_free >= 0 && batch > 1)
+        {
+            if(resv == NULL)
+            {
+                resv = &extent_reservations[n_extent_reservations++];
+                resv->rnode = rel->rd_node;
+                resv->nextents = 0;
+            }
+            addr.local_bms_offset = next_free;
+            resv->extents[resv->nextents++] = eob_address_to_eid(addr);
+            batch--;
+            next_free = EOB_NEXT_FREE(pg, next_free);
         }
         
         UnlockReleaseBuffer(buf);    
 
-        if(next_free >= 0)
+        if(ExtentIdIsValid(result))
             break;
     }
 
-    if(next_free < 0)
-    {
-        //elog(ERROR, "table is too large, and there is no space to extend.");
-        return InvalidExtentID;
-    }
+    /* 
+     * may be InvalidExtentID, table is too large or there is no free extent. 
+     */
+    return result;
+}
 
-    addr.physical_page_number = blk;
-    addr.local_bms_offset = next_free;
-    return eob_address_to_eid(addr);
+/*
+ * Forget the free extents remembered by this backend, at transaction end.
+ * They were never marked busy, so there is nothing to give back.
+ */
+void
+AtEOXact_ExtentReservations(bool isCommit)
+{
+    n_extent_reservations = 0;
 }
 
 void eob_truncate(Relation rel, ExtentID new_max_eid, ExtentID old_max_eid)
@@ -1121,10 +1293,20 @@ esa_get_anchor(Relation rel, ShardID sid)
                                RelationGetRelid(rel), addr.physical_page_number)));
     }
     
+    /* the anchor can be taken from the cache while the page is unchanged */
+    if(ExtentCacheLookup(EXTENT_CACHE_ESA, rel->rd_node, (uint32)sid,
+                         BufferGetLSNAtomic(buf), &anchor))
+    {
+        ReleaseBuffer(buf);
+        return anchor;
+    }
+
     LockBuffer(buf, BUFFER_LOCK_SHARE);
     pg = BufferGetPage(buf);
     esa_pg = (ESAPage)PageGetContents(pg);
     anchor = esa_pg->anchors[addr.local_idx];
+    ExtentCacheStore(EXTENT_CACHE_ESA, rel->rd_node, (uint32)sid,
+                     PageGetLSN(pg), &anchor);
     UnlockReleaseBuffer(buf);
 
     return anchor;
@@ -1389,39 +1571,28 @@ ema_prev_alloc(Relation rel, ExtentID curr, uint8 *freespace, ShardID *sid)
 ExtentID
 ema_next_scan(Relation rel, ExtentID curr, bool error_if_free, bool *is_occupied, ShardID *sid, int *hwm, uint8 *freespace)
 {
-    EMAAddress    curr_eme;
-    Buffer         buf;
-    EMAPage        pg;
-    ExtentID    next_extent;
+    ExtentMappingElement eme;
 
-    curr_eme = ema_eid_to_address(curr);
-    buf = extent_readbuffer(rel, curr_eme.physical_page_number, false);
-    ExtentAssert(BufferIsValid(buf));
-    LockBuffer(buf, BUFFER_LOCK_SHARE);
-
-    pg = (EMAPage)PageGetContents(BufferGetPage(buf));
+    ema_read_eme(rel, curr, &eme);
 
     if(error_if_free)
     {
-        ExtentAssertEMEIsOccup(pg->ema[curr_eme.local_idx]);
+        ExtentAssertEMEIsOccup(eme);
     }
-    next_extent = pg->ema[curr_eme.local_idx].scan_next;
 
     if(is_occupied)
-        *is_occupied = (bool)pg->ema[curr_eme.local_idx].is_occupied;
+        *is_occupied = (bool)eme.is_occupied;
     
     if(sid)
-        *sid = pg->ema[curr_eme.local_idx].shardid;
+        *sid = eme.shardid;
     
     if(hwm)
-        *hwm = pg->ema[curr_eme.local_idx].hwm;
+        *hwm = eme.hwm;
     
     if(freespace)
-        *freespace = pg->ema[curr_eme.local_idx].max_freespace;    
-
-    UnlockReleaseBuffer(buf);
+        *freespace = eme.max_freespace;    
 
-    return next_extent;
+    return eme.scan_next;
 }
 
 ExtentID
@@ -1454,24 +1625,46 @@ ema_prev_scan(Relation rel, ExtentID curr, uint8 *freespace, ShardID *sid)
 
 }
 
-ExtentMappingElement *
-ema_get_eme(Relation rel, ExtentID eid)
+/*
+ * Copy the EME of an extent, from the extent cache if its EMA page has not
+ * changed since the element was cached.
+ */
+static void
+ema_read_eme(Relation rel, ExtentID eid, ExtentMappingElement *eme)
 {
     EMAAddress    addr;
     Buffer         buf;
     Page        pg;
-    ExtentMappingElement *eme;
 
     addr = ema_eid_to_address(eid);
     buf = extent_readbuffer(rel, addr.physical_page_number, false);
     ExtentAssert(BufferIsValid(buf));
+
+    if(ExtentCacheLookup(EXTENT_CACHE_EMA, rel->rd_node, (uint32)eid,
+                         BufferGetLSNAtomic(buf), eme))
+    {
+        ReleaseBuffer(buf);
+        return;
+    }
+
     LockBuffer(buf, BUFFER_LOCK_SHARE);
 
     pg = BufferGetPage(buf);
-
-    eme = ema_page_get_eme(pg, addr.local_idx);
+    memcpy(eme, &((EMAPage)PageGetContents(pg))->ema[addr.local_idx],
+           sizeof(ExtentMappingElement));
+    ExtentCacheStore(EXTENT_CACHE_EMA, rel->rd_node, (uint32)eid,
+                     PageGetLSN(pg), eme);
 
     UnlockReleaseBuffer(buf);
+}
+
+ExtentMappingElement *
+ema_get_eme(Relation rel, ExtentID eid)
+{
+    ExtentMappingElement *eme;
+
+    eme = (ExtentMappingElement *)palloc(sizeof(ExtentMappingElement));
+    ema_read_eme(rel, eid, eme);
 
     return eme;
 }
@@ -1505,20 +1698,21 @@ ema_get_eme_extract(Relation rel, ExtentID eid,
                     bool *is_occupied, ShardID     *sid, int *hwm, uint8 *freespace)
 
 {
-    EMAAddress    addr;
-    Buffer         buf;
-    Page        pg;
+    ExtentMappingElement eme;
 
-    addr = ema_eid_to_address(eid);
-    buf = extent_readbuffer(rel, addr.physical_page_number, false);
-    ExtentAssert(BufferIsValid(buf));
-    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    ema_read_eme(rel, eid, &eme);
 
-    pg = BufferGetPage(buf);
+    if(is_occupied)
+        *is_occupied = (bool)eme.is_occupied;
 
-    ema_page_get_eme_extract(pg, addr.local_idx, is_occupied, sid, hwm, freespace);
+    if(sid)
+        *sid = (ShardID)eme.shardid;
 
-    UnlockReleaseBuffer(buf);
+    if(hwm)
+        *hwm = eme.hwm;
+
+    if(freespace)
+        *freespace = (uint8)eme.max_freespace;
 }
 
 
@@ -1717,6 +1911,9 @@ ema_rnode_set_eme_freespace(RelFileNode rnode, ExtentID eid, uint8 freespace)
     
     ema_page_set_eme_freespace(pg, addr.local_idx, freespace);
     MarkBufferDirty(ema_buf);
+
+    /* not WAL-logged, so the page LSN does not tell the cache */
+    ExtentCacheForget(EXTENT_CACHE_EMA, rnode, (uint32)eid);
     UnlockReleaseBuffer(ema_buf);
 }
 
@@ -4782,6 +4979,7 @@ shard_remove_extent_from_scanlist(Relation rel, ExtentID eid, bool ignore_error,
          */
         eob_page_mark_extent(BufferGetEOBPage(eob_buf), eob_addr.local_bms_offset, true);
         MarkBufferDirty(eob_buf);
+        EOBSummaryUpdate(rel->rd_node, eob_addr.physical_page_number - EOBPAGE_OFFSET, true);
         eob_xlrec.slot = eob_addr.local_bms_offset;
         eob_xlrec.setfree  = true;
         
@@ -4968,6 +5166,7 @@ shard_remove_extent_from_scanlist(Relation rel, ExtentID eid, bool ignore_error,
              */
             eob_page_mark_extent(BufferGetEOBPage(eob_buf), eob_addr.local_bms_offset, true);
             MarkBufferDirty(eob_buf);
+            EOBSummaryUpdate(rel->rd_node, eob_addr.physical_page_number - EOBPAGE_OFFSET, true);
             eob_xlrec.slot = eob_addr.local_bms_offset;
             eob_xlrec.setfree  = true;
             XLogRegisterBuffer(0, eob_buf, REGBUF_KEEP_DATA);
@@ -5551,6 +5750,7 @@ extent_extend_for_rebuild(Relation rel, ExtentID eid)
     for(bits = BufferGetEOBPage(eob_buf)->n_bits; bits <= eob_new_max_eid.local_bms_offset; bits++)
         bms_add_member(&BufferGetEOBPage(eob_buf)->eob_bits, bits);    
     BufferGetEOBPage(eob_buf)->n_bits = eob_new_max_eid.local_bms_offset + 1;
+    EOBSummaryUpdate(rel->rd_node, eob_new_max_eid.physical_page_number - EOBPAGE_OFFSET, true);
     
     /* update ema page and write xlog */
     xlrec_eme.n_emes = ema_new_max_eid.local_idx + 1;
@@ -5670,6 +5870,7 @@ FreeExtent(Relation rel, ExtentID eid)
         
         eob_page_mark_extent(eob_pg, eob_addr.local_bms_offset, true);
         MarkBufferDirty(eob_buf);
+        EOBSummaryUpdate(rel->rd_node, eob_addr.physical_page_number - EOBPAGE_OFFSET, true);
         /* write xlog */        
         XLogRegisterBuffer(0, eob_buf, REGBUF_KEEP_DATA);
         xlrec.slot = eob_addr.local_bms_offset;
@@ -0,0 +1,446 @@
+/*
+ * Tencent is pleased to support the open source community by making TBase available.  
+ * 
+ * Copyright (C) 2019 THL A29 Limited, a Tencent company.  All rights reserved.
+ * 
+ * TBase is licensed under the BSD 3-Clause License, except for the third-party component listed below. 
+ * 
+ * A copy of the BSD 3-Clause License is included in this file.
+ * 
+ * Other dependencies and licenses:
+ * 
+ * Open Source Software Licensed Under the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * 1. Postgres-XL XL9_5_STABLE
+ * Portions Copyright (c) 2015-2016, 2ndQuadrant Ltd
+ * Portions Copyright (c) 2012-2015, TransLattice, Inc.
+ * Portions Copyright (c) 2010-2017, Postgres-XC Development Group
+ * Portions Copyright (c) 1996-2015, The PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, The Regents of the University of California
+ * 
+ * Terms of the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written agreement
+ * is hereby granted, provided that the above copyright notice and this
+ * paragraph and the following two paragraphs appear in all copies.
+ * 
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+ * DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * 
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE UNIVERSITY OF CALIFORNIA HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ * 
+ * 
+ * Terms of the BSD 3-Clause License:
+ * --------------------------------------------------------------------
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of THL A29 Limited nor the names of its contributors may be used to endorse or promote products derived from this software without 
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+ * DAMAGE.
+ * 
+ */
+/*-------------------------------------------------------------------------
+ *
+ * extent_cache.c
+ *      shared memory cache of shard anchors and extent mapping elements.
+ *
+ * Looking up a shard anchor (ESA) or an extent mapping element (EMA) means
+ * reading the metadata page and taking its content lock, and every insert
+ * into a sharded table does several of these on the same few pages.  This
+ * cache keeps decoded copies of those elements in shared memory, tagged with
+ * the LSN of the page they were read from.  A lookup pins the metadata page,
+ * reads its LSN and returns the cached copy if the LSN has not moved, so the
+ * content lock is only taken when the page changed since it was cached.
+ *
+ * Every change of an ESA/EMA page is WAL-logged and stamps the page LSN, and
+ * redo stamps it too, which is what keeps entries honest.  The few paths
+ * that change a page without a new LSN (see ema_rnode_set_eme_freespace and
+ * the truncate redo routines) drop entries explicitly.
+ *
+ * The cache is direct-mapped: an entry lives in the slot its key hashes to
+ * and is simply replaced by whatever hashes there next, so entries of
+ * dropped relations age out without any bookkeeping.
+ *
+ * The same module keeps the free extent summary: one bit per EOB page of a
+ * relation telling whether the page may still have free extents, so that
+ * extent allocation skips full EOB pages without locking them.  Bits are
+ * set and cleared with atomic operations; a relation without a summary
+ * slot counts as having free extents everywhere.
+ *
+ * IDENTIFICATION
+ *      src/backend/storage/freespace/extent_cache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "port/atomics.h"
+#include "storage/extent_cache.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+
+#define NUM_EXTENT_CACHE_PARTITIONS    128
+#define NUM_EOB_SUMMARY_SLOTS        1024
+
+typedef struct ExtentCacheTag
+{
+    RelFileNode rnode;
+    int32        kind;            /* ExtentCacheKind */
+    uint32        id;                /* shard id or extent id */
+} ExtentCacheTag;
+
+typedef struct ExtentCacheSlot
+{
+    ExtentCacheTag tag;
+    bool        valid;
+    uint64        epoch;            /* cache epoch when filled */
+    XLogRecPtr    lsn;            /* LSN of the page the value was read from */
+    union
+    {
+        EMAShardAnchor anchor;
+        ExtentMappingElement eme;
+    }            value;
+} ExtentCacheSlot;
+
+typedef struct ExtentCacheCtl
+{
+    pg_atomic_uint64 epoch;        /* bumped to drop every entry at once */
+    LWLockPadded locks[NUM_EXTENT_CACHE_PARTITIONS];
+    ExtentCacheSlot slots[FLEXIBLE_ARRAY_MEMBER];
+} ExtentCacheCtl;
+
+typedef struct EOBSummarySlot
+{
+    RelFileNode rnode;
+    bool        valid;
+    pg_atomic_uint32 bits[EOB_SUMMARY_WORDS];    /* 1 = may have free extents */
+    pg_atomic_uint32 cursor;    /* where the next allocation starts looking */
+} EOBSummarySlot;
+
+typedef struct EOBSummaryCtl
+{
+    LWLockPadded locks[NUM_EXTENT_CACHE_PARTITIONS];    /* protect slot tags */
+    EOBSummarySlot slots[NUM_EOB_SUMMARY_SLOTS];
+} EOBSummaryCtl;
+
+/* GUC variable */
+int            g_ExtentCacheSize = 65536;
+
+static ExtentCacheCtl *ExtentCache = NULL;
+static EOBSummaryCtl *EOBSummary = NULL;
+
+static inline void
+extent_cache_tag(ExtentCacheTag *tag, ExtentCacheKind kind, RelFileNode rnode, uint32 id)
+{
+    /* the tag is hashed as raw bytes, so no padding may be left behind */
+    MemSet(tag, 0, sizeof(ExtentCacheTag));
+    tag->rnode = rnode;
+    tag->kind = (int32) kind;
+    tag->id = id;
+}
+
+static inline uint32
+extent_cache_slot(ExtentCacheTag *tag)
+{
+    return DatumGetUInt32(hash_any((unsigned char *) tag, sizeof(ExtentCacheTag)))
+                % (uint32) g_ExtentCacheSize;
+}
+
+static inline LWLock *
+extent_cache_lock(uint32 slot)
+{
+    return &ExtentCache->locks[slot % NUM_EXTENT_CACHE_PARTITIONS].lock;
+}
+
+static inline Size
+extent_cache_value_size(ExtentCacheKind kind)
+{
+    return kind == EXTENT_CACHE_ESA ? sizeof(EMAShardAnchor) : sizeof(ExtentMappingElement);
+}
+
+static Size
+extent_cache_size(void)
+{
+    if (g_ExtentCacheSize <= 0)
+        return 0;
+
+    return add_size(offsetof(ExtentCacheCtl, slots),
+                    mul_size(g_ExtentCacheSize, sizeof(ExtentCacheSlot)));
+}
+
+Size
+ExtentCacheShmemSize(void)
+{
+    return add_size(extent_cache_size(), sizeof(EOBSummaryCtl));
+}
+
+void
+ExtentCacheShmemInit(void)
+{
+    bool        found;
+    int            i;
+
+    EOBSummary = (EOBSummaryCtl *) ShmemInitStruct("EOB Free Summary",
+                                                   sizeof(EOBSummaryCtl),
+                                                   &found);
+    if (!found)
+    {
+        LWLockRegisterTranche(LWTRANCHE_EXTENT_CACHE, "extent_cache");
+
+        for (i = 0; i < NUM_EXTENT_CACHE_PARTITIONS; i++)
+            LWLockInitialize(&EOBSummary->locks[i].lock, LWTRANCHE_EXTENT_CACHE);
+        for (i = 0; i < NUM_EOB_SUMMARY_SLOTS; i++)
+        {
+            EOBSummary->slots[i].valid = false;
+            pg_atomic_init_u32(&EOBSummary->slots[i].cursor, 0);
+        }
+    }
+
+    if (g_ExtentCacheSize <= 0)
+        return;
+
+    ExtentCache = (ExtentCacheCtl *) ShmemInitStruct("Extent Metadata Cache",
+                                                     extent_cache_size(),
+                                                     &found);
+    if (!found)
+    {
+        pg_atomic_init_u64(&ExtentCache->epoch, 0);
+        for (i = 0; i < NUM_EXTENT_CACHE_PARTITIONS; i++)
+            LWLockInitialize(&ExtentCache->locks[i].lock, LWTRANCHE_EXTENT_CACHE);
+        for (i = 0; i < g_ExtentCacheSize; i++)
+            ExtentCache->slots[i].valid = false;
+    }
+}
+
+/*
+ * Copy the cached element into *value if it was read from the page at 'lsn'.
+ */
+bool
+ExtentCacheLookup(ExtentCacheKind kind, RelFileNode rnode, uint32 id,
+                  XLogRecPtr lsn, void *value)
+{
+    ExtentCacheTag tag;
+    ExtentCacheSlot *slot;
+    uint32        slotno;
+    bool        hit;
+
+    if (ExtentCache == NULL)
+        return false;
+
+    extent_cache_tag(&tag, kind, rnode, id);
+    slotno = extent_cache_slot(&tag);
+    slot = &ExtentCache->slots[slotno];
+
+    LWLockAcquire(extent_cache_lock(slotno), LW_SHARED);
+    hit = slot->valid &&
+          slot->lsn == lsn &&
+          slot->epoch == pg_atomic_read_u64(&ExtentCache->epoch) &&
+          memcmp(&slot->tag, &tag, sizeof(ExtentCacheTag)) == 0;
+    if (hit)
+        memcpy(value, &slot->value, extent_cache_value_size(kind));
+    LWLockRelease(extent_cache_lock(slotno));
+
+    return hit;
+}
+
+/*
+ * Remember an element read under the page's content lock, 'lsn' being the
+ * page LSN at that time.
+ */
+void
+ExtentCacheStore(ExtentCacheKind kind, RelFileNode rnode, uint32 id,
+                 XLogRecPtr lsn, const void *value)
+{
+    ExtentCacheTag tag;
+    ExtentCacheSlot *slot;
+    uint32        slotno;
+    uint64        epoch;
+
+    if (ExtentCache == NULL)
+        return;
+
+    extent_cache_tag(&tag, kind, rnode, id);
+    slotno = extent_cache_slot(&tag);
+    slot = &ExtentCache->slots[slotno];
+    epoch = pg_atomic_read_u64(&ExtentCache->epoch);
+
+    LWLockAcquire(extent_cache_lock(slotno), LW_EXCLUSIVE);
+
+    /* never replace a copy of the same element read from a newer page */
+    if (!(slot->valid &&
+          slot->epoch == epoch &&
+          slot->lsn > lsn &&
+          memcmp(&slot->tag, &tag, sizeof(ExtentCacheTag)) == 0))
+    {
+        slot->tag = tag;
+        slot->epoch = epoch;
+        slot->lsn = lsn;
+        memcpy(&slot->value, value, extent_cache_value_size(kind));
+        slot->valid = true;
+    }
+
+    LWLockRelease(extent_cache_lock(slotno));
+}
+
+/*
+ * Drop the element, for changes that do not move the page LSN.
+ */
+void
+ExtentCacheForget(ExtentCacheKind kind, RelFileNode rnode, uint32 id)
+{
+    ExtentCacheTag tag;
+    ExtentCacheSlot *slot;
+    uint32        slotno;
+
+    if (ExtentCache == NULL)
+        return;
+
+    extent_cache_tag(&tag, kind, rnode, id);
+    slotno = extent_cache_slot(&tag);
+    slot = &ExtentCache->slots[slotno];
+
+    LWLockAcquire(extent_cache_lock(slotno), LW_EXCLUSIVE);
+    if (slot->valid && memcmp(&slot->tag, &tag, sizeof(ExtentCacheTag)) == 0)
+        slot->valid = false;
+    LWLockRelease(extent_cache_lock(slotno));
+}
+
+/*
+ * Drop every element at once.  Used by redo of truncations, which rewrite
+ * metadata pages without stamping them.
+ */
+void
+ExtentCacheInvalidateAll(void)
+{
+    if (ExtentCache == NULL)
+        return;
+
+    pg_atomic_fetch_add_u64(&ExtentCache->epoch, 1);
+}
+
+static inline uint32
+eob_summary_slot(RelFileNode rnode)
+{
+    return DatumGetUInt32(hash_any((unsigned char *) &rnode, sizeof(RelFileNode)))
+                % NUM_EOB_SUMMARY_SLOTS;
+}
+
+static inline LWLock *
+eob_summary_lock(uint32 slot)
+{
+    return &EOBSummary->locks[slot % NUM_EXTENT_CACHE_PARTITIONS].lock;
+}
+
+/*
+ * Copy the free extent summary of a relation into words[EOB_SUMMARY_WORDS],
+ * taking over the relation's slot with an all-set summary if another
+ * relation has it.
+ */
+void
+EOBSummaryGet(RelFileNode rnode, uint32 *words)
+{
+    EOBSummarySlot *slot;
+    uint32        slotno;
+    int            i;
+
+    slotno = eob_summary_slot(rnode);
+    slot = &EOBSummary->slots[slotno];
+
+    LWLockAcquire(eob_summary_lock(slotno), LW_SHARED);
+    if (slot->valid && RelFileNodeEquals(slot->rnode, rnode))
+    {
+        for (i = 0; i < EOB_SUMMARY_WORDS; i++)
+            words[i] = pg_atomic_read_u32(&slot->bits[i]);
+        LWLockRelease(eob_summary_lock(slotno));
+        return;
+    }
+    LWLockRelease(eob_summary_lock(slotno));
+
+    LWLockAcquire(eob_summary_lock(slotno), LW_EXCLUSIVE);
+    if (!slot->valid || !RelFileNodeEquals(slot->rnode, rnode))
+    {
+        slot->rnode = rnode;
+        for (i = 0; i < EOB_SUMMARY_WORDS; i++)
+            pg_atomic_init_u32(&slot->bits[i], PG_UINT32_MAX);
+        pg_atomic_write_u32(&slot->cursor, 0);
+        slot->valid = true;
+    }
+    for (i = 0; i < EOB_SUMMARY_WORDS; i++)
+        words[i] = pg_atomic_read_u32(&slot->bits[i]);
+    LWLockRelease(eob_summary_lock(slotno));
+}
+
+/*
+ * Set or clear the summary bit of an EOB page.  Clearing must be done while
+ * holding the content lock of the page that was found without free extents,
+ * and setting after a page got a free extent, so that a concurrent free is
+ * never lost.
+ */
+void
+EOBSummaryUpdate(RelFileNode rnode, int eobpage, bool hasfree)
+{
+    EOBSummarySlot *slot;
+    uint32        slotno;
+    uint32        mask;
+
+    Assert(eobpage >= 0 && eobpage < EOB_MAXPAGES);
+
+    slotno = eob_summary_slot(rnode);
+    slot = &EOBSummary->slots[slotno];
+    mask = (uint32) 1 << (eobpage % 32);
+
+    LWLockAcquire(eob_summary_lock(slotno), LW_SHARED);
+    if (slot->valid && RelFileNodeEquals(slot->rnode, rnode))
+    {
+        if (hasfree)
+            pg_atomic_fetch_or_u32(&slot->bits[eobpage / 32], mask);
+        else
+            pg_atomic_fetch_and_u32(&slot->bits[eobpage / 32], ~mask);
+    }
+    LWLockRelease(eob_summary_lock(slotno));
+}
+
+/*
+ * Move the allocation cursor of a relation n extents ahead and return where
+ * it was.  Backends allocating extents of the same relation concurrently get
+ * different cursor values, and start looking for free extents at different
+ * EOB pages and bit offsets, so they neither queue on the same page nor pick
+ * the same free extents.
+ */
+uint32
+EOBSummaryAdvanceCursor(RelFileNode rnode, uint32 n)
+{
+    EOBSummarySlot *slot;
+    uint32        slotno;
+    uint32        result = 0;
+
+    slotno = eob_summary_slot(rnode);
+    slot = &EOBSummary->slots[slotno];
+
+    LWLockAcquire(eob_summary_lock(slotno), LW_SHARED);
+    if (slot->valid && RelFileNodeEquals(slot->rnode, rnode))
+        result = pg_atomic_fetch_add_u32(&slot->cursor, n);
+    LWLockRelease(eob_summary_lock(slotno));
+
+    return result;
+}
@@ -82,6 +82,7 @@
 #include "storage/block.h"
 #include "storage/extentmapping.h"
 #include "storage/extent_xlog.h"
+#include "storage/extent_cache.h"
 #include "storage/smgr.h"
 
 static void extent_xlog_apply_record(XLogReaderState *record);
@@ -349,6 +350,8 @@ extent_xlog_apply_record(XLogReaderState *record)
     {        
         if(BufferIsValid(bufs[block_idx]))
         {
+            /* the page LSN is what tells the extent cache the page changed */
+            PageSetLSN(BufferGetPage(bufs[block_idx]), record->EndRecPtr);
             MarkBufferDirty(bufs[block_idx]);
             UnlockReleaseBuffer(bufs[block_idx]);
         }
@@ -365,6 +368,8 @@ extent_xlog_apply_truncate(XLogReaderState *record)
     reln = smgropen(xlrec->rnode, InvalidBackendId);
     smgrdounlinkfork(reln, EXTENT_FORKNUM, true);
     smgrclose(reln);
+
+    ExtentCacheInvalidateAll();
 }
 
 static void
@@ -375,6 +380,9 @@ extent_xlog_apply_common(XLogReaderState *record)
     char *xlog_cursor = XLogRecGetData(record);
     int len = XLogRecGetDataLen(record);
 
+    /* the truncate and clean routines below do not stamp the pages */
+    ExtentCacheInvalidateAll();
+
     while(xlog_cursor - XLogRecGetData(record) < len)
     {
         memcpy(&xlogtag, xlog_cursor, sizeof(xlogtag));
@@ -82,6 +82,9 @@
 #include "access/nbtree.h"
 #include "access/subtrans.h"
 #include "access/twophase.h"
+#ifdef __TWO_PHASE_TRANS__
+#include "access/twophase_journal.h"
+#endif
 #include "commands/async.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -128,10 +131,16 @@
 #ifdef _MIGRATE_
 #include "pgxc/shardmap.h"
 #endif
+#ifdef _SHARDING_
+#include "storage/extent_cache.h"
+#endif
 #ifdef __TBASE__
 #include "storage/nodelock.h"
 #include "commands/vacuum.h"
 #include "libpq/auth.h"
+#include "access/gtm.h"
+#include "pgxc/poolmgr.h"
+#include "pgxc/commit_latency.h"
 #endif
 
 #ifdef __AUDIT__
@@ -289,6 +298,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 #endif
 #ifdef _SHARDING_
         size = add_size(size, ShardBarrierShmemSize());
+        size = add_size(size, ExtentCacheShmemSize());
 #endif
 #ifdef _MLS_
         size = add_size(size, MlsShmemSize());
@@ -298,6 +308,14 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
         size = add_size(size, NodeLockShmemSize());
         size = add_size(size, ShardStatisticShmemSize());
         size = add_size(size, QueryAnalyzeInfoShmemSize());
+#ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
+        size = add_size(size, GTSBrokerShmemSize());
+#endif
+        size = add_size(size, PoolerParkShmemSize());
+        size = add_size(size, CommitLatencyShmemSize());
+#endif
+#ifdef __TWO_PHASE_TRANS__
+        size = add_size(size, TwoPhaseJournalShmemSize());
 #endif
 #ifdef __AUDIT__
         size = add_size(size, AuditLoggerShmemSize());
@@ -459,6 +477,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 
 #ifdef _SHARDING_
     ShardBarrierShmemInit();
+    ExtentCacheShmemInit();
 #endif
 
 #ifdef __TBASE__
@@ -466,6 +485,14 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
     ShardStatisticShmemInit();
     QueryAnalyzeInfoInit();
     UserAuthShmemInit();
+#ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
+    GTSBrokerShmemInit();
+#endif
+    PoolerParkShmemInit();
+    CommitLatencyShmemInit();
+#endif
+#ifdef __TWO_PHASE_TRANS__
+    TwoPhaseJournalShmemInit();
 #endif
 
 #ifdef _MLS_
@@ -104,6 +104,7 @@
 #include "optimizer/planmain.h"
 #include "access/twophase.h"
 #include "executor/execParallel.h"
+#include "executor/execRuntimeFilter.h"
 #include "pgxc/poolutils.h"
 #include "commands/vacuum.h"
 #include "commands/explain_dist.h"
@@ -656,6 +657,7 @@ SocketBackend(StringInfo inBuf)
         case 'N':
 		case 'U':				/* coord info: coord_pid and top_xid */
 		case 'o':               /* global session id */
+        case 'y':               /* runtime filter */
 #endif
         case 'M':                /* Command ID */
         case 'g':                /* GXID */
@@ -1999,7 +2001,8 @@ exec_plan_message(const char *query_string,    /* source of the query */
                   const char *plan_string,        /* encoded plan to execute */
                   char **paramTypeNames,    /* parameter type names */
 				  int numParams,		/* number of parameters */
-				  int instrument_options)		/* explain analyze option */
+				  int instrument_options,		/* explain analyze option */
+				  int cache_slot)		/* remote plan cache slot, or -1 */
 {
     MemoryContext oldcontext;
     bool        save_log_statement_stats = log_statement_stats;
@@ -2097,7 +2100,7 @@ exec_plan_message(const char *query_string,    /* source of the query */
      */
 	StorePreparedStatement(stmt_name, psrc, false, true, 'N');
 
-    SetRemoteSubplan(psrc, plan_string);
+    SetRemoteSubplan(psrc, plan_string, cache_slot);
 	/* set instrument_options, default 0 */
 	psrc->instrument_options = instrument_options;
 
@@ -5144,6 +5147,8 @@ PostgresMain(int argc, char *argv[],
         Executor_done = false;
 
         ClearQueryAnalyzeInfo();
+
+        RuntimeFilterResetPending();
 #endif
 
 #ifdef __AUDIT__
@@ -5513,6 +5518,7 @@ PostgresMain(int argc, char *argv[],
                     int            numParams;
                     char       **paramTypes = NULL;
 					int         instrument_options = 0;
+					int         cache_slot = -1;
 
                     /* Set statement_timestamp() */
                     SetCurrentStatementStartTimestamp();
@@ -5531,12 +5537,25 @@ PostgresMain(int argc, char *argv[],
                     }
 					
 					instrument_options = pq_getmsgint(&input_message, 4);
+#ifdef __TBASE__
+					/* the plan may be, or refer to, a cached one */
+					if (input_message.cursor < input_message.len)
+					{
+						uint32		cache_id;
+
+						cache_slot = (int) pq_getmsgint(&input_message, 4);
+						cache_id = (uint32) pq_getmsgint(&input_message, 4);
+						plan_string = RemotePlanCacheResolve(plan_string,
+															 cache_slot,
+															 cache_id);
+					}
+#endif
 					
                     pq_getmsgend(&input_message);
 
                     exec_plan_message(query_string, stmt_name, plan_string,
 									  paramTypes, numParams,
-									  instrument_options);
+									  instrument_options, cache_slot);
                 }
                 break;
 #endif
@@ -5552,6 +5571,10 @@ PostgresMain(int argc, char *argv[],
                  * the field extraction out-of-line
                  */
                 exec_bind_message(&input_message);
+#ifdef __TBASE__
+                /* runtime filter, if any, applies to this Bind only */
+                RuntimeFilterResetPending();
+#endif
                 break;
 
             case 'E':            /* execute */
@@ -5740,6 +5763,16 @@ PostgresMain(int argc, char *argv[],
 					strncpy((char *) PGXCSessionId, sessionid, NAMEDATALEN);
 				}
 				break;
+
+            case 'y':       /* runtime filter for the next Bind */
+                {
+                    int         len = input_message.len - input_message.cursor;
+                    const char *data = pq_getmsgbytes(&input_message, len);
+
+                    pq_getmsgend(&input_message);
+                    RuntimeFilterSetPending(data, len);
+                }
+                break;
 #endif
                 /*
                  * 'X' means that the frontend is closing down the socket. EOF
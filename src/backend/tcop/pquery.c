@@ -858,6 +858,9 @@ PortalStart(Portal portal, ParamListInfo params,
                     {
                         SetProducerNodeMap(dest, nodeMap);
                     }
+
+                    /* filter tuples for the parent by the join it feeds */
+                    SetProducerRuntimeFilter(dest, RuntimeFilterTakePending());
 #endif
                     queryDesc->dest = dest;
                 }
@@ -963,12 +966,28 @@ PortalStart(Portal portal, ParamListInfo params,
                             queryDesc->sender
 #endif
                                 );
+#ifdef __TBASE__
+                        SetProducerRuntimeFilter(dest, RuntimeFilterTakePending());
+#endif
                         queryDesc->dest = dest;
 
                         addProducingPortal(portal);
                     }
                     else
                     {
+#ifdef __TBASE__
+                        dsm_handle    filter;
+
+                        /*
+                         * Let the producer drop the tuples our join can not
+                         * use, if the parent sent a runtime filter.
+                         */
+                        filter = RuntimeFilterPublishPending();
+                        if (filter != DSM_HANDLE_INVALID)
+                            SharedQueueSetConsumerFilter(queryDesc->squeue,
+                                                         queryDesc->myindex,
+                                                         filter);
+#endif
                         /*
                          * We do not need to initialize executor, but need
                          * a tuple descriptor
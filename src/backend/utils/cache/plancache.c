@@ -2074,7 +2074,8 @@ ResetPlanCache(void)
 
 #ifdef XCP
 void
-SetRemoteSubplan(CachedPlanSource *plansource, const char *plan_string)
+SetRemoteSubplan(CachedPlanSource *plansource, const char *plan_string,
+				 int cache_slot)
 {// #lizard forgives
     CachedPlan            *plan;
     MemoryContext         plan_context;
@@ -2099,6 +2100,14 @@ SetRemoteSubplan(CachedPlanSource *plansource, const char *plan_string)
                                          ALLOCSET_DEFAULT_MAXSIZE);
     oldcxt = MemoryContextSwitchTo(plan_context);
 
+#ifdef __TBASE__
+    /* a cached plan may have been parsed already, it lives with the context */
+    rstmt = NULL;
+    if (cache_slot >= 0)
+        rstmt = RemotePlanCacheGetStmt(cache_slot, plan_context);
+    if (rstmt == NULL)
+    {
+#endif
     /*
      * Restore query plan.
      *
@@ -2122,6 +2131,9 @@ SetRemoteSubplan(CachedPlanSource *plansource, const char *plan_string)
     }
     PG_END_TRY();
     set_portable_input(false);
+#ifdef __TBASE__
+    }
+#endif
 
     stmt = makeNode(PlannedStmt);
 
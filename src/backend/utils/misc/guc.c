@@ -29,6 +29,7 @@
 
 #include "access/commit_ts.h"
 #include "access/gin.h"
+#include "access/heapam.h"
 #ifdef PGXC
 #include "access/gtm.h"
 #include "pgxc/pgxc.h"
@@ -36,6 +37,9 @@
 #include "access/rmgr.h"
 #include "access/transam.h"
 #include "access/twophase.h"
+#ifdef __TWO_PHASE_TRANS__
+#include "access/twophase_journal.h"
+#endif
 #include "access/xact.h"
 #include "access/xlog_internal.h"
 #include "access/heapam_xlog.h"
@@ -75,6 +79,10 @@
 #include "pgxc/xc_maintenance_mode.h"
 #include "storage/procarray.h"
 #endif
+#ifdef __TBASE__
+#include "pgxc/commit_latency.h"
+#include "postmaster/partmaint.h"
+#endif
 #ifdef XCP
 #include "commands/sequence.h"
 #include "parser/parse_utilcmd.h"
@@ -95,6 +103,9 @@
 #include "replication/walsender.h"
 #include "storage/bufmgr.h"
 #include "storage/dsm_impl.h"
+#ifdef _SHARDING_
+#include "storage/extentmapping.h"
+#endif
 #include "storage/standby.h"
 #include "storage/fd.h"
 #include "storage/pg_shmem.h"
@@ -179,6 +190,9 @@ extern char *default_tablespace;
 extern char *temp_tablespaces;
 extern bool ignore_checksum_failure;
 extern bool synchronize_seqscans;
+#ifdef _SHARDING_
+extern int g_ExtentCacheSize;
+#endif
 extern bool enable_cold_hot_router_print;
 #ifdef _PUB_SUB_RELIABLE_
 static char * g_wal_stream_type_str;
@@ -202,6 +216,8 @@ extern bool    PlpgsqlDebugPrint;
 static int32 g_TotalMemorySize = 0;
 extern bool    enable_parallel_ddl;
 extern bool    enable_distinct_optimizer;
+extern bool    enable_runtime_filter;
+extern int     runtime_filter_max_rows;
 #endif
 static int    GUC_check_errcode_value;
 
@@ -291,6 +307,7 @@ static void strreplace_all(char *str, char *needle, char *replacement);
 #ifdef __TBASE__
 static bool set_warm_shared_buffer(bool *newval, void **extra, GucSource source);
 static const char *show_total_memorysize(void);
+static bool check_remote_features(int *newval, void **extra, GucSource source);
 #endif
 #ifdef __COLD_HOT__
 static void assign_cold_hot_partition_type(const char *newval, void *extra);
@@ -1579,6 +1596,17 @@ static struct config_bool ConfigureNamesBool[] =
         false,
         NULL, NULL, NULL
     },
+#ifdef __TBASE__
+    {
+        {"track_commit_latency", PGC_SUSET, STATS_COLLECTOR,
+            gettext_noop("Collects latency histograms of the distributed commit phases."),
+            NULL
+        },
+        &track_commit_latency,
+        true,
+        NULL, NULL, NULL
+    },
+#endif
 
     {
         {"update_process_title", PGC_SUSET, PROCESS_TITLE,
@@ -2086,6 +2114,35 @@ static struct config_bool ConfigureNamesBool[] =
         NULL, NULL, NULL
     },
 
+    {
+        {"squeue_minimal_tuple", PGC_USERSET, CUSTOM_OPTIONS,
+            gettext_noop("Pass tuples through the shared queue as MinimalTuple instead of DataRow."),
+            gettext_noop("The consumer session serializes the tuple, so the producer "
+                         "does not call the type output functions for every row.")
+        },
+        &g_SqueueMinimalTuple,
+        false,
+        NULL, NULL, NULL
+    },
+    {
+        {"enable_copy_sender_thread", PGC_USERSET, CUSTOM_OPTIONS,
+            gettext_noop("Use a sender thread per datanode to send COPY FROM data on the coordinator."),
+            NULL
+        },
+        &g_CopySenderThread,
+        false,
+        NULL, NULL, NULL
+    },
+    {
+        {"enable_onephase_commit", PGC_USERSET, CUSTOM_OPTIONS,
+            gettext_noop("Commit transactions that wrote on a single datanode without two-phase commit."),
+            gettext_noop("Datanodes that never assigned a transaction id are committed as read-only participants.")
+        },
+        &enable_onephase_commit,
+        true,
+        NULL, NULL, NULL
+    },
+
     {
         {"enable_pullup_subquery", PGC_USERSET, CUSTOM_OPTIONS,
             gettext_noop("pullup subquery to make execution more efficient."),
@@ -2405,6 +2462,15 @@ static struct config_bool ConfigureNamesBool[] =
         false,
         NULL, NULL, NULL
     },
+    {
+        {"enable_shard_physical_move", PGC_SUSET, CUSTOM_OPTIONS,
+            gettext_noop("Makes MOVE DATA pull the rows of the moved shards from the source datanode."),
+            gettext_noop("The shards must not be copied to the target datanode otherwise.")
+        },
+        &g_ShardPhysicalMove,
+        false,
+        NULL, NULL, NULL
+    },
 #endif
 
 #ifdef __AUDIT_FGA__
@@ -2461,6 +2527,17 @@ static struct config_bool ConfigureNamesBool[] =
         false,
         NULL, NULL, NULL
     },
+#ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
+    {
+        {"enable_gts_broker", PGC_USERSET, CUSTOM_OPTIONS,
+            gettext_noop("Share one GTM request among backends waiting for a snapshot global timestamp."),
+            NULL
+        },
+        &enable_gts_broker,
+        true,
+        NULL, NULL, NULL
+    },
+#endif
     {
         {"skip_gtm_catalog", PGC_POSTMASTER, CUSTOM_OPTIONS,
             gettext_noop("used to skip gtm catalog, WARNING:only for emergency purpose and only avaliable on coordinators."),
@@ -2481,6 +2558,18 @@ static struct config_bool ConfigureNamesBool[] =
         NULL, NULL, NULL
     },
 
+#ifdef __TWO_PHASE_TRANS__
+    {
+        {"enable_2pc_journal", PGC_SIGHUP, CUSTOM_OPTIONS,
+            gettext_noop("Appends the pg_2pc records of two-phase transactions to a journal instead of one file per transaction."),
+            NULL
+        },
+        &enable_2pc_journal,
+        true,
+        NULL, NULL, NULL
+    },
+#endif
+
     {
         {"enable_distri_visibility_print", PGC_SUSET, CUSTOM_OPTIONS,
             gettext_noop("enable distributed transaction visibility print"),
@@ -2802,6 +2891,64 @@ static struct config_bool ConfigureNamesBool[] =
 #endif
 		NULL, NULL, NULL
 	},
+#ifdef __TBASE__
+    {
+        {"enable_runtime_filter", PGC_USERSET, QUERY_TUNING_METHOD,
+            gettext_noop("Enables pushing hash join bloom filters down to remote subplan producers."),
+            NULL
+        },
+        &enable_runtime_filter,
+        true,
+        NULL, NULL, NULL
+    },
+    {
+        {"enable_partial_agg_bypass", PGC_USERSET, QUERY_TUNING_METHOD,
+            gettext_noop("Lets partial hash aggregates below a redistribution pass rows through when they do not reduce them."),
+            NULL
+        },
+        &enable_partial_agg_bypass,
+        true,
+        NULL, NULL, NULL
+    },
+    {
+        {"enable_remote_plan_cache", PGC_USERSET, QUERY_TUNING_OTHER,
+            gettext_noop("Lets remote nodes keep recently sent subplans so that they are not sent again."),
+            NULL
+        },
+        &enable_remote_plan_cache,
+        true,
+        NULL, NULL, NULL
+    },
+    {
+        {"enable_pooler_fast_path", PGC_USERSET, DATA_NODES,
+            gettext_noop("Keeps idle pooled connections in the session between transactions."),
+            gettext_noop("The next transaction takes them back without asking the pooler, "
+                         "unless the pooler needed them for another session meanwhile.")
+        },
+        &PoolerFastPath,
+        true,
+        NULL, NULL, NULL
+    },
+    {
+        {"pooler_sticky_connections", PGC_USERSET, DATA_NODES,
+            gettext_noop("Keeps parked connections in the session while it is idle."),
+            gettext_noop("Other sessions take them only when no other parked connections "
+                         "are left, and the pooler evicts them after pooler_sticky_idle_timeout.")
+        },
+        &PoolerStickyConnections,
+        false,
+        NULL, NULL, NULL
+    },
+    {
+        {"pooler_predictive_warm", PGC_SIGHUP, DATA_NODES,
+            gettext_noop("Grows connection pools ahead of the demand seen at the same time of day."),
+            NULL
+        },
+        &PoolerPredictiveWarm,
+        true,
+        NULL, NULL, NULL
+    },
+#endif
 
     /* End-of-list marker */
     {
@@ -4329,6 +4476,71 @@ static struct config_int ConfigureNamesInt[] =
         60, 60, INT_MAX,
         NULL, NULL, NULL
     },
+#ifdef __TBASE__
+    {
+        {"pooler_sticky_idle_timeout", PGC_SIGHUP, DATA_NODES,
+            gettext_noop("Idle time after which the pooler takes back the connections of a sticky session."),
+            gettext_noop("The timeout shrinks as the pools of the nodes fill up."),
+            GUC_UNIT_S
+        },
+        &PoolerStickyIdleTimeout,
+        300, 0, INT_MAX,
+        NULL, NULL, NULL
+    },
+    {
+        {"pooler_warm_lead_time", PGC_SIGHUP, DATA_NODES,
+            gettext_noop("How far ahead the pooler grows pools for the demand it predicts."),
+            NULL,
+            GUC_UNIT_S
+        },
+        &PoolerWarmLeadTime,
+        300, 0, 3600,
+        NULL, NULL, NULL
+    },
+    {
+        {"pooler_processes", PGC_POSTMASTER, DATA_NODES,
+            gettext_noop("Number of pooler processes sharing the database pools."),
+            gettext_noop("Database pools are assigned to a pooler by a hash of database "
+                         "and user name. Pooler processes beyond the first one are "
+                         "background workers and count against max_worker_processes.")
+        },
+        &PoolerProcesses,
+        1, 1, MAX_POOLER_PROCESSES,
+        NULL, NULL, NULL
+    },
+#endif
+#ifdef __TBASE__
+    {
+        {"partition_premake", PGC_SIGHUP, CUSTOM_OPTIONS,
+            gettext_noop("Number of future interval partitions the partition maintenance worker keeps created."),
+            gettext_noop("Applies to tables partitioned by timestamp that do not set "
+                         "the partition_premake storage parameter.")
+        },
+        &partition_premake,
+        2, 0, MAX_NUM_INTERVAL_PARTITIONS,
+        NULL, NULL, NULL
+    },
+    {
+        {"partition_maintenance_naptime", PGC_SIGHUP, CUSTOM_OPTIONS,
+            gettext_noop("Time to sleep between runs of the partition maintenance worker."),
+            NULL,
+            GUC_UNIT_S
+        },
+        &partition_maintenance_naptime,
+        60, 1, INT_MAX / 1000,
+        NULL, NULL, NULL
+    },
+    {
+        {"partition_maintenance_lock_timeout", PGC_SIGHUP, CUSTOM_OPTIONS,
+            gettext_noop("Lock timeout of the DDL run by the partition maintenance worker."),
+            gettext_noop("DDL that cannot get its locks in time is retried in the next run."),
+            GUC_UNIT_MS
+        },
+        &partition_maintenance_lock_timeout,
+        1000, 1, INT_MAX,
+        NULL, NULL, NULL
+    },
+#endif
 
     {
         {"pool_maintenance_timeout", PGC_SIGHUP, DATA_NODES,
@@ -4600,6 +4812,38 @@ static struct config_int ConfigureNamesInt[] =
         8, 1, 524288,
         NULL, NULL, NULL
     },
+    {
+        {"sender_thread_compress_level", PGC_SIGHUP, CUSTOM_OPTIONS,
+            gettext_noop("zlib level of batched DataRows sent by datapump, 0 sends DataRows one by one"),
+            NULL,
+            0
+        },
+        &g_SndCompressLevel,
+        0, 0, 9,
+        NULL, NULL, NULL
+    },
+    {
+        {"squeue_spill_memory", PGC_SIGHUP, RESOURCES_MEM,
+            gettext_noop("Memory all shared queue producers of the node may use to buffer rows of slow consumers."),
+            gettext_noop("A consumer gets its even share of the queue while the budget lasts, "
+                         "rows beyond it are written to temporary files. "
+                         "0 gives every consumer work_mem divided by the number of datanodes."),
+            GUC_UNIT_KB
+        },
+        &g_SqueueSpillMemory,
+        0, 0, MAX_KILOBYTES,
+        NULL, NULL, NULL
+    },
+    {
+        {"squeue_spill_delay", PGC_USERSET, CUSTOM_OPTIONS,
+            gettext_noop("Time a shared queue producer waits for a busy consumer before buffering its rows."),
+            NULL,
+            GUC_UNIT_MS
+        },
+        &g_SqueueSpillDelay,
+        0, 0, 10000,
+        NULL, NULL, NULL
+    },
     {
         {"archive_autowake_interval", PGC_USERSET, WAL_ARCHIVING,
             gettext_noop("how often to force a poll of the archive status directory in seconds."),
@@ -4616,6 +4860,68 @@ static struct config_int ConfigureNamesInt[] =
         32, 0, INT_MAX,
         NULL, NULL, NULL
     },
+    {
+        {"copy_sender_queue_size", PGC_USERSET, RESOURCES_MEM,
+            gettext_noop("Sets the amount of COPY data queued for each datanode sender thread."),
+            NULL,
+            GUC_UNIT_KB
+        },
+        &g_CopySenderQueueSize,
+        4096, 128, MAX_KILOBYTES,
+        NULL, NULL, NULL
+    },
+
+#ifdef _SHARDING_
+    {
+        {"extent_cache_size", PGC_POSTMASTER, RESOURCES_MEM,
+            gettext_noop("Sets the number of shard anchors and extent mapping elements cached in shared memory."),
+            gettext_noop("Zero disables the cache.")
+        },
+        &g_ExtentCacheSize,
+        65536, 0, INT_MAX / 2,
+        NULL, NULL, NULL
+    },
+
+    {
+        {"extent_reserve_batch", PGC_USERSET, RESOURCES_DISK,
+            gettext_noop("Sets the number of free extents a backend looks up at once when allocating extents."),
+            NULL
+        },
+        &g_ExtentReserveBatch,
+        8, 1, 64,
+        NULL, NULL, NULL
+    },
+
+    {
+        {"shard_scan_readahead_extents", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
+            gettext_noop("Sets the number of extents a shard scan resolves and prefetches ahead."),
+            NULL
+        },
+        &shard_scan_readahead_extents,
+        4, 1, 64,
+        NULL, NULL, NULL
+    },
+#endif
+#ifdef __TBASE__
+    {
+        {"runtime_filter_max_rows", PGC_USERSET, QUERY_TUNING_OTHER,
+            gettext_noop("Sets the largest hash join build side a runtime filter is pushed down for."),
+            NULL
+        },
+        &runtime_filter_max_rows,
+        1000000, 1, INT_MAX,
+        NULL, NULL, NULL
+    },
+    {
+        {"partial_agg_bypass_check_rows", PGC_USERSET, QUERY_TUNING_OTHER,
+            gettext_noop("Sets how many input rows a partial hash aggregate reads between checks of its reduction ratio."),
+            NULL
+        },
+        &partial_agg_bypass_check_rows,
+        100000, 1, INT_MAX,
+        NULL, NULL, NULL
+    },
+#endif
 
     {
         {"replication_level", PGC_USERSET, CUSTOM_OPTIONS,
@@ -4756,6 +5062,18 @@ static struct config_int ConfigureNamesInt[] =
         NULL, NULL, NULL
     },
 #endif
+#ifdef __TBASE__
+    {
+        {REMOTE_FEATURES_GUC, PGC_USERSET, UNGROUPED,
+            gettext_noop("Sets the protocol features the connected session supports."),
+            gettext_noop("Only set by coordinators and datanodes on their internal connections."),
+            GUC_REPORT | GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_DISALLOW_IN_FILE
+        },
+        &g_RemoteFeatures,
+        0, 0, INT_MAX,
+        check_remote_features, NULL, NULL
+    },
+#endif
 
     /* End-of-list marker */
     {
@@ -4957,6 +5275,17 @@ static struct config_real ConfigureNamesReal[] =
         0.5, 0.0, 1.0,
         NULL, NULL, NULL
     },
+#ifdef __TBASE__
+    {
+        {"partial_agg_bypass_ratio", PGC_USERSET, QUERY_TUNING_OTHER,
+            gettext_noop("Sets the groups per input row above which a partial hash aggregate is bypassed."),
+            NULL
+        },
+        &partial_agg_bypass_ratio,
+        0.5, 0.0, 1.0,
+        NULL, NULL, NULL
+    },
+#endif
 
     /* End-of-list marker */
     {
@@ -5640,6 +5969,17 @@ static struct config_string ConfigureNamesString[] =
         NULL, NULL, NULL
     },
 #endif
+#ifdef __TBASE__
+    {
+        {"partition_maintenance_database", PGC_POSTMASTER, CUSTOM_OPTIONS,
+            gettext_noop("Database whose interval partitions the partition maintenance worker maintains."),
+            gettext_noop("An empty string disables the worker.")
+        },
+        &partition_maintenance_database,
+        "",
+        NULL, NULL, NULL
+    },
+#endif
 #ifdef __TBASE__
     {
         {"pooler_warm_db_user", PGC_USERSET, CUSTOM_OPTIONS,
@@ -8357,7 +8697,11 @@ set_config_option(const char *name, const char *value,
 	 */
     if ((source == PGC_S_SESSION || source == PGC_S_CLIENT)
         && (IS_PGXC_DATANODE || !IsConnFromCoord())
-        && (strcmp(name,"remotetype") != 0 && strcmp(name,"parentnode") != 0))
+        && (strcmp(name,"remotetype") != 0 && strcmp(name,"parentnode") != 0)
+#ifdef __TBASE__
+        && strcmp(name, REMOTE_FEATURES_GUC) != 0
+#endif
+        )
     {
         send_to_nodes = true;
     }
@@ -13510,6 +13854,17 @@ show_total_memorysize(void)
 	snprintf(buf, sizeof(buf), "%dM", size);
     return buf;
 }
+
+/*
+ * Keep only the features this node supports, the value is reported back to
+ * the session that set it.
+ */
+static bool
+check_remote_features(int *newval, void **extra, GucSource source)
+{
+    *newval &= REMOTE_FEATURES_SUPPORTED;
+    return true;
+}
 #endif
 #ifdef __COLD_HOT__
 static void
@@ -272,6 +272,9 @@ struct Tuplestorestate
     long         stat_write_count;
     long        stat_spill_read;
     long        stat_spill_write;
+#ifdef __TBASE__
+    int64        stat_spill_bytes;    /* bytes of datarows written to file */
+#endif
 };
 
 #define COPYTUP(state,tup)    ((*(state)->copytup) (state, tup))
@@ -398,6 +401,9 @@ tuplestore_begin_common(int eflags, bool interXact, int maxKBytes)
     state->stat_read_count = 0;
     state->stat_spill_write = 0;
     state->stat_spill_read = 0;
+#ifdef __TBASE__
+    state->stat_spill_bytes = 0;
+#endif
 
     return state;
 }
@@ -1818,6 +1824,10 @@ writetup_datarow(Tuplestorestate *state, void *tup)
                          sizeof(tuplen)) != sizeof(tuplen))
             elog(ERROR, "write failed");
 
+#ifdef __TBASE__
+    state->stat_spill_bytes += tuplen;
+#endif
+
     FREEMEM(state, GetMemoryChunkSpace(tuple));
     pfree(tuple);
 }
@@ -1977,3 +1987,15 @@ tuplestore_collect_stat(Tuplestorestate *state, char *name)
 
     state->stat_name = pstrdup(name);
 }
+
+#ifdef __TBASE__
+/*
+ * Return number of bytes of datarows the tuplestore has written to the
+ * temporary file so far.
+ */
+int64
+tuplestore_spill_bytes(Tuplestorestate *state)
+{
+    return state->stat_spill_bytes;
+}
+#endif
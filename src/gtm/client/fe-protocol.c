@@ -428,6 +428,10 @@ break;
                 result->gr_status = GTM_RESULT_ERROR;
                 break;
             }
+            if (gtmpqGetc(&result->gr_resdata.grd_gts.gtm_readonly, conn) == EOF)
+            {
+                result->gr_resdata.grd_gts.gtm_readonly = false;
+            }
             break;
 
 
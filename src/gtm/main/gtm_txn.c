@@ -1350,6 +1350,28 @@ SyncGlobalTimestamp(void)
 
 }
 
+/*
+ * Reserve count consecutive global timestamps, returning the first one.  The
+ * base is moved past the last one, so that nothing issued later can be any
+ * of them or anything earlier.
+ */
+GlobalTimestamp
+GetNextGlobalTimestampRange(int count)
+{
+    GlobalTimestamp gts, now;
+
+    AcquireWriteLock();
+    now = GTM_TimestampGetMonotonicRaw();
+    gts = GTMTransactions.gt_global_timestamp + (now - GTMTransactions.gt_last_cycle);
+    GTMTransactions.gt_global_timestamp = gts + count;
+    GTMTransactions.gt_last_cycle = now;
+    GTMTransactions.gt_last_issue_timestamp = gts + count - 1;
+    ReleaseWriteLock();
+
+    elog(DEBUG8, "reserve %d global timestamps from "INT64_FORMAT, count, gts);
+    return gts;
+}
+
 void
 SetNextGlobalTimestamp(GlobalTimestamp gts)
 {
@@ -1436,6 +1458,9 @@ ProcessGetGTSCommandMulti(Port *myport, StringInfo message)
     StringInfoData buf;
     GTM_Timestamp timestamp;
     int gts_count;
+#ifdef __XLOG__
+    time_t        now;
+#endif
 
     if (Recovery_IsStandby())
     {
@@ -1450,10 +1475,31 @@ ProcessGetGTSCommandMulti(Port *myport, StringInfo message)
     if (gts_count <= 0)
         elog(PANIC, "Zero or less transaction count");
 
-    /* Get a GTM timestamp */
-    timestamp = GTM_TimestampGetCurrent();
+    /*
+     * The group gets gts_count consecutive timestamps starting at the one
+     * returned, and the proxy hands timestamp + i to its i-th requester, so
+     * that commit and prepare timestamps stay distinct.  Every requester was
+     * waiting before the first one was taken.
+     */
+    timestamp = GetNextGlobalTimestampRange(gts_count);
+#ifdef __XLOG__
+    now       = GTM_TimestampGetMonotonicRaw();
+
+    if(now - GetMyThreadInfo->last_sync_gts > GTM_SYNC_TIME_LIMIT)
+    {
+        SpinLockAcquire(&g_last_sync_gts_lock);
+        GetMyThreadInfo->last_sync_gts = g_last_sync_gts;
+        SpinLockRelease(&g_last_sync_gts_lock);
+
+        /* 
+         * check local last_sync_gts if updated ,if not ignore.
+         */
+        if(GetMyThreadInfo->last_sync_gts != 0 && now - GetMyThreadInfo->last_sync_gts > GTM_SYNC_TIME_LIMIT)
+            elog(ERROR,"sync time exceeded last:%lu now:%lu",GetMyThreadInfo->last_sync_gts,now);
+    }
+#endif
 
-    elog(DEBUG7, "GTM processes timestamp.\n");
+    elog(DEBUG7, "GTM processes timestamp for %d requests.\n", gts_count);
     
     BeforeReplyToClientXLogTrigger();
     
@@ -1467,6 +1513,10 @@ ProcessGetGTSCommandMulti(Port *myport, StringInfo message)
         pq_sendbytes(&buf, (char *)&proxyhdr, sizeof (GTM_ProxyMsgHeader));
     }
     pq_sendbytes(&buf, (char *)&timestamp, sizeof(GTM_Timestamp));
+    if (GTMClusterReadOnly)
+    {
+        pq_sendbyte(&buf, true);
+    }
     pq_endmessage(myport, &buf);
 
     if (myport->remote_type != GTM_NODE_GTM_PROXY)
@@ -52,6 +52,8 @@ extern int GTMProxyPortNumber;
 extern int GTMConnectRetryInterval;
 extern int GTMServerPortNumber;
 extern int GTMProxyWorkerThreads;
+extern int GTMProxyBatchWindow;
+extern int GTMProxyBatchMaxCommands;
 extern char *GTMProxyDataDir;
 extern char *GTMProxyConfigFileName;
 extern char *GTMConfigFileName;
@@ -63,6 +65,7 @@ extern char *GTMConfigFileName;
  * Some of them are declared also in proxy_main.c.
  */
 #define GTM_PROXY_DEFAULT_WORKERS 2
+#define GTM_PROXY_DEFAULT_BATCH_MAX_COMMANDS 256
 
 /*
  * We have different sets for client and server message level options because
@@ -220,6 +223,30 @@ struct config_int ConfigureNamesInt[] =
 		GTM_PROXY_DEFAULT_WORKERS, 1, INT_MAX, NULL, NULL,
         0, NULL
     },
+    {
+        {
+            GTM_OPTNAME_BATCH_WINDOW, GTMC_SIGHUP,
+            gettext_noop("Time in microseconds a worker thread waits for more "
+                         "groupable commands before sending them to GTM."),
+            NULL,
+            0
+        },
+        &GTMProxyBatchWindow,
+		0, 0, 1000000, NULL, NULL,
+        0, NULL
+    },
+    {
+        {
+            GTM_OPTNAME_BATCH_MAX_COMMANDS, GTMC_SIGHUP,
+            gettext_noop("Number of pending groupable commands that closes "
+                         "the batching window early."),
+            NULL,
+            0
+        },
+        &GTMProxyBatchMaxCommands,
+		GTM_PROXY_DEFAULT_BATCH_MAX_COMMANDS, 1, INT_MAX, NULL, NULL,
+        0, NULL
+    },
     /* End-of-list marker */
     {
 		{NULL, 0, NULL, NULL, 0}, NULL, 0, 0, 0, NULL, NULL, 0, NULL
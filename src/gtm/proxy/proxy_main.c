@@ -138,6 +138,15 @@ int            GTMServerPortNumber;
 
 int            GTMConnectRetryInterval = 60;
 
+/*
+ * Batching window for grouped commands.  A worker thread that has read some
+ * groupable commands keeps the round open for up to GTMProxyBatchWindow
+ * microseconds, or until GTMProxyBatchMaxCommands such commands are pending,
+ * so that they go to GTM in a single multi-request.
+ */
+int            GTMProxyBatchWindow = 0;
+int            GTMProxyBatchMaxCommands = 256;
+
 #ifdef __XLOG__
 char *recovery_file_name;
 #endif
@@ -227,6 +236,11 @@ static void ProcessResponse(GTMProxy_ThreadInfo *thrinfo,
         GTMProxy_CommandInfo *cmdinfo, GTM_Result *res);
 
 static void GTMProxy_ProcessPendingCommands(GTMProxy_ThreadInfo *thrinfo);
+static void GTMProxy_ReadCommands(GTMProxy_ThreadInfo *thrinfo,
+        StringInfo input_message, bool *round_read);
+static void GTMProxy_WaitForBatch(GTMProxy_ThreadInfo *thrinfo,
+        StringInfo input_message, bool *round_read);
+static int GTMProxy_PendingGroupedCount(GTMProxy_ThreadInfo *thrinfo);
 static void GTMProxy_CommandPending(GTMProxy_ConnectionInfo *conninfo,
         GTM_MessageType mtype, GTMProxy_CommandData cmd_data);
 
@@ -1144,14 +1158,13 @@ void *
 GTMProxy_ThreadMain(void *argp)
 {// #lizard forgives
     GTMProxy_ThreadInfo *thrinfo = (GTMProxy_ThreadInfo *)argp;
-    int qtype;
     StringInfoData input_message;
     sigjmp_buf  local_sigjmp_buf;
     int32 saved_seqno = -1;
     int ii, nrfds;
     char gtm_connect_string[1024];
     int    first_turn = TRUE;    /* Used only to set longjmp target at the first turn of thread loop */
-    GTMProxy_CommandData cmd_data = {};
+    bool   round_read[GTM_PROXY_MAX_CONNECTIONS];
 
     elog(DEBUG3, "Starting the connection helper thread");
 
@@ -1436,68 +1449,16 @@ setjmp_again:
          * Now, read command from each of the connections that has some data to
          * be read.
          */
-        for (ii = 0; ii < thrinfo->thr_conn_count; ii++)
-        {
-            int connIndx = thrinfo->thr_conn_map[ii];
-            GTMProxy_ConnectionInfo *conninfo = thrinfo->thr_all_conns[connIndx];
-            thrinfo->thr_conn = conninfo;
-
-            if (thrinfo->thr_poll_fds[ii].revents & POLLHUP)
-            {
-                /*
-                 * The fd has become invalid. The connection is broken. Add it
-                 * to the remove_list and cleanup at the end of this round of
-                 * cleanup.
-                 */
-                GTMProxy_CommandPending(thrinfo->thr_conn,
-                            MSG_BACKEND_DISCONNECT, cmd_data);
-                continue;
-            }
-
-            if ((thrinfo->thr_any_backup[connIndx]) ||
-                (thrinfo->thr_poll_fds[ii].revents & POLLIN))
-            {
-                /*
-                 * (3) read a command (loop blocks here)
-                 */
-                qtype = ReadCommand(thrinfo->thr_conn, &input_message);
-
-                thrinfo->thr_poll_fds[ii].revents = 0;
-
-                switch(qtype)
-                {
-                    case 'C':
-                        ProcessCommand(thrinfo->thr_conn, thrinfo->thr_gtm_conn,
-                                &input_message);
-                        HandlePostCommand(thrinfo->thr_conn, thrinfo->thr_gtm_conn);
-                        break;
-
-                    case 'X':
-                    case EOF:
-                        /*
-                         * Connection termination request
-                         *
-                         * Close the socket and remember the connection
-                         * as disconnected. All such connections will be
-                         * removed after the command processing is over. We
-                         * can't remove it just yet because we pass the slot id
-                         * to the server to quickly find the backend connection
-                         * while processing proxied messages.
-                         */
-                        GTMProxy_CommandPending(thrinfo->thr_conn,
-                                                MSG_BACKEND_DISCONNECT, cmd_data);
-                        break;
-                    default:
-                        /*
-                         * Also disconnect if protocol error
-                         */
-                        GTMProxy_HandleDisconnect(thrinfo->thr_conn, thrinfo->thr_gtm_conn);
-                        elog(ERROR, "Unexpected message, or client disconnected abruptly.");
-                        break;
-                }
+        memset(round_read, 0, sizeof (round_read));
+        GTMProxy_ReadCommands(thrinfo, &input_message, round_read);
 
-            }
-        }
+        /*
+         * If anything we read can be grouped, hold the round open for a short
+         * while so that commands from other connections join the same
+         * multi-request.
+         */
+        if (GTMProxyBatchWindow > 0)
+            GTMProxy_WaitForBatch(thrinfo, &input_message, round_read);
 
         /*
          * Ok. All the commands are processed. Commands which can be proxied
@@ -1670,6 +1631,9 @@ ProcessCommand(GTMProxy_ConnectionInfo *conninfo, GTM_Conn *gtm_conn,
         case MSG_TXN_COMMIT_MULTI:
         case MSG_TXN_ROLLBACK:
         case MSG_TXN_GET_GXID:
+#ifdef __TBASE__
+        case MSG_GETGTS:
+#endif
             ProcessTransactionCommand(conninfo, gtm_conn, mtype, input_message);
             break;
 
@@ -1959,6 +1923,43 @@ ProcessResponse(GTMProxy_ThreadInfo *thrinfo, GTMProxy_CommandInfo *cmdinfo,
             ReleaseCmdBackup(cmdinfo);
             break;
 
+#ifdef __TBASE__
+        case MSG_GETGTS:
+            /*
+             * Grouped command. GTM reserved one timestamp per requester of
+             * the round, starting at the one returned for the
+             * MSG_GETGTS_MULTI message.
+             */
+            if (res->gr_status == GTM_RESULT_OK)
+            {
+                if (res->gr_type != TXN_BEGIN_GETGTS_MULTI_RESULT)
+                {
+                    ReleaseCmdBackup(cmdinfo);
+                    elog(ERROR, "Wrong result");
+                }
+
+                timestamp = res->gr_resdata.grd_gts.grd_gts + cmdinfo->ci_res_index;
+
+                pq_beginmessage(&buf, 'S');
+                pq_sendint(&buf, TXN_BEGIN_GETGTS_RESULT, 4);
+                pq_sendbytes(&buf, (char *)&timestamp, sizeof (GTM_Timestamp));
+                if (res->gr_resdata.grd_gts.gtm_readonly)
+                    pq_sendbyte(&buf, true);
+                pq_endmessage(cmdinfo->ci_conn->con_port, &buf);
+                pq_flush(cmdinfo->ci_conn->con_port);
+            }
+            else
+            {
+                pq_beginmessage(&buf, 'E');
+                pq_sendbytes(&buf, res->gr_proxy_data, res->gr_msglen);
+                pq_endmessage(cmdinfo->ci_conn->con_port, &buf);
+                pq_flush(cmdinfo->ci_conn->con_port);
+            }
+            cmdinfo->ci_conn->con_pending_msg = MSG_TYPE_INVALID;
+            ReleaseCmdBackup(cmdinfo);
+            break;
+#endif
+
         case MSG_SNAPSHOT_GET_MULTI:
             if ((res->gr_type != SNAPSHOT_GET_RESULT) &&
                 (res->gr_type != SNAPSHOT_GET_MULTI_RESULT))
@@ -2238,6 +2239,18 @@ ProcessTransactionCommand(GTMProxy_ConnectionInfo *conninfo, GTM_Conn *gtm_conn,
             GTMProxy_CommandPending(conninfo, mtype, cmd_data);
             break;
 
+#ifdef __TBASE__
+        case MSG_GETGTS:
+            /*
+             * Global timestamp requests carry no payload; all of them in a
+             * round are answered from the timestamps of one MSG_GETGTS_MULTI.
+             */
+            pq_getmsgend(message);
+            memset(&cmd_data, 0, sizeof (cmd_data));
+            GTMProxy_CommandPending(conninfo, mtype, cmd_data);
+            break;
+#endif
+
         case MSG_TXN_BEGIN:
         case MSG_TXN_GET_GXID:
             elog(FATAL, "Support not yet added for these message types");
@@ -2470,6 +2483,180 @@ GTMProxy_HandleDisconnect(GTMProxy_ConnectionInfo *conninfo, GTM_Conn *gtm_conn)
     return;
 }
 
+/*
+ * Read one command from each connection that has data to be read and has not
+ * been served yet in this round.  Connections served here are flagged in
+ * round_read, which is indexed like thr_poll_fds.
+ */
+static void
+GTMProxy_ReadCommands(GTMProxy_ThreadInfo *thrinfo, StringInfo input_message,
+                      bool *round_read)
+{// #lizard forgives
+    GTMProxy_CommandData cmd_data = {};
+    int qtype;
+    int ii;
+
+    for (ii = 0; ii < thrinfo->thr_conn_count; ii++)
+    {
+        int connIndx = thrinfo->thr_conn_map[ii];
+        GTMProxy_ConnectionInfo *conninfo = thrinfo->thr_all_conns[connIndx];
+
+        if (round_read[ii])
+            continue;
+
+        thrinfo->thr_conn = conninfo;
+
+        if (thrinfo->thr_poll_fds[ii].revents & POLLHUP)
+        {
+            /*
+             * The fd has become invalid. The connection is broken. Add it
+             * to the remove_list and cleanup at the end of this round of
+             * cleanup.
+             */
+            GTMProxy_CommandPending(thrinfo->thr_conn,
+                        MSG_BACKEND_DISCONNECT, cmd_data);
+            round_read[ii] = true;
+            continue;
+        }
+
+        if ((thrinfo->thr_any_backup[connIndx]) ||
+            (thrinfo->thr_poll_fds[ii].revents & POLLIN))
+        {
+            round_read[ii] = true;
+
+            /*
+             * (3) read a command (loop blocks here)
+             */
+            qtype = ReadCommand(thrinfo->thr_conn, input_message);
+
+            thrinfo->thr_poll_fds[ii].revents = 0;
+
+            switch(qtype)
+            {
+                case 'C':
+                    ProcessCommand(thrinfo->thr_conn, thrinfo->thr_gtm_conn,
+                            input_message);
+                    HandlePostCommand(thrinfo->thr_conn, thrinfo->thr_gtm_conn);
+                    break;
+
+                case 'X':
+                case EOF:
+                    /*
+                     * Connection termination request
+                     *
+                     * Close the socket and remember the connection
+                     * as disconnected. All such connections will be
+                     * removed after the command processing is over. We
+                     * can't remove it just yet because we pass the slot id
+                     * to the server to quickly find the backend connection
+                     * while processing proxied messages.
+                     */
+                    GTMProxy_CommandPending(thrinfo->thr_conn,
+                                            MSG_BACKEND_DISCONNECT, cmd_data);
+                    break;
+                default:
+                    /*
+                     * Also disconnect if protocol error
+                     */
+                    GTMProxy_HandleDisconnect(thrinfo->thr_conn, thrinfo->thr_gtm_conn);
+                    elog(ERROR, "Unexpected message, or client disconnected abruptly.");
+                    break;
+            }
+        }
+    }
+}
+
+/*
+ * Number of commands waiting to be sent to GTM as part of a multi-request.
+ */
+static int
+GTMProxy_PendingGroupedCount(GTMProxy_ThreadInfo *thrinfo)
+{
+    int count = 0;
+    int ii;
+
+    for (ii = 0; ii < MSG_TYPE_COUNT; ii++)
+    {
+        if (ii == MSG_BACKEND_DISCONNECT)
+            continue;
+        count += gtm_list_length(thrinfo->thr_pending_commands[ii]);
+    }
+
+    return count;
+}
+
+/*
+ * Keep the current round open until GTMProxyBatchWindow microseconds have
+ * passed or GTMProxyBatchMaxCommands groupable commands are pending, reading
+ * whatever arrives meanwhile on connections not yet served in this round.
+ *
+ * Nothing is delayed unless at least one groupable command is already
+ * pending; a round made only of directly proxied commands goes out at once.
+ * poll() only has millisecond resolution, so the last wait of a window may
+ * overshoot it by up to a millisecond when no command arrives.
+ *
+ * Longjmp stays disabled here: a reconnect request is noticed by the next
+ * Enable_Longjmp() once the window closes, which keeps the poll array
+ * consistent.
+ */
+static void
+GTMProxy_WaitForBatch(GTMProxy_ThreadInfo *thrinfo, StringInfo input_message,
+                      bool *round_read)
+{// #lizard forgives
+    struct timeval start;
+    struct timeval now;
+    long    elapsed;
+    int     nfds;
+    int     nrfds;
+    int     ii;
+
+    if (GTMProxy_PendingGroupedCount(thrinfo) == 0)
+        return;
+
+    gettimeofday(&start, NULL);
+
+    while (GTMProxy_PendingGroupedCount(thrinfo) < GTMProxyBatchMaxCommands)
+    {
+        gettimeofday(&now, NULL);
+        elapsed = (now.tv_sec - start.tv_sec) * 1000000L +
+                  (now.tv_usec - start.tv_usec);
+        if (elapsed >= GTMProxyBatchWindow)
+            break;
+
+        /*
+         * Mask out connections already served in this round; poll() skips
+         * negative descriptors.
+         */
+        nfds = thrinfo->thr_conn_count;
+        for (ii = 0; ii < nfds; ii++)
+        {
+            thrinfo->thr_poll_fds[ii].revents = 0;
+            if (round_read[ii])
+                thrinfo->thr_poll_fds[ii].fd = -1 - thrinfo->thr_poll_fds[ii].fd;
+        }
+
+        nrfds = poll(thrinfo->thr_poll_fds, nfds,
+                     (GTMProxyBatchWindow - elapsed + 999) / 1000);
+
+        for (ii = 0; ii < nfds; ii++)
+        {
+            if (round_read[ii])
+                thrinfo->thr_poll_fds[ii].fd = -1 - thrinfo->thr_poll_fds[ii].fd;
+        }
+
+        if (nrfds < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            elog(FATAL, "poll returned with error %d", nrfds);
+        }
+        else if (nrfds == 0)
+            break;
+
+        GTMProxy_ReadCommands(thrinfo, input_message, round_read);
+    }
+}
+
 /*
  * Process all the pending messages now.
  */
@@ -2668,6 +2855,41 @@ GTMProxy_ProcessPendingCommands(GTMProxy_ThreadInfo *thrinfo)
                 thrinfo->thr_pending_commands[ii] = gtm_NIL;
                 break;
 
+#ifdef __TBASE__
+            case MSG_GETGTS:
+                if (gtmpqPutInt(MSG_GETGTS_MULTI, sizeof (GTM_MessageType), gtm_conn) ||
+                    gtmpqPutInt(gtm_list_length(thrinfo->thr_pending_commands[ii]), sizeof(int), gtm_conn))
+                    elog(ERROR, "Error sending data");
+
+                /*
+                 * A single result answers the whole group, so every command
+                 * but the first one reuses it instead of reading another.
+                 * The index in the group picks the timestamp of the command.
+                 */
+                gtm_foreach (elem, thrinfo->thr_pending_commands[ii])
+                {
+                    cmdinfo = (GTMProxy_CommandInfo *)gtm_lfirst(elem);
+                    Assert(cmdinfo->ci_mtype == ii);
+                    cmdinfo->ci_res_index = res_index++;
+                }
+
+                /* Finish the message. */
+                Enable_Longjmp();
+                if (gtmpqPutMsgEnd(gtm_conn))
+                    elog(ERROR, "Error finishing the message");
+                Disable_Longjmp();
+
+                /*
+                 * Move the entire list to the processed command
+                 */
+                thrinfo->thr_processed_commands = gtm_list_concat(thrinfo->thr_processed_commands,
+                        thrinfo->thr_pending_commands[ii]);
+                if ((thrinfo->thr_processed_commands != thrinfo->thr_pending_commands[ii]) &&
+                    (thrinfo->thr_pending_commands[ii] != gtm_NIL))
+                    pfree(thrinfo->thr_pending_commands[ii]);
+                thrinfo->thr_pending_commands[ii] = gtm_NIL;
+                break;
+#endif
 
             default:
                 elog(ERROR, "This message type (%d) can not be grouped together", ii);
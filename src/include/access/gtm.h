@@ -112,6 +112,12 @@ extern void InitGTM(void);
 extern void CloseGTM(void);
 extern GTM_Timestamp 
 GetGlobalTimestampGTM(void);
+#ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
+extern bool enable_gts_broker;
+extern GTM_Timestamp GetSnapshotGlobalTimestampGTM(void);
+extern Size GTSBrokerShmemSize(void);
+extern void GTSBrokerShmemInit(void);
+#endif
 extern GlobalTransactionId BeginTranGTM(GTM_Timestamp *timestamp, const char *globalSession);
 extern GlobalTransactionId BeginTranAutovacuumGTM(void);
 extern int CommitTranGTM(GlobalTransactionId gxid, int waited_xid_count,
@@ -445,6 +445,10 @@ extern void hashbucketcleanup(Relation rel, Bucket cur_bucket,
 
 #ifdef PGXC
 extern Datum compute_hash(Oid type, Datum value, char locator);
+#ifdef __TBASE__
+extern void compute_hash_batch(Oid type, Datum *values, bool *nulls, int nvalues,
+                               char locator, long *hashvalues);
+#endif
 extern char *get_compute_hash_function(Oid type, char locator);
 #endif
 
@@ -132,6 +132,12 @@ extern void heap_parallelscan_initialize(ParallelHeapScanDesc target,
 							 Relation relation, Snapshot snapshot);
 extern void heap_parallelscan_reinitialize(ParallelHeapScanDesc parallel_scan);
 extern HeapScanDesc heap_beginscan_parallel(Relation, ParallelHeapScanDesc);
+#ifdef _SHARDING_
+extern int shard_scan_readahead_extents;
+extern HeapScanDesc heap_beginscan_shards(Relation relation, Snapshot snapshot,
+					  int nkeys, ScanKey key,
+					  int nshards, ShardID *shards);
+#endif
 
 extern bool heap_fetch(Relation relation, Snapshot snapshot,
 		   HeapTuple tuple, Buffer *userbuf, bool keep_buf,
@@ -134,6 +134,9 @@ typedef struct HeapScanDescData
     Buffer        rs_cbuf;        /* current buffer in scan, if any */
     /* NB: if rs_cbuf is not InvalidBuffer, we hold a pin on that buffer */
     ParallelHeapScanDesc rs_parallel;    /* parallel scan information */
+#ifdef _SHARDING_
+    struct ShardScanStateData *rs_shardscan;    /* shard scan state, or NULL */
+#endif
 
 #ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
     /* statistic account */
@@ -76,6 +76,7 @@
 
 #include "access/xlogdefs.h"
 #include "datatype/timestamp.h"
+#include "nodes/pg_list.h"
 #include "storage/lock.h"
 
 #include "gtm/gtm_c.h"
@@ -138,6 +139,8 @@ extern void record_2pc_involved_nodes_xid(const char * tid,
 extern void record_2pc_commit_timestamp(const char *tid, GlobalTimestamp commit_timestamp);
 extern void remove_2pc_records(const char *tid, bool record_in_xlog);
 extern void record_2pc_readonly(const char *gid);
+extern char *get_2pc_record(const char *tid);
+extern List *get_2pc_record_list(void);
 #endif
 
 #endif                            /* TWOPHASE_H */
@@ -0,0 +1,33 @@
+/*-------------------------------------------------------------------------
+ *
+ * twophase_journal.h
+ *      Append-only journal for the pg_2pc records of distributed transactions
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * src/include/access/twophase_journal.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef TWOPHASE_JOURNAL_H
+#define TWOPHASE_JOURNAL_H
+
+#include "nodes/pg_list.h"
+
+extern bool enable_2pc_journal;
+
+extern Size TwoPhaseJournalShmemSize(void);
+extern void TwoPhaseJournalShmemInit(void);
+
+extern bool TwoPhaseJournalCreate(const char *gid, const char *text,
+                      bool overwrite);
+extern bool TwoPhaseJournalExists(const char *gid);
+extern bool TwoPhaseJournalSetTimestamp(const char *gid,
+                            GlobalTimestamp commit_timestamp);
+extern bool TwoPhaseJournalRemove(const char *gid);
+extern char *TwoPhaseJournalLookup(const char *gid);
+extern List *TwoPhaseJournalGidList(void);
+
+extern void CheckPointTwoPhaseJournal(void);
+
+#endif                            /* TWOPHASE_JOURNAL_H */
@@ -6846,6 +6846,17 @@ DESCR("set need_mvcc flag");
 DATA(insert OID = 4629 (  tbase_show_need_mvcc PGNSP PGUID 12 1 0 0 0 f f f f t f v r 0 0 23 "" _null_ _null_ _null_ _null_ _null_ tbase_show_need_mvcc _null_ _null_ _null_ ));
 DESCR("show need_mvcc flag");
 
+DATA(insert OID = 4631 (  tbase_squeue_spill_statistic PGNSP PGUID 12 1 100 0 0 f f f f t t v r 0 0 2249 "" "{25,23,23,23,20,20}" "{o,o,o,o,o,o}" "{squeue,producer_pid,consumers,spill_consumers,spill_tuples,spill_bytes}" _null_ _null_ tbase_squeue_spill_statistic _null_ _null_ _null_ ));
+DESCR("show rows buffered by producers of the active shared queues");
+
+DATA(insert OID = 4632 (  tbase_shard_export PGNSP PGUID 12 1 1000 0 0 f f f f t t v r 2 0 2249 "2205 23" "{2205,23,23,23,17}" "{i,i,o,o,o}" "{rel,shard_id,extent_id,ntuples,data}" _null_ _null_ tbase_shard_export _null_ _null_ _null_ ));
+DESCR("export visible tuples of a shard by walking its extents");
+
+DATA(insert OID = 4634 (  tbase_commit_latency PGNSP PGUID 12 1 3 0 0 f f f f t t v r 0 0 2249 "" "{25,20,701,701,701,701,701,701}" "{o,o,o,o,o,o,o,o}" "{phase,calls,total_time,mean_time,p50_time,p90_time,p99_time,max_time}" _null_ _null_ tbase_commit_latency _null_ _null_ _null_ ));
+DESCR("show latency percentiles of the distributed commit phases");
+DATA(insert OID = 4635 (  tbase_reset_commit_latency PGNSP PGUID 12 1 0 0 0 f f f f t f v r 0 0 2278 "" _null_ _null_ _null_ _null_ _null_ tbase_reset_commit_latency _null_ _null_ _null_ ));
+DESCR("reset latency statistics of the distributed commit phases");
+
 #endif
 
 /*
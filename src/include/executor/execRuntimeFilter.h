@@ -0,0 +1,51 @@
+/*-------------------------------------------------------------------------
+ *
+ * execRuntimeFilter.h
+ *      Bloom filters pushed from a hash join build side down to the
+ *      producers of the probe side RemoteSubplan
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * src/include/executor/execRuntimeFilter.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECRUNTIMEFILTER_H
+#define EXECRUNTIMEFILTER_H
+
+#include "executor/tuptable.h"
+#include "fmgr.h"
+#include "lib/bloomfilter.h"
+#include "storage/dsm.h"
+
+/*
+ * Local form of a runtime filter.  A tuple passes the filter if all of its
+ * key columns are non-null and the hash join hash value computed over them
+ * may be present in the bloom filter.
+ */
+typedef struct RuntimeFilter
+{
+    int            nkeys;
+    AttrNumber *keyattnos;        /* key columns of the filtered tuples */
+    FmgrInfo   *hashfunctions;    /* hash function of each key column */
+    bloom_filter *bloom;
+    uint64        nprobed;        /* tuples checked */
+    uint64        nfiltered;        /* tuples rejected */
+} RuntimeFilter;
+
+extern bool enable_runtime_filter;
+extern int    runtime_filter_max_rows;
+
+extern char *RuntimeFilterSerialize(int nkeys, AttrNumber *keyattnos,
+                       Oid *hashfuncids, bloom_filter *bloom, int *len);
+extern RuntimeFilter *RuntimeFilterDeserialize(const char *data, int len);
+extern bool RuntimeFilterRejects(RuntimeFilter *filter, TupleTableSlot *slot);
+extern void RuntimeFilterFree(RuntimeFilter *filter);
+
+extern void RuntimeFilterSetPending(const char *data, int len);
+extern void RuntimeFilterResetPending(void);
+extern RuntimeFilter *RuntimeFilterTakePending(void);
+extern dsm_handle RuntimeFilterPublishPending(void);
+extern RuntimeFilter *RuntimeFilterAttach(dsm_handle handle);
+
+#endif                            /* EXECRUNTIMEFILTER_H */
@@ -201,6 +201,11 @@ extern void InitResultRelInfo(ResultRelInfo *resultRelInfo,
                   Index resultRelationIndex,
                   Relation partition_root,
                   int instrument_options);
+#ifdef __TBASE__
+extern ResultRelInfo *ExecInitPartitionResultRel(EState *estate,
+                           ResultRelInfo *parent, int partidx,
+                           bool speculative);
+#endif
 extern ResultRelInfo *ExecGetTriggerResultRel(EState *estate, Oid relid);
 extern void ExecCleanUpTriggerState(EState *estate);
 extern bool ExecContextForcesOids(PlanState *planstate, bool *hasoids);
@@ -521,6 +526,7 @@ extern Relation ExecOpenScanRelation(EState *estate, Index scanrelid, int eflags
 
 #ifdef __TBASE__
 extern Relation ExecOpenScanRelationPartition(EState *estate, Index scanrelid, int eflags, int partidx);
+extern List *ExecPruneIntervalSubplans(PlanState *planstate, List *subplans, List *quals);
 
 extern bool HasDisconnectNode(PlanState *node);
 #endif
@@ -23,6 +23,9 @@
 extern bool g_hybrid_hash_agg;
 extern bool g_hybrid_hash_agg_debug;
 extern int  g_default_hashagg_nbatches;
+extern bool enable_partial_agg_bypass;
+extern int  partial_agg_bypass_check_rows;
+extern double partial_agg_bypass_ratio;
 #endif
 
 extern AggState *ExecInitAgg(Agg *node, EState *estate, int eflags);
@@ -17,6 +17,9 @@
 #include "tcop/dest.h"
 #include "pgxc/locator.h"
 #include "pgxc/squeue.h"
+#ifdef __TBASE__
+#include "executor/execRuntimeFilter.h"
+#endif
 
 
 extern DestReceiver *CreateProducerDestReceiver(void);
@@ -37,5 +40,6 @@ extern bool ProducerReceiverPushBuffers(DestReceiver *self);
 
 #ifdef __TBASE__
 extern void SetProducerNodeMap(DestReceiver *self, int16 *nodemap);
+extern void SetProducerRuntimeFilter(DestReceiver *self, RuntimeFilter *filter);
 #endif
 #endif   /* PRODUCER_RECEIVER_H */
@@ -348,6 +348,8 @@ const char *const config_type_names[] =\
 #define GTM_OPTNAME_STATUS_READER        "status_reader"
 #define GTM_OPTNAME_SYNCHRONOUS_BACKUP    "synchronous_backup"
 #define GTM_OPTNAME_WORKER_THREADS        "worker_threads"
+#define GTM_OPTNAME_BATCH_WINDOW        "batch_window"
+#define GTM_OPTNAME_BATCH_MAX_COMMANDS    "batch_max_commands"
 #define GTM_OPTNAME_ENABLE_DEBUG        "enable_gtm_debug"
 #define GTM_OPTNAME_ENABLE_SEQ_DEBUG    "enable_gtm_sequence_debug"
 #define GTM_OPTNAME_SCALE_FACTOR_THREADS        "scale_factor_threads"
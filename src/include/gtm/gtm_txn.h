@@ -52,6 +52,7 @@ extern void SetGlobalTransactionIdLimit(GlobalTransactionId oldest_datfrozenxid)
 extern void SetNextGlobalTransactionId(GlobalTransactionId gxid);
 #ifdef __TBASE__
 extern GlobalTimestamp GetNextGlobalTimestamp(void);
+extern GlobalTimestamp GetNextGlobalTimestampRange(int count);
 extern void SetNextGlobalTimestamp(GlobalTimestamp gts);
 extern GlobalTimestamp SyncGlobalTimestamp(void);
 extern void AcquireWriteLock(void);
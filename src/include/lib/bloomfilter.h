@@ -0,0 +1,31 @@
+/*-------------------------------------------------------------------------
+ *
+ * bloomfilter.h
+ *      Space-efficient set membership testing
+ *
+ * The filter is allocated as a single flat chunk of memory, so it can be
+ * shipped to another backend or node simply by copying bloom_total_size()
+ * bytes starting at the filter pointer.
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * IDENTIFICATION
+ *      src/include/lib/bloomfilter.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef _BLOOMFILTER_H_
+#define _BLOOMFILTER_H_
+
+typedef struct bloom_filter bloom_filter;
+
+extern bloom_filter *bloom_create(int64 total_elems, int bloom_work_mem,
+                                  uint32 seed);
+extern void bloom_free(bloom_filter *filter);
+extern void bloom_add_hash(bloom_filter *filter, uint32 hash);
+extern bool bloom_lacks_hash(bloom_filter *filter, uint32 hash);
+extern double bloom_prop_bits_set(bloom_filter *filter);
+extern Size bloom_total_size(bloom_filter *filter);
+extern bloom_filter *bloom_restore(const char *data, Size len);
+
+#endif                            /* _BLOOMFILTER_H_ */
@@ -440,6 +440,7 @@ typedef struct ResultRelInfo
     CmdType     operation;        /*just as param when init*/
     struct ResultRelInfo    *parent;
     int part_index;
+    bool        part_lazy;        /* expanding model entries built on first route */
 #endif
 } ResultRelInfo;
 
@@ -1881,6 +1882,10 @@ typedef struct HashJoinState
     size_t      matched_tuples;
     Size                  hj_parallelStateLen;
     ParallelHashJoinState *hj_parallelState;
+    bool        hj_PushRuntimeFilter;       /* push a runtime filter down to
+                                             * the outer RemoteSubplan */
+    AttrNumber *hj_RuntimeFilterAttnos;     /* outer keys in remote tuples */
+    Oid        *hj_RuntimeFilterHashFuncs;  /* outer key hash functions */
 #endif
 } HashJoinState;
 
@@ -2083,6 +2088,13 @@ typedef struct AggState
     TupleTableSlot *dataslot;
     Oid                dataType;
     MemoryContext   tmpcxt;
+    /* adaptive partial aggregation, see agg_retrieve_bypass() */
+    bool            agg_adaptive;    /* may give up on partial aggregation */
+    bool            agg_bypass;        /* gave up, rest of input bypasses table */
+    bool            bypass_streaming;    /* hash table drained, streaming input */
+    uint64            bypass_input_rows;    /* rows hashed so far */
+    ExprContext    *bypasscontext;    /* transition values of a streamed row */
+    AggStatePerGroup bypass_pergroup;    /* per-trans state of a streamed row */
 #endif    
 } AggState;
 
@@ -2259,6 +2271,9 @@ typedef struct HashState
 
 	SharedHashInfo *shared_info;	/* one entry per worker */
 	HashInstrumentation *hinstrument;	/* this worker's entry */
+#ifdef __TBASE__
+    struct bloom_filter *runtime_filter;    /* collects inner hash values */
+#endif
 } HashState;
 
 /* ----------------
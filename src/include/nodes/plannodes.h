@@ -299,6 +299,7 @@ typedef struct Append
     List       *appendplans;
 #ifdef __TBASE__
     bool       interval;
+    List       *partprunequals;    /* partition key quals on Params, pruned at executor startup */
 #endif
 } Append;
 
@@ -321,6 +322,7 @@ typedef struct MergeAppend
     bool       *nullsFirst;        /* NULLS FIRST/LAST directions */
 #ifdef __TBASE__
     bool       interval;
+    List       *partprunequals;    /* partition key quals on Params, pruned at executor startup */
 #endif
 } MergeAppend;
 
@@ -856,6 +858,7 @@ typedef struct Agg
 	uint32     entrySize;
 	bool       hybrid;
 	bool       noDistinct;      /* no need of distinct related initialization */
+	bool       adaptive;        /* partial agg may bypass when not reducing */
 #endif
 } Agg;
 
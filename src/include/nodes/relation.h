@@ -1711,6 +1711,7 @@ typedef struct AggPath
 	uint32      entrySize;
 	bool        hybrid;
 	bool        noDistinct;     /* no need of distinct related initialization */
+	bool        adaptive;       /* partial agg may bypass when not reducing */
 #endif
 } AggPath;
 
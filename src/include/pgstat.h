@@ -782,6 +782,9 @@ typedef enum
 	WAIT_EVENT_WAL_WRITER_MAIN,
 #ifdef __AUDIT_FGA__
     WAIT_EVENT_AUDIT_FGA_MAIN,
+#endif
+#ifdef __TBASE__
+    WAIT_EVENT_PARTITION_MAINTENANCE_MAIN,
 #endif
 	WAIT_EVENT_CLUSTER_MONITOR_MAIN
 } WaitEventActivity;
@@ -831,7 +834,10 @@ typedef enum
 	WAIT_EVENT_REPLICATION_ORIGIN_DROP,
 	WAIT_EVENT_REPLICATION_SLOT_DROP,
 	WAIT_EVENT_SAFE_SNAPSHOT,
-	WAIT_EVENT_SYNC_REP
+	WAIT_EVENT_SYNC_REP,
+#ifdef __TBASE__
+	WAIT_EVENT_GTS_BROKER
+#endif
 } WaitEventIPC;
 
 /* ----------
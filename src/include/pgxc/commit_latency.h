@@ -0,0 +1,44 @@
+/*-------------------------------------------------------------------------
+ *
+ * commit_latency.h
+ *      Latency histograms of the phases of distributed commit
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * src/include/pgxc/commit_latency.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef COMMIT_LATENCY_H
+#define COMMIT_LATENCY_H
+
+#include "fmgr.h"
+#include "portability/instr_time.h"
+
+typedef enum CommitLatencyPhase
+{
+    COMMIT_LATENCY_PREPARE,        /* PREPARE round of two-phase commit */
+    COMMIT_LATENCY_GTS,            /* prepare or commit timestamp from GTM */
+    COMMIT_LATENCY_COMMIT,        /* COMMIT or COMMIT PREPARED round */
+    COMMIT_LATENCY_NPHASES
+} CommitLatencyPhase;
+
+extern bool track_commit_latency;
+
+/* start timing a phase; a zero start time is not recorded */
+#define CommitLatencyStart(start) \
+    do { \
+        if (track_commit_latency) \
+            INSTR_TIME_SET_CURRENT(start); \
+        else \
+            INSTR_TIME_SET_ZERO(start); \
+    } while (0)
+
+extern Size CommitLatencyShmemSize(void);
+extern void CommitLatencyShmemInit(void);
+extern void CommitLatencyRecord(CommitLatencyPhase phase, instr_time start);
+
+extern Datum tbase_commit_latency(PG_FUNCTION_ARGS);
+extern Datum tbase_reset_commit_latency(PG_FUNCTION_ARGS);
+
+#endif                            /* COMMIT_LATENCY_H */
@@ -62,6 +62,9 @@
 #define BIT_SET(data, bit)   ((1 << (bit)) & (data)) 
 
 extern int DataRowBufferSize;
+extern bool g_CopySenderThread;
+extern int  g_CopySenderQueueSize;
+extern bool enable_onephase_commit;
 
 extern bool need_global_snapshot;
 extern List *executed_node_list;
@@ -263,6 +266,11 @@ typedef struct RemoteSubplanState
     bool        finish_init;
     int32       eflags;                       /* estate flag. */
     ParallelWorkerStatus *parallel_status; /* Shared storage for parallel worker. */
+    char       *runtime_filter;     /* runtime filter to send with the first Bind */
+    int         runtime_filter_len;
+    int         setup_nodes;        /* nodes the subplan was dispatched to */
+    double      setup_begin_time;   /* ms spent starting remote transactions */
+    double      setup_dispatch_time;    /* ms spent sending the subplan */
 #endif
 } RemoteSubplanState;
 
@@ -438,6 +446,8 @@ extern TupleDesc create_tuple_desc(char *msg_body, size_t len);
 
 extern void ExecFinishRemoteSubplan(RemoteSubplanState *node);
 extern void ExecShutdownRemoteSubplan(RemoteSubplanState *node);
+extern void ExecRemoteSubplanSetRuntimeFilter(RemoteSubplanState *node,
+                                  char *data, int len);
 extern bool SetSnapshot(EState *state);
 #endif
 
@@ -186,6 +186,11 @@ extern int GET_NODES(Locator *self, Datum value, bool isnull,
 					       Datum secValue, bool secIsNull,
 #endif
 	                       bool *hasprimary);
+#ifdef __TBASE__
+extern bool LocatorSupportsBatch(Locator *self);
+extern bool GET_NODES_BATCH(Locator *self, Datum *values, bool *nulls,
+                            int nvalues, void *results);
+#endif
 extern void *getLocatorResults(Locator *self);
 extern void *getLocatorNodeMap(Locator *self);
 extern int getLocatorNodeCount(Locator *self);
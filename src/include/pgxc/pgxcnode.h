@@ -78,6 +78,34 @@ typedef enum
 		((conn)->inCursor + 4 < (conn)->inEnd \
 			&& (conn)->inCursor + ntohl(*((uint32_t *) ((conn)->inBuffer + (conn)->inCursor + 1))) < (conn)->inEnd)
 
+#ifdef __TBASE__
+/* number of subplans a remote node keeps for a coordinator session */
+#define REMOTE_PLAN_CACHE_SLOTS 16
+
+/*
+ * Protocol features negotiated on every new connection of a session.  The
+ * session sends "SET tbase.remote_features" with the features it supports,
+ * and the remote node reports back the ones it supports too.  A node of an
+ * older release takes the setting as a placeholder and reports nothing, so
+ * none of the features is used with it.
+ */
+#define REMOTE_FEATURES_GUC             "tbase.remote_features"
+#define REMOTE_FEATURE_XID_REPORT       0x0001  /* 'w' when an xid is assigned */
+#define REMOTE_FEATURE_DATAROW_BATCH    0x0002  /* 'B' compressed DataRow batches */
+#define REMOTE_FEATURE_RUNTIME_FILTER   0x0004  /* 'y' runtime filter before Bind */
+#define REMOTE_FEATURE_PLAN_CACHE       0x0008  /* plan cache slot and id in 'p' */
+#ifdef HAVE_LIBZ
+#define REMOTE_FEATURES_SUPPORTED       (REMOTE_FEATURE_XID_REPORT | \
+                                         REMOTE_FEATURE_DATAROW_BATCH | \
+                                         REMOTE_FEATURE_RUNTIME_FILTER | \
+                                         REMOTE_FEATURE_PLAN_CACHE)
+#else
+#define REMOTE_FEATURES_SUPPORTED       (REMOTE_FEATURE_XID_REPORT | \
+                                         REMOTE_FEATURE_RUNTIME_FILTER | \
+                                         REMOTE_FEATURE_PLAN_CACHE)
+#endif
+#endif
+
 struct pgxc_node_handle
 {
 	Oid			nodeoid;
@@ -129,6 +157,11 @@ struct pgxc_node_handle
 	long        recv_datarows;
 	bool 		plpgsql_need_begin_sub_txn;
 	bool 		plpgsql_need_begin_txn;
+	void	   *copy_sender;	/* COPY FROM sender thread of the connection, if any */
+	/* ids of the plans the remote node holds in its plan cache slots */
+	uint32		plan_cache_ids[REMOTE_PLAN_CACHE_SLOTS];
+	bool		xid_assigned;	/* remote transaction has assigned an xid */
+	int			remote_features;	/* REMOTE_FEATURE_* agreed with the node */
 #endif
 };
 typedef struct pgxc_node_handle PGXCNodeHandle;
@@ -197,6 +230,9 @@ extern int	ensure_in_buffer_capacity(size_t bytes_needed, PGXCNodeHandle * handl
 extern int	ensure_out_buffer_capacity(size_t bytes_needed, PGXCNodeHandle * handle);
 
 extern int	pgxc_node_send_query(PGXCNodeHandle * handle, const char *query);
+#ifdef __TBASE__
+extern int	pgxc_node_queue_query(PGXCNodeHandle *handle, const char *query);
+#endif
 extern int	pgxc_node_send_rollback(PGXCNodeHandle * handle, const char *query);
 extern int	pgxc_node_send_describe(PGXCNodeHandle * handle, bool is_statement,
 						const char *name);
@@ -223,7 +259,23 @@ extern int	pgxc_node_send_query_extended(PGXCNodeHandle *handle, const char *que
 							  bool send_describe, int fetch_size);
 extern int  pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
 					const char *query, const char *planstr,
-					short num_params, Oid *param_types, int instrument_options);
+					short num_params, Oid *param_types, int instrument_options,
+					int cache_slot, uint32 cache_id);
+#ifdef __TBASE__
+struct RemoteParam;
+struct RemoteStmt;
+extern bool enable_remote_plan_cache;
+extern int  RemotePlanCacheLookup(uint32 id, int nparams,
+					struct RemoteParam *params);
+extern char *RemotePlanCacheGetText(int slot);
+extern int  RemotePlanCacheStore(const char *planstr, int nparams,
+					struct RemoteParam *params, uint32 *id);
+extern const char *RemotePlanCacheResolve(const char *planstr, int slot,
+					uint32 id);
+extern struct RemoteStmt *RemotePlanCacheGetStmt(int slot,
+					MemoryContext plan_context);
+extern void pgxc_node_forget_cached_plans(PGXCNodeHandle *handle);
+#endif
 extern int pgxc_node_send_gid(PGXCNodeHandle *handle, char* gid);
 #ifdef __TWO_PHASE_TRANS__
 extern int pgxc_node_send_starter(PGXCNodeHandle *handle, char* startnode);
@@ -235,6 +287,10 @@ extern int pgxc_node_send_after_prepare(PGXCNodeHandle *handle);
 #endif
 extern int	pgxc_node_send_gxid(PGXCNodeHandle * handle, GlobalTransactionId gxid);
 extern int	pgxc_node_send_cmd_id(PGXCNodeHandle *handle, CommandId cid);
+#ifdef __TBASE__
+extern int	pgxc_node_send_runtime_filter(PGXCNodeHandle *handle,
+							  const char *data, int len);
+#endif
 extern int	pgxc_node_send_snapshot(PGXCNodeHandle * handle, Snapshot snapshot);
 extern int	pgxc_node_send_timestamp(PGXCNodeHandle * handle, TimestampTz timestamp);
 extern int
@@ -259,6 +315,9 @@ extern int	pgxc_node_is_data_enqueued(PGXCNodeHandle *conn);
 
 extern int	send_some(PGXCNodeHandle * handle, int len);
 extern int	pgxc_node_flush(PGXCNodeHandle *handle);
+#ifdef __TBASE__
+extern int	pgxc_node_flush_all(int conn_count, PGXCNodeHandle **connections);
+#endif
 extern void	pgxc_node_flush_read(PGXCNodeHandle *handle);
 
 extern char get_message(PGXCNodeHandle *conn, int *len, char **msg);
@@ -295,6 +354,9 @@ inline bool  is_ddl_leader_cn(char *leader_cn);
 extern int pgxc_node_send_sessionid(PGXCNodeHandle * handle);
 extern void SerializeSessionId(Size maxsize, char *start_address);
 extern void StartParallelWorkerSessionId(char *address);
+
+/* features asked for by the session this node serves, see above */
+extern int g_RemoteFeatures;
 #endif
 
 #ifdef __AUDIT__
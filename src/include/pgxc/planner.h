@@ -256,6 +256,11 @@ typedef struct
     bool        parallelWorkerSendTuple; 
 	/* params that generated by initplan */
 	Bitmapset  *initPlanParams;
+	/*
+	 * remote plan cache id of the serialized subplan, set by the executor of
+	 * this backend; neither copied nor serialized
+	 */
+	uint32		cache_id;
 #endif
 
 } RemoteSubplan;
@@ -44,8 +44,10 @@ typedef struct
 #endif
 } PoolPort;
 
-extern int    pool_listen(unsigned short port, const char *unixSocketName);
-extern int    pool_connect(unsigned short port, const char *unixSocketName);
+extern int    pool_listen(unsigned short port, const char *unixSocketName,
+                        int shard);
+extern int    pool_connect(unsigned short port, const char *unixSocketName,
+                         int shard);
 extern int    pool_getbyte(PoolPort *port);
 extern int    pool_pollbyte(PoolPort *port);
 extern int    pool_getmessage(PoolPort *port, StringInfo s, int maxlen);
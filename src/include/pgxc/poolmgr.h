@@ -129,9 +129,26 @@ typedef struct
 
     char        node_name[NAMEDATALEN]; /* name of the node.*/
 	time_t		m_version;	/* version of node pool */
+#ifdef __TBASE__
+    int         warm_target;    /* connections predicted to be in use soon */
+#endif
     PGXCNodePoolSlot **slot;
 } PGXCNodePool;
 
+#ifdef __TBASE__
+/* Demand history of a node in a database pool, one slot per quarter hour */
+#define POOL_DEMAND_SLOTS    96
+
+typedef struct PoolDemandHistory
+{
+    Oid         nodeoid;        /* hash key */
+    bool        coord;
+    int         slot;           /* quarter hour the peak belongs to */
+    int         peak;           /* most connections in use in that quarter hour */
+    uint16      demand[POOL_DEMAND_SLOTS];    /* smoothed peak of each quarter hour */
+} PoolDemandHistory;
+#endif
+
 /* All pools for specified database */
 typedef struct databasepool
 {
@@ -144,6 +161,9 @@ typedef struct databasepool
      bool        bneed_warm;
     bool        bneed_precreate;
     bool        bneed_pool;        /* check whether need  connect pool */
+#ifdef __TBASE__
+    HTAB       *demandHistory;  /* PoolDemandHistory of each node, outlives node pools */
+#endif
     MemoryContext mcxt;
     struct databasepool *next;     /* Reference to next to organize linked list */
 } DatabasePool;
@@ -217,6 +237,9 @@ typedef struct
 	PGXCASyncTaskCtl *task_control;  /* in error situation, we need to free the task control */
 
     pg_time_t cmd_start_time;        /* command start time */
+#ifdef __TBASE__
+	int				park_index;		 /* parked connection state of the session, -1 if unknown */
+#endif
 } PoolAgent;
 
 /* Handle to the pool manager (Session's side) */
@@ -269,6 +292,23 @@ extern int  PoolCheckSlotTimeout;
 extern int  PoolPrintStatTimeout;
 extern bool PoolConnectDebugPrint; 
 extern bool PoolSubThreadLogPrint;
+#ifdef __TBASE__
+extern bool PoolerFastPath;
+extern bool PoolerStickyConnections;
+extern int  PoolerStickyIdleTimeout;
+extern bool PoolerPredictiveWarm;
+extern int  PoolerWarmLeadTime;
+
+/* Sharded pooler: pooler processes each owning part of the database pools */
+#define MAX_POOLER_PROCESSES    16
+
+extern int  PoolerProcesses;
+extern int  PoolerShardIndex;
+
+extern int  PoolerShardOf(const char *database, const char *user_name);
+extern void PoolerShardsRegister(void);
+extern void PoolerShardMain(Datum main_arg);
+#endif
 /* Status inquiry functions */
 extern void PGXCPoolerProcessIam(void);
 extern bool IsPGXCPoolerProcess(void);
@@ -288,6 +328,7 @@ extern int    PoolManagerDestroy(void);
  * only be accessible by the process running the session.
  */
 extern PoolHandle *GetPoolManagerHandle(void);
+extern PoolHandle *GetPoolManagerShardHandle(int shard);
 
 /*
  * Called from Postmaster(Coordinator) after fork. Close one end of the pipe and
@@ -347,6 +388,14 @@ extern int    PoolManagerAbortTransactions(char *dbname, char *username, int **p
 /* Return connections back to the pool, for both Coordinator and Datanode connections */
 extern void PoolManagerReleaseConnections(bool force);
 
+#ifdef __TBASE__
+/* Keep idle connections in the session between transactions */
+extern Size PoolerParkShmemSize(void);
+extern void PoolerParkShmemInit(void);
+extern bool PoolManagerParkConnections(void);
+extern bool PoolManagerUnparkConnections(void);
+#endif
+
 /* Cancel a running query on Datanodes as well as on other Coordinators */
 extern bool PoolManagerCancelQuery(int dn_count, int* dn_list, int co_count, int* co_list, int signal);
 
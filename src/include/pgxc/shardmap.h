@@ -103,6 +103,9 @@
 #define STRINGLENGTH 1024   /* string buffer length */
 
 extern int32       GetNodeIndexByHashValue(Oid group, long shardIdx);
+#ifdef __TBASE__
+extern void        GetNodeIndexByHashValues(Oid group, long *hashvalues, int nvalues, int32 *nodeindexes);
+#endif
 extern Bitmapset  *g_DatanodeShardgroupBitmap;
 extern List       *g_TempKeyValueList;
 extern bool         g_IsExtension;
@@ -136,6 +139,9 @@ typedef enum
 }ShardOpType;
 
 extern bool  show_all_shard_stat;
+#ifdef __TBASE__
+extern bool  g_ShardPhysicalMove;
+#endif
 
 #ifdef __COLD_HOT__
 extern bool    g_EnableKeyValue;
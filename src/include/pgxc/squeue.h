@@ -148,8 +148,12 @@ extern bool  g_DataPumpDebug;
 extern int32 g_SndThreadNum;
 extern int32 g_SndThreadBufferSize;
 extern int32 g_SndBatchSize;
+extern int32 g_SndCompressLevel;
 extern int   consumer_connect_timeout;
 extern int   g_DisConsumer_timeout;
+extern bool  g_SqueueMinimalTuple;
+extern int   g_SqueueSpillMemory;
+extern int   g_SqueueSpillDelay;
 
 extern bool in_data_pump;
 
@@ -157,7 +161,7 @@ extern volatile sig_atomic_t end_query_requested;
 
 extern DataPumpSender BuildDataPumpSenderControl(SharedQueue sq);
 extern int32  DataPumpSendDataRow(void *sender, int32 nodeindex, int32 nodeId,  char *data, size_t len);
-extern int32  DataPumpSetNodeSocket(void *sender, int32 nodeindex, int32 nodeId,  int32 socket);
+extern int32  DataPumpSetNodeSocket(void *sender, int32 nodeindex, int32 nodeId,  int32 socket, int32 features);
 /*
  * To finish the cursor. Step 1:DataPumpWaitSenderDone, Step 2:DestoryDataPumpSenderControl
  */
@@ -178,6 +182,10 @@ extern void WaitForParallelWorkerDone(int numParallelWorkers, bool launch_failed
 
 extern int GetConsumerIdx(SharedQueue sq, int nodeid);
 
+extern void SharedQueueSetConsumerFilter(SharedQueue sq, int consumerIdx, dsm_handle handle);
+
+extern dsm_handle SharedQueueGetConsumerFilter(SharedQueue sq, int consumerIdx);
+
 extern void ParallelSendEreport(void);
 
 extern void ParallelDsmDetach(void);
@@ -229,6 +237,7 @@ extern bool    IsEmpty(PGPipe *pPipe);
 extern int 	   PipeLength(PGPipe *pPipe);
 
 extern int32 CreateThread(void *(*f) (void *), void *arg, int32 mode);
+extern void  ThreadSigmask(void);
 
 extern const char *SqueueName(SharedQueue sq);
 
@@ -0,0 +1,24 @@
+/*-------------------------------------------------------------------------
+ *
+ * partmaint.h
+ *      Background worker that maintains interval partitions
+ *
+ * Portions Copyright (c) 2019, TBase Development Group
+ *
+ * src/include/postmaster/partmaint.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PARTMAINT_H
+#define PARTMAINT_H
+
+/* GUC variables */
+extern char *partition_maintenance_database;
+extern int    partition_maintenance_naptime;
+extern int    partition_maintenance_lock_timeout;
+extern int    partition_premake;
+
+extern void PartitionMaintenanceRegister(void);
+extern void PartitionMaintenanceMain(Datum main_arg);
+
+#endif                            /* PARTMAINT_H */
@@ -282,6 +282,8 @@ extern bool         eob_extent_is_free(Relation rel, ExtentID eid);
 extern void         eob_mark_extent(Relation rel, ExtentID eid, bool setfree);
 extern ExtentID     eob_get_free_extent(Relation rel);
 extern ExtentID     eob_get_free_extent_and_set_busy(Relation rel);
+extern int        g_ExtentReserveBatch;
+extern void     AtEOXact_ExtentReservations(bool isCommit);
 extern void         eob_truncate(Relation rel, ExtentID new_max_eid, ExtentID old_max_eid);
 
 
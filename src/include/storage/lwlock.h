@@ -288,6 +288,9 @@ typedef enum BuiltinTrancheIds
     LWTRANCHE_PARALLEL_WORKER_DSA,
 #endif
     LWTRANCHE_TBM,
+#ifdef _SHARDING_
+    LWTRANCHE_EXTENT_CACHE,
+#endif
     LWTRANCHE_FIRST_USER_DEFINED
 }            BuiltinTrancheIds;
 
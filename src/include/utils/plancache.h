@@ -257,7 +257,7 @@ extern CachedPlan *GetCachedPlan(CachedPlanSource *plansource,
 extern void ReleaseCachedPlan(CachedPlan *plan, bool useResOwner);
 #ifdef XCP
 extern void SetRemoteSubplan(CachedPlanSource *plansource,
-                 const char *plan_string);
+                 const char *plan_string, int cache_slot);
 #endif
 
 #endif                            /* PLANCACHE_H */
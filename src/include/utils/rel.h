@@ -305,6 +305,10 @@ typedef struct StdRdOptions
 	AutoVacOpts autovacuum;		/* autovacuum-related options */
 	bool		user_catalog_table; /* use as an additional catalog relation */
 	int			parallel_workers;	/* max number of parallel workers */
+#ifdef __TBASE__
+	int			partition_premake;	/* future interval partitions to keep */
+	int			partition_retention;	/* past interval partitions to keep */
+#endif
 } StdRdOptions;
 
 #define HEAP_MIN_FILLFACTOR			10
@@ -352,6 +356,27 @@ typedef struct StdRdOptions
 	((relation)->rd_options ? \
 	 ((StdRdOptions *) (relation)->rd_options)->parallel_workers : (defaultpw))
 
+#ifdef __TBASE__
+/*
+ * RelationGetPartitionPremake
+ *		Returns the relation's partition_premake reloption setting, or the
+ *		default when it is not set.  Note multiple eval of argument!
+ */
+#define RelationGetPartitionPremake(relation, defaultpm) \
+	((relation)->rd_options && \
+	 ((StdRdOptions *) (relation)->rd_options)->partition_premake >= 0 ? \
+	 ((StdRdOptions *) (relation)->rd_options)->partition_premake : (defaultpm))
+
+/*
+ * RelationGetPartitionRetention
+ *		Returns the relation's partition_retention reloption setting.
+ *		Note multiple eval of argument!
+ */
+#define RelationGetPartitionRetention(relation) \
+	((relation)->rd_options ? \
+	 ((StdRdOptions *) (relation)->rd_options)->partition_retention : 0)
+#endif
+
 
 /*
  * ViewOptions
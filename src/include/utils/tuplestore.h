@@ -161,6 +161,7 @@ extern void tuplestore_collect_stat(Tuplestorestate *state, char *name);
 
 #ifdef __TBASE__
 extern void tuplestore_set_tupdeleted(Tuplestorestate *state);
+extern int64 tuplestore_spill_bytes(Tuplestorestate *state);
 #endif
 
 #endif                            /* TUPLESTORE_H */
@@ -0,0 +1,43 @@
+--
+-- TBASE_2PC_JOURNAL
+--
+-- The pg_2pc records of distributed transactions live in the 2PC journal.
+-- A transaction left prepared is finished later, as pg_clean does after a
+-- crash, also across checkpoints that rewrite the journal.
+--
+show enable_2pc_journal;
+create table t_2pc(a int, b int) distribute by shard(a);
+insert into t_2pc select i, 0 from generate_series(1, 100) i;
+
+-- implicit two-phase commits
+update t_2pc set b = b + 1;
+update t_2pc set b = b + 1;
+select b, count(*) from t_2pc group by b order by b;
+
+-- committed after a checkpoint
+begin;
+update t_2pc set b = 3;
+prepare transaction 'p_2pc_1';
+select gid from pg_prepared_xacts where gid = 'p_2pc_1';
+checkpoint;
+commit prepared 'p_2pc_1';
+select gid from pg_prepared_xacts where gid = 'p_2pc_1';
+select b, count(*) from t_2pc group by b order by b;
+
+-- rolled back after a checkpoint
+begin;
+update t_2pc set b = 4;
+prepare transaction 'p_2pc_2';
+checkpoint;
+rollback prepared 'p_2pc_2';
+select gid from pg_prepared_xacts where gid = 'p_2pc_2';
+select b, count(*) from t_2pc group by b order by b;
+
+-- the gid of a finished transaction can be used again
+begin;
+update t_2pc set b = 5 where a <= 10;
+prepare transaction 'p_2pc_1';
+commit prepared 'p_2pc_1';
+select b, count(*) from t_2pc group by b order by b;
+
+drop table t_2pc;
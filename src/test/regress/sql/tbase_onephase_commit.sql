@@ -0,0 +1,55 @@
+--
+-- TBASE_ONEPHASE_COMMIT
+--
+-- Transactions that write on a single datanode commit without implicit
+-- two-phase commit, the other datanodes are committed as read-only.
+--
+show enable_onephase_commit;
+create table t_1pc(a int, b int) distribute by shard(a);
+insert into t_1pc select i, 0 from generate_series(1, 100) i;
+
+-- reads from every datanode, writes on one
+begin;
+select count(*) from t_1pc;
+update t_1pc set b = 1 where a = 1;
+commit;
+select a, b from t_1pc where b <> 0 order by a;
+
+-- begun writable on every datanode, changes rows on one
+begin;
+update t_1pc set b = 2 where b = 1;
+commit;
+select a, b from t_1pc where b <> 0 order by a;
+
+-- writes on several datanodes
+begin;
+update t_1pc set b = 3 where a <= 50;
+update t_1pc set b = 4 where a = 100;
+commit;
+select b, count(*) from t_1pc group by b order by b;
+
+-- a single writer rolled back
+begin;
+select count(*) from t_1pc;
+update t_1pc set b = 5 where a = 2;
+rollback;
+select count(*) from t_1pc where b = 5;
+
+-- every writable datanode goes through two-phase commit when disabled
+set enable_onephase_commit = off;
+begin;
+select count(*) from t_1pc;
+update t_1pc set b = 6 where a = 1;
+commit;
+reset enable_onephase_commit;
+select a, b from t_1pc where b = 6;
+
+-- explicit two-phase commit of a single writer
+begin;
+select count(*) from t_1pc;
+update t_1pc set b = 7 where a = 1;
+prepare transaction 'p_1pc';
+commit prepared 'p_1pc';
+select a, b from t_1pc where b = 7;
+
+drop table t_1pc;
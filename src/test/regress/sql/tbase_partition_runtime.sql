@@ -0,0 +1,56 @@
+--
+-- TBASE_PARTITION_RUNTIME
+--
+-- Rows routed to interval partitions at run time, and partitions pruned
+-- with the parameters of generic plans.
+--
+create table t_rt(c1 int, c2 timestamp without time zone, c3 int)
+partition by range(c2) begin(timestamp without time zone '2015-09-01') step(interval '1 day') partitions(10)
+distribute by shard(c1);
+
+-- partition key computed for every row
+insert into t_rt select i, timestamp without time zone '2015-09-01 12:00:00' + (i % 10) * interval '1 day', i from generate_series(1, 100) i;
+select count(1) from t_rt;
+select count(1) from t_rt partition for(timestamp without time zone '2015-09-03 00:00:00');
+
+-- partition key from a parameter
+prepare ins_rt(int, timestamp without time zone) as insert into t_rt values($1, $2, $1);
+execute ins_rt(101, '2015-09-10 01:00:00');
+execute ins_rt(102, '2015-09-01 01:00:00');
+execute ins_rt(103, '2015-09-05 01:00:00');
+create function ins_rt_f(int, timestamp without time zone) returns void as
+$$ insert into t_rt values($1, $2, $1) $$ language sql;
+select ins_rt_f(104, '2015-09-05 02:00:00');
+select ins_rt_f(105, '2015-09-07 23:59:00');
+select ins_rt_f(106, '2015-09-10 23:00:00');
+select c1, c2 from t_rt where c1 > 100 order by c1;
+select count(1) from t_rt partition for(timestamp without time zone '2015-09-05 00:00:00');
+select count(1) from t_rt partition for(timestamp without time zone '2015-09-10 00:00:00');
+
+-- the plan of a SQL function keeps the parameters, the executor prunes
+create function cnt_rt(timestamp without time zone, timestamp without time zone) returns bigint as
+$$ select count(1) from t_rt where c2 >= $1 and c2 < $2 $$ language sql;
+select cnt_rt('2015-09-01', '2015-09-02');
+select cnt_rt('2015-09-05', '2015-09-06');
+select cnt_rt('2015-09-02', '2015-09-04');
+select cnt_rt('2015-09-01', '2015-09-11');
+-- no partition left after pruning
+select cnt_rt('2014-01-01', '2014-02-01');
+select cnt_rt('2016-01-01', '2016-02-01');
+
+-- integer partition key compared with a bigint parameter
+create table t_rt_int(f1 int, f3 int) partition by range (f3) begin (1) step (50) partitions (4) distribute by shard(f1);
+insert into t_rt_int select i, i from generate_series(1, 200) i;
+create function cnt_rt_int(bigint) returns bigint as
+$$ select count(1) from t_rt_int where f3 < $1 $$ language sql;
+select cnt_rt_int(60);
+select cnt_rt_int(151);
+select cnt_rt_int(1000);
+select cnt_rt_int(-5);
+
+deallocate ins_rt;
+drop function ins_rt_f(int, timestamp without time zone);
+drop function cnt_rt(timestamp without time zone, timestamp without time zone);
+drop function cnt_rt_int(bigint);
+drop table t_rt;
+drop table t_rt_int;
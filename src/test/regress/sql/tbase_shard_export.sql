@@ -0,0 +1,20 @@
+--
+-- TBASE_SHARD_EXPORT
+--
+-- Raw shard contents bypass column privileges and row level security, so
+-- only superusers may export shards or move them physically.
+--
+create table t_shard_export(a int, b text) distribute by shard(a);
+insert into t_shard_export select i, 'row ' || i from generate_series(1, 10) i;
+create role regress_shard_user;
+grant select on t_shard_export to regress_shard_user;
+set session authorization regress_shard_user;
+select count(*) from t_shard_export;
+select extent_id, ntuples from tbase_shard_export('t_shard_export'::regclass, 0);
+set enable_shard_physical_move = on;
+reset session authorization;
+
+select extent_id, ntuples from tbase_shard_export('t_shard_export'::regclass, -1);
+
+drop table t_shard_export;
+drop role regress_shard_user;